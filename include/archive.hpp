@@ -0,0 +1,105 @@
+#pragma once
+
+#include "compression.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+/**
+ * @file archive.hpp
+ * @brief Archive export for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the Archiver class, which writes the snapshot of a
+ * commit as a tar, gzip-compressed tar or zip archive straight from the
+ * object store.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @enum ArchiveFormat
+ * @brief Container format of an archive
+ */
+enum class ArchiveFormat {
+    TAR, /**< POSIX ustar with pax headers where needed */
+    TGZ, /**< tar compressed as one gzip stream */
+    ZIP  /**< zip with Zip64 records where needed */
+};
+
+/**
+ * @struct ArchiveOptions
+ * @brief How to write an archive
+ */
+struct ArchiveOptions {
+    ArchiveFormat format = ArchiveFormat::TAR;            /**< Container format */
+    std::string prefix;                                   /**< Prepended to every path, e.g. "project-1.0/" */
+    CompressionLevel level = CompressionLevel::DEFAULT;   /**< Level for tgz and zip entries */
+};
+
+/**
+ * @class Archiver
+ * @brief Streams a commit's files into an archive
+ *
+ * Nothing is checked out and no temporary files are written. Files are
+ * archived in path order with the commit time as their modification time,
+ * so the same commit always gives the same bytes. Blobs are read, inflated
+ * and, for zip, deflated again on the task scheduler one window at a time:
+ * while one window is written out in order, the next is being read. Blobs
+ * larger than kStreamThreshold skip the window and are streamed from the
+ * object store straight into the archive. Content is archived as stored,
+ * without smudge filters.
+ */
+class Archiver {
+public:
+    /** @brief Most files read ahead in one window */
+    static constexpr size_t kWindowFiles = 256;
+
+    /** @brief Most bytes read ahead in one window */
+    static constexpr uint64_t kWindowBytes = 32 * 1024 * 1024;
+
+    /** @brief Blobs above this size are streamed rather than read ahead */
+    static constexpr uint64_t kStreamThreshold = 8 * 1024 * 1024;
+
+    /**
+     * @brief Constructor for Archiver
+     * @param repoPath Path to the repository root
+     * @param mimirionDir Path to the .mimirion directory
+     */
+    Archiver(const fs::path& repoPath, const fs::path& mimirionDir);
+
+    /**
+     * @brief Write the archive of a commit
+     * @param revision Commit to archive, as accepted by RefStore::resolve
+     * @param options Archive options
+     * @param sink Receives the archive bytes; returns false to abort
+     * @return true if successful, false if the revision is unknown, an
+     *         object could not be read or the sink aborted
+     */
+    bool write(const std::string& revision, const ArchiveOptions& options, const CompressionSink& sink);
+
+    /**
+     * @brief Parse a format name
+     * @param name "tar", "tgz", "tar.gz" or "zip"
+     * @param format Receives the format
+     * @return true if the name is known
+     */
+    static bool parseFormat(const std::string& name, ArchiveFormat& format);
+
+    /**
+     * @brief Pick a format from an output file name
+     * @param path Output file
+     * @param format Receives the format matching the extension
+     * @return true if the extension names a format
+     */
+    static bool formatForPath(const fs::path& path, ArchiveFormat& format);
+
+private:
+    fs::path repositoryPath;
+    fs::path mimirionDir;
+};
+
+} // namespace mimirion
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+/**
+ * @file arena.hpp
+ * @brief Per-operation memory arena for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the Arena class, a monotonic allocator that parse-heavy
+ * code paths use for their temporary structures so they are released in one
+ * shot at the end of the operation instead of one allocation at a time.
+ * Results that only live as long as the operation, such as a CommitRecord
+ * read during a history walk, can be built on the arena as well.
+ */
+
+namespace mimirion {
+
+/**
+ * @class Arena
+ * @brief Monotonic std::pmr memory resource with allocation accounting
+ *
+ * Memory handed out by the arena is only reclaimed when the arena is
+ * released or destroyed; deallocation is a no-op. The first block can be
+ * supplied by the caller (typically a stack buffer) so short operations do
+ * not touch the heap at all.
+ *
+ * Typical use:
+ * @code{.cpp}
+ * Arena arena;
+ * std::pmr::vector<std::string_view> lines(arena.resource());
+ * @endcode
+ */
+class Arena {
+public:
+    /**
+     * @brief Create an arena that allocates blocks from the heap
+     * @param initialSize Size of the first heap block in bytes
+     */
+    explicit Arena(size_t initialSize = 16 * 1024);
+
+    /**
+     * @brief Create an arena whose first block is a caller-owned buffer
+     * @param buffer Initial buffer, must outlive the arena
+     * @param size Size of the buffer in bytes
+     */
+    Arena(void* buffer, size_t size);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * @brief Get the memory resource to pass to std::pmr containers
+     * @return Memory resource backed by this arena
+     */
+    std::pmr::memory_resource* resource();
+
+    /**
+     * @brief Get the number of bytes requested from the arena
+     * @return Bytes allocated since construction or the last release()
+     */
+    size_t bytesAllocated() const;
+
+    /**
+     * @brief Get the number of allocations served by the arena
+     * @return Allocation count since construction or the last release()
+     */
+    size_t allocationCount() const;
+
+    /**
+     * @brief Free all memory at once
+     *
+     * Every object allocated from the arena must be dead before this call.
+     */
+    void release();
+
+private:
+    /**
+     * @brief Forwarding resource that counts what passes through it
+     */
+    class CountingResource : public std::pmr::memory_resource {
+    public:
+        explicit CountingResource(std::pmr::memory_resource* upstream);
+
+        size_t bytes;
+        size_t count;
+
+    private:
+        std::pmr::memory_resource* upstream;
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+    std::pmr::monotonic_buffer_resource monotonic;
+    CountingResource counting;
+};
+
+} // namespace mimirion
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @file attributes.hpp
+ * @brief Per-path attributes for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the Attributes class, which reads the
+ * .mimirionattributes file at the repository root and answers which
+ * attributes apply to a path.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @class Attributes
+ * @brief Path patterns mapped to attributes
+ *
+ * Each non-empty, non-comment line of .mimirionattributes holds a pattern
+ * followed by attributes: `name` sets an attribute to "true", `-name` to
+ * "false" and `name=value` to a value, for example
+ *
+ *     *.psd  filter=lfs
+ *     docs/manual.pdf  filter=lfs -diff
+ *
+ * Patterns are shell globs matched with fnmatch. A pattern without a slash
+ * matches the file name in any directory; a pattern with a slash matches
+ * the path relative to the repository root. When several lines set the
+ * same attribute, the last one wins.
+ */
+class Attributes {
+public:
+    /** @brief Name of the attributes file at the repository root */
+    static constexpr const char* kFileName = ".mimirionattributes";
+
+    /**
+     * @brief Load the attributes of a repository
+     * @param repoPath Path to the repository root
+     * @return Attributes; empty if the repository has no attributes file
+     */
+    static Attributes load(const fs::path& repoPath);
+
+    /**
+     * @brief Parse attribute lines
+     * @param text Contents in .mimirionattributes format
+     * @return Parsed attributes
+     */
+    static Attributes parse(const std::string& text);
+
+    /**
+     * @brief Get an attribute of a path
+     * @param path Path relative to the repository root
+     * @param name Attribute name
+     * @return Value ("true", "false" or the assigned value), or nullopt if unset
+     */
+    std::optional<std::string> get(const std::string& path, const std::string& name) const;
+
+    /**
+     * @brief Get all attributes of a path
+     * @param path Path relative to the repository root
+     * @return Attribute names mapped to their values
+     */
+    std::map<std::string, std::string> getAll(const std::string& path) const;
+
+    /**
+     * @brief Get the patterns that assign an attribute value
+     * @param name Attribute name
+     * @param value Attribute value
+     * @return Patterns, in file order
+     */
+    std::vector<std::string> patternsWith(const std::string& name, const std::string& value) const;
+
+    /**
+     * @brief Check whether there are no rules
+     * @return true if no patterns are defined
+     */
+    bool empty() const;
+
+    /**
+     * @brief Append a rule to a repository's attributes file
+     *
+     * Nothing is written if the same pattern already assigns the value.
+     *
+     * @param repoPath Path to the repository root
+     * @param pattern Path pattern
+     * @param attribute Attribute assignment such as "filter=lfs"
+     * @return true if successful, false otherwise
+     */
+    static bool addRule(const fs::path& repoPath, const std::string& pattern,
+                        const std::string& attribute);
+
+    /**
+     * @brief Check whether a pattern matches a path
+     * @param pattern Path pattern
+     * @param path Path relative to the repository root
+     * @return true if the pattern matches
+     */
+    static bool matches(const std::string& pattern, const std::string& path);
+
+private:
+    struct Rule {
+        std::string pattern;
+        std::vector<std::pair<std::string, std::string>> values;
+    };
+
+    std::vector<Rule> rules;
+};
+
+} // namespace mimirion
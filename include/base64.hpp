@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * @file base64.hpp
+ * @brief Vectorized streaming base64 for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the Base64Encoder and Base64Decoder classes. Bulk
+ * input is converted with SSSE3 or AVX2 kernels chosen at runtime from the
+ * CPU's features, with a portable scalar kernel as the fallback.
+ */
+
+namespace mimirion {
+
+/**
+ * @brief Receives output chunks from a Base64Encoder or Base64Decoder
+ *
+ * The data pointer refers to an internal buffer and is only valid during
+ * the call. Return false to abort the stream.
+ */
+using Base64Sink = std::function<bool(const char* data, size_t size)>;
+
+/**
+ * @class Base64Encoder
+ * @brief Streaming base64 encoder (standard alphabet, padded, no line breaks)
+ */
+class Base64Encoder {
+public:
+    Base64Encoder();
+
+    /**
+     * @brief Encode a chunk of input
+     *
+     * Up to two trailing bytes are held back until more input arrives or
+     * the stream is finished.
+     *
+     * @param data Input bytes
+     * @param size Number of input bytes
+     * @param sink Receives encoded output
+     * @return true if successful, false if the sink aborted
+     */
+    bool write(const char* data, size_t size, const Base64Sink& sink);
+
+    /**
+     * @brief Encode the held back bytes with padding and end the stream
+     * @param sink Receives the final encoded output
+     * @return true if successful, false if the sink aborted
+     */
+    bool finish(const Base64Sink& sink);
+
+    /**
+     * @brief Encode a buffer in one call
+     * @param data Input bytes
+     * @param out Encoded text is appended to this string
+     */
+    static void encode(std::string_view data, std::string& out);
+
+    /**
+     * @brief Get the encoded length of some input
+     * @param size Number of input bytes
+     * @return Number of base64 characters, including padding
+     */
+    static size_t encodedSize(size_t size);
+
+private:
+    unsigned char pending[3];
+    size_t pendingCount;
+    std::unique_ptr<char[]> buffer;
+};
+
+/**
+ * @class Base64Decoder
+ * @brief Streaming base64 decoder
+ *
+ * Whitespace (as in line-wrapped base64) is skipped. Padding is optional at
+ * the very end, but anything other than whitespace after it is an error.
+ */
+class Base64Decoder {
+public:
+    Base64Decoder();
+
+    /**
+     * @brief Decode a chunk of input
+     * @param data Base64 text
+     * @param size Number of characters
+     * @param sink Receives decoded output
+     * @return true if successful, false on invalid input or if the sink aborted
+     */
+    bool write(const char* data, size_t size, const Base64Sink& sink);
+
+    /**
+     * @brief Flush the final bytes and end the stream
+     * @param sink Receives the final decoded output
+     * @return true if the input was complete and valid, false otherwise
+     */
+    bool finish(const Base64Sink& sink);
+
+    /**
+     * @brief Decode a buffer in one call
+     * @param encoded Base64 text
+     * @param out Decoded bytes are appended to this string
+     * @return true if the input was valid, false otherwise
+     */
+    static bool decode(std::string_view encoded, std::string& out);
+
+private:
+    uint32_t bits;
+    int count;
+    int paddingLeft;
+    bool ended;
+    bool ok;
+    std::unique_ptr<unsigned char[]> buffer;
+
+    bool decodeSpan(const char*& data, size_t& size, unsigned char* out,
+                    size_t capacity, size_t& produced);
+    bool flushQuantum(unsigned char* out, size_t& produced);
+};
+
+/**
+ * @brief Get the name of the base64 kernel in use
+ * @return "avx2", "ssse3" or "scalar"
+ */
+const char* base64Kernel();
+
+/**
+ * @brief Select a base64 kernel, overriding CPU detection
+ *
+ * Intended for tests and benchmarks; the kernel applies process-wide.
+ *
+ * @param name "avx2", "ssse3" or "scalar"
+ * @return true if the kernel exists and this CPU supports it
+ */
+bool setBase64Kernel(const std::string& name);
+
+} // namespace mimirion
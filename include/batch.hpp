@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <istream>
+#include <ostream>
+#include <filesystem>
+#include "object_store.hpp"
+#include "refs.hpp"
+#include "file_tracker.hpp"
+#include "diff.hpp"
+
+/**
+ * @file batch.hpp
+ * @brief Batch request processing for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the definition of the BatchProcessor class, which
+ * answers a stream of small queries against one open repository so tools
+ * do not have to start a new process per query.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @class BatchProcessor
+ * @brief Answers a stream of repository queries read from an input stream
+ *
+ * Each request is one line (or one NUL-terminated record) of the form
+ * `<command> <arguments>`. Supported commands:
+ * - `cat-object <hash>`: raw content of an object
+ * - `resolve <name>`: hash a ref, branch, HEAD or hash prefix points to
+ * - `status-path <path>`: status of one working tree file
+ * - `diff-blobs <old-hash> <new-hash>`: unified diff between two objects
+ *
+ * Every response is a header line `ok <size>` or `error <size>`, followed
+ * by exactly `size` bytes of payload and the request delimiter.
+ */
+class BatchProcessor {
+public:
+    /**
+     * @brief Constructor for BatchProcessor
+     * @param repoPath Path to the repository root directory
+     * @param mimirionDir Path to the repository's .mimirion directory
+     */
+    BatchProcessor(const fs::path& repoPath, const fs::path& mimirionDir);
+
+    /**
+     * @brief Process requests until the input is exhausted
+     * @param in Stream to read requests from
+     * @param out Stream to write responses to
+     * @param delimiter Request and response terminator ('\n' or '\0')
+     * @return Number of requests processed
+     */
+    size_t run(std::istream& in, std::ostream& out, char delimiter = '\n');
+
+    /**
+     * @brief Process a single request
+     * @param request Request line without the delimiter
+     * @param payload Receives the response payload or error message
+     * @return true if the request succeeded, false otherwise
+     */
+    bool handle(const std::string& request, std::string& payload);
+
+    /**
+     * @brief Resolve a name to the hash it refers to
+     * @param name HEAD, a ref path, a branch name, or a (partial) object hash
+     * @return Resolved hash, empty string if the name is unknown
+     */
+    std::string resolve(const std::string& name) const;
+
+private:
+    fs::path repositoryPath;
+    fs::path mimirionDir;
+    ObjectStore objects;
+    RefStore refs;
+    FileTracker tracker;
+    DiffEngine diffEngine;
+};
+
+} // namespace mimirion
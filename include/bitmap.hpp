@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file bitmap.hpp
+ * @brief Reachability bitmaps for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the EwahBitmap class, a run-length compressed bitmap,
+ * and the BitmapIndex class, which stores the objects reachable from
+ * selected commits as such bitmaps so that reachability questions become
+ * bitmap arithmetic instead of history walks.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @class EwahBitmap
+ * @brief Bitmap compressed with the Enhanced Word-Aligned Hybrid scheme
+ *
+ * The bitmap is a sequence of 64-bit words. Each marker word holds a run
+ * bit in bit 0, the number of clean words (all zero or all one, per the
+ * run bit) in bits 1 to 32 and the number of literal words that follow
+ * the marker in bits 33 to 63. Long stretches of history that a commit
+ * reaches, or does not, cost one marker word.
+ */
+class EwahBitmap {
+public:
+    /**
+     * @brief Compress a plain bitmap
+     * @param words Bitmap with bit i in word i / 64, bit i % 64
+     * @return Compressed bitmap of the same words
+     */
+    static EwahBitmap compress(const std::vector<uint64_t>& words);
+
+    /**
+     * @brief OR this bitmap into a plain one
+     * @param words Plain bitmap, grown as needed
+     */
+    void orInto(std::vector<uint64_t>& words) const;
+
+    /**
+     * @brief Get the number of set bits without decompressing
+     * @return Set bit count
+     */
+    uint64_t count() const;
+
+    /**
+     * @brief Get the length of the plain bitmap
+     * @return Word count of the decompressed bitmap
+     */
+    size_t wordCount() const { return words; }
+
+    /**
+     * @brief Get the compressed size
+     * @return Word count of the compressed stream
+     */
+    size_t compressedWords() const { return stream.size(); }
+
+    /**
+     * @brief Append the bitmap in its file format to a buffer
+     * @param out Receives the plain word count, the compressed word count
+     *        and the compressed words, little-endian
+     */
+    void serialize(std::string& out) const;
+
+    /**
+     * @brief Read a bitmap written by serialize()
+     * @param data Buffer holding the bitmap
+     * @param offset Position of the bitmap, advanced past it
+     * @return true if a well-formed bitmap was read, false otherwise
+     */
+    bool parse(std::string_view data, size_t& offset);
+
+private:
+    uint32_t words = 0;
+    std::vector<uint64_t> stream;
+};
+
+/**
+ * @struct ReachableObjects
+ * @brief Result of a reachability query
+ */
+struct ReachableObjects {
+    size_t commits = 0;                 /**< Number of commits */
+    size_t blobs = 0;                   /**< Number of blobs */
+    std::vector<std::string> commitHashes; /**< Commits, newest first, if requested */
+    std::vector<std::string> blobHashes;   /**< Blobs, if requested */
+};
+
+/**
+ * @struct BitmapWriteStats
+ * @brief Size of a written bitmap index
+ */
+struct BitmapWriteStats {
+    size_t objects = 0; /**< Objects in the index */
+    size_t commits = 0; /**< Commits among them */
+    size_t bitmaps = 0; /**< Commits with a stored bitmap */
+    uint64_t bytes = 0; /**< Size of the index file */
+};
+
+/**
+ * @class BitmapIndex
+ * @brief Reachability bitmaps stored in .mimirion/objects/info/bitmaps
+ *
+ * The index numbers every object reachable from the refs when it was
+ * written: commits in topological order, parents first, each followed by
+ * the blobs it is the first to reach, so older history fills the low
+ * positions and a commit's bitmap is mostly one run. Every ref tip and
+ * every kSelectionInterval-th commit gets an EWAH bitmap of the objects it
+ * reaches.
+ *
+ * A query walks the history from its commits and stops at any commit with
+ * a bitmap, ORing that in instead. Objects created after the index was
+ * written get positions past its end for the length of the query, so the
+ * index never has to be current to give exact answers, only to give fast
+ * ones. Without an index every query is a full walk.
+ *
+ * The file holds a magic number, a version, the object and bitmap counts,
+ * the object table, an EWAH bitmap of the commit positions and the
+ * selected bitmaps, and ends with the SHA-256 of everything before it.
+ */
+class BitmapIndex {
+public:
+    /** @brief Commits between two selected bitmaps along the history */
+    static constexpr size_t kSelectionInterval = 100;
+
+    /**
+     * @brief Constructor for BitmapIndex; loads the index if there is one
+     * @param mimirionDir Path to the .mimirion directory
+     */
+    explicit BitmapIndex(const fs::path& mimirionDir);
+
+    /**
+     * @brief Rebuild the index from every ref and worktree HEAD
+     * @param stats If not null, receives the size of the new index
+     * @return true if successful, false otherwise
+     */
+    bool write(BitmapWriteStats* stats = nullptr);
+
+    /**
+     * @brief Collect the objects reachable from some commits but not others
+     * @param include Commits whose history is wanted
+     * @param exclude Commits whose history is left out
+     * @param result Receives the counts and, if requested, the hashes
+     * @param listHashes Whether to fill in the hash lists
+     * @return true if successful, false if a commit could not be read
+     */
+    bool reachable(const std::vector<std::string>& include, const std::vector<std::string>& exclude,
+                   ReachableObjects& result, bool listHashes = true) const;
+
+    /**
+     * @brief List the commits an index is built from
+     * @return Every ref's commit and every worktree's HEAD, without repeats
+     */
+    std::vector<std::string> tips() const;
+
+    /**
+     * @brief Count the commits reachable from the tips that the index lacks
+     * @param limit Count at which to stop walking
+     * @return Number of commits outside the index, at most limit
+     */
+    size_t unindexedCommits(size_t limit) const;
+
+    /**
+     * @brief Check whether an index was loaded
+     * @return true if queries can use stored bitmaps
+     */
+    bool loaded() const { return !objects.empty(); }
+
+    /**
+     * @brief Get the number of objects in the index
+     * @return Object count
+     */
+    size_t objectCount() const { return objects.size(); }
+
+    /**
+     * @brief Get the number of stored bitmaps
+     * @return Bitmap count
+     */
+    size_t bitmapCount() const { return bitmaps.size(); }
+
+    /**
+     * @brief Check the trailing checksum of an index file
+     * @param path Index file
+     * @return true if the file is well-formed and its checksum matches
+     */
+    static bool verify(const fs::path& path);
+
+private:
+    struct Walk;
+
+    fs::path mimirionDir;
+    fs::path indexPath;
+    std::vector<std::string> objects;
+    std::unordered_map<std::string, uint32_t> positions;
+    std::vector<uint64_t> commitPositions;
+    std::unordered_map<uint32_t, EwahBitmap> bitmaps;
+
+    bool load();
+};
+
+} // namespace mimirion
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "compression.hpp"
+
+/**
+ * @file codec.hpp
+ * @brief Pluggable object compression codecs for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the Codec interface, the registry of codecs compiled
+ * into the library, and the per-object header that records which codec and
+ * dictionary an object was stored with, so repositories with mixed codecs
+ * read transparently.
+ */
+
+namespace mimirion {
+
+/**
+ * @enum CodecId
+ * @brief Codec identifiers as stored in object headers
+ *
+ * The values are part of the on-disk format and must never change.
+ */
+enum class CodecId : uint8_t {
+    RAW = 0,  /**< Stored uncompressed */
+    ZLIB = 1, /**< zlib (deflate) */
+    ZSTD = 2  /**< Zstandard, optionally with a trained dictionary */
+};
+
+/**
+ * @struct ObjectHeader
+ * @brief Header stored in front of every encoded object
+ *
+ * Layout (16 bytes): the magic "MO", format version 1, codec id, 32-bit
+ * little-endian dictionary id (0 for none) and 64-bit little-endian size
+ * of the decoded content.
+ */
+struct ObjectHeader {
+    CodecId codec = CodecId::RAW;  /**< Codec of the payload */
+    uint32_t dictionaryId = 0;     /**< Dictionary the payload needs, 0 for none */
+    uint64_t size = 0;             /**< Decoded content size in bytes */
+
+    /** @brief Encoded header size in bytes */
+    static constexpr size_t kSize = 16;
+
+    /**
+     * @brief Append the encoded header to a buffer
+     * @param out Buffer to append to
+     */
+    void encode(std::string& out) const;
+
+    /**
+     * @brief Parse a header from the start of a stored object
+     * @param data Stored object bytes
+     * @param header Receives the parsed header
+     * @return true if data starts with a valid header, false otherwise
+     */
+    static bool decode(std::string_view data, ObjectHeader& header);
+};
+
+/**
+ * @class Codec
+ * @brief Interface of a compression codec
+ *
+ * Codecs are stateless singletons obtained from find(); any per-thread
+ * compression state is managed internally, so one codec can be used from
+ * several threads at once.
+ */
+class Codec {
+public:
+    virtual ~Codec() = default;
+
+    /**
+     * @brief Get the codec identifier
+     * @return Identifier stored in object headers
+     */
+    virtual CodecId id() const = 0;
+
+    /**
+     * @brief Get the codec name used in configuration
+     * @return Name such as "zlib" or "zstd"
+     */
+    virtual const char* name() const = 0;
+
+    /**
+     * @brief Compress a buffer
+     * @param data Input bytes
+     * @param out Receives the compressed bytes
+     * @param level Compression level
+     * @param dictionaryId Registered dictionary to use, 0 for none
+     * @return true if successful, false otherwise
+     */
+    virtual bool compress(std::string_view data, std::string& out, CompressionLevel level,
+                          uint32_t dictionaryId = 0) const = 0;
+
+    /**
+     * @brief Decompress a buffer
+     * @param data Compressed bytes
+     * @param out Receives the decompressed bytes
+     * @param sizeHint Expected decompressed size, 0 if unknown
+     * @param dictionaryId Dictionary the data was compressed with, 0 for none
+     * @return true if successful, false otherwise
+     */
+    virtual bool decompress(std::string_view data, std::string& out, size_t sizeHint,
+                            uint32_t dictionaryId = 0) const = 0;
+
+    /**
+     * @brief Check whether the codec can use trained dictionaries
+     * @return true if dictionaries are supported
+     */
+    virtual bool supportsDictionaries() const;
+
+    /**
+     * @brief Register a dictionary for use by compress() and decompress()
+     * @param content Dictionary bytes, as produced by trainDictionary()
+     * @return Dictionary id, 0 if the dictionary is invalid or unsupported
+     */
+    virtual uint32_t addDictionary(const std::string& content) const;
+
+    /**
+     * @brief Check whether a dictionary is registered
+     * @param dictionaryId Dictionary id
+     * @return true if the dictionary can be used
+     */
+    virtual bool hasDictionary(uint32_t dictionaryId) const;
+
+    /**
+     * @brief Train a dictionary from sample contents
+     * @param samples Representative small objects
+     * @param maxSize Maximum dictionary size in bytes
+     * @return Dictionary bytes, empty string if training failed or is unsupported
+     */
+    virtual std::string trainDictionary(const std::vector<std::string>& samples,
+                                        size_t maxSize) const;
+
+    /**
+     * @brief Look up a codec compiled into the library
+     * @param id Codec identifier
+     * @return Codec, or nullptr if it is not available in this build
+     */
+    static const Codec* find(CodecId id);
+
+    /**
+     * @brief Look up a codec by configuration name
+     * @param name Codec name ("none", "zlib" or "zstd")
+     * @return Codec, or nullptr if unknown or not available in this build
+     */
+    static const Codec* find(const std::string& name);
+
+    /**
+     * @brief List the codecs available in this build
+     * @return Available codecs
+     */
+    static std::vector<const Codec*> available();
+};
+
+} // namespace mimirion
@@ -1,10 +1,12 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <filesystem>
 #include <chrono>
+#include <memory_resource>
 
 /**
  * @file commit.hpp
@@ -21,6 +23,9 @@ namespace mimirion {
 
 namespace fs = std::filesystem;
 
+class Arena;
+class ObjectStore;
+
 /**
  * @struct CommitInfo
  * @brief Structure containing all data for a single commit
@@ -38,6 +43,32 @@ struct CommitInfo {
     std::unordered_map<std::string, std::string> fileHashes; /**< Map of file paths to their content hashes */
 };
 
+/**
+ * @struct CommitRecord
+ * @brief A commit read into arena memory
+ *
+ * The text fields are views into the record's copy of the stored object,
+ * and everything the record allocates comes from the arena it is built on.
+ * History walks read one commit after another into the same arena,
+ * releasing it in between, instead of building a CommitInfo per commit.
+ */
+struct CommitRecord {
+    /**
+     * @brief Create an empty record
+     * @param arena Arena all of the record's memory comes from
+     */
+    explicit CommitRecord(Arena& arena);
+
+    std::pmr::string hash;          /**< Hash the commit was read by */
+    std::pmr::string content;       /**< The commit object as stored */
+    std::string_view message;       /**< Commit message, without trailing newlines */
+    std::string_view author;        /**< Name of the commit author */
+    std::string_view email;         /**< Email of the commit author */
+    std::chrono::system_clock::time_point timestamp; /**< Time when the commit was created */
+    std::pmr::vector<std::string_view> parentHashes; /**< Hashes of parent commits */
+    std::pmr::vector<std::pair<std::string_view, std::string_view>> files; /**< File paths and their content hashes */
+};
+
 /**
  * @class CommitManager
  * @brief Class responsible for managing commits in a Mimirion repository
@@ -67,6 +98,29 @@ public:
     std::string createCommit(const std::string& message, 
                            const std::vector<std::string>& stagedFiles);
     
+    /**
+     * @brief Name a fully described commit without storing it
+     *
+     * Used to replay existing history: the caller supplies the author,
+     * time, parents and files, and the commit gets its hash from them.
+     * Trailing newlines are stripped from the message first.
+     *
+     * @param commit Commit to name; its message is normalized and its hash set
+     * @return The commit hash
+     */
+    std::string hashCommit(CommitInfo& commit) const;
+
+    /**
+     * @brief Store a commit named by hashCommit without moving any branch
+     *
+     * Different commits may be stored from several threads at once.
+     *
+     * @param commit Commit to store
+     * @param objects Object store of this repository to write to
+     * @return true if successful, false otherwise
+     */
+    bool storeCommit(const CommitInfo& commit, ObjectStore& objects) const;
+    
     /**
      * @brief Get a commit by its hash
      * @param hash Commit hash
@@ -74,6 +128,44 @@ public:
      */
     CommitInfo* getCommit(const std::string& hash);
     
+    /**
+     * @brief Read a commit without keeping it in this manager's cache
+     *
+     * For walks over long histories, where getCommit would end up holding
+     * every commit in memory.
+     *
+     * @param hash Commit hash
+     * @param commit Receives the commit
+     * @return true if the commit was found, false otherwise
+     */
+    bool readCommit(const std::string& hash, CommitInfo& commit) const;
+
+    /**
+     * @brief Read a commit into arena memory
+     *
+     * Reuses the caller's object store, so a walk opens the packs once
+     * rather than once per commit.
+     *
+     * @param hash Commit hash
+     * @param objects Object store of this repository to read from
+     * @param commit Receives the commit; its previous contents are replaced
+     * @return true if the commit was found, false otherwise
+     */
+    bool readCommit(const std::string& hash, ObjectStore& objects, CommitRecord& commit) const;
+
+    /**
+     * @brief Check that a stored commit matches the hash it is named by
+     *
+     * The commit is parsed, written out again and hashed. Commits made
+     * before snapshots were named by their file list hashed a placeholder
+     * tree line, and are accepted in that form as well.
+     *
+     * @param hash Hash the commit is stored under
+     * @param content Stored commit object
+     * @return true if the content is a well-formed commit with this hash
+     */
+    bool verifyCommit(const std::string& hash, const std::string& content) const;
+    
     /**
      * @brief Get the current HEAD commit
      * @return CommitInfo object if found, nullptr otherwise
@@ -105,9 +197,12 @@ private:
     std::string currentHead;
     std::unordered_map<std::string, CommitInfo> commits;
     
-    std::string generateCommitHash(const CommitInfo& commit) const;
+    std::string generateCommitHash(const CommitInfo& commit, bool placeholderTree = false) const;
     bool saveCommitObject(const CommitInfo& commit) const;
+    std::string serializeCommit(const CommitInfo& commit) const;
     CommitInfo loadCommitObject(const std::string& hash) const;
+    CommitInfo parseCommitObject(const std::string& hash, const std::string& content) const;
+    void loadIdentity(std::string& name, std::string& email) const;
 };
 
 } // namespace mimirion
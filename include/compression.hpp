@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+/**
+ * @file compression.hpp
+ * @brief Streaming zlib compression for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the Compressor and Decompressor classes. Both stream
+ * their output to a sink callback in chunks, reuse one zlib context per
+ * thread instead of allocating a new one for every object, and offer
+ * one-shot helpers that size their output buffer up front.
+ */
+
+namespace mimirion {
+
+/** @brief zlib stream plus output buffer, defined in compression.cpp */
+struct ZlibContext;
+
+/**
+ * @enum CompressionLevel
+ * @brief Speed/size trade-off of a compressor
+ */
+enum class CompressionLevel {
+    FAST,    /**< Fastest compression, used for loose objects */
+    DEFAULT, /**< zlib's default balance */
+    BEST     /**< Smallest output, used for long-lived packed data */
+};
+
+/**
+ * @enum CompressionFormat
+ * @brief Framing around the deflate stream
+ */
+enum class CompressionFormat {
+    ZLIB, /**< zlib header and Adler-32 trailer, used for objects */
+    GZIP, /**< gzip member, as in .tar.gz files */
+    RAW   /**< Bare deflate data, as in zip entries */
+};
+
+/**
+ * @brief Receives output chunks from a Compressor or Decompressor
+ *
+ * The data pointer refers to an internal buffer and is only valid during
+ * the call. Return false to abort the stream.
+ */
+using CompressionSink = std::function<bool(const char* data, size_t size)>;
+
+/**
+ * @class Compressor
+ * @brief Streaming zlib deflater with a per-thread reusable context
+ *
+ * The first Compressor of a given level and format on a thread takes that
+ * thread's cached z_stream and resets it when done, so repeated compressions
+ * do not pay for deflateInit. Nested or concurrent compressors on the same thread
+ * fall back to a private context. A Compressor must be destroyed on the
+ * thread that created it.
+ */
+class Compressor {
+public:
+    /**
+     * @brief Create a compressor
+     * @param level Compression level
+     * @param format Framing of the output
+     */
+    explicit Compressor(CompressionLevel level = CompressionLevel::DEFAULT,
+                        CompressionFormat format = CompressionFormat::ZLIB);
+
+    /**
+     * @brief Destructor, returns the context to the thread cache
+     */
+    ~Compressor();
+
+    Compressor(const Compressor&) = delete;
+    Compressor& operator=(const Compressor&) = delete;
+
+    /**
+     * @brief Compress a chunk of input
+     * @param data Input bytes
+     * @param size Number of input bytes
+     * @param sink Receives compressed output as it becomes available
+     * @return true if successful, false on error or if the sink aborted
+     */
+    bool write(const char* data, size_t size, const CompressionSink& sink);
+
+    /**
+     * @brief Flush the remaining output and end the stream
+     * @param sink Receives the final compressed output
+     * @return true if successful, false otherwise
+     */
+    bool finish(const CompressionSink& sink);
+
+    /**
+     * @brief Get the number of input bytes consumed so far
+     * @return Input byte count
+     */
+    uint64_t totalIn() const;
+
+    /**
+     * @brief Get the number of compressed bytes produced so far
+     * @return Output byte count
+     */
+    uint64_t totalOut() const;
+
+    /**
+     * @brief Compress a buffer in one call
+     *
+     * The output is allocated once at its worst-case size and compressed in
+     * a single pass, then trimmed.
+     *
+     * @param data Input bytes
+     * @param out Receives the compressed bytes
+     * @param level Compression level
+     * @return true if successful, false otherwise
+     */
+    static bool compress(std::string_view data, std::string& out,
+                         CompressionLevel level = CompressionLevel::DEFAULT);
+
+private:
+    ZlibContext* context;
+    bool owned;
+    bool ok;
+
+    bool pump(int flush, const CompressionSink& sink);
+};
+
+/**
+ * @class Decompressor
+ * @brief Streaming zlib inflater with a per-thread reusable context
+ *
+ * Context reuse follows the same rules as Compressor.
+ */
+class Decompressor {
+public:
+    /**
+     * @brief Create a decompressor
+     */
+    Decompressor();
+
+    /**
+     * @brief Destructor, returns the context to the thread cache
+     */
+    ~Decompressor();
+
+    Decompressor(const Decompressor&) = delete;
+    Decompressor& operator=(const Decompressor&) = delete;
+
+    /**
+     * @brief Decompress a chunk of input
+     * @param data Compressed bytes
+     * @param size Number of compressed bytes
+     * @param sink Receives decompressed output as it becomes available
+     * @return true if successful, false on corrupt input or if the sink aborted
+     */
+    bool write(const char* data, size_t size, const CompressionSink& sink);
+
+    /**
+     * @brief Check whether the end of the compressed stream was reached
+     * @return true once the whole stream has been decoded
+     */
+    bool finished() const;
+
+    /**
+     * @brief Decompress a buffer in one call
+     * @param data Compressed bytes
+     * @param out Receives the decompressed bytes
+     * @param sizeHint Expected decompressed size, 0 if unknown; an exact hint
+     *        lets the data be inflated straight into its final buffer
+     * @return true if the input was one complete zlib stream, false otherwise
+     */
+    static bool decompress(std::string_view data, std::string& out, size_t sizeHint = 0);
+
+    /**
+     * @brief Decompress a zlib stream embedded at the start of a buffer
+     *
+     * Unlike decompress, bytes after the end of the stream are allowed and
+     * left alone, as in container formats that store streams back to back
+     * without their compressed lengths.
+     *
+     * @param data Buffer starting with a zlib stream
+     * @param out Receives the decompressed bytes
+     * @param size Exact decompressed size
+     * @param consumed If not null, receives the compressed length of the stream
+     * @return true if a complete stream of exactly size bytes was decoded
+     */
+    static bool decompressPrefix(std::string_view data, std::string& out, size_t size,
+                                 size_t* consumed = nullptr);
+
+    /**
+     * @brief Check whether data starts with a zlib stream header
+     * @param data Bytes to inspect
+     * @return true if the first two bytes form a valid zlib header
+     */
+    static bool looksCompressed(std::string_view data);
+
+private:
+    ZlibContext* context;
+    bool owned;
+    bool ok;
+    bool done;
+};
+
+} // namespace mimirion
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @file config.hpp
+ * @brief Layered configuration for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the Config class, the single place where repository,
+ * user and system settings are read and written. Settings are parsed once
+ * per process into an immutable snapshot that every subsystem shares.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @class Config
+ * @brief Immutable snapshot of the merged configuration scopes
+ *
+ * Configuration files use an INI-like syntax:
+ * @code
+ * [user]
+ *     name = Jane Doe
+ *     email = jane@example.com
+ * [remote "origin"]
+ *     url = https://github.com/jane/project.git
+ * @endcode
+ * Keys are addressed as `section.key` or `section.subsection.key`, e.g.
+ * `remote.origin.url`. Section and key names are case-insensitive,
+ * subsection names are not. Lines starting with '#' or ';' are comments.
+ *
+ * Scopes are read in the order system, user, repository; later scopes
+ * override earlier ones. The system file is /etc/mimirionconfig and the
+ * user file is ~/.mimirionconfig; both can be redirected with the
+ * MIMIRION_CONFIG_SYSTEM and MIMIRION_CONFIG_GLOBAL environment variables.
+ * The repository file is .mimirion/config/settings.
+ */
+class Config {
+public:
+    /**
+     * @enum Scope
+     * @brief Configuration file a value is read from or written to
+     */
+    enum class Scope {
+        SYSTEM,     /**< Machine-wide settings */
+        USER,       /**< Settings of the current user */
+        REPOSITORY  /**< Settings of one repository */
+    };
+
+    /**
+     * @brief Get the configuration snapshot for a repository
+     *
+     * The snapshot is built once per process and reused until one of the
+     * configuration files changes. With useCache the parsed form is also
+     * stored in .mimirion/config/settings.cache, keyed by the modification
+     * times and sizes of the source files, so later processes skip parsing.
+     *
+     * @param mimirionDir Path to the repository's .mimirion directory, may be
+     *        empty to read only the system and user scopes
+     * @param useCache Whether to read and write the binary cache
+     * @return Shared immutable snapshot
+     */
+    static std::shared_ptr<const Config> load(const fs::path& mimirionDir, bool useCache = true);
+
+    /**
+     * @brief Parse configuration text into a snapshot
+     * @param text Configuration file contents
+     * @return Snapshot containing the parsed values
+     */
+    static std::shared_ptr<const Config> parse(const std::string& text);
+
+    /**
+     * @brief Get the path of a scope's configuration file
+     * @param mimirionDir Path to the repository's .mimirion directory
+     * @param scope Configuration scope
+     * @return Path to the file (which may not exist)
+     */
+    static fs::path scopePath(const fs::path& mimirionDir, Scope scope);
+
+    /**
+     * @brief Set a value in one scope and invalidate cached snapshots
+     * @param mimirionDir Path to the repository's .mimirion directory
+     * @param scope Scope to write to
+     * @param key Key such as "user.name"
+     * @param value New value
+     * @return true if successful, false otherwise
+     */
+    static bool set(const fs::path& mimirionDir, Scope scope,
+                    const std::string& key, const std::string& value);
+
+    /**
+     * @brief Remove a value from one scope
+     * @param mimirionDir Path to the repository's .mimirion directory
+     * @param scope Scope to write to
+     * @param key Key to remove
+     * @return true if successful, false otherwise
+     */
+    static bool unset(const fs::path& mimirionDir, Scope scope, const std::string& key);
+
+    /**
+     * @brief Rewrite one scope through a callback
+     *
+     * The callback receives every value of the scope keyed by normalized
+     * name and may change it freely; the result replaces the file.
+     *
+     * @param mimirionDir Path to the repository's .mimirion directory
+     * @param scope Scope to write to
+     * @param editor Function that modifies the values
+     * @return true if successful, false otherwise
+     */
+    static bool edit(const fs::path& mimirionDir, Scope scope,
+                     const std::function<void(std::map<std::string, std::string>&)>& editor);
+
+    /**
+     * @brief Drop every snapshot held by this process
+     */
+    static void invalidate();
+
+    /**
+     * @brief Normalize a key: lowercase section and name, keep the subsection
+     * @param key Key as written by the user
+     * @return Normalized key, empty string if the key is malformed
+     */
+    static std::string normalizeKey(const std::string& key);
+
+    /**
+     * @brief Get a raw value
+     * @param key Key such as "user.name"
+     * @return Value, or std::nullopt if unset
+     */
+    std::optional<std::string> get(const std::string& key) const;
+
+    /**
+     * @brief Get a string value
+     * @param key Key to look up
+     * @param defaultValue Value returned when the key is unset
+     * @return Configured or default value
+     */
+    std::string getString(const std::string& key, const std::string& defaultValue = "") const;
+
+    /**
+     * @brief Get a boolean value (true/yes/on/1 or false/no/off/0)
+     * @param key Key to look up
+     * @param defaultValue Value returned when the key is unset or invalid
+     * @return Configured or default value
+     */
+    bool getBool(const std::string& key, bool defaultValue = false) const;
+
+    /**
+     * @brief Get an integer value, accepting k/m/g suffixes
+     * @param key Key to look up
+     * @param defaultValue Value returned when the key is unset or invalid
+     * @return Configured or default value
+     */
+    int64_t getInt(const std::string& key, int64_t defaultValue = 0) const;
+
+    /**
+     * @brief List the subsections of a section, e.g. remote names
+     * @param section Section name such as "remote"
+     * @return Sorted subsection names
+     */
+    std::vector<std::string> getSubsections(const std::string& section) const;
+
+    /**
+     * @brief Get every value in the snapshot
+     * @return Map of normalized keys to values
+     */
+    const std::map<std::string, std::string>& entries() const;
+
+private:
+    std::map<std::string, std::string> values;
+
+    static void parseInto(const std::string& text, std::map<std::string, std::string>& values);
+    static std::string serialize(const std::map<std::string, std::string>& values);
+};
+
+} // namespace mimirion
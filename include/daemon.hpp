@@ -0,0 +1,129 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <atomic>
+#include <unordered_map>
+#include "repository.hpp"
+
+/**
+ * @file daemon.hpp
+ * @brief Per-repository background daemon for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the definitions for the Daemon class, which keeps a
+ * loaded repository in memory and answers CLI requests over a Unix socket,
+ * and the DaemonClient helper used by the CLI to forward commands to it.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @class Daemon
+ * @brief Long-running server that keeps repository state hot in memory
+ *
+ * The daemon loads the repository once and serves read-only commands
+ * (currently `status`) over a Unix socket at .mimirion/daemon.sock.
+ * Before every request it checks the modification times of HEAD and the
+ * configuration files and reloads the repository only when they changed.
+ *
+ * Wire format: every message is a 4-byte big-endian length followed by
+ * the payload. Requests carry the command arguments separated by NUL
+ * bytes; responses carry a 4-byte big-endian exit code followed by the
+ * command output.
+ */
+class Daemon {
+public:
+    /** @brief Seconds a client may stall before the daemon drops it; clients are served one at a time */
+    static constexpr int kConnectionTimeout = 2;
+
+    /**
+     * @brief Constructor for Daemon
+     * @param repoPath Path to the repository root directory
+     * @param mimirionDir Path to the repository's .mimirion directory
+     */
+    Daemon(const fs::path& repoPath, const fs::path& mimirionDir);
+
+    /**
+     * @brief Destructor, closes and removes the socket
+     */
+    ~Daemon();
+
+    Daemon(const Daemon&) = delete;
+    Daemon& operator=(const Daemon&) = delete;
+
+    /**
+     * @brief Load the repository and bind the listening socket
+     *
+     * Fails if another daemon is already serving this repository. A stale
+     * socket left behind by a crashed daemon is removed.
+     *
+     * @return true if the daemon is ready to serve, false otherwise
+     */
+    bool start();
+
+    /**
+     * @brief Serve requests until stop() is called or a shutdown request arrives
+     */
+    void serve();
+
+    /**
+     * @brief Ask the serving loop to exit
+     *
+     * Safe to call from another thread or from a signal handler.
+     */
+    void stop();
+
+    /**
+     * @brief Get the socket path used for a repository
+     * @param mimirionDir Path to the repository's .mimirion directory
+     * @return Path of the daemon's Unix socket
+     */
+    static fs::path socketPath(const fs::path& mimirionDir);
+
+private:
+    fs::path repositoryPath;
+    fs::path mimirionDir;
+    Repository repository;
+    std::unordered_map<std::string, fs::file_time_type> stamps;
+    int listenFd;
+    std::atomic<bool> running;
+
+    bool refreshIfStale();
+    std::string handleRequest(const std::vector<std::string>& args, int& exitCode);
+    void handleConnection(int clientFd);
+};
+
+/**
+ * @brief Client side of the daemon protocol used by the CLI
+ */
+class DaemonClient {
+public:
+    /**
+     * @brief Forward a command to the repository's daemon
+     *
+     * Returns false without side effects if no daemon is running, so the
+     * caller can fall back to in-process execution.
+     *
+     * @param mimirionDir Path to the repository's .mimirion directory
+     * @param args Command arguments, e.g. {"status"}
+     * @param output Receives the command output
+     * @param exitCode Receives the command exit code
+     * @return true if the daemon handled the command, false otherwise
+     */
+    static bool forward(const fs::path& mimirionDir, const std::vector<std::string>& args,
+                        std::string& output, int& exitCode);
+
+    /**
+     * @brief Check whether a daemon is serving the repository
+     * @param mimirionDir Path to the repository's .mimirion directory
+     * @return true if the daemon answered a ping, false otherwise
+     */
+    static bool isRunning(const fs::path& mimirionDir);
+};
+
+} // namespace mimirion
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <filesystem>
 
@@ -45,7 +46,7 @@ public:
      * @param contextLines Number of context lines to include (default: 3)
      * @return FileDiff object representing the differences
      */
-    FileDiff generateDiffFromStrings(const std::string& oldContent, const std::string& newContent, 
+    FileDiff generateDiffFromStrings(std::string_view oldContent, std::string_view newContent, 
                                  int contextLines = 3) const;
     
     /**
@@ -71,7 +72,7 @@ public:
     FileDiff parseDiff(const std::string& diffStr) const;
 
 private:
-    std::vector<std::string> splitLines(const std::string& content) const;
+    std::vector<std::string> splitLines(std::string_view content) const;
     std::vector<DiffHunk> computeHunks(const std::vector<std::string>& oldLines, 
                                       const std::vector<std::string>& newLines, 
                                       int contextLines) const;
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @file fast_export.hpp
+ * @brief Streaming history export for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the FastExporter class, which writes a range of
+ * history as a fast-import stream.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @struct FastExportStats
+ * @brief Counts reported by an export
+ */
+struct FastExportStats {
+    size_t blobs = 0;   /**< Blob records written */
+    size_t commits = 0; /**< Commit records written */
+    size_t refs = 0;    /**< Refs set at the end of the stream */
+};
+
+/**
+ * @class FastExporter
+ * @brief Writes commits, blobs and ref updates in the format FastImporter reads
+ *
+ * Revisions select the range: a branch, tag, full ref or HEAD adds the
+ * history it reaches, `^<rev>` removes the history reachable from a
+ * revision, and `<a>..<b>` is `^<a> <b>`. Without revisions every branch
+ * and tag is exported. Positive revisions have to name refs, as they
+ * are the refs the stream sets.
+ *
+ * Commits are written parents first, straight from a depth-first walk:
+ * only the ids of visited commits and the current path are held, and
+ * each commit is read in full once, when it is written. A commit lists
+ * its changes against its first parent with `M` and `D`. Each blob is
+ * written once, before the first commit using it, and later referenced
+ * by its mark. Parents outside the range are named by hash. Commit
+ * hashes depend only on commit content, so importing a stream gives the
+ * same hashes, and `a..b` streams extend a copy that already holds `a`.
+ * At the end, a `reset` record sets every exported ref.
+ */
+class FastExporter {
+public:
+    /**
+     * @brief Constructor for FastExporter
+     * @param repoPath Path to the repository root
+     * @param mimirionDir Path to the .mimirion directory
+     */
+    FastExporter(const fs::path& repoPath, const fs::path& mimirionDir);
+
+    /**
+     * @brief Export a range of history
+     * @param revisions Revisions selecting the range, empty for all refs
+     * @param out Stream to write to
+     * @param stats If not null, receives what was written
+     * @return true if successful, false if a revision is unknown, an
+     *         object could not be read or the stream failed
+     */
+    bool run(const std::vector<std::string>& revisions, std::ostream& out, FastExportStats* stats = nullptr);
+
+private:
+    fs::path repositoryPath;
+    fs::path mimirionDir;
+};
+
+} // namespace mimirion
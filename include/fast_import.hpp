@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @file fast_import.hpp
+ * @brief Streaming commit ingestion for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the FastImporter class, which builds commits from a
+ * stream of blob, commit and ref records without going through the
+ * working tree or the index.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @struct FastImportStats
+ * @brief Counts reported by a stream import
+ */
+struct FastImportStats {
+    size_t blobs = 0;   /**< Blobs stored */
+    size_t commits = 0; /**< Commits stored */
+    size_t refs = 0;    /**< Refs written */
+};
+
+/**
+ * @class FastImporter
+ * @brief Reads a fast-import stream and writes its objects directly
+ *
+ * The stream is a line-oriented subset of Git's fast-import format:
+ *
+ *     blob
+ *     mark :<n>
+ *     data <size>
+ *     <size bytes>
+ *
+ *     commit <ref>
+ *     mark :<n>
+ *     author <name> <<email>> <seconds> <zone>
+ *     committer <name> <<email>> <seconds> <zone>
+ *     data <size>
+ *     <message>
+ *     from <commit>
+ *     merge <commit>
+ *     deleteall
+ *     M <mode> <:mark | hash | inline> <path>
+ *     D <path>
+ *
+ *     reset <ref>
+ *     from <commit>
+ *
+ *     checkpoint
+ *     done
+ *
+ * `mark`, `author`, `from`, `merge` and the file commands are optional.
+ * `data <<<delimiter>` reads up to a line holding only the delimiter, and
+ * a `data` record may be followed by one empty line. Blank lines and lines
+ * starting with '#' between records are ignored. A commit is named
+ * `:<mark>`, by a hash or by a ref; a ref without "refs/" is a branch.
+ * A commit without `from` continues its ref, from where the stream last
+ * left it or from the repository's value. It gets the author's identity
+ * and time, or the committer's if there is no author; zones are ignored.
+ * Paths may be C-quoted. `D` removes a file or a whole directory. `reset`
+ * without `from` makes the ref's next commit a root commit.
+ *
+ * Marks are held in memory and may be loaded from and saved to a marks
+ * file of `:<n> <hash>` lines. Objects are hashed as they arrive and
+ * written in batches on the task scheduler. At a `checkpoint` and at the
+ * end, every batch is flushed, the object store is synced and then the
+ * refs are written. The working tree, the index and HEAD are not touched.
+ */
+class FastImporter {
+public:
+    /** @brief Content bytes buffered before a batch is written */
+    static constexpr size_t kBatchBytes = 64 * 1024 * 1024;
+
+    /** @brief Objects buffered before a batch is written */
+    static constexpr size_t kBatchObjects = 4096;
+
+    /**
+     * @brief Constructor for FastImporter
+     * @param repoPath Path to the repository root
+     * @param mimirionDir Path to the .mimirion directory
+     */
+    FastImporter(const fs::path& repoPath, const fs::path& mimirionDir);
+
+    /**
+     * @brief Load marks saved by an earlier import
+     * @param path Marks file
+     * @return true if the file was read, false otherwise
+     */
+    bool importMarks(const fs::path& path);
+
+    /**
+     * @brief Save the marks known so far
+     * @param path Marks file, replaced atomically
+     * @return true if successful, false otherwise
+     */
+    bool exportMarks(const fs::path& path) const;
+
+    /**
+     * @brief Import a stream
+     *
+     * On a malformed record the import stops with a message naming its
+     * line. Objects already written stay in the store; refs are only
+     * updated at checkpoints, so no ref points at an incomplete import.
+     *
+     * @param in Stream to read
+     * @param stats If not null, receives what was imported
+     * @return true if the whole stream was imported, false otherwise
+     */
+    bool run(std::istream& in, FastImportStats* stats = nullptr);
+
+private:
+    fs::path repositoryPath;
+    fs::path mimirionDir;
+    std::unordered_map<uint64_t, std::string> marks;
+};
+
+} // namespace mimirion
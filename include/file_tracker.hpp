@@ -4,6 +4,11 @@
 #include <vector>
 #include <unordered_map>
 #include <filesystem>
+#include <cstdint>
+#include <memory>
+#include "scanner.hpp"
+#include "filter.hpp"
+#include "ignore.hpp"
 
 /**
  * @file file_tracker.hpp
@@ -38,12 +43,23 @@ enum class FileStatus {
  * This structure holds all relevant metadata about a file being tracked
  * by the version control system, including its path, content hashes,
  * and current status.
+ *
+ * The size and modification time record the file as it was when hash was
+ * computed. While both still match the file on disk, the hash and the
+ * content facts next to it are reused instead of reading the file again.
+ * For paths with clean filters, the hash and content facts describe the
+ * cleaned content, as it would be stored.
  */
 struct FileInfo {
     std::string path;          /**< Relative path to the file from repository root */
     std::string hash;          /**< Hash of the file's current content */
     std::string lastCommitHash; /**< Hash of the file's content at last commit */
     FileStatus status;         /**< Current status of the file */
+    uint64_t size = 0;         /**< Size of the file when it was hashed */
+    int64_t mtime = 0;         /**< Modification time when it was hashed, 0 if unknown */
+    bool binary = false;       /**< Whether the content looks binary */
+    uint64_t lineCount = 0;    /**< Number of lines in the content */
+    NewlineStyle newlines = NewlineStyle::NONE; /**< Line ending convention of the content */
 };
 
 /**
@@ -78,6 +94,24 @@ public:
      */
     bool unstageFile(const std::string& path);
     
+    /**
+     * @brief Get the status of a single file
+     * 
+     * Compares the working tree copy of the file against the index without
+     * scanning the rest of the repository.
+     * 
+     * @param path Path to the file relative to the repository root
+     * @return Current status of the file (UNTRACKED if it is not in the index)
+     */
+    FileStatus getFileStatus(const std::string& path) const;
+    
+    /**
+     * @brief Check if a file is in the index
+     * @param path Path to the file relative to the repository root
+     * @return true if the file is tracked or staged, false otherwise
+     */
+    bool isTracked(const std::string& path) const;
+    
     /**
      * @brief Get a list of staged files
      * @return Vector of FileInfo objects
@@ -100,10 +134,14 @@ private:
     fs::path repositoryPath;
     fs::path mimirionDir;
     std::unordered_map<std::string, FileInfo> files;
+    int64_t indexTime = 0;
+    std::shared_ptr<FilterPipeline> filters;
+    IgnoreRules ignoreRules;
     
-    std::string calculateFileHash(const fs::path& filePath) const;
+    std::string calculateFileHash(const fs::path& filePath, const FileInfo* cached = nullptr) const;
+    bool scanFile(const fs::path& filePath, FileInfo& file, const FileInfo* cached) const;
     void updateFileStatus(FileInfo& file);
-    bool isIgnored(const fs::path& path) const;
+    bool isIgnored(const fs::path& path, bool directory) const;
 };
 
 } // namespace mimirion
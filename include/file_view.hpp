@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+/**
+ * @file file_view.hpp
+ * @brief Read-only views of file contents for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the FileView class, which gives read-only access to a
+ * whole file without copying it into a std::string. Large regular files are
+ * memory-mapped; small files and special files are read into a buffer.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @class FileView
+ * @brief Read-only, memory-mapped view of a file's contents
+ *
+ * Mapping only pays off once a file spans several pages, so files smaller
+ * than kMapThreshold, and files that cannot be mapped such as pipes or
+ * procfs entries, are read into an owned buffer instead. Either way the
+ * contents are exposed as one contiguous range that stays valid until the
+ * view is closed, moved from or destroyed. A mapped file that is truncated
+ * by another process while mapped can raise SIGBUS on access, as with any
+ * mmap-based reader.
+ */
+class FileView {
+public:
+    /**
+     * @enum Advice
+     * @brief Expected access pattern, passed to madvise for mapped files
+     */
+    enum class Advice {
+        NORMAL,     /**< No particular pattern */
+        SEQUENTIAL, /**< Read front to back once; aggressive read-ahead */
+        RANDOM,     /**< Scattered reads; no read-ahead */
+        WILL_NEED   /**< Start reading the whole range in now */
+    };
+
+    /** @brief Files smaller than this are read instead of mapped */
+    static constexpr size_t kMapThreshold = 64 * 1024;
+
+    /**
+     * @brief Create a closed view
+     */
+    FileView();
+
+    /**
+     * @brief Open a view of a file
+     * @param path File to view
+     * @param advice Expected access pattern
+     */
+    explicit FileView(const fs::path& path, Advice advice = Advice::SEQUENTIAL);
+
+    ~FileView();
+
+    FileView(FileView&& other) noexcept;
+    FileView& operator=(FileView&& other) noexcept;
+    FileView(const FileView&) = delete;
+    FileView& operator=(const FileView&) = delete;
+
+    /**
+     * @brief Open a view of a file, closing any current one
+     * @param path File to view
+     * @param advice Expected access pattern
+     * @return true if successful, false if the file could not be read
+     */
+    bool open(const fs::path& path, Advice advice = Advice::SEQUENTIAL);
+
+    /**
+     * @brief Release the mapping or buffer
+     */
+    void close();
+
+    /**
+     * @brief Check whether a file is open
+     * @return true if open() succeeded and the view has not been closed
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Check whether the contents are memory-mapped
+     * @return true if mapped, false if read into a buffer or closed
+     */
+    bool isMapped() const;
+
+    /**
+     * @brief Get a pointer to the contents
+     * @return Pointer to the first byte; not NUL terminated
+     */
+    const char* data() const;
+
+    /**
+     * @brief Get the size of the contents
+     * @return Size in bytes
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the contents
+     * @return View of the whole file
+     */
+    std::string_view view() const;
+
+    /**
+     * @brief Get part of the contents
+     * @param offset Start of the range, clamped to the size
+     * @param length Length of the range, clamped to the end
+     * @return View of the range
+     */
+    std::string_view view(size_t offset, size_t length) const;
+
+    /**
+     * @brief Give the kernel a hint about upcoming accesses
+     *
+     * Has no effect on buffered views.
+     *
+     * @param advice Expected access pattern
+     * @param offset Start of the range the hint applies to
+     * @param length Length of the range, 0 for the rest of the file
+     */
+    void advise(Advice advice, size_t offset = 0, size_t length = 0) const;
+
+private:
+    const char* contents;
+    size_t length;
+    bool mapped;
+    bool opened;
+    std::string buffer;
+
+    bool readAll(int fd, size_t sizeHint);
+};
+
+} // namespace mimirion
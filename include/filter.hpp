@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "attributes.hpp"
+#include "compression.hpp"
+
+/**
+ * @file filter.hpp
+ * @brief Clean and smudge content filters for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the streaming filter pipeline that transforms file
+ * content between the working tree and the object store: line ending
+ * normalization, keyword expansion and external filter processes.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+class FilterProcess;
+
+/**
+ * @enum FilterDirection
+ * @brief Which way content flows through a filter
+ */
+enum class FilterDirection {
+    CLEAN,  /**< Working tree to object store, when adding or hashing */
+    SMUDGE  /**< Object store to working tree, on checkout */
+};
+
+/**
+ * @class FilterStage
+ * @brief One transformation in a filter chain
+ *
+ * Stages receive content in arbitrary pieces and pass their output on to
+ * the next stage's sink. A stage that needs to look ahead, for example at
+ * a CR that may be followed by an LF, holds back only the undecided bytes.
+ */
+class FilterStage {
+public:
+    virtual ~FilterStage() = default;
+
+    /**
+     * @brief Filter the next piece of content
+     * @param data Input bytes
+     * @param size Number of input bytes
+     * @param next Receives the output
+     * @return true if successful, false on error or if next aborted
+     */
+    virtual bool write(const char* data, size_t size, const CompressionSink& next) = 0;
+
+    /**
+     * @brief End the content and flush any held back output
+     * @param next Receives the remaining output
+     * @return true if successful, false otherwise
+     */
+    virtual bool finish(const CompressionSink& next) = 0;
+};
+
+/**
+ * @class FilterChain
+ * @brief The stages that apply to one path, connected to an output sink
+ */
+class FilterChain {
+public:
+    /**
+     * @brief Connect stages to an output
+     * @param stages Stages in the order content passes through them
+     * @param output Receives the filtered content
+     */
+    FilterChain(std::vector<std::unique_ptr<FilterStage>> stages, CompressionSink output);
+
+    FilterChain(const FilterChain&) = delete;
+    FilterChain& operator=(const FilterChain&) = delete;
+
+    /**
+     * @brief Filter the next piece of content
+     * @param data Input bytes
+     * @param size Number of input bytes
+     * @return true if successful, false otherwise
+     */
+    bool write(const char* data, size_t size);
+
+    /**
+     * @brief End the content, finishing each stage in turn
+     * @return true if successful, false otherwise
+     */
+    bool finish();
+
+    /**
+     * @brief Check whether content passes through unchanged
+     * @return true if the chain has no stages
+     */
+    bool empty() const;
+
+private:
+    std::vector<std::unique_ptr<FilterStage>> stages;
+    std::vector<CompressionSink> sinks;
+};
+
+/**
+ * @class FilterPipeline
+ * @brief Builds filter chains for paths from their attributes
+ *
+ * The attributes of a path select its filters:
+ *
+ * - `text` normalizes CRLF to LF when cleaning; `text=auto` does so only
+ *   for content that does not look binary. `eol=crlf` implies `text` and
+ *   converts LF to CRLF when smudging.
+ * - `ident` collapses `$Id: ... $` to `$Id$` when cleaning and expands
+ *   `$Id$` to `$Id: <object hash> $` when smudging.
+ * - `filter=<driver>` runs the command configured as
+ *   `filter.<driver>.process`. It is started once and then serves every
+ *   file of the pipeline over git's long-running filter protocol, so
+ *   existing git filter processes work unchanged. If the driver is not
+ *   configured, content passes through unless `filter.<driver>.required`
+ *   is set. The lfs driver is handled by LargeFileStore and ignored here.
+ *
+ * Cleaning runs the driver, then line endings, then keywords; smudging
+ * runs them in reverse. A pipeline can be shared between threads; uses of
+ * the same filter process are serialized.
+ */
+class FilterPipeline {
+public:
+    /**
+     * @brief Constructor for FilterPipeline
+     * @param repoPath Path to the repository root
+     * @param mimirionDir Path to the .mimirion directory
+     */
+    FilterPipeline(const fs::path& repoPath, const fs::path& mimirionDir);
+
+    /**
+     * @brief Destructor, stops any filter processes
+     */
+    ~FilterPipeline();
+
+    FilterPipeline(const FilterPipeline&) = delete;
+    FilterPipeline& operator=(const FilterPipeline&) = delete;
+
+    /**
+     * @brief Check whether any filter applies to a path
+     * @param path Path relative to the repository root
+     * @return true if content of the path is transformed
+     */
+    bool hasFilters(const std::string& path) const;
+
+    /**
+     * @brief Build the filter chain for a path
+     * @param path Path relative to the repository root
+     * @param direction Clean or smudge
+     * @param output Receives the filtered content
+     * @param objectHash Object hash for keyword expansion when smudging
+     * @return Chain to write the content to, without stages if no filter
+     *         applies; nullptr if a required filter process is unavailable
+     */
+    std::unique_ptr<FilterChain> open(const std::string& path, FilterDirection direction,
+                                      CompressionSink output,
+                                      const std::string& objectHash = "");
+
+    /**
+     * @brief Clean a working tree file
+     *
+     * The file is viewed through a FileView and fed to the chain in chunks.
+     *
+     * @param file File to read
+     * @param path Path relative to the repository root
+     * @param output Receives the cleaned content
+     * @return true if successful, false otherwise
+     */
+    bool clean(const fs::path& file, const std::string& path, const CompressionSink& output);
+
+    /**
+     * @brief Get the attributes the pipeline was built from
+     * @return Repository attributes
+     */
+    const Attributes& attributes() const;
+
+private:
+    fs::path repositoryPath;
+    fs::path mimirionDir;
+    Attributes rules;
+    std::mutex processMutex;
+    std::map<std::string, std::shared_ptr<FilterProcess>> processes;
+
+    std::shared_ptr<FilterProcess> process(const std::string& driver);
+};
+
+} // namespace mimirion
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+/**
+ * @file fsck.hpp
+ * @brief Repository integrity checks for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the IntegrityChecker class, which verifies the object
+ * store, the refs and the indexes of a repository.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @struct FsckProgress
+ * @brief Where a running check is
+ */
+struct FsckProgress {
+    const char* phase = ""; /**< "Checking packs", "Checking objects", "Checking connectivity" or "Checking indexes" */
+    size_t done = 0;        /**< Items finished in this phase */
+    size_t total = 0;       /**< Items in this phase, 0 if not known yet */
+    uint64_t bytes = 0;     /**< Content bytes read in this phase */
+};
+
+/**
+ * @struct FsckOptions
+ * @brief How to run a check
+ */
+struct FsckOptions {
+    std::chrono::milliseconds budget{0};                  /**< Time limit, 0 for none */
+    std::function<void(const FsckProgress&)> progress;    /**< Called now and then from any thread, if set */
+    bool connectivity = true;                             /**< Walk the history from every ref */
+};
+
+/**
+ * @struct FsckReport
+ * @brief What a check found
+ */
+struct FsckReport {
+    size_t objects = 0;      /**< Objects verified */
+    size_t totalObjects = 0; /**< Objects in the store */
+    uint64_t bytes = 0;      /**< Content bytes verified */
+    size_t commits = 0;      /**< Commits reached from the refs */
+    size_t corrupt = 0;      /**< Objects that could not be read or do not match their name */
+    size_t missing = 0;      /**< Objects referred to but not in any store */
+    size_t badRefs = 0;      /**< Refs that do not name a commit */
+    size_t badIndexEntries = 0; /**< Malformed index entries */
+    size_t dangling = 0;     /**< Sound objects no ref reaches */
+    bool complete = true;    /**< false if the budget ran out first */
+
+    /** @brief Number of problems found */
+    size_t errors() const { return corrupt + missing + badRefs + badIndexEntries; }
+};
+
+/**
+ * @class IntegrityChecker
+ * @brief Verifies objects, connectivity and indexes
+ *
+ * The checksums of every pack and of the bitmap index are verified first.
+ * Then every loose and packed object in this repository's store is decoded
+ * and rehashed in parallel on the task scheduler, in chunks taken in hash
+ * order so reads of loose objects stay within one fan-out directory. A blob must hash to its name; a commit,
+ * whose name is derived from its fields, must parse and rehash to its name
+ * with CommitManager::verifyCommit. Then the history is walked breadth first from every ref and every
+ * worktree's HEAD, reading each level of commits in parallel, and every
+ * parent and file must exist here or in an alternate. Finally the index of
+ * the main worktree and of every linked worktree is parsed: paths must be
+ * relative and unique, and committed content must exist.
+ *
+ * Problems are reported on std::cerr as they are found. With a budget, no
+ * new work starts once it is spent and the report is marked incomplete.
+ */
+class IntegrityChecker {
+public:
+    /** @brief Objects verified per scheduled task */
+    static constexpr size_t kChunkObjects = 64;
+
+    /** @brief Least time between two progress calls */
+    static constexpr std::chrono::milliseconds kProgressInterval{100};
+
+    /**
+     * @brief Constructor for IntegrityChecker
+     * @param repoPath Path to the repository root
+     * @param mimirionDir Path to the .mimirion directory
+     */
+    IntegrityChecker(const fs::path& repoPath, const fs::path& mimirionDir);
+
+    /**
+     * @brief Check the repository
+     * @param options Budget, progress callback and which checks to run
+     * @param report If not null, receives what was found
+     * @return true if the check completed without finding problems
+     */
+    bool run(const FsckOptions& options, FsckReport* report = nullptr);
+
+private:
+    fs::path repositoryPath;
+    fs::path mimirionDir;
+};
+
+} // namespace mimirion
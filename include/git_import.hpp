@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file git_import.hpp
+ * @brief Native import of Git history for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the GitObjectReader class, which reads objects
+ * straight from a Git object database, and the GitImporter class, which
+ * replays a Git repository's history as Mimirion commits.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @enum GitObjectType
+ * @brief Type of a Git object, numbered as in pack files
+ */
+enum class GitObjectType {
+    NONE = 0,   /**< Missing or unreadable */
+    COMMIT = 1, /**< Commit */
+    TREE = 2,   /**< Directory listing */
+    BLOB = 3,   /**< File content */
+    TAG = 4     /**< Annotated tag */
+};
+
+/**
+ * @class GitObjectReader
+ * @brief Reads objects from a Git directory without running git
+ *
+ * Loose objects are inflated from objects/xx/yyyy. Pack files are mapped
+ * together with their version 2 .idx files; objects are found through the
+ * index fan-out and rebuilt from OFS_DELTA and REF_DELTA chains. Objects
+ * that serve as delta bases are kept in a cache bounded by
+ * kBaseCacheBytes, so walking a chain of related versions inflates each
+ * base once. Reads are safe from several threads at once.
+ */
+class GitObjectReader {
+public:
+    /** @brief Most bytes of delta bases kept in memory */
+    static constexpr size_t kBaseCacheBytes = 96 * 1024 * 1024;
+
+    /**
+     * @brief Open the object database of a Git directory
+     * @param gitDir Path to the .git directory, or a bare repository
+     */
+    explicit GitObjectReader(const fs::path& gitDir);
+
+    ~GitObjectReader();
+
+    GitObjectReader(const GitObjectReader&) = delete;
+    GitObjectReader& operator=(const GitObjectReader&) = delete;
+
+    /**
+     * @brief Read an object
+     * @param id 40-character hexadecimal object id
+     * @param type Receives the object type
+     * @param data Receives the object content
+     * @return true if the object was found and is intact
+     */
+    bool read(const std::string& id, GitObjectType& type, std::string& data);
+
+    /**
+     * @brief Number of pack files opened
+     */
+    size_t packCount() const;
+
+    /**
+     * @brief Find the Git directory for a path
+     * @param path A .git directory, a bare repository or a working tree
+     * @return The Git directory, empty if path is none of those
+     */
+    static fs::path findGitDir(const fs::path& path);
+
+private:
+    struct Pack;
+    using Cached = std::pair<GitObjectType, std::shared_ptr<const std::string>>;
+
+    fs::path objectsDir;
+    std::vector<std::unique_ptr<Pack>> packs;
+
+    std::mutex cacheMutex;
+    std::list<std::pair<std::string, Cached>> cacheOrder;
+    std::unordered_map<std::string, std::list<std::pair<std::string, Cached>>::iterator> cache;
+    size_t cacheBytes;
+
+    bool readPacked(size_t pack, uint64_t offset, GitObjectType& type, std::string& data);
+    bool readLoose(const std::string& id, GitObjectType& type, std::string& data) const;
+    bool findPacked(std::string_view rawId, size_t& pack, uint64_t& offset) const;
+    bool lookupBase(const std::string& key, Cached& object);
+    void storeBase(const std::string& key, GitObjectType type, const std::string& data);
+};
+
+/**
+ * @struct GitImportStats
+ * @brief Counts reported by an import
+ */
+struct GitImportStats {
+    size_t commits = 0;  /**< Commits written */
+    size_t blobs = 0;    /**< Blobs converted */
+    size_t refs = 0;     /**< Branches and tags written */
+};
+
+/**
+ * @class GitImporter
+ * @brief Replays the history of a Git repository into a Mimirion repository
+ *
+ * Every commit reachable from the branches, tags and HEAD of the source is
+ * imported, parents first, keeping its author, time and message; tags are
+ * peeled to the commits they name. Commits are taken in batches of up to
+ * kBatchCommits: the batch's trees are flattened into file maps, the blobs
+ * it introduces are converted on the task scheduler, and then its commits
+ * are named in order and stored on the scheduler too. Objects are not synced one by one; the object
+ * store is flushed once before any ref is published.
+ *
+ * The Git id of every imported commit and blob is recorded in
+ * .mimirion/import/git-map, so running the import again only converts
+ * what is new and moves the refs. Branches and tags are overwritten with
+ * their Git values; HEAD follows the source's current branch.
+ */
+class GitImporter {
+public:
+    /** @brief Most commits written per batch */
+    static constexpr size_t kBatchCommits = 512;
+
+    /** @brief Most file entries held per batch */
+    static constexpr size_t kBatchFiles = 1000000;
+
+    /** @brief Most flattened tree entries kept for reuse */
+    static constexpr size_t kTreeCacheEntries = 2000000;
+
+    /**
+     * @brief Constructor for GitImporter
+     * @param repoPath Path to the repository root
+     * @param mimirionDir Path to the .mimirion directory
+     */
+    GitImporter(const fs::path& repoPath, const fs::path& mimirionDir);
+
+    /**
+     * @brief Import a Git repository
+     * @param source A .git directory, a bare repository or a working tree
+     * @param stats If not null, receives what was imported
+     * @return true if successful, false otherwise
+     */
+    bool run(const fs::path& source, GitImportStats* stats = nullptr);
+
+private:
+    fs::path repositoryPath;
+    fs::path mimirionDir;
+};
+
+} // namespace mimirion
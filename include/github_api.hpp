@@ -140,6 +140,13 @@ public:
 private:
     GitHubCredentials credentials;
     CURL* curl;
+    bool curlInitialized;
+    
+    /**
+     * @brief Initialize libcurl and the request handle on first use
+     * @return true if a handle is available, false otherwise
+     */
+    bool ensureHandle();
     
     bool executeRequest(const std::string& url, const std::string& method = "GET",
                       const std::string& data = "", std::string* response = nullptr);
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file grep.hpp
+ * @brief Content search for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the Grep class, which searches the working tree, the
+ * index or a commit for lines matching a pattern, and the LineMatcher it
+ * uses to find matching lines in a buffer.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @enum GrepSource
+ * @brief Which version of the files to search
+ */
+enum class GrepSource {
+    WORKING_TREE, /**< Files as they are on disk */
+    INDEX,        /**< Content as staged or last committed */
+    COMMIT        /**< Snapshot of a commit, read from the object store */
+};
+
+/**
+ * @struct GrepOptions
+ * @brief What to search for and how to report it
+ */
+struct GrepOptions {
+    std::string pattern;                /**< POSIX extended regex, or a literal with fixedStrings */
+    bool fixedStrings = false;          /**< Treat the pattern as a literal string */
+    bool ignoreCase = false;            /**< ASCII case-insensitive matching */
+    bool lineNumbers = false;           /**< Prefix matching lines with their number */
+    bool filesWithMatches = false;      /**< Only list the files that match */
+    bool count = false;                 /**< Only print the number of matching lines per file */
+    GrepSource source = GrepSource::WORKING_TREE; /**< Version of the files to search */
+    std::string revision;               /**< Commit to search, for GrepSource::COMMIT */
+    bool untracked = false;             /**< Also search untracked, not ignored working tree files */
+    std::vector<std::string> paths;     /**< Limit to these directories or patterns, empty for all */
+    bool useIndex = false;              /**< Narrow commit searches with the trigram index */
+};
+
+/**
+ * @class LineMatcher
+ * @brief Finds lines matching a pattern in a buffer
+ *
+ * Buffers are searched as a whole rather than line by line. A literal that
+ * every match must contain is located first: its rarest byte is found with
+ * memchr, which glibc implements with SSE2/AVX2, and the literal is then
+ * compared around each hit. Only lines containing the literal are handed
+ * to the regex engine. Patterns without such a literal, for example
+ * alternations, run the regex over the buffer directly.
+ */
+class LineMatcher {
+public:
+    /**
+     * @brief Compile a matcher
+     * @param options Pattern and matching options
+     * @param error Receives a message if the pattern is invalid
+     * @return Matcher, nullptr if the pattern is invalid
+     */
+    static std::unique_ptr<LineMatcher> create(const GrepOptions& options, std::string& error);
+
+    /**
+     * @brief Destructor
+     */
+    ~LineMatcher();
+
+    LineMatcher(const LineMatcher&) = delete;
+    LineMatcher& operator=(const LineMatcher&) = delete;
+
+    /**
+     * @brief Find the next matching line
+     * @param text Buffer to search
+     * @param offset Start of a line to search from; advanced past the match
+     * @param lineStart Receives the offset of the matching line
+     * @param lineEnd Receives the offset of the line's end, excluding the newline
+     * @return true if a matching line was found
+     */
+    bool next(std::string_view text, size_t& offset, size_t& lineStart, size_t& lineEnd) const;
+
+    /**
+     * @brief Get the literal used to skip non-matching text
+     * @return Required literal, empty if the pattern has none
+     */
+    const std::string& requiredLiteral() const;
+
+    /**
+     * @brief Extract the literals that every match of a regex contains
+     *
+     * Only top-level text outside groups, brackets and optional or repeated
+     * atoms qualifies; patterns with alternation have none.
+     *
+     * @param pattern POSIX extended regex
+     * @return Required literals in pattern order, empty if none were found
+     */
+    static std::vector<std::string> requiredLiterals(const std::string& pattern);
+
+    /**
+     * @brief Extract the longest literal that every match of a regex contains
+     * @param pattern POSIX extended regex
+     * @return Longest of requiredLiterals(), empty if there is none
+     */
+    static std::string extractLiteral(const std::string& pattern);
+
+private:
+    struct Regex;
+
+    std::string literal;
+    size_t rareIndex = 0;
+    bool ignoreCase = false;
+    std::unique_ptr<Regex> regex;
+
+    LineMatcher() = default;
+    size_t findLiteral(std::string_view text, size_t offset) const;
+    bool matchRegex(std::string_view text, size_t start, size_t end, size_t& found) const;
+};
+
+/**
+ * @class Grep
+ * @brief Searches a repository's files for matching lines
+ *
+ * Tracked files are those in the index and in the HEAD commit; the
+ * .mimirionignore rules decide which untracked files are searched when
+ * asked for. Files are searched in batches on the shared task scheduler,
+ * and each batch's output is printed in path order, so the output is
+ * deterministic. Working tree files are read through FileViews; the index
+ * and commits are read from the object store without a checkout.
+ */
+class Grep {
+public:
+    /**
+     * @brief Constructor for Grep
+     * @param repoPath Path to the repository root
+     * @param mimirionDir Path to the .mimirion directory
+     */
+    Grep(const fs::path& repoPath, const fs::path& mimirionDir);
+
+    /**
+     * @brief Run a search
+     *
+     * Output follows git grep: `path:line` with an optional line number,
+     * prefixed by the revision when searching a commit.
+     *
+     * @param options Search options
+     * @param out Receives the results
+     * @return Number of files with matches, -1 if the pattern or revision is invalid
+     */
+    int run(const GrepOptions& options, std::ostream& out);
+
+private:
+    struct Target {
+        std::string path;  // relative to the repository root
+        std::string hash;  // object to read, empty to read the working tree file
+    };
+
+    fs::path repositoryPath;
+    fs::path mimirionDir;
+
+    bool collectTargets(const GrepOptions& options, std::vector<Target>& targets);
+    static bool selected(const GrepOptions& options, const std::string& path);
+};
+
+} // namespace mimirion
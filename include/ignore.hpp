@@ -0,0 +1,77 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/**
+ * @file ignore.hpp
+ * @brief Ignore rules for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the IgnoreRules class, which reads the
+ * .mimirionignore file at the repository root and decides which paths are
+ * left out of status, add and untracked searches.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @class IgnoreRules
+ * @brief Path patterns that exclude files from tracking
+ *
+ * Each non-empty, non-comment line of .mimirionignore is a pattern, matched
+ * like attribute patterns (see Attributes::matches). A trailing slash
+ * limits a pattern to directories and a leading `!` re-includes paths an
+ * earlier pattern excluded; the last matching pattern wins. A path inside
+ * an ignored directory is ignored as well.
+ */
+class IgnoreRules {
+public:
+    /** @brief Name of the ignore file at the repository root */
+    static constexpr const char* kFileName = ".mimirionignore";
+
+    /**
+     * @brief Load the ignore rules of a repository
+     * @param repoPath Path to the repository root
+     * @return Rules; empty if the repository has no ignore file
+     */
+    static IgnoreRules load(const fs::path& repoPath);
+
+    /**
+     * @brief Parse ignore rules
+     * @param text Contents in .mimirionignore format
+     * @return Parsed rules
+     */
+    static IgnoreRules parse(const std::string& text);
+
+    /**
+     * @brief Check whether a path is ignored
+     * @param path Path relative to the repository root
+     * @param directory Whether the path names a directory
+     * @return true if the path or one of its parent directories is ignored
+     */
+    bool isIgnored(const std::string& path, bool directory = false) const;
+
+    /**
+     * @brief Check whether there are no rules
+     * @return true if nothing is ignored
+     */
+    bool empty() const;
+
+private:
+    struct Rule {
+        std::string pattern;
+        bool negated = false;
+        bool directoryOnly = false;
+    };
+
+    std::vector<Rule> rules;
+
+    bool matchesEntry(const std::string& path, bool directory) const;
+};
+
+} // namespace mimirion
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include "attributes.hpp"
+
+/**
+ * @file lfs.hpp
+ * @brief Large file storage for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the LargeFileStore class, which keeps the content of
+ * large files outside the object store. Commits record a small pointer
+ * object in place of such a file; the content lives in a separate
+ * content-addressed store and is copied back into the working tree on
+ * checkout or on demand.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @struct LfsPointer
+ * @brief Reference to a file held in the large file store
+ */
+struct LfsPointer {
+    std::string oid;   /**< SHA-256 of the file content */
+    uint64_t size = 0; /**< Content size in bytes */
+};
+
+/**
+ * @class LargeFileStore
+ * @brief Content-addressed store for large files and their pointer files
+ *
+ * Paths whose `filter` attribute is `lfs` in .mimirionattributes are
+ * committed as pointer text of the form
+ *
+ *     version https://mimirion.dev/spec/lfs/v1
+ *     oid sha256:<hash>
+ *     size <bytes>
+ *
+ * while the content goes to .mimirion/lfs/objects/ab/cd/<hash>. Content is
+ * copied in and out in fixed-size chunks so memory use does not grow with
+ * the file; where the filesystem supports reflinks (FICLONE), copies share
+ * extents with their source and cost no extra space.
+ */
+class LargeFileStore {
+public:
+    /** @brief First line of every pointer */
+    static constexpr const char* kPointerVersion = "version https://mimirion.dev/spec/lfs/v1";
+
+    /** @brief Pointers are never larger than this; bigger files are content */
+    static constexpr size_t kMaxPointerSize = 200;
+
+    /** @brief Size of the chunks used to copy content */
+    static constexpr size_t kChunkSize = 1024 * 1024;
+
+    /**
+     * @brief Constructor for LargeFileStore
+     * @param repoPath Path to the repository root
+     * @param mimirionDir Path to the .mimirion directory
+     */
+    LargeFileStore(const fs::path& repoPath, const fs::path& mimirionDir);
+
+    /**
+     * @brief Check whether a path is stored as a pointer
+     * @param path Path relative to the repository root
+     * @return true if the path's filter attribute is lfs
+     */
+    bool isTracked(const std::string& path) const;
+
+    /**
+     * @brief Store a working tree file
+     *
+     * A file that already holds pointer text is not stored again; its
+     * pointer is returned as is.
+     *
+     * @param file File to store
+     * @param pointer Receives the pointer to the stored content
+     * @return true if successful, false otherwise
+     */
+    bool store(const fs::path& file, LfsPointer& pointer);
+
+    /**
+     * @brief Copy stored content into the working tree
+     *
+     * The target is replaced atomically, so an interrupted copy leaves
+     * either the previous file or the complete content.
+     *
+     * @param pointer Pointer to the content
+     * @param target File to write
+     * @return true if successful, false if the content is not stored locally
+     */
+    bool materialize(const LfsPointer& pointer, const fs::path& target) const;
+
+    /**
+     * @brief Check whether content is stored locally
+     * @param oid Content hash
+     * @return true if the content is in the store
+     */
+    bool hasObject(const std::string& oid) const;
+
+    /**
+     * @brief Get the path of stored content
+     * @param oid Content hash
+     * @return Path of the content in the store
+     */
+    fs::path objectPath(const std::string& oid) const;
+
+    /**
+     * @brief Format pointer text
+     * @param pointer Pointer to format
+     * @return Pointer text, as committed in place of the file
+     */
+    static std::string formatPointer(const LfsPointer& pointer);
+
+    /**
+     * @brief Parse pointer text
+     * @param text Text that may be a pointer
+     * @param pointer Receives the pointer
+     * @return true if text is a well-formed pointer
+     */
+    static bool parsePointer(std::string_view text, LfsPointer& pointer);
+
+    /**
+     * @brief Read a file that may hold pointer text
+     * @param file File to read
+     * @param pointer Receives the pointer
+     * @return true if the file is a pointer file
+     */
+    static bool readPointerFile(const fs::path& file, LfsPointer& pointer);
+
+private:
+    fs::path repositoryPath;
+    fs::path storeDir;
+    Attributes attributes;
+
+    fs::path temporaryPath() const;
+};
+
+} // namespace mimirion
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/**
+ * @file maintenance.hpp
+ * @brief Incremental repository maintenance for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the MaintenanceManager class, which packs loose
+ * objects, refreshes the reachability bitmaps and prunes garbage in small,
+ * time-limited steps, and starts itself in the background when a
+ * repository needs it.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @struct MaintenanceOptions
+ * @brief How to run maintenance
+ */
+struct MaintenanceOptions {
+    std::chrono::milliseconds budget{0}; /**< Time limit, 0 for none */
+    bool autoOnly = false;               /**< Only run the tasks whose thresholds are crossed */
+    std::vector<std::string> tasks;      /**< Tasks to run, all of them if empty */
+};
+
+/**
+ * @struct MaintenanceReport
+ * @brief What a maintenance run did
+ */
+struct MaintenanceReport {
+    std::vector<std::string> tasks; /**< Tasks that ran to the end */
+    size_t packedObjects = 0;       /**< Loose objects moved into packs */
+    size_t packsWritten = 0;        /**< Packs written for loose objects */
+    size_t mergedPacks = 0;         /**< Packs combined into a larger one */
+    size_t prunedObjects = 0;       /**< Unreachable loose objects removed */
+    size_t unpackedObjects = 0;     /**< Unreachable packed objects made loose again */
+    size_t removedTemporaries = 0;  /**< Abandoned temporary files removed */
+    size_t bitmapObjects = 0;       /**< Objects in a rewritten bitmap index */
+    bool complete = true;           /**< false if the budget ran out first */
+};
+
+/**
+ * @class MaintenanceManager
+ * @brief Keeps a repository's object store compact and its indexes current
+ *
+ * There are three tasks, run in this order:
+ *
+ * - `loose-objects` copies reachable loose objects into packs of at most
+ *   kPackObjects objects, flushes them to disk and only then deletes the
+ *   loose files. When there are more than kMaxPacks packs, the smallest
+ *   are merged until half that many remain; packed objects that are no
+ *   longer reachable are written out as loose objects instead.
+ * - `bitmaps` rewrites the reachability bitmaps (see BitmapIndex) when
+ *   they lack some commit.
+ * - `prune` deletes loose objects that no ref, worktree HEAD or index
+ *   reaches and that have not been written for kPruneGrace, and abandoned
+ *   temporary files of the same age. Packs holding unreachable objects are
+ *   rewritten the same way as in a merge, so those objects are deleted by
+ *   a later prune, kPruneGrace after they were unpacked. Objects another repository borrows
+ *   through its alternates are not known here, so a store that others use
+ *   as an alternate should not be pruned.
+ *
+ * With a budget, no new step starts once it is spent, but every run takes
+ * at least one, so repeated short runs always get through: packs are
+ * finished with the objects added so far, a merge of packs runs to its end
+ * and prune records the fan-out directory it stopped at in
+ * `.mimirion/maintenance`, so the next run carries on where this one
+ * ended. Runs of
+ * all worktrees are serialized by a lock on `.mimirion/maintenance.lock`,
+ * which the system releases when the runner exits, however it ends; the
+ * file also holds the runner's process id.
+ *
+ * After commands that add objects, spawnIfDue() checks cheap estimates
+ * against the `maintenance.autoLooseObjects` and
+ * `maintenance.autoUnindexedCommits` thresholds and, if one is crossed,
+ * starts `mimirion maintenance run --auto` as a detached process at low
+ * CPU and I/O priority, limited to `maintenance.autoBudget` seconds.
+ * `maintenance.auto` set to false turns this off.
+ */
+class MaintenanceManager {
+public:
+    /** @brief Loose objects at which packing them is due */
+    static constexpr size_t kAutoLooseObjects = 6700;
+
+    /** @brief Commits missing from the bitmap index at which rewriting it is due */
+    static constexpr size_t kAutoUnindexedCommits = 100;
+
+    /** @brief Default time limit of background runs */
+    static constexpr std::chrono::seconds kAutoBudget{60};
+
+    /** @brief Packs beyond which the smallest are merged */
+    static constexpr size_t kMaxPacks = 8;
+
+    /** @brief Most objects written into one pack for loose objects */
+    static constexpr size_t kPackObjects = 10000;
+
+    /** @brief Age an unreachable object must reach before it is pruned */
+    static constexpr std::chrono::hours kPruneGrace{24 * 14};
+
+    /** @brief Least time between two prunes started automatically */
+    static constexpr std::chrono::hours kPruneInterval{24};
+
+    /**
+     * @brief Constructor for MaintenanceManager
+     * @param repoPath Path to the repository root
+     * @param mimirionDir Path to the .mimirion directory
+     */
+    MaintenanceManager(const fs::path& repoPath, const fs::path& mimirionDir);
+
+    /**
+     * @brief Get the names of the tasks in the order they run
+     * @return "loose-objects", "bitmaps" and "prune"
+     */
+    static const std::vector<std::string>& taskNames();
+
+    /**
+     * @brief Check which tasks the repository needs
+     * @return Tasks whose thresholds are crossed, in run order; prune only
+     *         joins another task, once per kPruneInterval
+     */
+    std::vector<std::string> dueTasks() const;
+
+    /**
+     * @brief Estimate the number of loose objects from one fan-out directory
+     * @return Estimated loose object count
+     */
+    size_t estimateLooseObjects() const;
+
+    /**
+     * @brief Count the packs of this repository
+     * @return Number of packs
+     */
+    size_t packCount() const;
+
+    /**
+     * @brief Get the process running maintenance for this repository
+     * @return Its process id, 0 if no run is going on
+     */
+    long runningProcess() const;
+
+    /**
+     * @brief Run maintenance in this process
+     * @param options Budget and tasks to run
+     * @param report If not null, receives what was done
+     * @return true if every task succeeded, false on errors, unknown tasks
+     *         or if another run holds the lock
+     */
+    bool run(const MaintenanceOptions& options, MaintenanceReport* report = nullptr);
+
+    /**
+     * @brief Start maintenance as a detached, low-priority process
+     * @param options Budget and tasks to run
+     * @return true if the process was started
+     */
+    bool spawn(const MaintenanceOptions& options) const;
+
+    /**
+     * @brief Start a background run if automatic maintenance is on and due
+     * @return true if a background run was started
+     */
+    bool spawnIfDue() const;
+
+private:
+    fs::path repositoryPath;
+    fs::path mimirionDir;
+    fs::path mainDir;
+};
+
+} // namespace mimirion
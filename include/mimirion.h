@@ -0,0 +1,143 @@
+#ifndef MIMIRION_H
+#define MIMIRION_H
+
+/**
+ * @file mimirion.h
+ * @brief Stable C interface to libmimirion
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This header is the embeddable interface of the Mimirion library. It only
+ * uses C types so it can be called from C and from any language with a C
+ * foreign function interface. All functions returning int return
+ * MIMIRION_OK on success and a negative error code otherwise; the message
+ * for the last failure on the calling thread is available from
+ * mimirion_last_error().
+ */
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#  ifdef MIMIRION_BUILDING_LIBRARY
+#    define MIMIRION_API __declspec(dllexport)
+#  else
+#    define MIMIRION_API __declspec(dllimport)
+#  endif
+#elif defined(__GNUC__)
+#  define MIMIRION_API __attribute__((visibility("default")))
+#else
+#  define MIMIRION_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Opaque handle to an open repository */
+typedef struct mimirion_repository mimirion_repository;
+
+/** @brief Return codes */
+enum {
+    MIMIRION_OK = 0,            /**< Success */
+    MIMIRION_ERROR = -1,        /**< Generic failure */
+    MIMIRION_NOT_FOUND = -2,    /**< Repository, object or ref does not exist */
+    MIMIRION_INVALID = -3,      /**< Invalid argument */
+    MIMIRION_BUFFER_TOO_SMALL = -4 /**< Output buffer cannot hold the result */
+};
+
+/** @brief File statuses reported by mimirion_status_foreach() */
+typedef enum {
+    MIMIRION_STATUS_UNTRACKED = 0, /**< Not tracked */
+    MIMIRION_STATUS_MODIFIED = 1,  /**< Modified since the last commit */
+    MIMIRION_STATUS_STAGED = 2,    /**< Staged for the next commit */
+    MIMIRION_STATUS_COMMITTED = 3, /**< Committed and unchanged */
+    MIMIRION_STATUS_DELETED = 4    /**< Tracked but missing from the working tree */
+} mimirion_file_status;
+
+/**
+ * @brief Callback invoked once per file by mimirion_status_foreach()
+ * @return 0 to continue, non-zero to stop the iteration
+ */
+typedef int (*mimirion_status_cb)(const char* path, mimirion_file_status status, void* payload);
+
+/**
+ * @brief Get the library version
+ * @return Version string, e.g. "0.1.0"
+ */
+MIMIRION_API const char* mimirion_version(void);
+
+/**
+ * @brief Get the message of the last error on the calling thread
+ * @return Error message, empty string if there was none
+ */
+MIMIRION_API const char* mimirion_last_error(void);
+
+/**
+ * @brief Open the repository containing a path
+ * @param path Repository root or a directory inside it
+ * @param out Receives the repository handle
+ * @return MIMIRION_OK or an error code
+ */
+MIMIRION_API int mimirion_repository_open(const char* path, mimirion_repository** out);
+
+/**
+ * @brief Close a repository and release every buffer handed out for it
+ * @param repo Repository handle, may be NULL
+ */
+MIMIRION_API void mimirion_repository_close(mimirion_repository* repo);
+
+/**
+ * @brief Read an object without copying it
+ *
+ * The returned buffer points into the library's object cache and remains
+ * valid until the repository is closed. It must not be modified or freed.
+ *
+ * @param repo Repository handle
+ * @param hash Full object hash
+ * @param data Receives a pointer to the object content
+ * @param size Receives the object size in bytes
+ * @return MIMIRION_OK, MIMIRION_NOT_FOUND or another error code
+ */
+MIMIRION_API int mimirion_object_read(mimirion_repository* repo, const char* hash,
+                                      const void** data, size_t* size);
+
+/**
+ * @brief Resolve HEAD, a ref, a branch name or a hash prefix
+ * @param repo Repository handle
+ * @param name Name to resolve
+ * @param out Buffer receiving the NUL-terminated hash
+ * @param outSize Size of the buffer in bytes
+ * @return MIMIRION_OK, MIMIRION_NOT_FOUND or another error code
+ */
+MIMIRION_API int mimirion_ref_lookup(mimirion_repository* repo, const char* name,
+                                     char* out, size_t outSize);
+
+/**
+ * @brief Report the status of every file in the working tree
+ * @param repo Repository handle
+ * @param callback Function called for each file
+ * @param payload Opaque pointer passed through to the callback
+ * @return MIMIRION_OK, or the callback's non-zero value if it stopped early
+ */
+MIMIRION_API int mimirion_status_foreach(mimirion_repository* repo,
+                                         mimirion_status_cb callback, void* payload);
+
+/**
+ * @brief Create a commit from a list of files
+ * @param repo Repository handle
+ * @param message Commit message
+ * @param paths Paths of the files to commit, relative to the repository root
+ * @param pathCount Number of entries in paths
+ * @param out Buffer receiving the NUL-terminated commit hash, may be NULL
+ * @param outSize Size of the buffer in bytes
+ * @return MIMIRION_OK or an error code
+ */
+MIMIRION_API int mimirion_commit_create(mimirion_repository* repo, const char* message,
+                                        const char* const* paths, size_t pathCount,
+                                        char* out, size_t outSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MIMIRION_H */
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <filesystem>
+#include "codec.hpp"
+#include "file_view.hpp"
+#include "scanner.hpp"
+
+/**
+ * @file object_store.hpp
+ * @brief Access to the Mimirion object database
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the definition of the ObjectStore class, which reads
+ * and writes content-addressed objects under .mimirion/objects.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+class PackFile;
+
+/**
+ * @class ObjectStore
+ * @brief Reads and writes objects in a repository's object database
+ *
+ * Objects are stored as loose files named after their hash, split into a
+ * two character directory and the remainder (objects/ab/cdef...). Objects
+ * that have been read are kept in an in-memory cache, so repeated reads of
+ * the same object return the same buffer without touching the disk.
+ *
+ * Each object file starts with an ObjectHeader naming the codec (and
+ * dictionary) used for it, so objects written with different settings can
+ * coexist. The codec for new objects comes from the `core.compression`
+ * setting ("none", "zlib" or "zstd"; default "zlib") and the level from
+ * `core.compressionLevel` ("fast", "default" or "best"; default "fast").
+ * With zstd, objects up to 64 KiB use the repository's trained dictionary
+ * unless `core.compressionDictionary` is false. Headerless files written by
+ * older versions are read as zlib streams or raw content.
+ *
+ * `objects/info/alternates` may list other objects directories, one per
+ * line, relative to this objects directory unless absolute. Objects and
+ * dictionaries missing here are looked up there, and in their alternates
+ * in turn, up to kMaxAlternateDepth levels; a store reached twice is only
+ * searched once, so alternates naming each other cannot loop. The object
+ * cache holds objects from every store. Writes always go to this store,
+ * but objects an alternate already has are not written again.
+ *
+ * Objects may also live in packs under `objects/pack` (see PackFile), here
+ * or in an alternate. Packs are searched before loose files. When an object
+ * is found in neither, the pack directories are checked for changes and
+ * rescanned, so objects that maintenance moved into a new pack while the
+ * store was open are still found.
+ */
+class ObjectStore {
+public:
+    /** @brief Levels of alternates followed from a store */
+    static constexpr int kMaxAlternateDepth = 5;
+
+    /**
+     * @brief Constructor for ObjectStore
+     * @param mimirionDir Path to the repository's .mimirion directory
+     */
+    explicit ObjectStore(const fs::path& mimirionDir);
+
+    /**
+     * @brief Check if an object exists
+     * @param hash Object hash
+     * @return true if the object exists, false otherwise
+     */
+    bool hasObject(const std::string& hash) const;
+
+    /**
+     * @brief Get an object's content size from its header, without decoding it
+     * @param hash Object hash
+     * @param size Receives the content size in bytes
+     * @return true if successful, false if the object is missing or was
+     *         written before object headers recorded sizes
+     */
+    bool objectSize(const std::string& hash, uint64_t& size) const;
+
+    /**
+     * @brief Read an object's content
+     *
+     * The returned buffer is shared with the cache and stays valid for as
+     * long as the caller holds on to it. Compressed objects are inflated
+     * transparently; objects stored uncompressed are returned as they are.
+     *
+     * @param hash Object hash
+     * @return Object content, or nullptr if the object does not exist
+     */
+    std::shared_ptr<const std::string> readObject(const std::string& hash);
+
+    /**
+     * @brief Store content as a zlib-compressed object
+     *
+     * The hash is computed over the uncompressed content.
+     *
+     * @param content Object content
+     * @return Hash of the stored object, empty string on failure
+     */
+    std::string writeObject(const std::string& content);
+
+    /**
+     * @brief Store a file's content as an object
+     *
+     * The file is viewed through a FileView, so large files are mapped
+     * rather than copied. It is hashed and scanned first, and only
+     * compressed if no object with that hash exists yet; large zlib objects
+     * are compressed straight to disk instead of being held in memory.
+     *
+     * @param path File to store
+     * @param result Optional, receives the scan result of the file
+     * @return Hash of the stored object, empty string on failure
+     */
+    std::string writeFile(const fs::path& path, ScanResult* result = nullptr);
+
+    /**
+     * @brief Store content produced piece by piece as an object
+     *
+     * The producer is called once and passes the content to the sink it is
+     * given, in as many pieces as it likes. The content is hashed and
+     * compressed to a temporary file as it arrives, so it is never held in
+     * memory as a whole; the object is renamed into place once its hash is
+     * known. Streamed objects always use zlib.
+     *
+     * @param producer Writes the content to its sink; returns false to abort
+     * @param result Optional, receives the scan result of the content
+     * @return Hash of the stored object, empty string on failure
+     */
+    std::string writeStream(const std::function<bool(const CompressionSink&)>& producer,
+                            ScanResult* result = nullptr);
+
+    /**
+     * @brief Read an object's content piece by piece
+     *
+     * zlib and uncompressed objects are decoded incrementally from the
+     * mapped object file; other codecs are decoded in one piece. The cache
+     * is not used, so several threads may read objects at the same time.
+     *
+     * @param hash Object hash
+     * @param sink Receives the content; returns false to abort
+     * @return true if successful, false if the object is missing, corrupt
+     *         or the sink aborted
+     */
+    bool readStream(const std::string& hash, const CompressionSink& sink);
+
+    /**
+     * @brief Store content under a caller-chosen name
+     *
+     * Used for objects whose name is not the hash of their content, such
+     * as commits. An existing object with the same name is kept.
+     *
+     * @param hash Object name
+     * @param content Object content
+     * @return true if successful, false otherwise
+     */
+    bool storeObject(const std::string& hash, std::string_view content);
+
+    /**
+     * @brief Encode content in the on-disk object format
+     * @param content Object content
+     * @return Header followed by the compressed payload, empty string on failure
+     */
+    std::string encodeObject(std::string_view content);
+
+    /**
+     * @brief Decode an object file's bytes
+     * @param stored Bytes of the object file
+     * @param content Receives the object content
+     * @return true if successful, false if the data is corrupt or needs a
+     *         codec or dictionary that is not available
+     */
+    bool decodeObject(std::string_view stored, std::string& content);
+
+    /**
+     * @brief Train a zstd dictionary on the repository's small objects
+     *
+     * The dictionary is stored under objects/info/dictionaries and used for
+     * new small objects from then on; existing objects are not rewritten.
+     *
+     * @param maxSize Maximum dictionary size in bytes
+     * @return Dictionary id, 0 if zstd is unavailable or training failed
+     */
+    uint32_t trainDictionary(size_t maxSize = 64 * 1024);
+
+    /**
+     * @brief Get the codec used for new objects
+     * @return Codec
+     */
+    const Codec& writeCodec() const;
+
+    /**
+     * @brief Get the dictionary used for new small objects
+     * @return Dictionary id, 0 for none
+     */
+    uint32_t writeDictionary() const;
+
+    /**
+     * @brief Get the path of a loose object in this store
+     * @param hash Object hash
+     * @return Path of the object file (which may not exist), never in an alternate
+     */
+    fs::path objectPath(const std::string& hash) const;
+
+    /**
+     * @brief Write an already encoded object as a loose file
+     *
+     * The object is written to the side and renamed into place, so an
+     * interrupted write never leaves a truncated object that would pass
+     * for a complete one. An existing loose copy is replaced.
+     *
+     * @param hash Object hash
+     * @param encoded Object as stored, header included
+     * @return true if successful, false otherwise
+     */
+    bool writeLoose(const std::string& hash, std::string_view encoded);
+
+    /**
+     * @brief Find the object whose hash starts with a prefix
+     * @param prefix Hash prefix of at least 4 characters
+     * @return Full hash if exactly one object matches, empty string otherwise
+     */
+    std::string resolvePrefix(const std::string& prefix) const;
+
+    /**
+     * @brief Add another object store to read objects from
+     * @param dir Objects directory of the other store, or a directory
+     *        with an objects directory in it, such as its .mimirion
+     * @return true if the store was added or already listed, false if it
+     *         does not exist, is this store or could not be recorded
+     */
+    bool addAlternate(const fs::path& dir);
+
+    /**
+     * @brief Get the objects directories reads fall back to
+     * @return Alternates in lookup order, as canonical paths
+     */
+    const std::vector<fs::path>& alternateDirs() const;
+
+    /**
+     * @brief Drop all cached objects
+     */
+    void clearCache();
+
+    /**
+     * @brief Flush written objects to stable storage
+     *
+     * Objects are written without an fsync each. Bulk writers call this
+     * once after a batch, before publishing refs that point into it, so a
+     * crash cannot leave a ref naming objects that never reached the disk.
+     *
+     * @return true if successful, false otherwise
+     */
+    bool sync() const;
+
+    /**
+     * @brief Check that a string is a well-formed object hash
+     * @param hash Candidate hash
+     * @return true if the hash is non-trivial lowercase hexadecimal
+     */
+    static bool isValidHash(const std::string& hash);
+
+private:
+    struct PackSet {
+        std::vector<std::shared_ptr<const PackFile>> files;
+        std::vector<fs::file_time_type> stamps;
+    };
+
+    // Keeps the bytes of a stored object readable while they are used
+    struct Stored {
+        FileView file;
+        std::shared_ptr<const PackSet> packs;
+        std::string_view bytes;
+    };
+
+    fs::path objectsDir;
+    std::vector<fs::path> alternates;
+    mutable std::shared_ptr<const PackSet> packs;
+    std::unordered_map<std::string, std::shared_ptr<const std::string>> cache;
+    size_t cacheBytes;
+    const Codec* codec;
+    CompressionLevel level;
+    uint32_t dictionaryId;
+
+    void loadAlternates();
+    bool locate(const std::string& hash, fs::path& path) const;
+    bool freshen(const std::string& hash) const;
+    bool refreshPacks() const;
+    bool findPacked(const std::string& hash) const;
+    bool openStored(const std::string& hash, Stored& stored) const;
+    fs::path dictionaryPath(uint32_t id) const;
+    fs::path temporaryPath() const;
+    bool streamObject(const std::string& hash, std::string_view content);
+    bool loadDictionary(const Codec& dictionaryCodec, uint32_t id);
+};
+
+} // namespace mimirion
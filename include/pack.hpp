@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "file_view.hpp"
+
+/**
+ * @file pack.hpp
+ * @brief Pack files for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the PackFile class, which reads many stored objects
+ * from one file, and the PackWriter class, which writes such files.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @class PackFile
+ * @brief A pack of stored objects and its index
+ *
+ * `objects/pack/pack-<checksum>.pack` starts with the magic "MPAK", a
+ * version and the object count, holds the objects' stored bytes back to
+ * back, each exactly as a loose object file would (ObjectHeader and
+ * payload), and ends with the SHA-256 of everything before it. Its index,
+ * `pack-<checksum>.idx`, lists the objects sorted by hash with the offset
+ * and length of their bytes, followed by the pack's checksum and the
+ * SHA-256 of the index itself. The index is written last, so a pack
+ * without one is unfinished and ignored.
+ *
+ * Both files are mapped: lookups binary search the index and reads are
+ * slices of the pack, so packed objects decode like loose ones. An open
+ * pack is immutable and can be read from several threads at once.
+ */
+class PackFile {
+public:
+    /** @brief Bytes per index entry: raw hash, offset and length */
+    static constexpr size_t kEntrySize = 48;
+
+    /**
+     * @brief Open a pack through its index
+     * @param indexPath Path of the .idx file
+     * @return true if both files are well-formed, false otherwise
+     */
+    bool open(const fs::path& indexPath);
+
+    /**
+     * @brief Find an object
+     * @param hash Full object hash
+     * @param stored Receives the object's stored bytes
+     * @return true if the pack holds the object
+     */
+    bool find(const std::string& hash, std::string_view& stored) const;
+
+    /**
+     * @brief Collect the objects whose hash starts with a prefix
+     * @param prefix Hash prefix
+     * @param matches Receives the full hashes
+     */
+    void findPrefix(const std::string& prefix, std::vector<std::string>& matches) const;
+
+    /**
+     * @brief Get the number of objects
+     * @return Object count
+     */
+    size_t objectCount() const { return count; }
+
+    /**
+     * @brief Get the hash of the i-th object in hash order
+     * @param i Index below objectCount()
+     * @return Object hash
+     */
+    std::string hashAt(size_t i) const;
+
+    /**
+     * @brief Get the stored bytes of the i-th object in hash order
+     * @param i Index below objectCount()
+     * @return Stored bytes
+     */
+    std::string_view storedAt(size_t i) const;
+
+    /**
+     * @brief Check the checksums of the pack and its index
+     * @return true if both match their contents
+     */
+    bool verify() const;
+
+    /**
+     * @brief Get the path of the pack file
+     * @return Path of the .pack file
+     */
+    const fs::path& packPath() const { return pack; }
+
+    /**
+     * @brief Get the path of the index file
+     * @return Path of the .idx file
+     */
+    const fs::path& indexPath() const { return index; }
+
+    /**
+     * @brief Get the size of the pack file
+     * @return Size in bytes
+     */
+    uint64_t size() const { return packView.size(); }
+
+private:
+    fs::path pack;
+    fs::path index;
+    FileView packView;
+    FileView indexView;
+    size_t count = 0;
+
+    size_t lowerBound(const std::string& raw) const;
+};
+
+/**
+ * @class PackWriter
+ * @brief Writes objects into a new pack
+ *
+ * Objects are appended to a temporary file as they are added. finish()
+ * fills in the object count, appends the checksum, writes the index and
+ * renames both into place, index last.
+ */
+class PackWriter {
+public:
+    /**
+     * @brief Start a pack
+     * @param packDir Directory of the packs, usually objects/pack
+     */
+    explicit PackWriter(const fs::path& packDir);
+
+    ~PackWriter();
+
+    PackWriter(const PackWriter&) = delete;
+    PackWriter& operator=(const PackWriter&) = delete;
+
+    /**
+     * @brief Append an object
+     * @param hash Object hash; each hash is added at most once
+     * @param stored Stored bytes of the object
+     * @return true if successful, false otherwise
+     */
+    bool add(const std::string& hash, std::string_view stored);
+
+    /**
+     * @brief Get the number of objects added
+     * @return Object count
+     */
+    size_t objectCount() const { return entries.size(); }
+
+    /**
+     * @brief Get the number of bytes written so far
+     * @return Size of the pack in bytes
+     */
+    uint64_t size() const { return offset; }
+
+    /**
+     * @brief Complete the pack and move it into place
+     * @param indexPath If not null, receives the path of the new index
+     * @return true if successful, false otherwise
+     */
+    bool finish(fs::path* indexPath = nullptr);
+
+private:
+    struct Entry {
+        std::string hash;
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    fs::path packDir;
+    fs::path temp;
+    std::ofstream out;
+    std::vector<Entry> entries;
+    uint64_t offset = 0;
+    bool finished = false;
+
+    bool write(std::string_view data);
+};
+
+} // namespace mimirion
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+#include <filesystem>
+#include <vector>
+
+/**
+ * @file refs.hpp
+ * @brief Reference lookup for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the definition of the RefStore class, which reads
+ * HEAD and the files under .mimirion/refs and resolves names to hashes.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+class ObjectStore;
+
+/**
+ * @class RefStore
+ * @brief Reads and resolves references in a repository
+ */
+class RefStore {
+public:
+    /**
+     * @brief Constructor for RefStore
+     * @param mimirionDir Path to the repository's .mimirion directory
+     */
+    explicit RefStore(const fs::path& mimirionDir);
+
+    /**
+     * @brief Read the raw value of a reference file
+     * @param ref Reference path relative to .mimirion, e.g. "refs/heads/master"
+     * @return First line of the reference file, empty string if missing
+     */
+    std::string readRef(const std::string& ref) const;
+
+    /**
+     * @brief Write a reference file
+     *
+     * The value is written to `<ref>.lock`, which is created exclusively
+     * and then renamed over the reference. Readers see either the old or
+     * the new value, and while one process, in any worktree, updates a
+     * reference, others trying to update it fail instead of waiting.
+     *
+     * @param ref Reference path relative to .mimirion, e.g. "refs/tags/v1.0"
+     * @param value Hash or symbolic reference to store
+     * @param expected If not null, the value the reference must still
+     *        hold, empty for a reference that must not exist yet
+     * @return true if successful, false if the reference is locked, no
+     *         longer holds the expected value or could not be written
+     */
+    bool writeRef(const std::string& ref, const std::string& value, const std::string* expected = nullptr) const;
+
+    /**
+     * @brief Resolve a name to the hash it refers to
+     *
+     * Names are tried in order as HEAD, a full ref path, a branch name, a
+     * tag name and, when an object store is given, a full or abbreviated
+     * object hash.
+     *
+     * @param name Name to resolve
+     * @param objects Optional object store used to resolve hashes
+     * @return Resolved hash, empty string if the name is unknown
+     */
+    std::string resolve(const std::string& name, const ObjectStore* objects = nullptr) const;
+
+    /**
+     * @brief List the references under a directory
+     * @param prefix Directory relative to .mimirion, e.g. "refs/heads"
+     * @return Sorted reference paths such as "refs/heads/master"; lock
+     *         files of updates in progress are left out
+     */
+    std::vector<std::string> listRefs(const std::string& prefix = "refs") const;
+
+    /**
+     * @brief Get the branch HEAD points to
+     * @return Branch name, empty string if HEAD is missing or detached
+     */
+    std::string currentBranch() const;
+
+    /**
+     * @brief Point HEAD at a branch
+     *
+     * HEAD belongs to the worktree; in a linked worktree this is the
+     * worktree's own HEAD.
+     *
+     * @param branch Branch name
+     * @return true if successful, false otherwise
+     */
+    bool setHead(const std::string& branch) const;
+
+    /**
+     * @brief Parse the value of a symbolic reference
+     * @param value First line of a ref file, e.g. "ref: refs/heads/master"
+     * @param target Receives the referenced name, e.g. "refs/heads/master"
+     * @return true if the value is a symbolic reference, false otherwise
+     */
+    static bool parseSymbolicRef(const std::string& value, std::string& target);
+
+private:
+    fs::path mimirionDir;
+};
+
+} // namespace mimirion
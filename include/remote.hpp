@@ -135,6 +135,26 @@ public:
      * @return true if successful, false otherwise
      */
     bool loadState();
+    
+    /**
+     * @brief Read the remotes of a repository from its configuration
+     * 
+     * Remotes are stored as `remote.<name>.url` keys. A legacy
+     * config/remotes file is still read if present.
+     * 
+     * @param mimirionDir Path to the repository's .mimirion directory
+     * @return Map of remote names to URLs
+     */
+    static std::unordered_map<std::string, std::string> loadRemotes(const fs::path& mimirionDir);
+    
+    /**
+     * @brief Replace the remotes stored in a repository's configuration
+     * @param mimirionDir Path to the repository's .mimirion directory
+     * @param remotes Map of remote names to URLs
+     * @return true if successful, false otherwise
+     */
+    static bool saveRemotes(const fs::path& mimirionDir,
+                            const std::unordered_map<std::string, std::string>& remotes);
 
 private:
     fs::path repositoryPath;
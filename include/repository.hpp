@@ -133,7 +133,7 @@ public:
     
     /**
      * @brief Switch to a branch
-     * @param name Branch name
+     * @param name Branch name, not checked out in another worktree
      * @return true if successful, false otherwise
      */
     bool checkout(const std::string& name);
@@ -176,6 +176,29 @@ public:
      * @return true if successful, false otherwise
      */
     bool setGitHubCredentialsFromFile(const fs::path& tokenFilePath);
+    
+    /**
+     * @brief Find the root of the repository containing a path
+     * 
+     * Walks up the directory tree from the given path looking for a
+     * .mimirion directory or a linked worktree's .mimirion file.
+     * 
+     * @param start Path to the repository or a subdirectory within it
+     * @return Absolute repository root, or an empty path if none was found
+     */
+    static fs::path findRepositoryRoot(const fs::path& start);
+    
+    /**
+     * @brief Find the metadata directory of a repository root
+     * 
+     * This is root/.mimirion, unless that is the file of a linked
+     * worktree, holding a "mimirdir: <path>" line that names the
+     * worktree's directory in the main repository.
+     * 
+     * @param root Repository root, as returned by findRepositoryRoot()
+     * @return Path to use as the repository's .mimirion directory
+     */
+    static fs::path findMimirionDir(const fs::path& root);
 
 private:
     /** @brief Absolute path to the repository's root directory */
@@ -193,9 +216,19 @@ private:
     /** @brief List of staged files awaiting commit */
     std::vector<std::string> stagedFiles;
     
-    /** @brief GitHub provider for remote operations */
+    /** @brief GitHub provider for remote operations, created on first use */
     std::unique_ptr<GitHubProvider> githubProvider;
     
+    /**
+     * @brief Get the GitHub provider, creating it on first use
+     * 
+     * Local commands never touch the network, so the provider (and with it
+     * libcurl and TLS) is only set up by the operations that need it.
+     * 
+     * @return GitHub provider instance
+     */
+    GitHubProvider& getGitHubProvider();
+    
     /**
      * @brief Validates that the current paths point to a valid repository
      * 
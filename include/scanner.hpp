@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "compression.hpp"
+
+/**
+ * @file scanner.hpp
+ * @brief Single-pass file scanning for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the FileScanner class, which reads a file once and
+ * derives everything the tracker and object store need from that read:
+ * the object hash, binary detection, line count and newline style, and
+ * optionally the compressed object data.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @enum NewlineStyle
+ * @brief Line ending convention of a file
+ */
+enum class NewlineStyle {
+    NONE,  /**< No line breaks */
+    LF,    /**< Unix line endings only */
+    CRLF,  /**< Windows line endings only */
+    MIXED  /**< Both kinds of line endings */
+};
+
+/**
+ * @struct ScanResult
+ * @brief Facts about a file's content gathered in one pass
+ */
+struct ScanResult {
+    std::string hash;                         /**< SHA-256 of the content, the object hash */
+    uint64_t size = 0;                        /**< Content size in bytes */
+    bool binary = false;                      /**< Whether the content looks binary */
+    uint64_t lines = 0;                       /**< Number of lines, counting an unterminated last line */
+    NewlineStyle newlines = NewlineStyle::NONE; /**< Line ending convention */
+};
+
+/**
+ * @class ScanStream
+ * @brief Incremental scan of content that arrives piece by piece
+ *
+ * Produces the same result as scanning the concatenated pieces at once.
+ * Used where content is generated rather than read from a file, such as
+ * the output of a filter.
+ */
+class ScanStream {
+public:
+    /**
+     * @brief Start a scan
+     */
+    ScanStream();
+
+    /**
+     * @brief Destructor
+     */
+    ~ScanStream();
+
+    ScanStream(const ScanStream&) = delete;
+    ScanStream& operator=(const ScanStream&) = delete;
+
+    /**
+     * @brief Scan the next piece of content
+     * @param data Content bytes
+     * @param size Number of bytes
+     */
+    void update(const char* data, size_t size);
+
+    /**
+     * @brief End the scan
+     * @return Scan result of all content passed to update()
+     */
+    ScanResult finish();
+
+private:
+    struct State;
+    std::unique_ptr<State> state;
+};
+
+/**
+ * @class FileScanner
+ * @brief Hashes, classifies and counts a file in a single streaming read
+ *
+ * The file is opened as a FileView and processed in fixed-size chunks, so
+ * large files are mapped rather than copied. Each chunk is hashed,
+ * classified and counted, and can additionally be handed to a sink or
+ * compressed, so callers that need the content do not read the file again.
+ */
+class FileScanner {
+public:
+    /**
+     * @brief Constructor for FileScanner
+     * @param chunkSize Size of the chunks handed to sinks, in bytes
+     */
+    explicit FileScanner(size_t chunkSize = 64 * 1024);
+
+    /**
+     * @brief Scan a file
+     * @param path File to scan
+     * @param result Receives the scan result
+     * @param contentSink Optional sink that receives the raw content chunk by chunk
+     * @return true if successful, false if the file could not be read or the sink aborted
+     */
+    bool scan(const fs::path& path, ScanResult& result,
+              const CompressionSink& contentSink = nullptr);
+
+    /**
+     * @brief Scan a file and compress it in the same pass
+     * @param path File to scan
+     * @param result Receives the scan result
+     * @param compressor Compressor fed with the content; finished when the file ends
+     * @param compressedSink Receives the compressed output
+     * @return true if successful, false otherwise
+     */
+    bool scan(const fs::path& path, ScanResult& result, Compressor& compressor,
+              const CompressionSink& compressedSink);
+
+    /**
+     * @brief Scan content that is already in memory
+     * @param data Content to scan
+     * @return Scan result
+     */
+    static ScanResult scanBuffer(std::string_view data);
+
+    /**
+     * @brief Check whether the start of a file looks binary
+     *
+     * Only the first 4 KiB are inspected: content containing NUL bytes or
+     * control characters other than tab, CR and LF is binary.
+     *
+     * @param prefix Leading bytes of the content
+     * @return true if the content looks binary
+     */
+    static bool looksBinary(std::string_view prefix);
+
+    /**
+     * @brief Number of leading bytes inspected by looksBinary()
+     */
+    static constexpr size_t kBinaryCheckSize = 4096;
+
+private:
+    size_t chunkSize;
+};
+
+} // namespace mimirion
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @file scheduler.hpp
+ * @brief Shared work-stealing task scheduler for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the TaskScheduler, the single thread pool every
+ * parallel code path in the library runs on, and TaskGroup, which tracks a
+ * set of related tasks so they can be waited on or cancelled together.
+ */
+
+namespace mimirion {
+
+class TaskGroup;
+
+/**
+ * @class TaskScheduler
+ * @brief Work-stealing thread pool shared by the whole library
+ *
+ * Each worker thread owns a deque of tasks. Workers push and pop at the
+ * back of their own deque and steal from the front of other workers'
+ * deques when they run dry. Tasks submitted from outside the pool are
+ * spread round-robin over the workers. Threads blocked in TaskGroup::wait()
+ * execute queued tasks instead of sleeping, so nested groups cannot
+ * deadlock the pool.
+ *
+ * The number of workers defaults to the number of hardware threads and can
+ * be set with the MIMIRION_THREADS environment variable. With
+ * MIMIRION_THREADS=0 no workers are started and tasks run inline.
+ */
+class TaskScheduler {
+public:
+    /**
+     * @struct Metrics
+     * @brief Counters describing scheduler activity
+     */
+    struct Metrics {
+        uint64_t tasksExecuted = 0; /**< Tasks run to completion (or skipped after cancel) */
+        uint64_t steals = 0;        /**< Tasks taken from another worker's deque */
+        size_t maxQueueDepth = 0;   /**< Largest single-deque depth observed */
+        size_t queuedTasks = 0;     /**< Tasks currently waiting in deques */
+        size_t threadCount = 0;     /**< Number of worker threads */
+    };
+
+    /**
+     * @brief Create a scheduler with a fixed number of workers
+     * @param threadCount Number of worker threads (0 runs tasks inline)
+     */
+    explicit TaskScheduler(size_t threadCount);
+
+    /**
+     * @brief Destructor, finishes queued tasks and joins the workers
+     */
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    /**
+     * @brief Get the process-wide scheduler, started on first use
+     * @return Shared scheduler instance
+     */
+    static TaskScheduler& instance();
+
+    /**
+     * @brief Get the worker count used by instance()
+     * @return Value of MIMIRION_THREADS, or the hardware thread count
+     */
+    static size_t defaultThreadCount();
+
+    /**
+     * @brief Get the number of worker threads
+     * @return Worker thread count
+     */
+    size_t threadCount() const;
+
+    /**
+     * @brief Get a snapshot of the scheduler counters
+     * @return Current metrics
+     */
+    Metrics getMetrics() const;
+
+    /**
+     * @brief Reset the cumulative counters
+     */
+    void resetMetrics();
+
+private:
+    friend class TaskGroup;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queued;
+    std::atomic<size_t> nextWorker;
+    std::atomic<bool> stopping;
+
+    std::atomic<uint64_t> tasksExecuted;
+    std::atomic<uint64_t> steals;
+    std::atomic<size_t> maxQueueDepth;
+
+    void submit(std::function<void()> task);
+    bool runOneTask();
+    bool popTask(size_t self, std::function<void()>& task);
+    void workerLoop(size_t index);
+};
+
+/**
+ * @class TaskGroup
+ * @brief A set of tasks that can be waited on and cancelled together
+ *
+ * Tasks added after cancel() are skipped, and long-running tasks can poll
+ * isCancelled() to stop early. The first exception thrown by a task is
+ * rethrown from wait(). The destructor waits for outstanding tasks.
+ */
+class TaskGroup {
+public:
+    /**
+     * @brief Create a group on a scheduler
+     * @param scheduler Scheduler to run tasks on
+     */
+    explicit TaskGroup(TaskScheduler& scheduler = TaskScheduler::instance());
+
+    /**
+     * @brief Destructor, waits for outstanding tasks
+     */
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    /**
+     * @brief Schedule a task
+     * @param task Function to run
+     */
+    void run(std::function<void()> task);
+
+    /**
+     * @brief Wait for every task in the group, helping to run queued tasks
+     * @throws The first exception thrown by a task
+     */
+    void wait();
+
+    /**
+     * @brief Skip tasks that have not started yet
+     */
+    void cancel();
+
+    /**
+     * @brief Check whether the group was cancelled
+     * @return true after cancel() was called, false otherwise
+     */
+    bool isCancelled() const;
+
+private:
+    TaskScheduler& scheduler;
+    std::atomic<size_t> outstanding;
+    std::atomic<bool> cancelled;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+
+    void finishTask();
+};
+
+/**
+ * @brief Run a function for every index in [0, count) on the shared scheduler
+ *
+ * Indices are processed in contiguous chunks to keep scheduling overhead low.
+ *
+ * @param count Number of iterations
+ * @param body Function called with each index
+ * @param grainSize Minimum number of indices per task
+ */
+void parallelFor(size_t count, const std::function<void(size_t)>& body, size_t grainSize = 16);
+
+} // namespace mimirion
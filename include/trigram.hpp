@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @file trigram.hpp
+ * @brief Trigram content index for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the TrigramIndex class, which maps 3-byte sequences
+ * to the blobs containing them so that searches of a commit only read the
+ * blobs that can match.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @class TrigramIndex
+ * @brief Posting lists from trigrams to blobs, stored in .mimirion/index.d
+ *
+ * Blobs are indexed by content hash, so every snapshot sharing a blob
+ * shares its postings and indexing a new commit only reads the blobs it
+ * changed. Each blob gets a numeric id from the append-only `blobs` table;
+ * each update writes a segment holding the posting lists of the blobs it
+ * added. A segment starts with a directory sorted by trigram, followed by
+ * one zlib-compressed, delta-varint encoded list of ids per trigram, so a
+ * query only inflates the lists it needs. Segments are merged once there
+ * are more than kMaxSegments.
+ *
+ * Trigrams are folded to ASCII lower case, so the same index serves case
+ * sensitive and insensitive searches; candidates are always verified
+ * against the content. Binary and oversized blobs get an id but no
+ * postings; segments list them separately and they are always candidates.
+ */
+class TrigramIndex {
+public:
+    /** @brief Segment count above which all segments are merged into one */
+    static constexpr size_t kMaxSegments = 8;
+
+    /** @brief Larger blobs are not indexed */
+    static constexpr uint64_t kMaxIndexedSize = 16 * 1024 * 1024;
+
+    /**
+     * @brief Constructor for TrigramIndex
+     * @param mimirionDir Path to the .mimirion directory
+     */
+    explicit TrigramIndex(const fs::path& mimirionDir);
+
+    /**
+     * @brief Index the blobs that are not indexed yet
+     * @param hashes Blob hashes, typically the files of a commit
+     * @param added Optional, receives the number of newly indexed blobs
+     * @return true if successful, false if the index could not be written
+     */
+    bool update(const std::vector<std::string>& hashes, size_t* added = nullptr);
+
+    /**
+     * @brief Find the blobs that may contain all of a set of literals
+     *
+     * Posting lists are intersected from the shortest up, and the search
+     * stops as soon as the intersection is empty.
+     *
+     * @param literals Strings every match contains
+     * @param hashes Receives the hashes of the candidate blobs, including
+     *        every blob that was not tokenized
+     * @return true if the literals narrowed the search, false if they are
+     *         too short to use the index and every blob is a candidate
+     */
+    bool candidates(const std::vector<std::string>& literals,
+                    std::unordered_set<std::string>& hashes) const;
+
+    /**
+     * @brief Check whether a blob is indexed
+     * @param hash Blob hash
+     * @return true if the blob has an id
+     */
+    bool contains(const std::string& hash) const;
+
+    /**
+     * @brief Get the number of indexed blobs
+     * @return Blob count
+     */
+    size_t blobCount() const;
+
+    /**
+     * @brief Get the number of segment files
+     * @return Segment count
+     */
+    size_t segmentCount() const;
+
+    /**
+     * @brief Collect the distinct trigrams of a text
+     * @param text Content to index
+     * @return Sorted trigrams, each packed into the low 24 bits, lower-cased
+     */
+    static std::vector<uint32_t> trigrams(std::string_view text);
+
+private:
+    struct Segment {
+        fs::path path;
+        uint32_t firstId = 0;
+        uint32_t blobCount = 0;
+    };
+
+    fs::path mimirionDir;
+    fs::path indexDir;
+    std::vector<std::string> blobs;
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<Segment> segments;
+
+    void load();
+    bool writeSegment(uint32_t firstId, uint32_t blobCount,
+                      const std::vector<std::pair<uint32_t, std::vector<uint32_t>>>& lists);
+    bool merge();
+};
+
+} // namespace mimirion
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <filesystem>
+#include <memory_resource>
+#include "compression.hpp"
 
 namespace mimirion {
 
@@ -48,21 +51,23 @@ std::string formatTimestamp(const std::chrono::system_clock::time_point& timesta
  * @param str ISO 8601 formatted string
  * @return Parsed timestamp
  */
-std::chrono::system_clock::time_point parseTimestamp(const std::string& str);
+std::chrono::system_clock::time_point parseTimestamp(std::string_view str);
 
 /**
  * @brief Compress data using zlib
  * @param data Input data
- * @return Compressed data
+ * @param level Compression level
+ * @return Compressed data, empty string on failure
  */
-std::string compress(const std::string& data);
+std::string compress(const std::string& data, CompressionLevel level = CompressionLevel::DEFAULT);
 
 /**
  * @brief Decompress data using zlib
  * @param data Compressed data
- * @return Decompressed data
+ * @param sizeHint Expected decompressed size, 0 if unknown
+ * @return Decompressed data, empty string on failure
  */
-std::string decompress(const std::string& data);
+std::string decompress(const std::string& data, size_t sizeHint = 0);
 
 /**
  * @brief Read entire file into string
@@ -94,6 +99,33 @@ bool createDirectory(const fs::path& path);
  */
 std::vector<std::string> split(const std::string& s, char delimiter);
 
+/**
+ * @brief Check that a path can be recorded in a commit
+ *
+ * Paths are checked out below the repository root, never outside it or
+ * into .mimirion, and commit objects list them one per line, followed by
+ * a tab. So the path must be relative, its components must not be empty,
+ * ".", ".." or ".mimirion", and it must not contain a tab or newline.
+ *
+ * @param path Path with '/' separators
+ * @return true if the path is safe to store and check out
+ */
+bool isSafePath(std::string_view path);
+
+/**
+ * @brief Split text into lines without copying them
+ * 
+ * Lines are separated by '\n'; a trailing newline does not produce an
+ * empty last line. The views point into the input, and the vector is
+ * allocated from the given resource (typically an Arena).
+ * 
+ * @param text Input text, must outlive the returned views
+ * @param resource Memory resource for the vector
+ * @return Vector of line views
+ */
+std::pmr::vector<std::string_view> splitLines(std::string_view text,
+                                              std::pmr::memory_resource* resource);
+
 /**
  * @brief Join strings with delimiter
  * @param strings Vector of strings
@@ -118,8 +150,8 @@ std::string base64Encode(const std::string& data);
 
 /**
  * @brief Base64 decode data
- * @param encoded Base64 encoded string
- * @return Decoded data
+ * @param encoded Base64 encoded string, optionally line-wrapped
+ * @return Decoded data, empty string if the input is not valid base64
  */
 std::string base64Decode(const std::string& encoded);
 
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/**
+ * @file worktree.hpp
+ * @brief Linked worktrees for the Mimirion VCS
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * This file contains the WorktreeManager class, which checks out further
+ * branches of a repository into directories of their own that share the
+ * repository's object store and refs.
+ */
+
+namespace mimirion {
+
+namespace fs = std::filesystem;
+
+/**
+ * @struct WorktreeInfo
+ * @brief A working directory of a repository
+ */
+struct WorktreeInfo {
+    std::string name;   /**< Name under .mimirion/worktrees, empty for the main worktree */
+    fs::path path;      /**< Root of the working directory */
+    std::string branch; /**< Branch HEAD points to, empty if detached */
+    std::string head;   /**< Commit HEAD resolves to, empty if there is none */
+};
+
+/**
+ * @class WorktreeManager
+ * @brief Adds, lists and removes linked worktrees
+ *
+ * A linked worktree has a `.mimirion` file instead of a directory, with
+ * one line `mimirdir: <path>` naming its directory in the main repository,
+ * `.mimirion/worktrees/<name>`. That directory holds the worktree's own
+ * HEAD and index, a `worktree` file with the path of the working
+ * directory and a `commondir` file pointing back at the main .mimirion
+ * directory. Its `objects`, `refs`, `config`, `lfs` and `import` entries
+ * are symbolic links into the main .mimirion directory, so code working
+ * on a .mimirion directory needs no changes for worktrees, and nothing but
+ * the checked out files is copied. Concurrent ref updates from different
+ * worktrees are serialized by the lock files of RefStore::writeRef.
+ *
+ * A branch can be checked out in one worktree at a time.
+ */
+class WorktreeManager {
+public:
+    /**
+     * @brief Constructor for WorktreeManager
+     * @param repoPath Path to the root of any worktree of the repository
+     * @param mimirionDir Path to that worktree's .mimirion directory
+     */
+    WorktreeManager(const fs::path& repoPath, const fs::path& mimirionDir);
+
+    /**
+     * @brief Create a worktree and check out a branch into it
+     * @param path Directory to create; it must not exist or be empty
+     * @param branch Existing branch that no other worktree has checked out
+     * @return true if successful, false otherwise
+     */
+    bool add(const fs::path& path, const std::string& branch);
+
+    /**
+     * @brief List the main worktree followed by the linked ones
+     * @return Worktrees, linked ones ordered by name
+     */
+    std::vector<WorktreeInfo> list() const;
+
+    /**
+     * @brief Remove a linked worktree and its working directory
+     *
+     * Unless forced, a worktree is only removed if every file in it is
+     * clean: tracked by its HEAD commit with the content stored there.
+     *
+     * @param worktree Name or path of the worktree
+     * @param force Remove the worktree even if it has changes
+     * @return true if successful, false otherwise
+     */
+    bool remove(const std::string& worktree, bool force = false);
+
+    /**
+     * @brief Drop the metadata of worktrees whose directories are gone
+     * @return Number of worktrees pruned
+     */
+    size_t prune();
+
+    /**
+     * @brief Get the main .mimirion directory shared by all worktrees
+     * @param mimirionDir .mimirion directory of any worktree
+     * @return The main .mimirion directory
+     */
+    static fs::path commonDir(const fs::path& mimirionDir);
+
+private:
+    fs::path repositoryPath;
+    fs::path mimirionDir;
+    fs::path mainDir;
+
+    bool find(const std::string& worktree, WorktreeInfo& info) const;
+    bool isClean(const WorktreeInfo& info) const;
+};
+
+} // namespace mimirion
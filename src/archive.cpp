@@ -0,0 +1,602 @@
+/**
+ * @file archive.cpp
+ * @brief Implementation of the Archiver class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/archive.hpp"
+#include "../include/commit.hpp"
+#include "../include/object_store.hpp"
+#include "../include/refs.hpp"
+#include "../include/scheduler.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+#include <zlib.h>
+
+namespace mimirion {
+
+namespace {
+
+// Output is handed to the sink in pieces of about this size
+constexpr size_t kOutputBufferSize = 256 * 1024;
+
+constexpr size_t kTarBlock = 512;
+// Archives are padded to a multiple of 20 blocks, like tar and git do
+constexpr size_t kTarRecord = 20 * kTarBlock;
+constexpr uint32_t kFileMode = 0100644;
+
+constexpr uint32_t kZip32Max = 0xffffffff;
+// Streamed zip entries near 4 GiB get Zip64 sizes, deflate may grow them
+constexpr uint64_t kZip64StreamLimit = kZip32Max - 16 * 1024 * 1024;
+
+struct Entry {
+    std::string path;      // archive path, prefix included
+    std::string hash;
+    uint64_t size = 0;     // content size, once known
+    bool streamed = false;
+    bool ready = false;    // data holds the prepared content
+    std::string data;      // content, or deflated content for zip
+    uint32_t crc = 0;
+    bool deflated = false;
+};
+
+// Buffers small writes and counts the bytes written
+class Output {
+public:
+    explicit Output(const CompressionSink& target) : sink(target) {
+        buffer.reserve(kOutputBufferSize);
+    }
+
+    bool write(const char* data, size_t size) {
+        written += size;
+        if (buffer.size() + size > kOutputBufferSize) {
+            if (!flush()) {
+                return false;
+            }
+            if (size >= kOutputBufferSize) {
+                return sink(data, size);
+            }
+        }
+        buffer.append(data, size);
+        return true;
+    }
+
+    bool write(std::string_view data) {
+        return write(data.data(), data.size());
+    }
+
+    bool flush() {
+        bool ok = buffer.empty() || sink(buffer.data(), buffer.size());
+        buffer.clear();
+        return ok;
+    }
+
+    uint64_t offset() const {
+        return written;
+    }
+
+private:
+    const CompressionSink& sink;
+    std::string buffer;
+    uint64_t written = 0;
+};
+
+void put16(std::string& out, uint16_t value) {
+    out.push_back(static_cast<char>(value & 0xff));
+    out.push_back(static_cast<char>(value >> 8));
+}
+
+void put32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+void put64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+uint32_t updateCrc(uint32_t crc, const char* data, size_t size) {
+    while (size > 0) {
+        uInt span = static_cast<uInt>(std::min<size_t>(size, UINT_MAX));
+        crc = static_cast<uint32_t>(crc32(crc, reinterpret_cast<const Bytef*>(data), span));
+        data += span;
+        size -= span;
+    }
+    return crc;
+}
+
+/**
+ * Writes entries in one container format. prepare() runs on the scheduler,
+ * everything else on the writing thread in archive order.
+ */
+class Formatter {
+public:
+    virtual ~Formatter() = default;
+    virtual void prepare(Entry& entry) const = 0;
+    virtual bool begin(const std::string& commitHash) = 0;
+    virtual bool writeEntry(const Entry& entry) = 0;
+    virtual bool writeStreamed(Entry& entry, ObjectStore& objects) = 0;
+    virtual bool finish(const std::string& commitHash) = 0;
+};
+
+class TarFormatter : public Formatter {
+public:
+    TarFormatter(Output& output, int64_t time) : out(output), mtime(time) {
+    }
+
+    void prepare(Entry&) const override {
+    }
+
+    bool begin(const std::string& commitHash) override {
+        // Records the commit like git archive, in a global pax header
+        std::string records = paxRecord("comment", commitHash);
+        return header("pax_global_header", records.size(), 'g') && out.write(records) &&
+               pad(records.size());
+    }
+
+    bool writeEntry(const Entry& entry) override {
+        return file(entry.path, entry.data.size()) && out.write(entry.data) && pad(entry.data.size());
+    }
+
+    bool writeStreamed(Entry& entry, ObjectStore& objects) override {
+        if (!file(entry.path, entry.size)) {
+            return false;
+        }
+        uint64_t produced = 0;
+        bool read = objects.readStream(entry.hash, [&](const char* data, size_t size) {
+            produced += size;
+            return out.write(data, size);
+        });
+        return read && produced == entry.size && pad(entry.size);
+    }
+
+    bool finish(const std::string&) override {
+        // Two zero blocks end the archive, then pad the last record
+        uint64_t end = out.offset() + 2 * kTarBlock;
+        uint64_t padded = (end + kTarRecord - 1) / kTarRecord * kTarRecord;
+        std::string zeros(padded - out.offset(), '\0');
+        return out.write(zeros);
+    }
+
+private:
+    Output& out;
+    int64_t mtime;
+
+    static std::string paxRecord(const std::string& key, const std::string& value) {
+        // "<length> key=value\n", where the length counts its own digits
+        size_t base = key.size() + value.size() + 3;
+        size_t length = base + std::to_string(base).size();
+        length = base + std::to_string(length).size();
+        return std::to_string(length) + " " + key + "=" + value + "\n";
+    }
+
+    bool file(const std::string& path, uint64_t size) {
+        std::string name = path;
+        std::string prefix;
+        std::string records;
+        if (name.size() > 100) {
+            // ustar splits long paths at a slash into prefix and name
+            size_t slash = name.rfind('/', 155);
+            if (slash != std::string::npos && slash > 0 && name.size() - slash - 1 <= 100 &&
+                name.size() - slash - 1 > 0) {
+                prefix = name.substr(0, slash);
+                name = name.substr(slash + 1);
+            } else {
+                records += paxRecord("path", path);
+                name = path.substr(0, 100);
+            }
+        }
+        if (size >= 077777777777ULL) {
+            records += paxRecord("size", std::to_string(size));
+        }
+        if (!records.empty() &&
+            !(header("pax_header", records.size(), 'x') && out.write(records) && pad(records.size()))) {
+            return false;
+        }
+        return header(name, size, '0', prefix);
+    }
+
+    bool header(const std::string& name, uint64_t size, char type, const std::string& prefix = "") {
+        char block[kTarBlock] = {};
+        std::memcpy(block, name.data(), std::min<size_t>(name.size(), 100));
+        std::snprintf(block + 100, 8, "%07o", kFileMode & 07777);
+        std::snprintf(block + 108, 8, "%07o", 0);
+        std::snprintf(block + 116, 8, "%07o", 0);
+        // Sizes too large for the field are given by a pax record
+        std::snprintf(block + 124, 12, "%011llo",
+                      static_cast<unsigned long long>(std::min<uint64_t>(size, 077777777777ULL)));
+        std::snprintf(block + 136, 12, "%011llo", static_cast<unsigned long long>(std::max<int64_t>(mtime, 0)));
+        std::memset(block + 148, ' ', 8);
+        block[156] = type;
+        std::memcpy(block + 257, "ustar", 6);
+        std::memcpy(block + 263, "00", 2);
+        std::memcpy(block + 265, "root", 4);
+        std::memcpy(block + 297, "root", 4);
+        std::memcpy(block + 345, prefix.data(), std::min<size_t>(prefix.size(), 155));
+
+        unsigned checksum = 0;
+        for (char c : block) {
+            checksum += static_cast<unsigned char>(c);
+        }
+        std::snprintf(block + 148, 8, "%06o", checksum);
+        block[155] = ' ';
+        return out.write(block, kTarBlock);
+    }
+
+    bool pad(uint64_t size) {
+        static const char zeros[kTarBlock] = {};
+        size_t remainder = size % kTarBlock;
+        return remainder == 0 || out.write(zeros, kTarBlock - remainder);
+    }
+};
+
+class ZipFormatter : public Formatter {
+public:
+    ZipFormatter(Output& output, int64_t time, CompressionLevel compression)
+        : out(output), level(compression) {
+        // DOS timestamps, in UTC so the archive does not depend on the zone
+        std::time_t seconds = static_cast<std::time_t>(std::max<int64_t>(time, 315532800));
+        std::tm utc = {};
+        gmtime_r(&seconds, &utc);
+        dosDate = static_cast<uint16_t>(((utc.tm_year - 80) << 9) | ((utc.tm_mon + 1) << 5) | utc.tm_mday);
+        dosTime = static_cast<uint16_t>((utc.tm_hour << 11) | (utc.tm_min << 5) | (utc.tm_sec / 2));
+    }
+
+    void prepare(Entry& entry) const override {
+        entry.crc = updateCrc(0, entry.data.data(), entry.data.size());
+        std::string deflated;
+        Compressor compressor(level, CompressionFormat::RAW);
+        auto append = [&deflated](const char* data, size_t size) {
+            deflated.append(data, size);
+            return true;
+        };
+        // Content that does not shrink is stored
+        if (compressor.write(entry.data.data(), entry.data.size(), append) && compressor.finish(append) &&
+            deflated.size() < entry.data.size()) {
+            entry.data.swap(deflated);
+            entry.deflated = true;
+        }
+    }
+
+    bool begin(const std::string&) override {
+        return true;
+    }
+
+    bool writeEntry(const Entry& entry) override {
+        Central central{entry.path, entry.crc, entry.data.size(), entry.size, out.offset(),
+                        static_cast<uint16_t>(entry.deflated ? 8 : 0), kUtf8};
+        central.zip64 = central.compressed >= kZip32Max || central.size >= kZip32Max;
+        bool ok = localHeader(central, false) && out.write(entry.data);
+        entries.push_back(std::move(central));
+        return ok;
+    }
+
+    bool writeStreamed(Entry& entry, ObjectStore& objects) override {
+        // Sizes and CRC follow the data in a data descriptor
+        Central central{entry.path, 0, 0, 0, out.offset(), 8, kUtf8 | kDataDescriptor};
+        central.zip64 = entry.size >= kZip64StreamLimit;
+        if (!localHeader(central, true)) {
+            return false;
+        }
+
+        Compressor compressor(level, CompressionFormat::RAW);
+        auto emit = [&](const char* data, size_t size) {
+            central.compressed += size;
+            return out.write(data, size);
+        };
+        bool read = objects.readStream(entry.hash, [&](const char* data, size_t size) {
+            central.crc = updateCrc(central.crc, data, size);
+            central.size += size;
+            return compressor.write(data, size, emit);
+        });
+        if (!read || !compressor.finish(emit) || central.size != entry.size ||
+            (!central.zip64 && central.compressed >= kZip32Max)) {
+            return false;
+        }
+
+        std::string descriptor;
+        put32(descriptor, 0x08074b50);
+        put32(descriptor, central.crc);
+        if (central.zip64) {
+            put64(descriptor, central.compressed);
+            put64(descriptor, central.size);
+        } else {
+            put32(descriptor, static_cast<uint32_t>(central.compressed));
+            put32(descriptor, static_cast<uint32_t>(central.size));
+        }
+        entries.push_back(std::move(central));
+        return out.write(descriptor);
+    }
+
+    bool finish(const std::string& commitHash) override {
+        uint64_t directoryOffset = out.offset();
+        for (const auto& entry : entries) {
+            if (!centralHeader(entry)) {
+                return false;
+            }
+        }
+        uint64_t directorySize = out.offset() - directoryOffset;
+
+        std::string end;
+        bool zip64 = entries.size() >= 0xffff || directoryOffset >= kZip32Max || directorySize >= kZip32Max;
+        if (zip64) {
+            uint64_t recordOffset = out.offset();
+            put32(end, 0x06064b50);
+            put64(end, 44);
+            put16(end, kMadeBy);
+            put16(end, 45);
+            put32(end, 0);
+            put32(end, 0);
+            put64(end, entries.size());
+            put64(end, entries.size());
+            put64(end, directorySize);
+            put64(end, directoryOffset);
+            put32(end, 0x07064b50);
+            put32(end, 0);
+            put64(end, recordOffset);
+            put32(end, 1);
+        }
+
+        // The commit hash is the archive comment, like git archive
+        uint16_t count = static_cast<uint16_t>(std::min<size_t>(entries.size(), 0xffff));
+        put32(end, 0x06054b50);
+        put16(end, 0);
+        put16(end, 0);
+        put16(end, count);
+        put16(end, count);
+        put32(end, static_cast<uint32_t>(std::min<uint64_t>(directorySize, kZip32Max)));
+        put32(end, static_cast<uint32_t>(std::min<uint64_t>(directoryOffset, kZip32Max)));
+        put16(end, static_cast<uint16_t>(commitHash.size()));
+        end += commitHash;
+        return out.write(end);
+    }
+
+private:
+    static constexpr uint16_t kUtf8 = 0x0800;
+    static constexpr uint16_t kDataDescriptor = 0x0008;
+    // Unix, specification 4.5
+    static constexpr uint16_t kMadeBy = (3 << 8) | 45;
+
+    struct Central {
+        std::string path;
+        uint32_t crc;
+        uint64_t compressed;
+        uint64_t size;
+        uint64_t offset;
+        uint16_t method;
+        uint16_t flags;
+        bool zip64 = false;
+    };
+
+    Output& out;
+    CompressionLevel level;
+    uint16_t dosDate = 0;
+    uint16_t dosTime = 0;
+    std::vector<Central> entries;
+
+    void common(std::string& header, const Central& entry, bool zip64) const {
+        put16(header, zip64 ? 45 : 20);
+        put16(header, entry.flags);
+        put16(header, entry.method);
+        put16(header, dosTime);
+        put16(header, dosDate);
+        put32(header, entry.crc);
+    }
+
+    bool localHeader(const Central& entry, bool streamed) {
+        std::string header;
+        put32(header, 0x04034b50);
+        common(header, entry, entry.zip64);
+        std::string extra;
+        if (entry.zip64) {
+            // Streamed entries give their real sizes in the descriptor
+            put16(extra, 0x0001);
+            put16(extra, 16);
+            put64(extra, streamed ? 0 : entry.size);
+            put64(extra, streamed ? 0 : entry.compressed);
+            put32(header, kZip32Max);
+            put32(header, kZip32Max);
+        } else {
+            put32(header, static_cast<uint32_t>(entry.compressed));
+            put32(header, static_cast<uint32_t>(entry.size));
+        }
+        put16(header, static_cast<uint16_t>(entry.path.size()));
+        put16(header, static_cast<uint16_t>(extra.size()));
+        header += entry.path;
+        header += extra;
+        return out.write(header);
+    }
+
+    bool centralHeader(const Central& entry) {
+        bool largeSize = entry.size >= kZip32Max || entry.zip64;
+        bool largeCompressed = entry.compressed >= kZip32Max || entry.zip64;
+        bool largeOffset = entry.offset >= kZip32Max;
+        std::string extra;
+        if (largeSize || largeCompressed || largeOffset) {
+            std::string fields;
+            if (largeSize) {
+                put64(fields, entry.size);
+            }
+            if (largeCompressed) {
+                put64(fields, entry.compressed);
+            }
+            if (largeOffset) {
+                put64(fields, entry.offset);
+            }
+            put16(extra, 0x0001);
+            put16(extra, static_cast<uint16_t>(fields.size()));
+            extra += fields;
+        }
+
+        std::string header;
+        put32(header, 0x02014b50);
+        put16(header, kMadeBy);
+        common(header, entry, !extra.empty());
+        put32(header, largeCompressed ? kZip32Max : static_cast<uint32_t>(entry.compressed));
+        put32(header, largeSize ? kZip32Max : static_cast<uint32_t>(entry.size));
+        put16(header, static_cast<uint16_t>(entry.path.size()));
+        put16(header, static_cast<uint16_t>(extra.size()));
+        put16(header, 0);
+        put16(header, 0);
+        put16(header, 0);
+        put32(header, kFileMode << 16);
+        put32(header, largeOffset ? kZip32Max : static_cast<uint32_t>(entry.offset));
+        header += entry.path;
+        header += extra;
+        return out.write(header);
+    }
+};
+
+} // namespace
+
+Archiver::Archiver(const fs::path& repoPath, const fs::path& mimirDir)
+    : repositoryPath(repoPath), mimirionDir(mimirDir) {
+}
+
+bool Archiver::write(const std::string& revision, const ArchiveOptions& options, const CompressionSink& sink) {
+    ObjectStore objects(mimirionDir);
+    std::string commitHash = RefStore(mimirionDir).resolve(revision, &objects);
+    CommitManager commits(repositoryPath, mimirionDir);
+    CommitInfo* commit = commitHash.empty() ? nullptr : commits.getCommit(commitHash);
+    if (!commit) {
+        std::cerr << "Unknown revision: " << revision << std::endl;
+        return false;
+    }
+
+    std::map<std::string, std::string> files(commit->fileHashes.begin(), commit->fileHashes.end());
+    std::vector<Entry> entries;
+    entries.reserve(files.size());
+    for (const auto& [path, hash] : files) {
+        Entry entry;
+        entry.path = options.prefix + path;
+        entry.hash = hash;
+        // Objects from before size headers are read whole to learn their size
+        entry.streamed = objects.objectSize(hash, entry.size) && entry.size > kStreamThreshold;
+        entries.push_back(std::move(entry));
+    }
+
+    // Windows of read-ahead entries; a streamed entry is a window of its own
+    std::vector<std::pair<size_t, size_t>> windows;
+    for (size_t i = 0; i < entries.size();) {
+        size_t end = i + 1;
+        uint64_t bytes = entries[i].size;
+        while (!entries[i].streamed && end < entries.size() && !entries[end].streamed &&
+               end - i < kWindowFiles && bytes < kWindowBytes) {
+            bytes += entries[end++].size;
+        }
+        windows.emplace_back(i, end);
+        i = end;
+    }
+
+    // tgz is the tar stream run through gzip
+    Compressor gzip(options.level, CompressionFormat::GZIP);
+    CompressionSink gzipSink = [&](const char* data, size_t size) {
+        return gzip.write(data, size, sink);
+    };
+    bool compressed = options.format == ArchiveFormat::TGZ;
+    Output out(compressed ? gzipSink : sink);
+
+    int64_t mtime = static_cast<int64_t>(std::chrono::system_clock::to_time_t(commit->timestamp));
+    std::unique_ptr<Formatter> formatter;
+    if (options.format == ArchiveFormat::ZIP) {
+        formatter = std::make_unique<ZipFormatter>(out, mtime, options.level);
+    } else {
+        formatter = std::make_unique<TarFormatter>(out, mtime);
+    }
+
+    auto readAhead = [&](size_t window, TaskGroup& group) {
+        for (size_t i = windows[window].first; i < windows[window].second; ++i) {
+            Entry& entry = entries[i];
+            if (entry.streamed) {
+                continue;
+            }
+            group.run([&entry, &objects, &formatter]() {
+                entry.ready = objects.readStream(entry.hash, [&entry](const char* data, size_t size) {
+                    entry.data.append(data, size);
+                    return true;
+                });
+                if (entry.ready) {
+                    entry.size = entry.data.size();
+                    formatter->prepare(entry);
+                }
+            });
+        }
+    };
+
+    if (!formatter->begin(commit->hash)) {
+        return false;
+    }
+    if (!windows.empty()) {
+        TaskGroup first;
+        readAhead(0, first);
+        first.wait();
+    }
+    for (size_t window = 0; window < windows.size(); ++window) {
+        // The next window is read while this one is written
+        TaskGroup next;
+        if (window + 1 < windows.size()) {
+            readAhead(window + 1, next);
+        }
+
+        for (size_t i = windows[window].first; i < windows[window].second; ++i) {
+            Entry& entry = entries[i];
+            bool ok = entry.streamed ? formatter->writeStreamed(entry, objects)
+                                     : entry.ready && formatter->writeEntry(entry);
+            if (!ok) {
+                std::cerr << "Failed to archive " << entry.path << " (" << entry.hash << ")" << std::endl;
+                next.cancel();
+                return false;
+            }
+            std::string().swap(entry.data);
+        }
+        next.wait();
+    }
+
+    if (!formatter->finish(commit->hash) || !out.flush()) {
+        return false;
+    }
+    return !compressed || gzip.finish(sink);
+}
+
+bool Archiver::parseFormat(const std::string& name, ArchiveFormat& format) {
+    if (name == "tar") {
+        format = ArchiveFormat::TAR;
+    } else if (name == "tgz" || name == "tar.gz") {
+        format = ArchiveFormat::TGZ;
+    } else if (name == "zip") {
+        format = ArchiveFormat::ZIP;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool Archiver::formatForPath(const fs::path& path, ArchiveFormat& format) {
+    std::string name = path.filename().string();
+    auto endsWith = [&name](const std::string& suffix) {
+        return name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    if (endsWith(".tar.gz") || endsWith(".tgz")) {
+        format = ArchiveFormat::TGZ;
+    } else if (endsWith(".tar")) {
+        format = ArchiveFormat::TAR;
+    } else if (endsWith(".zip")) {
+        format = ArchiveFormat::ZIP;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace mimirion
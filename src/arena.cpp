@@ -0,0 +1,57 @@
+/**
+ * @file arena.cpp
+ * @brief Implementation of the Arena class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/arena.hpp"
+
+namespace mimirion {
+
+Arena::Arena(size_t initialSize)
+    : monotonic(initialSize), counting(&monotonic) {
+}
+
+Arena::Arena(void* buffer, size_t size)
+    : monotonic(buffer, size), counting(&monotonic) {
+}
+
+std::pmr::memory_resource* Arena::resource() {
+    return &counting;
+}
+
+size_t Arena::bytesAllocated() const {
+    return counting.bytes;
+}
+
+size_t Arena::allocationCount() const {
+    return counting.count;
+}
+
+void Arena::release() {
+    monotonic.release();
+    counting.bytes = 0;
+    counting.count = 0;
+}
+
+Arena::CountingResource::CountingResource(std::pmr::memory_resource* up)
+    : bytes(0), count(0), upstream(up) {
+}
+
+void* Arena::CountingResource::do_allocate(size_t size, size_t alignment) {
+    bytes += size;
+    ++count;
+    return upstream->allocate(size, alignment);
+}
+
+void Arena::CountingResource::do_deallocate(void* p, size_t size, size_t alignment) {
+    // Monotonic: memory comes back when the whole arena is released
+    upstream->deallocate(p, size, alignment);
+}
+
+bool Arena::CountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+} // namespace mimirion
@@ -0,0 +1,155 @@
+/**
+ * @file attributes.cpp
+ * @brief Implementation of the Attributes class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/attributes.hpp"
+#include "../include/utils.hpp"
+#include <fnmatch.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace mimirion {
+
+Attributes Attributes::load(const fs::path& repoPath) {
+    fs::path file = repoPath / kFileName;
+    if (!fs::is_regular_file(file)) {
+        return Attributes();
+    }
+    return parse(utils::readFile(file));
+}
+
+Attributes Attributes::parse(const std::string& text) {
+    Attributes attributes;
+    std::istringstream stream(text);
+    std::string line;
+    while (std::getline(stream, line)) {
+        std::istringstream fields(line);
+        Rule rule;
+        if (!(fields >> rule.pattern) || rule.pattern[0] == '#') {
+            continue;
+        }
+
+        std::string token;
+        while (fields >> token) {
+            size_t equals = token.find('=');
+            if (equals != std::string::npos) {
+                rule.values.emplace_back(token.substr(0, equals), token.substr(equals + 1));
+            } else if (token[0] == '-' && token.size() > 1) {
+                rule.values.emplace_back(token.substr(1), "false");
+            } else {
+                rule.values.emplace_back(token, "true");
+            }
+        }
+        if (!rule.values.empty()) {
+            attributes.rules.push_back(std::move(rule));
+        }
+    }
+    return attributes;
+}
+
+std::optional<std::string> Attributes::get(const std::string& path, const std::string& name) const {
+    // Later rules override earlier ones, so look from the end
+    for (auto rule = rules.rbegin(); rule != rules.rend(); ++rule) {
+        for (auto value = rule->values.rbegin(); value != rule->values.rend(); ++value) {
+            if (value->first == name && matches(rule->pattern, path)) {
+                return value->second;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+std::map<std::string, std::string> Attributes::getAll(const std::string& path) const {
+    std::map<std::string, std::string> values;
+    for (const auto& rule : rules) {
+        if (matches(rule.pattern, path)) {
+            for (const auto& value : rule.values) {
+                values[value.first] = value.second;
+            }
+        }
+    }
+    return values;
+}
+
+std::vector<std::string> Attributes::patternsWith(const std::string& name,
+                                                  const std::string& value) const {
+    std::vector<std::string> patterns;
+    for (const auto& rule : rules) {
+        for (const auto& entry : rule.values) {
+            if (entry.first == name && entry.second == value) {
+                patterns.push_back(rule.pattern);
+                break;
+            }
+        }
+    }
+    return patterns;
+}
+
+bool Attributes::empty() const {
+    return rules.empty();
+}
+
+bool Attributes::addRule(const fs::path& repoPath, const std::string& pattern,
+                         const std::string& attribute) {
+    fs::path file = repoPath / kFileName;
+    std::string existing = fs::exists(file) ? utils::readFile(file) : "";
+
+    size_t equals = attribute.find('=');
+    std::string name = attribute.substr(0, equals);
+    std::string value = equals == std::string::npos ? "true" : attribute.substr(equals + 1);
+    for (const auto& known : parse(existing).patternsWith(name, value)) {
+        if (known == pattern) {
+            return true;
+        }
+    }
+
+    std::ofstream out(file, std::ios::app);
+    if (!out) {
+        std::cerr << "Failed to update " << kFileName << std::endl;
+        return false;
+    }
+    if (!existing.empty() && existing.back() != '\n') {
+        out << '\n';
+    }
+    out << pattern << ' ' << attribute << '\n';
+    return out.good();
+}
+
+bool Attributes::matches(const std::string& pattern, const std::string& path) {
+    if (pattern.find('/') == std::string::npos) {
+        // Bare patterns match the file name at any depth
+        size_t slash = path.rfind('/');
+        std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+        return fnmatch(pattern.c_str(), name.c_str(), 0) == 0;
+    }
+
+    std::string anchored = pattern[0] == '/' ? pattern.substr(1) : pattern;
+
+    // dir/** matches everything below dir; without FNM_PATHNAME the
+    // trailing * also crosses slashes
+    if (anchored.size() > 3 && anchored.compare(anchored.size() - 3, 3, "/**") == 0) {
+        std::string below = anchored.substr(0, anchored.size() - 1);
+        return fnmatch(below.c_str(), path.c_str(), 0) == 0;
+    }
+
+    // **/rest matches rest at any depth
+    if (anchored.compare(0, 3, "**/") == 0) {
+        std::string rest = anchored.substr(3);
+        for (size_t start = 0; start != std::string::npos;) {
+            if (fnmatch(rest.c_str(), path.c_str() + start, FNM_PATHNAME) == 0) {
+                return true;
+            }
+            size_t slash = path.find('/', start);
+            start = slash == std::string::npos ? slash : slash + 1;
+        }
+        return false;
+    }
+
+    return fnmatch(anchored.c_str(), path.c_str(), FNM_PATHNAME) == 0;
+}
+
+} // namespace mimirion
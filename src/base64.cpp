@@ -0,0 +1,529 @@
+/**
+ * @file base64.cpp
+ * @brief Implementation of the Base64Encoder and Base64Decoder classes
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * The SIMD kernels follow Wojciech Muła's pshufb-based base64 algorithms.
+ * They are compiled with per-function target attributes, so the library
+ * itself still runs on any x86-64 CPU and only uses them when the CPU
+ * reports support at runtime.
+ */
+
+#include "../include/base64.hpp"
+#include <algorithm>
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MIMIRION_BASE64_X86 1
+#include <immintrin.h>
+#endif
+
+namespace mimirion {
+
+namespace {
+
+// Encoded characters handed to a sink at a time; a multiple of 4
+constexpr size_t kBufferSize = 64 * 1024;
+
+// SIMD decoders store whole vectors, overshooting their output by this much
+constexpr size_t kSlack = 8;
+
+constexpr char kAlphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+struct DecodeTable {
+    signed char values[256];
+
+    constexpr DecodeTable() : values() {
+        for (int i = 0; i < 256; ++i) {
+            values[i] = -1;
+        }
+        for (int i = 0; i < 64; ++i) {
+            values[static_cast<unsigned char>(kAlphabet[i])] = static_cast<signed char>(i);
+        }
+    }
+};
+
+constexpr DecodeTable kDecodeTable;
+
+inline bool isSpace(char c) {
+    return c == '\n' || c == '\r' || c == ' ' || c == '\t';
+}
+
+// Encode whole triplets; size must be a multiple of 3
+size_t encodeScalar(const unsigned char* in, size_t size, char* out) {
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t v = (uint32_t(in[i]) << 16) | (uint32_t(in[i + 1]) << 8) | in[i + 2];
+        *out++ = kAlphabet[(v >> 18) & 0x3f];
+        *out++ = kAlphabet[(v >> 12) & 0x3f];
+        *out++ = kAlphabet[(v >> 6) & 0x3f];
+        *out++ = kAlphabet[v & 0x3f];
+    }
+    return size;
+}
+
+// Encode the final one or two bytes with padding
+void encodeTail(const unsigned char* in, size_t size, char* out) {
+    uint32_t v = uint32_t(in[0]) << 16;
+    if (size > 1) {
+        v |= uint32_t(in[1]) << 8;
+    }
+    out[0] = kAlphabet[(v >> 18) & 0x3f];
+    out[1] = kAlphabet[(v >> 12) & 0x3f];
+    out[2] = size > 1 ? kAlphabet[(v >> 6) & 0x3f] : '=';
+    out[3] = '=';
+}
+
+// Decode whole quads of alphabet characters, stopping at the first quad
+// that holds anything else; returns the characters consumed
+size_t decodeScalar(const char* in, size_t size, unsigned char* out, size_t& produced) {
+    size_t consumed = 0;
+    while (size - consumed >= 4) {
+        const unsigned char* q = reinterpret_cast<const unsigned char*>(in + consumed);
+        int a = kDecodeTable.values[q[0]];
+        int b = kDecodeTable.values[q[1]];
+        int c = kDecodeTable.values[q[2]];
+        int d = kDecodeTable.values[q[3]];
+        if ((a | b | c | d) < 0) {
+            break;
+        }
+        uint32_t v = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | uint32_t(d);
+        out[produced++] = static_cast<unsigned char>(v >> 16);
+        out[produced++] = static_cast<unsigned char>(v >> 8);
+        out[produced++] = static_cast<unsigned char>(v);
+        consumed += 4;
+    }
+    return consumed;
+}
+
+#ifdef MIMIRION_BASE64_X86
+
+// 12 input bytes per 16 output characters
+__attribute__((target("ssse3")))
+size_t encodeSsse3(const unsigned char* in, size_t size, char* out) {
+    const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+    size_t done = 0;
+    while (size - done >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + done));
+        v = _mm_shuffle_epi8(v, shuffle);
+
+        // Spread each 24-bit group into four 6-bit indices
+        __m128i hi = _mm_mulhi_epu16(_mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00)),
+                                     _mm_set1_epi32(0x04000040));
+        __m128i lo = _mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi32(0x003f03f0)),
+                                     _mm_set1_epi32(0x01000010));
+        __m128i indices = _mm_or_si128(hi, lo);
+
+        // Map each index range to the offset that turns it into ASCII
+        __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+        __m128i chars = _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), chars);
+        done += 12;
+        out += 16;
+    }
+    return done + encodeScalar(in + done, size - done, out);
+}
+
+// 24 input bytes per 32 output characters
+__attribute__((target("avx2")))
+size_t encodeAvx2(const unsigned char* in, size_t size, char* out) {
+    const __m256i shuffle = _mm256_broadcastsi128_si256(
+        _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m256i offsets = _mm256_broadcastsi128_si256(
+        _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0));
+
+    size_t done = 0;
+    while (size - done >= 28) {
+        // Each lane gets 12 of the 24 bytes
+        __m256i v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + done))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + done + 12)), 1);
+        v = _mm256_shuffle_epi8(v, shuffle);
+
+        __m256i hi = _mm256_mulhi_epu16(_mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00)),
+                                        _mm256_set1_epi32(0x04000040));
+        __m256i lo = _mm256_mullo_epi16(_mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0)),
+                                        _mm256_set1_epi32(0x01000010));
+        __m256i indices = _mm256_or_si256(hi, lo);
+
+        __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        range = _mm256_or_si256(range, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+        __m256i chars = _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), chars);
+        done += 24;
+        out += 32;
+    }
+    return done + encodeSsse3(in + done, size - done, out);
+}
+
+// 16 input characters per 12 output bytes; stops at any block holding a
+// character outside the alphabet and leaves it to the scalar code
+__attribute__((target("ssse3")))
+size_t decodeSsse3(const char* in, size_t size, unsigned char* out, size_t& produced) {
+    const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                        0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                          0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2f = _mm_set1_epi8(0x2f);
+    const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    size_t consumed = 0;
+    while (size - consumed >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + consumed));
+        __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(v, 4), mask2f);
+        __m128i loNibbles = _mm_and_si128(v, mask2f);
+        __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+        __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0) {
+            break;
+        }
+
+        // Characters to 6-bit values, then four values to three bytes
+        __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(v, mask2f), hiNibbles));
+        v = _mm_add_epi8(v, roll);
+        v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+        v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+        v = _mm_shuffle_epi8(v, pack);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + produced), v);
+        consumed += 16;
+        produced += 12;
+    }
+    return consumed + decodeScalar(in + consumed, size - consumed, out, produced);
+}
+
+// 32 input characters per 24 output bytes
+__attribute__((target("avx2")))
+size_t decodeAvx2(const char* in, size_t size, unsigned char* out, size_t& produced) {
+    const __m256i lutLo = _mm256_broadcastsi128_si256(
+        _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                      0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a));
+    const __m256i lutHi = _mm256_broadcastsi128_si256(
+        _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10));
+    const __m256i lutRoll = _mm256_broadcastsi128_si256(
+        _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0));
+    const __m256i mask2f = _mm256_set1_epi8(0x2f);
+    const __m256i pack = _mm256_broadcastsi128_si256(
+        _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+
+    size_t consumed = 0;
+    while (size - consumed >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + consumed));
+        __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(v, 4), mask2f);
+        __m256i loNibbles = _mm256_and_si256(v, mask2f);
+        __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+        __m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+        if (!_mm256_testz_si256(lo, hi)) {
+            break;
+        }
+
+        __m256i roll = _mm256_shuffle_epi8(lutRoll,
+                                           _mm256_add_epi8(_mm256_cmpeq_epi8(v, mask2f), hiNibbles));
+        v = _mm256_add_epi8(v, roll);
+        v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+        v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+        v = _mm256_shuffle_epi8(v, pack);
+
+        // Close the gap between the two lanes' 12-byte results
+        v = _mm256_permutevar8x32_epi32(v, lanes);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + produced), v);
+        consumed += 32;
+        produced += 24;
+    }
+    return consumed + decodeSsse3(in + consumed, size - consumed, out, produced);
+}
+
+bool hasAvx2() {
+    return __builtin_cpu_supports("avx2");
+}
+
+bool hasSsse3() {
+    return __builtin_cpu_supports("ssse3");
+}
+
+#endif
+
+bool always() {
+    return true;
+}
+
+struct Kernel {
+    const char* name;
+    bool (*supported)();
+    size_t (*encode)(const unsigned char* in, size_t size, char* out);
+    size_t (*decode)(const char* in, size_t size, unsigned char* out, size_t& produced);
+};
+
+// In order of preference
+const Kernel kKernels[] = {
+#ifdef MIMIRION_BASE64_X86
+    {"avx2", hasAvx2, encodeAvx2, decodeAvx2},
+    {"ssse3", hasSsse3, encodeSsse3, decodeSsse3},
+#endif
+    {"scalar", always, encodeScalar, decodeScalar},
+};
+
+std::atomic<const Kernel*> activeKernel{nullptr};
+
+const Kernel& kernel() {
+    const Kernel* active = activeKernel.load(std::memory_order_relaxed);
+    if (!active) {
+        for (const Kernel& candidate : kKernels) {
+            if (candidate.supported()) {
+                active = &candidate;
+                break;
+            }
+        }
+        activeKernel.store(active, std::memory_order_relaxed);
+    }
+    return *active;
+}
+
+} // namespace
+
+Base64Encoder::Base64Encoder() : pending(), pendingCount(0) {
+}
+
+bool Base64Encoder::write(const char* data, size_t size, const Base64Sink& sink) {
+    if (!buffer) {
+        buffer = std::make_unique<char[]>(kBufferSize);
+    }
+
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(data);
+    size_t used = 0;
+
+    // Complete the triplet left over from the previous write
+    if (pendingCount > 0) {
+        while (pendingCount < 3 && size > 0) {
+            pending[pendingCount++] = *in++;
+            --size;
+        }
+        if (pendingCount < 3) {
+            return true;
+        }
+        encodeScalar(pending, 3, buffer.get());
+        used = 4;
+        pendingCount = 0;
+    }
+
+    const Kernel& active = kernel();
+    while (size >= 3) {
+        size_t chunk = std::min(size / 3, (kBufferSize - used) / 4) * 3;
+        active.encode(in, chunk, buffer.get() + used);
+        used += chunk / 3 * 4;
+        in += chunk;
+        size -= chunk;
+
+        if (!sink(buffer.get(), used)) {
+            return false;
+        }
+        used = 0;
+    }
+
+    if (used > 0 && !sink(buffer.get(), used)) {
+        return false;
+    }
+
+    while (size > 0) {
+        pending[pendingCount++] = *in++;
+        --size;
+    }
+    return true;
+}
+
+bool Base64Encoder::finish(const Base64Sink& sink) {
+    if (pendingCount == 0) {
+        return true;
+    }
+
+    char tail[4];
+    encodeTail(pending, pendingCount, tail);
+    pendingCount = 0;
+    return sink(tail, sizeof(tail));
+}
+
+void Base64Encoder::encode(std::string_view data, std::string& out) {
+    size_t base = out.size();
+    out.resize(base + encodedSize(data.size()));
+
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(data.data());
+    char* dst = &out[base];
+    size_t whole = data.size() / 3 * 3;
+    kernel().encode(in, whole, dst);
+    if (whole < data.size()) {
+        encodeTail(in + whole, data.size() - whole, dst + whole / 3 * 4);
+    }
+}
+
+size_t Base64Encoder::encodedSize(size_t size) {
+    return (size + 2) / 3 * 4;
+}
+
+Base64Decoder::Base64Decoder() : bits(0), count(0), paddingLeft(0), ended(false), ok(true) {
+}
+
+bool Base64Decoder::decodeSpan(const char*& data, size_t& size, unsigned char* out,
+                               size_t capacity, size_t& produced) {
+    const Kernel& active = kernel();
+    while (size > 0 && produced + 3 <= capacity) {
+        // Whole quads go through the bulk kernel
+        if (count == 0 && !ended && size >= 16) {
+            size_t limit = std::min(size, (capacity - produced) / 3 * 4);
+            size_t consumed = active.decode(data, limit, out, produced);
+            data += consumed;
+            size -= consumed;
+            if (consumed > 0) {
+                continue;
+            }
+        }
+
+        // Whitespace, padding and partial quads are handled a character at a time
+        char c = *data++;
+        --size;
+        if (isSpace(c)) {
+            continue;
+        }
+        if (ended) {
+            if (c != '=' || paddingLeft == 0) {
+                ok = false;
+                return false;
+            }
+            --paddingLeft;
+            continue;
+        }
+        if (c == '=') {
+            if (count < 2 || !flushQuantum(out, produced)) {
+                ok = false;
+                return false;
+            }
+            paddingLeft = 4 - count - 1;
+            count = 0;
+            ended = true;
+            continue;
+        }
+
+        int value = kDecodeTable.values[static_cast<unsigned char>(c)];
+        if (value < 0) {
+            ok = false;
+            return false;
+        }
+        bits = (bits << 6) | static_cast<uint32_t>(value);
+        if (++count == 4) {
+            out[produced++] = static_cast<unsigned char>(bits >> 16);
+            out[produced++] = static_cast<unsigned char>(bits >> 8);
+            out[produced++] = static_cast<unsigned char>(bits);
+            bits = 0;
+            count = 0;
+        }
+    }
+    return true;
+}
+
+bool Base64Decoder::flushQuantum(unsigned char* out, size_t& produced) {
+    switch (count) {
+        case 0:
+            return true;
+        case 2:
+            out[produced++] = static_cast<unsigned char>(bits >> 4);
+            return true;
+        case 3:
+            out[produced++] = static_cast<unsigned char>(bits >> 10);
+            out[produced++] = static_cast<unsigned char>(bits >> 2);
+            return true;
+        default:
+            // A single character cannot encode a byte
+            return false;
+    }
+}
+
+bool Base64Decoder::write(const char* data, size_t size, const Base64Sink& sink) {
+    if (!ok) {
+        return false;
+    }
+    if (!buffer) {
+        buffer = std::make_unique<unsigned char[]>(kBufferSize + kSlack);
+    }
+
+    while (size > 0) {
+        size_t produced = 0;
+        if (!decodeSpan(data, size, buffer.get(), kBufferSize, produced)) {
+            return false;
+        }
+        if (produced > 0 && !sink(reinterpret_cast<const char*>(buffer.get()), produced)) {
+            ok = false;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Base64Decoder::finish(const Base64Sink& sink) {
+    unsigned char tail[3];
+    size_t produced = 0;
+    bool complete = ok && (ended ? paddingLeft == 0 : flushQuantum(tail, produced));
+
+    // Ready for another stream
+    bits = 0;
+    count = 0;
+    paddingLeft = 0;
+    ended = false;
+    ok = true;
+
+    if (!complete) {
+        return false;
+    }
+    return produced == 0 || sink(reinterpret_cast<const char*>(tail), produced);
+}
+
+bool Base64Decoder::decode(std::string_view encoded, std::string& out) {
+    // Sized for the largest possible result, decoded straight into place
+    size_t base = out.size();
+    size_t capacity = (encoded.size() / 4 + 2) * 3;
+    out.resize(base + capacity + kSlack);
+
+    Base64Decoder decoder;
+    unsigned char* dst = reinterpret_cast<unsigned char*>(&out[base]);
+    const char* data = encoded.data();
+    size_t size = encoded.size();
+    size_t produced = 0;
+    bool valid = decoder.decodeSpan(data, size, dst, capacity, produced) && size == 0 &&
+                 (decoder.ended ? decoder.paddingLeft == 0 : decoder.flushQuantum(dst, produced));
+
+    out.resize(valid ? base + produced : base);
+    return valid;
+}
+
+const char* base64Kernel() {
+    return kernel().name;
+}
+
+bool setBase64Kernel(const std::string& name) {
+    for (const Kernel& candidate : kKernels) {
+        if (name == candidate.name) {
+            if (!candidate.supported()) {
+                return false;
+            }
+            activeKernel.store(&candidate, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace mimirion
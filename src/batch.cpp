@@ -0,0 +1,126 @@
+/**
+ * @file batch.cpp
+ * @brief Implementation of the BatchProcessor class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/batch.hpp"
+
+namespace mimirion {
+
+namespace {
+
+const char* statusName(FileStatus status) {
+    switch (status) {
+        case FileStatus::UNTRACKED: return "untracked";
+        case FileStatus::MODIFIED:  return "modified";
+        case FileStatus::STAGED:    return "staged";
+        case FileStatus::COMMITTED: return "committed";
+        case FileStatus::DELETED:   return "deleted";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+BatchProcessor::BatchProcessor(const fs::path& repoPath, const fs::path& mimirDir)
+    : repositoryPath(repoPath), mimirionDir(mimirDir), objects(mimirDir),
+      refs(mimirDir), tracker(repoPath, mimirDir) {
+    tracker.loadState();
+}
+
+size_t BatchProcessor::run(std::istream& in, std::ostream& out, char delimiter) {
+    size_t count = 0;
+    std::string request;
+    std::string payload;
+
+    while (std::getline(in, request, delimiter)) {
+        if (delimiter == '\n' && !request.empty() && request.back() == '\r') {
+            request.pop_back();
+        }
+        if (request.empty()) {
+            continue;
+        }
+
+        bool ok = handle(request, payload);
+        out << (ok ? "ok " : "error ") << payload.size() << '\n';
+        out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        out << delimiter;
+
+        // Callers usually wait for each answer before sending the next request
+        out.flush();
+        ++count;
+    }
+
+    return count;
+}
+
+bool BatchProcessor::handle(const std::string& request, std::string& payload) {
+    size_t space = request.find(' ');
+    std::string command = request.substr(0, space);
+    std::string args = space == std::string::npos ? "" : request.substr(space + 1);
+
+    if (command == "cat-object") {
+        std::string hash = resolve(args);
+        auto content = hash.empty() ? nullptr : objects.readObject(hash);
+        if (!content) {
+            payload = "missing object " + args;
+            return false;
+        }
+        payload = *content;
+        return true;
+    }
+
+    if (command == "resolve") {
+        payload = resolve(args);
+        if (payload.empty()) {
+            payload = "unknown name " + args;
+            return false;
+        }
+        return true;
+    }
+
+    if (command == "status-path") {
+        if (!tracker.isTracked(args) && !fs::exists(repositoryPath / args)) {
+            payload = "no such path " + args;
+            return false;
+        }
+        payload = statusName(tracker.getFileStatus(args));
+        return true;
+    }
+
+    if (command == "diff-blobs") {
+        size_t split = args.find(' ');
+        if (split == std::string::npos) {
+            payload = "diff-blobs needs two object names";
+            return false;
+        }
+
+        std::string oldName = args.substr(0, split);
+        std::string newName = args.substr(split + 1);
+        std::string oldHash = resolve(oldName);
+        std::string newHash = resolve(newName);
+        auto oldContent = oldHash.empty() ? nullptr : objects.readObject(oldHash);
+        auto newContent = newHash.empty() ? nullptr : objects.readObject(newHash);
+        if (!oldContent || !newContent) {
+            payload = "missing object " + (oldContent ? newName : oldName);
+            return false;
+        }
+
+        FileDiff diff = diffEngine.generateDiffFromStrings(*oldContent, *newContent);
+        diff.oldFile = "a/" + oldHash;
+        diff.newFile = "b/" + newHash;
+        payload = diff.hunks.empty() ? "" : diffEngine.diffToString(diff);
+        return true;
+    }
+
+    payload = "unknown command " + command;
+    return false;
+}
+
+std::string BatchProcessor::resolve(const std::string& name) const {
+    return refs.resolve(name, &objects);
+}
+
+} // namespace mimirion
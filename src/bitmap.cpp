@@ -0,0 +1,547 @@
+/**
+ * @file bitmap.cpp
+ * @brief Implementation of the EwahBitmap and BitmapIndex classes
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/bitmap.hpp"
+#include "../include/arena.hpp"
+#include "../include/commit.hpp"
+#include "../include/file_view.hpp"
+#include "../include/object_store.hpp"
+#include "../include/refs.hpp"
+#include "../include/scheduler.hpp"
+#include "../include/utils.hpp"
+#include "../include/worktree.hpp"
+#include <algorithm>
+#include <iostream>
+#include <unistd.h>
+#include <unordered_set>
+
+namespace mimirion {
+
+namespace {
+
+const char kMagic[] = {'M', 'B', 'M', 'P'};
+constexpr uint32_t kVersion = 1;
+
+// magic, version, object count, bitmap count
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kHashBytes = 32;
+
+constexpr uint64_t kMaxRun = 0xffffffffull;
+constexpr uint64_t kMaxLiterals = 0x7fffffffull;
+constexpr uint64_t kAllOnes = ~0ull;
+
+// Commits read at a time while numbering objects
+constexpr size_t kReadBatch = 256;
+
+// Arena space for the commit being read during a walk
+constexpr size_t kWalkScratch = 64 * 1024;
+
+void put32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+void put64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+uint64_t get(std::string_view data, size_t offset, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(data[offset + i])) << (8 * i);
+    }
+    return value;
+}
+
+void putHash(std::string& out, const std::string& hex) {
+    auto nibble = [](char c) { return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10; };
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        out.push_back(static_cast<char>(nibble(hex[i]) << 4 | nibble(hex[i + 1])));
+    }
+}
+
+std::string getHash(std::string_view data, size_t offset) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(kHashBytes * 2);
+    for (size_t i = 0; i < kHashBytes; ++i) {
+        unsigned char byte = static_cast<unsigned char>(data[offset + i]);
+        hex += digits[byte >> 4];
+        hex += digits[byte & 15];
+    }
+    return hex;
+}
+
+void setBit(std::vector<uint64_t>& words, size_t bit) {
+    if (bit / 64 >= words.size()) {
+        words.resize(bit / 64 + 1, 0);
+    }
+    words[bit / 64] |= 1ull << (bit % 64);
+}
+
+bool testBit(const std::vector<uint64_t>& words, size_t bit) {
+    return bit / 64 < words.size() && (words[bit / 64] >> (bit % 64)) & 1;
+}
+
+} // namespace
+
+EwahBitmap EwahBitmap::compress(const std::vector<uint64_t>& plain) {
+    EwahBitmap bitmap;
+    bitmap.words = static_cast<uint32_t>(plain.size());
+    size_t i = 0;
+    while (i < plain.size()) {
+        // A run of clean words, then the dirty words up to the next clean one
+        uint64_t fill = plain[i] == kAllOnes ? kAllOnes : 0;
+        uint64_t run = 0;
+        while (i < plain.size() && plain[i] == fill && run < kMaxRun) {
+            ++run;
+            ++i;
+        }
+        size_t marker = bitmap.stream.size();
+        bitmap.stream.push_back(0);
+        uint64_t literals = 0;
+        while (i < plain.size() && plain[i] != 0 && plain[i] != kAllOnes && literals < kMaxLiterals) {
+            bitmap.stream.push_back(plain[i++]);
+            ++literals;
+        }
+        bitmap.stream[marker] = (fill & 1) | (run << 1) | (literals << 33);
+    }
+    return bitmap;
+}
+
+void EwahBitmap::orInto(std::vector<uint64_t>& plain) const {
+    if (plain.size() < words) {
+        plain.resize(words, 0);
+    }
+    size_t at = 0;
+    for (size_t i = 0; i < stream.size(); ++i) {
+        uint64_t marker = stream[i];
+        uint64_t run = (marker >> 1) & kMaxRun;
+        uint64_t literals = marker >> 33;
+        if (marker & 1) {
+            std::fill(plain.begin() + at, plain.begin() + at + run, kAllOnes);
+        }
+        at += run;
+        for (uint64_t j = 0; j < literals; ++j) {
+            plain[at++] |= stream[++i];
+        }
+    }
+}
+
+uint64_t EwahBitmap::count() const {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < stream.size(); ++i) {
+        uint64_t marker = stream[i];
+        uint64_t literals = marker >> 33;
+        if (marker & 1) {
+            bits += ((marker >> 1) & kMaxRun) * 64;
+        }
+        for (uint64_t j = 0; j < literals; ++j) {
+            bits += __builtin_popcountll(stream[++i]);
+        }
+    }
+    return bits;
+}
+
+void EwahBitmap::serialize(std::string& out) const {
+    put32(out, words);
+    put32(out, static_cast<uint32_t>(stream.size()));
+    for (uint64_t word : stream) {
+        put64(out, word);
+    }
+}
+
+bool EwahBitmap::parse(std::string_view data, size_t& offset) {
+    if (data.size() < offset + 8) {
+        return false;
+    }
+    uint32_t plainWords = static_cast<uint32_t>(get(data, offset, 4));
+    size_t length = static_cast<size_t>(get(data, offset + 4, 4));
+    if ((data.size() - offset - 8) / 8 < length) {
+        return false;
+    }
+    std::vector<uint64_t> parsed(length);
+    for (size_t i = 0; i < length; ++i) {
+        parsed[i] = get(data, offset + 8 + i * 8, 8);
+    }
+
+    // The markers must describe exactly the plain words
+    uint64_t covered = 0;
+    for (size_t i = 0; i < length; ++i) {
+        uint64_t literals = parsed[i] >> 33;
+        covered += ((parsed[i] >> 1) & kMaxRun) + literals;
+        if (literals > length - i - 1) {
+            return false;
+        }
+        i += literals;
+    }
+    if (covered != plainWords) {
+        return false;
+    }
+    words = plainWords;
+    stream = std::move(parsed);
+    offset += 8 + length * 8;
+    return true;
+}
+
+// State of one query: objects newer than the index get positions past its end
+struct BitmapIndex::Walk {
+    explicit Walk(const BitmapIndex& index)
+        : index(index), commits(index.mimirionDir.parent_path(), index.mimirionDir), store(index.mimirionDir),
+          scratch(kWalkScratch), arena(scratch.data(), scratch.size()) {}
+
+    const BitmapIndex& index;
+    CommitManager commits;
+    ObjectStore store;
+    std::vector<char> scratch;
+    Arena arena;
+    std::unordered_map<std::string, uint32_t> extra;
+    std::vector<std::string> extraObjects;
+    std::vector<uint64_t> extraCommits;
+
+    uint32_t position(const std::string& hash, bool commit) {
+        auto known = index.positions.find(hash);
+        if (known != index.positions.end()) {
+            return known->second;
+        }
+        auto [it, added] = extra.emplace(hash, static_cast<uint32_t>(index.objects.size() + extraObjects.size()));
+        if (added) {
+            extraObjects.push_back(hash);
+            if (commit) {
+                setBit(extraCommits, it->second);
+            }
+        }
+        return it->second;
+    }
+
+    const std::string& hashAt(size_t position) const {
+        return position < index.objects.size() ? index.objects[position]
+                                               : extraObjects[position - index.objects.size()];
+    }
+
+    // Sets the bits of everything reachable from the tips, not going past
+    // commits set in stop
+    bool reach(const std::vector<std::string>& tips, std::vector<uint64_t>& bits,
+               const std::vector<uint64_t>* stop = nullptr) {
+        std::vector<std::string> pending(tips.rbegin(), tips.rend());
+        while (!pending.empty()) {
+            std::string hash = std::move(pending.back());
+            pending.pop_back();
+            uint32_t at = position(hash, true);
+            if (testBit(bits, at) || (stop && testBit(*stop, at))) {
+                continue;
+            }
+            auto stored = index.bitmaps.find(at);
+            if (stored != index.bitmaps.end()) {
+                stored->second.orInto(bits);
+                continue;
+            }
+            arena.release();
+            CommitRecord commit(arena);
+            if (!commits.readCommit(hash, store, commit)) {
+                std::cerr << "Cannot read commit " << hash << std::endl;
+                return false;
+            }
+            setBit(bits, at);
+            for (const auto& file : commit.files) {
+                setBit(bits, position(std::string(file.second), false));
+            }
+            pending.insert(pending.end(), commit.parentHashes.rbegin(), commit.parentHashes.rend());
+        }
+        return true;
+    }
+};
+
+BitmapIndex::BitmapIndex(const fs::path& mimirDir)
+    : mimirionDir(mimirDir), indexPath(mimirDir / "objects" / "info" / "bitmaps") {
+    load();
+}
+
+bool BitmapIndex::load() {
+    objects.clear();
+    positions.clear();
+    commitPositions.clear();
+    bitmaps.clear();
+    std::error_code ec;
+    if (!fs::exists(indexPath, ec)) {
+        return false;
+    }
+
+    FileView view(indexPath, FileView::Advice::SEQUENTIAL);
+    std::string_view data = view.view();
+    bool ok = data.size() >= kHeaderSize + kHashBytes && std::equal(kMagic, kMagic + 4, data.data()) &&
+              get(data, 4, 4) == kVersion;
+    size_t count = ok ? static_cast<size_t>(get(data, 8, 4)) : 0;
+    size_t selected = ok ? static_cast<size_t>(get(data, 12, 4)) : 0;
+    data.remove_suffix(ok ? kHashBytes : 0);
+    ok = ok && (data.size() - kHeaderSize) / kHashBytes >= count;
+
+    size_t offset = kHeaderSize;
+    if (ok) {
+        objects.reserve(count);
+        positions.reserve(count);
+        for (size_t i = 0; i < count; ++i, offset += kHashBytes) {
+            objects.push_back(getHash(data, offset));
+            positions.emplace(objects.back(), static_cast<uint32_t>(i));
+        }
+        EwahBitmap commitBitmap;
+        ok = commitBitmap.parse(data, offset);
+        commitBitmap.orInto(commitPositions);
+    }
+    for (size_t i = 0; ok && i < selected; ++i) {
+        uint32_t at = offset + 4 <= data.size() ? static_cast<uint32_t>(get(data, offset, 4)) : UINT32_MAX;
+        offset += 4;
+        EwahBitmap bitmap;
+        ok = at < count && bitmap.parse(data, offset);
+        bitmaps.emplace(at, std::move(bitmap));
+    }
+    if (!ok || offset != data.size()) {
+        std::cerr << "Ignoring corrupt bitmap index " << indexPath.string() << std::endl;
+        objects.clear();
+        positions.clear();
+        commitPositions.clear();
+        bitmaps.clear();
+        return false;
+    }
+    return true;
+}
+
+bool BitmapIndex::verify(const fs::path& path) {
+    FileView view(path, FileView::Advice::SEQUENTIAL);
+    std::string_view data = view.view();
+    if (data.size() < kHeaderSize + kHashBytes || !std::equal(kMagic, kMagic + 4, data.data())) {
+        return false;
+    }
+    std::string body(data.substr(0, data.size() - kHashBytes));
+    return getHash(data, data.size() - kHashBytes) == utils::sha256(body);
+}
+
+std::vector<std::string> BitmapIndex::tips() const {
+    // Every ref and every worktree's HEAD, which may be detached
+    RefStore refs(mimirionDir);
+    std::vector<std::string> result;
+    std::unordered_set<std::string> seen;
+    auto addTip = [&](const std::string& hash) {
+        if (ObjectStore::isValidHash(hash) && seen.insert(hash).second) {
+            result.push_back(hash);
+        }
+    };
+    for (const auto& name : refs.listRefs()) {
+        addTip(refs.readRef(name));
+    }
+    for (const auto& worktree : WorktreeManager(mimirionDir.parent_path(), mimirionDir).list()) {
+        addTip(worktree.head);
+    }
+    return result;
+}
+
+size_t BitmapIndex::unindexedCommits(size_t limit) const {
+    CommitManager commits(mimirionDir.parent_path(), mimirionDir);
+    ObjectStore store(mimirionDir);
+    std::vector<char> scratch(kWalkScratch);
+    Arena arena(scratch.data(), scratch.size());
+    std::vector<std::string> pending = tips();
+    std::unordered_set<std::string> seen(pending.begin(), pending.end());
+    size_t count = 0;
+    while (!pending.empty() && count < limit) {
+        std::string hash = std::move(pending.back());
+        pending.pop_back();
+        arena.release();
+        CommitRecord commit(arena);
+        if (positions.count(hash) || !commits.readCommit(hash, store, commit)) {
+            continue;
+        }
+        ++count;
+        for (std::string_view parent : commit.parentHashes) {
+            auto [it, added] = seen.emplace(parent);
+            if (added) {
+                pending.push_back(*it);
+            }
+        }
+    }
+    return count;
+}
+
+bool BitmapIndex::write(BitmapWriteStats* stats) {
+    std::vector<std::string> tips = this->tips();
+    std::unordered_set<std::string> seen(tips.begin(), tips.end());
+
+    // The commit graph, one generation of commits read in parallel at a time
+    CommitManager commits(mimirionDir.parent_path(), mimirionDir);
+    std::unordered_map<std::string, std::vector<std::string>> parents;
+    std::vector<std::string> frontier = tips;
+    while (!frontier.empty()) {
+        std::vector<CommitInfo> level(frontier.size());
+        std::vector<char> read(frontier.size(), 0);
+        parallelFor(frontier.size(), [&](size_t i) {
+            read[i] = commits.readCommit(frontier[i], level[i]);
+        }, 4);
+        std::vector<std::string> next;
+        for (size_t i = 0; i < frontier.size(); ++i) {
+            if (!read[i]) {
+                std::cerr << "Cannot read commit " << frontier[i] << std::endl;
+                return false;
+            }
+            for (const auto& parent : level[i].parentHashes) {
+                if (seen.insert(parent).second) {
+                    next.push_back(parent);
+                }
+            }
+            parents[frontier[i]] = std::move(level[i].parentHashes);
+        }
+        frontier = std::move(next);
+    }
+
+    // Parents before children
+    std::vector<std::string> order;
+    std::unordered_set<std::string> placed;
+    for (const auto& tip : tips) {
+        std::vector<std::pair<std::string, bool>> stack{{tip, false}};
+        while (!stack.empty()) {
+            auto [hash, expanded] = stack.back();
+            stack.pop_back();
+            if (expanded) {
+                order.push_back(hash);
+                continue;
+            }
+            if (!placed.insert(hash).second) {
+                continue;
+            }
+            stack.emplace_back(hash, true);
+            const auto& list = parents[hash];
+            for (auto parent = list.rbegin(); parent != list.rend(); ++parent) {
+                stack.emplace_back(*parent, false);
+            }
+        }
+    }
+
+    // Each commit is numbered, then the blobs it is first to reach
+    objects.clear();
+    positions.clear();
+    commitPositions.clear();
+    bitmaps.clear();
+    auto number = [&](const std::string& hash) {
+        if (positions.emplace(hash, static_cast<uint32_t>(objects.size())).second) {
+            objects.push_back(hash);
+        }
+    };
+    for (size_t first = 0; first < order.size(); first += kReadBatch) {
+        size_t count = std::min(kReadBatch, order.size() - first);
+        std::vector<CommitInfo> batch(count);
+        parallelFor(count, [&](size_t i) {
+            commits.readCommit(order[first + i], batch[i]);
+        }, 4);
+        for (size_t i = 0; i < count; ++i) {
+            number(order[first + i]);
+            setBit(commitPositions, positions[order[first + i]]);
+            std::vector<std::string> blobs;
+            for (const auto& file : batch[i].fileHashes) {
+                blobs.push_back(file.second);
+            }
+            std::sort(blobs.begin(), blobs.end());
+            for (const auto& blob : blobs) {
+                number(blob);
+            }
+        }
+    }
+
+    // Older bitmaps are reused by the walks of newer ones
+    std::unordered_set<std::string> tipSet(tips.begin(), tips.end());
+    Walk walk(*this);
+    for (size_t i = 0; i < order.size(); ++i) {
+        if ((i + 1) % kSelectionInterval != 0 && !tipSet.count(order[i])) {
+            continue;
+        }
+        std::vector<uint64_t> bits;
+        if (!walk.reach({order[i]}, bits)) {
+            return false;
+        }
+        bitmaps.emplace(positions[order[i]], EwahBitmap::compress(bits));
+    }
+
+    std::string file(kMagic, 4);
+    put32(file, kVersion);
+    put32(file, static_cast<uint32_t>(objects.size()));
+    put32(file, static_cast<uint32_t>(bitmaps.size()));
+    for (const auto& hash : objects) {
+        putHash(file, hash);
+    }
+    EwahBitmap::compress(commitPositions).serialize(file);
+    for (size_t i = 0; i < order.size(); ++i) {
+        auto stored = bitmaps.find(positions[order[i]]);
+        if (stored != bitmaps.end()) {
+            put32(file, stored->first);
+            stored->second.serialize(file);
+        }
+    }
+    putHash(file, utils::sha256(file));
+
+    std::error_code ec;
+    if (!fs::is_directory(indexPath.parent_path(), ec)) {
+        fs::create_directories(indexPath.parent_path(), ec);
+    }
+    fs::path temp = indexPath.parent_path() / ("bitmaps.tmp-" + std::to_string(getpid()));
+    if (utils::writeFile(temp, file)) {
+        fs::rename(temp, indexPath, ec);
+    } else {
+        ec = std::make_error_code(std::errc::io_error);
+    }
+    if (ec) {
+        std::cerr << "Failed to write bitmap index " << indexPath.string() << std::endl;
+        fs::remove(temp, ec);
+        return false;
+    }
+
+    if (stats) {
+        stats->objects = objects.size();
+        stats->commits = order.size();
+        stats->bitmaps = bitmaps.size();
+        stats->bytes = file.size();
+    }
+    return true;
+}
+
+bool BitmapIndex::reachable(const std::vector<std::string>& include, const std::vector<std::string>& exclude,
+                            ReachableObjects& result, bool listHashes) const {
+    // The include walk stops where the excluded history starts; whatever
+    // it still shares with that history is masked out afterwards
+    Walk walk(*this);
+    std::vector<uint64_t> excluded;
+    std::vector<uint64_t> wanted;
+    if (!walk.reach(exclude, excluded) || !walk.reach(include, wanted, &excluded)) {
+        return false;
+    }
+
+    // Indexed commits are numbered parents first, newer ones in walk order
+    result = ReachableObjects();
+    std::vector<std::string> newer;
+    for (size_t w = 0; w < wanted.size(); ++w) {
+        uint64_t bits = wanted[w] & ~(w < excluded.size() ? excluded[w] : 0);
+        uint64_t commitBits = bits & ((w < commitPositions.size() ? commitPositions[w] : 0) |
+                                      (w < walk.extraCommits.size() ? walk.extraCommits[w] : 0));
+        result.commits += __builtin_popcountll(commitBits);
+        result.blobs += __builtin_popcountll(bits & ~commitBits);
+        for (; listHashes && bits; bits &= bits - 1) {
+            size_t at = w * 64 + __builtin_ctzll(bits);
+            if (!((commitBits >> (at % 64)) & 1)) {
+                result.blobHashes.push_back(walk.hashAt(at));
+            } else if (at < objects.size()) {
+                result.commitHashes.push_back(walk.hashAt(at));
+            } else {
+                newer.push_back(walk.hashAt(at));
+            }
+        }
+    }
+    std::reverse(result.commitHashes.begin(), result.commitHashes.end());
+    result.commitHashes.insert(result.commitHashes.begin(), newer.begin(), newer.end());
+    return true;
+}
+
+} // namespace mimirion
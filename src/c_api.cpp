@@ -0,0 +1,181 @@
+/**
+ * @file c_api.cpp
+ * @brief Implementation of the C interface declared in mimirion.h
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/mimirion.h"
+#include "../include/repository.hpp"
+#include "../include/object_store.hpp"
+#include "../include/refs.hpp"
+#include "../include/file_tracker.hpp"
+#include "../include/commit.hpp"
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifndef MIMIRION_VERSION
+#define MIMIRION_VERSION "0.0.0"
+#endif
+
+namespace fs = std::filesystem;
+
+struct mimirion_repository {
+    fs::path repositoryPath;
+    fs::path mimirionDir;
+    mimirion::ObjectStore objects;
+    mimirion::RefStore refs;
+
+    // Buffers handed out by mimirion_object_read, kept alive until close
+    std::unordered_map<std::string, std::shared_ptr<const std::string>> pinned;
+
+    mimirion_repository(const fs::path& root)
+        : repositoryPath(root), mimirionDir(mimirion::Repository::findMimirionDir(root)),
+          objects(mimirionDir), refs(mimirionDir) {
+    }
+};
+
+namespace {
+
+thread_local std::string lastError;
+
+int fail(int code, const std::string& message) {
+    lastError = message;
+    return code;
+}
+
+int copyOut(const std::string& value, char* out, size_t outSize) {
+    if (!out) {
+        return MIMIRION_OK;
+    }
+    if (value.size() + 1 > outSize) {
+        return fail(MIMIRION_BUFFER_TOO_SMALL, "Output buffer too small");
+    }
+    memcpy(out, value.c_str(), value.size() + 1);
+    return MIMIRION_OK;
+}
+
+} // namespace
+
+extern "C" {
+
+const char* mimirion_version(void) {
+    return MIMIRION_VERSION;
+}
+
+const char* mimirion_last_error(void) {
+    return lastError.c_str();
+}
+
+int mimirion_repository_open(const char* path, mimirion_repository** out) {
+    if (!path || !out) {
+        return fail(MIMIRION_INVALID, "Invalid argument");
+    }
+    *out = nullptr;
+
+    try {
+        fs::path root = mimirion::Repository::findRepositoryRoot(path);
+        if (root.empty()) {
+            return fail(MIMIRION_NOT_FOUND, std::string("Not a Mimirion repository: ") + path);
+        }
+        *out = new mimirion_repository(root);
+        return MIMIRION_OK;
+    } catch (const std::exception& e) {
+        return fail(MIMIRION_ERROR, e.what());
+    }
+}
+
+void mimirion_repository_close(mimirion_repository* repo) {
+    delete repo;
+}
+
+int mimirion_object_read(mimirion_repository* repo, const char* hash,
+                         const void** data, size_t* size) {
+    if (!repo || !hash || !data || !size) {
+        return fail(MIMIRION_INVALID, "Invalid argument");
+    }
+
+    try {
+        auto it = repo->pinned.find(hash);
+        if (it == repo->pinned.end()) {
+            auto content = repo->objects.readObject(hash);
+            if (!content) {
+                return fail(MIMIRION_NOT_FOUND, std::string("Object not found: ") + hash);
+            }
+            it = repo->pinned.emplace(hash, std::move(content)).first;
+        }
+
+        *data = it->second->data();
+        *size = it->second->size();
+        return MIMIRION_OK;
+    } catch (const std::exception& e) {
+        return fail(MIMIRION_ERROR, e.what());
+    }
+}
+
+int mimirion_ref_lookup(mimirion_repository* repo, const char* name, char* out, size_t outSize) {
+    if (!repo || !name || !out) {
+        return fail(MIMIRION_INVALID, "Invalid argument");
+    }
+
+    try {
+        std::string hash = repo->refs.resolve(name, &repo->objects);
+        if (hash.empty()) {
+            return fail(MIMIRION_NOT_FOUND, std::string("Unknown name: ") + name);
+        }
+        return copyOut(hash, out, outSize);
+    } catch (const std::exception& e) {
+        return fail(MIMIRION_ERROR, e.what());
+    }
+}
+
+int mimirion_status_foreach(mimirion_repository* repo, mimirion_status_cb callback, void* payload) {
+    if (!repo || !callback) {
+        return fail(MIMIRION_INVALID, "Invalid argument");
+    }
+
+    try {
+        mimirion::FileTracker tracker(repo->repositoryPath, repo->mimirionDir);
+        tracker.loadState();
+        tracker.updateStatus();
+
+        for (const auto& file : tracker.getFiles()) {
+            int result = callback(file.path.c_str(),
+                                  static_cast<mimirion_file_status>(file.status), payload);
+            if (result != 0) {
+                return result;
+            }
+        }
+        return MIMIRION_OK;
+    } catch (const std::exception& e) {
+        return fail(MIMIRION_ERROR, e.what());
+    }
+}
+
+int mimirion_commit_create(mimirion_repository* repo, const char* message,
+                           const char* const* paths, size_t pathCount,
+                           char* out, size_t outSize) {
+    if (!repo || !message || (pathCount > 0 && !paths)) {
+        return fail(MIMIRION_INVALID, "Invalid argument");
+    }
+
+    try {
+        std::vector<std::string> files(paths, paths + pathCount);
+
+        mimirion::CommitManager commitManager(repo->repositoryPath, repo->mimirionDir);
+        commitManager.loadState();
+        std::string hash = commitManager.createCommit(message, files);
+        if (hash.empty()) {
+            return fail(MIMIRION_ERROR, "Failed to create commit");
+        }
+        return copyOut(hash, out, outSize);
+    } catch (const std::exception& e) {
+        return fail(MIMIRION_ERROR, e.what());
+    }
+}
+
+} // extern "C"
@@ -0,0 +1,152 @@
+/**
+ * @file codec.cpp
+ * @brief Implementation of the codec registry and the raw and zlib codecs
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/codec.hpp"
+
+namespace mimirion {
+
+#ifdef MIMIRION_HAVE_ZSTD
+// Defined in codec_zstd.cpp, which is the only file that sees zstd.h
+const Codec* zstdCodec();
+#endif
+
+namespace {
+
+const char kMagic[] = {'M', 'O'};
+constexpr uint8_t kVersion = 1;
+
+class RawCodec : public Codec {
+public:
+    CodecId id() const override {
+        return CodecId::RAW;
+    }
+
+    const char* name() const override {
+        return "none";
+    }
+
+    bool compress(std::string_view data, std::string& out, CompressionLevel,
+                  uint32_t dictionaryId) const override {
+        out.assign(data.data(), data.size());
+        return dictionaryId == 0;
+    }
+
+    bool decompress(std::string_view data, std::string& out, size_t,
+                    uint32_t dictionaryId) const override {
+        out.assign(data.data(), data.size());
+        return dictionaryId == 0;
+    }
+};
+
+class ZlibCodec : public Codec {
+public:
+    CodecId id() const override {
+        return CodecId::ZLIB;
+    }
+
+    const char* name() const override {
+        return "zlib";
+    }
+
+    bool compress(std::string_view data, std::string& out, CompressionLevel level,
+                  uint32_t dictionaryId) const override {
+        return dictionaryId == 0 && Compressor::compress(data, out, level);
+    }
+
+    bool decompress(std::string_view data, std::string& out, size_t sizeHint,
+                    uint32_t dictionaryId) const override {
+        return dictionaryId == 0 && Decompressor::decompress(data, out, sizeHint);
+    }
+};
+
+} // namespace
+
+void ObjectHeader::encode(std::string& out) const {
+    out.push_back(kMagic[0]);
+    out.push_back(kMagic[1]);
+    out.push_back(static_cast<char>(kVersion));
+    out.push_back(static_cast<char>(codec));
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((dictionaryId >> (8 * i)) & 0xff));
+    }
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((size >> (8 * i)) & 0xff));
+    }
+}
+
+bool ObjectHeader::decode(std::string_view data, ObjectHeader& header) {
+    if (data.size() < kSize || data[0] != kMagic[0] || data[1] != kMagic[1] ||
+        static_cast<uint8_t>(data[2]) != kVersion) {
+        return false;
+    }
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data.data());
+    header.codec = static_cast<CodecId>(bytes[3]);
+    header.dictionaryId = 0;
+    for (int i = 0; i < 4; ++i) {
+        header.dictionaryId |= static_cast<uint32_t>(bytes[4 + i]) << (8 * i);
+    }
+    header.size = 0;
+    for (int i = 0; i < 8; ++i) {
+        header.size |= static_cast<uint64_t>(bytes[8 + i]) << (8 * i);
+    }
+    return true;
+}
+
+bool Codec::supportsDictionaries() const {
+    return false;
+}
+
+uint32_t Codec::addDictionary(const std::string&) const {
+    return 0;
+}
+
+bool Codec::hasDictionary(uint32_t) const {
+    return false;
+}
+
+std::string Codec::trainDictionary(const std::vector<std::string>&, size_t) const {
+    return "";
+}
+
+const Codec* Codec::find(CodecId id) {
+    static const RawCodec raw;
+    static const ZlibCodec zlib;
+
+    switch (id) {
+        case CodecId::RAW: return &raw;
+        case CodecId::ZLIB: return &zlib;
+        case CodecId::ZSTD:
+#ifdef MIMIRION_HAVE_ZSTD
+            return zstdCodec();
+#else
+            return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+const Codec* Codec::find(const std::string& name) {
+    for (const Codec* codec : available()) {
+        if (name == codec->name()) {
+            return codec;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<const Codec*> Codec::available() {
+    std::vector<const Codec*> codecs;
+    for (CodecId id : {CodecId::RAW, CodecId::ZLIB, CodecId::ZSTD}) {
+        if (const Codec* codec = find(id)) {
+            codecs.push_back(codec);
+        }
+    }
+    return codecs;
+}
+
+} // namespace mimirion
@@ -0,0 +1,226 @@
+/**
+ * @file codec_zstd.cpp
+ * @brief Zstandard codec with trained dictionary support
+ * @author Mimirion Team
+ * @date June 2025
+ *
+ * Only built when zstd is available (MIMIRION_HAVE_ZSTD). Kept in its own
+ * translation unit so no other file depends on the zstd headers.
+ */
+
+#include "../include/codec.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <zdict.h>
+#include <zstd.h>
+
+namespace mimirion {
+
+namespace {
+
+int zstdLevel(CompressionLevel level) {
+    switch (level) {
+        case CompressionLevel::FAST: return 1;
+        case CompressionLevel::BEST: return 19;
+        case CompressionLevel::DEFAULT: break;
+    }
+    return ZSTD_CLEVEL_DEFAULT;
+}
+
+struct CCtxDeleter {
+    void operator()(ZSTD_CCtx* ctx) const { ZSTD_freeCCtx(ctx); }
+};
+
+struct DCtxDeleter {
+    void operator()(ZSTD_DCtx* ctx) const { ZSTD_freeDCtx(ctx); }
+};
+
+// Contexts are reused for every object compressed on a thread
+ZSTD_CCtx* threadCCtx() {
+    thread_local std::unique_ptr<ZSTD_CCtx, CCtxDeleter> ctx(ZSTD_createCCtx());
+    return ctx.get();
+}
+
+ZSTD_DCtx* threadDCtx() {
+    thread_local std::unique_ptr<ZSTD_DCtx, DCtxDeleter> ctx(ZSTD_createDCtx());
+    return ctx.get();
+}
+
+// A registered dictionary with its digested forms; compression dictionaries
+// depend on the level and are built on first use
+struct Dictionary {
+    std::string content;
+    ZSTD_DDict* ddict = nullptr;
+    ZSTD_CDict* cdicts[3] = {nullptr, nullptr, nullptr};
+
+    ~Dictionary() {
+        ZSTD_freeDDict(ddict);
+        for (ZSTD_CDict* cdict : cdicts) {
+            ZSTD_freeCDict(cdict);
+        }
+    }
+};
+
+class ZstdCodec : public Codec {
+public:
+    CodecId id() const override {
+        return CodecId::ZSTD;
+    }
+
+    const char* name() const override {
+        return "zstd";
+    }
+
+    bool compress(std::string_view data, std::string& out, CompressionLevel level,
+                  uint32_t dictionaryId) const override {
+        ZSTD_CCtx* ctx = threadCCtx();
+        if (!ctx) {
+            return false;
+        }
+
+        out.resize(ZSTD_compressBound(data.size()));
+        size_t written;
+        if (dictionaryId != 0) {
+            ZSTD_CDict* cdict = compressionDictionary(dictionaryId, level);
+            if (!cdict) {
+                return false;
+            }
+            written = ZSTD_compress_usingCDict(ctx, &out[0], out.size(),
+                                               data.data(), data.size(), cdict);
+        } else {
+            written = ZSTD_compressCCtx(ctx, &out[0], out.size(),
+                                        data.data(), data.size(), zstdLevel(level));
+        }
+
+        if (ZSTD_isError(written)) {
+            out.clear();
+            return false;
+        }
+        out.resize(written);
+        return true;
+    }
+
+    bool decompress(std::string_view data, std::string& out, size_t sizeHint,
+                    uint32_t dictionaryId) const override {
+        ZSTD_DCtx* ctx = threadDCtx();
+        if (!ctx) {
+            return false;
+        }
+
+        // Frames written by compress() always carry their content size
+        unsigned long long size = ZSTD_getFrameContentSize(data.data(), data.size());
+        if (size == ZSTD_CONTENTSIZE_ERROR) {
+            return false;
+        }
+        if (size == ZSTD_CONTENTSIZE_UNKNOWN) {
+            if (sizeHint == 0) {
+                return false;
+            }
+            size = sizeHint;
+        }
+
+        out.resize(size);
+        size_t read;
+        if (dictionaryId != 0) {
+            ZSTD_DDict* ddict = decompressionDictionary(dictionaryId);
+            if (!ddict) {
+                return false;
+            }
+            read = ZSTD_decompress_usingDDict(ctx, &out[0], out.size(),
+                                              data.data(), data.size(), ddict);
+        } else {
+            read = ZSTD_decompressDCtx(ctx, &out[0], out.size(), data.data(), data.size());
+        }
+
+        if (ZSTD_isError(read)) {
+            out.clear();
+            return false;
+        }
+        out.resize(read);
+        return true;
+    }
+
+    bool supportsDictionaries() const override {
+        return true;
+    }
+
+    uint32_t addDictionary(const std::string& content) const override {
+        uint32_t dictionaryId = ZDICT_getDictID(content.data(), content.size());
+        if (dictionaryId == 0) {
+            return 0;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& entry = dictionaries[dictionaryId];
+        if (!entry) {
+            auto dictionary = std::make_unique<Dictionary>();
+            dictionary->content = content;
+            dictionary->ddict = ZSTD_createDDict(content.data(), content.size());
+            if (!dictionary->ddict) {
+                dictionaries.erase(dictionaryId);
+                return 0;
+            }
+            entry = std::move(dictionary);
+        }
+        return dictionaryId;
+    }
+
+    bool hasDictionary(uint32_t dictionaryId) const override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return dictionaries.count(dictionaryId) > 0;
+    }
+
+    std::string trainDictionary(const std::vector<std::string>& samples,
+                                size_t maxSize) const override {
+        std::string buffer;
+        std::vector<size_t> sizes;
+        for (const auto& sample : samples) {
+            buffer += sample;
+            sizes.push_back(sample.size());
+        }
+
+        std::string dictionary(maxSize, '\0');
+        size_t size = ZDICT_trainFromBuffer(&dictionary[0], dictionary.size(), buffer.data(),
+                                            sizes.data(), static_cast<unsigned>(sizes.size()));
+        if (ZDICT_isError(size)) {
+            return "";
+        }
+        dictionary.resize(size);
+        return dictionary;
+    }
+
+private:
+    mutable std::mutex mutex;
+    mutable std::map<uint32_t, std::unique_ptr<Dictionary>> dictionaries;
+
+    ZSTD_CDict* compressionDictionary(uint32_t dictionaryId, CompressionLevel level) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = dictionaries.find(dictionaryId);
+        if (it == dictionaries.end()) {
+            return nullptr;
+        }
+
+        ZSTD_CDict*& cdict = it->second->cdicts[static_cast<int>(level)];
+        if (!cdict) {
+            const std::string& content = it->second->content;
+            cdict = ZSTD_createCDict(content.data(), content.size(), zstdLevel(level));
+        }
+        return cdict;
+    }
+
+    ZSTD_DDict* decompressionDictionary(uint32_t dictionaryId) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = dictionaries.find(dictionaryId);
+        return it == dictionaries.end() ? nullptr : it->second->ddict;
+    }
+};
+
+} // namespace
+
+const Codec* zstdCodec() {
+    static const ZstdCodec codec;
+    return &codec;
+}
+
+} // namespace mimirion
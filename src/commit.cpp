@@ -1,13 +1,95 @@
 #include "../include/commit.hpp"
 #include "../include/utils.hpp"
+#include "../include/arena.hpp"
+#include "../include/config.hpp"
+#include "../include/refs.hpp"
+#include "../include/object_store.hpp"
+#include "../include/lfs.hpp"
+#include "../include/filter.hpp"
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 #include <ctime>
+#include <cstdlib>
 
 namespace mimirion {
 
+namespace {
+
+// Fills in everything but the hash, as views into content
+bool parseCommit(std::string_view content, CommitRecord& commit) {
+    commit.message = {};
+    commit.author = {};
+    commit.email = {};
+    commit.timestamp = {};
+    commit.parentHashes.clear();
+    commit.files.clear();
+    
+    std::pmr::vector<std::string_view> lines =
+        utils::splitLines(content, commit.parentHashes.get_allocator().resource());
+    
+    // Verify it's a commit object
+    if (lines.empty() || lines[0].substr(0, 7) != "commit ") {
+        return false;
+    }
+    
+    // Read headers up to the blank line
+    size_t i = 1;
+    for (; i < lines.size() && !lines[i].empty(); ++i) {
+        std::string_view line = lines[i];
+        if (line.substr(0, 7) == "parent ") {
+            commit.parentHashes.push_back(line.substr(7));
+        } else if (line.substr(0, 7) == "author ") {
+            // Parse author information
+            // Format: "author Name <email> timestamp"
+            size_t emailStart = line.find('<');
+            size_t emailEnd = line.find('>');
+            if (emailStart != std::string_view::npos && emailEnd != std::string_view::npos &&
+                emailStart >= 8 && emailEnd > emailStart) {
+                commit.author = line.substr(7, emailStart - 8);
+                commit.email = line.substr(emailStart + 1, emailEnd - emailStart - 1);
+                if (emailEnd + 2 < line.size()) {
+                    commit.timestamp = utils::parseTimestamp(line.substr(emailEnd + 2));
+                }
+            }
+        }
+        // Skip other headers
+    }
+    if (i < lines.size()) {
+        ++i;
+    }
+    
+    // The message runs up to the files line, less trailing newlines
+    size_t messageStart = i < lines.size() ? lines[i].data() - content.data() : content.size();
+    while (i < lines.size() && lines[i] != "files:") {
+        ++i;
+    }
+    size_t messageEnd = i < lines.size() ? lines[i].data() - content.data() : content.size();
+    commit.message = content.substr(messageStart, messageEnd - messageStart);
+    while (!commit.message.empty() &&
+           (commit.message.back() == '\n' || commit.message.back() == '\r')) {
+        commit.message.remove_suffix(1);
+    }
+    
+    // Read file hashes if available
+    for (++i; i < lines.size(); ++i) {
+        size_t tabPos = lines[i].find('\t');
+        if (tabPos != std::string_view::npos) {
+            commit.files.emplace_back(lines[i].substr(0, tabPos), lines[i].substr(tabPos + 1));
+        }
+    }
+    
+    return true;
+}
+
+} // namespace
+
+CommitRecord::CommitRecord(Arena& arena)
+    : hash(arena.resource()), content(arena.resource()), parentHashes(arena.resource()),
+      files(arena.resource()) {}
+
 CommitManager::CommitManager(const fs::path& repoPath, const fs::path& mimirDir)
     : repositoryPath(repoPath), mimirionDir(mimirDir), currentHead("") {
 }
@@ -28,8 +110,7 @@ std::string CommitManager::createCommit(const std::string& message,
         cleanMessage.pop_back();
     }
     commit.message = cleanMessage;
-    commit.author = utils::getUserName();
-    commit.email = utils::getUserEmail();
+    loadIdentity(commit.author, commit.email);
     commit.timestamp = std::chrono::system_clock::now();
     
     // Add parent commit if there is a HEAD
@@ -37,10 +118,37 @@ std::string CommitManager::createCommit(const std::string& message,
         commit.parentHashes.push_back(currentHead);
     }
     
-    // Add file information
+    // Store the content of every staged file as a blob; large files go to
+    // the large file store and only their pointer becomes a blob, filtered
+    // files are cleaned on their way to the compressor
+    ObjectStore objects(mimirionDir);
+    LargeFileStore largeFiles(repositoryPath, mimirionDir);
+    FilterPipeline filters(repositoryPath, mimirionDir);
     for (const auto& file : stagedFiles) {
-        // TODO: Save file content to objects directory
-        commit.fileHashes[file] = "dummy-file-hash"; // Placeholder
+        fs::path filePath = repositoryPath / file;
+        if (!fs::is_regular_file(filePath)) {
+            std::cerr << "Cannot commit missing file: " << file << std::endl;
+            return "";
+        }
+        
+        std::string blobHash;
+        if (largeFiles.isTracked(file)) {
+            LfsPointer pointer;
+            if (!largeFiles.store(filePath, pointer)) {
+                return "";
+            }
+            blobHash = objects.writeObject(LargeFileStore::formatPointer(pointer));
+        } else if (filters.hasFilters(file)) {
+            blobHash = objects.writeStream([&](const CompressionSink& sink) {
+                return filters.clean(filePath, file, sink);
+            });
+        } else {
+            blobHash = objects.writeFile(filePath);
+        }
+        if (blobHash.empty()) {
+            return "";
+        }
+        commit.fileHashes[file] = blobHash;
     }
     
     // Generate commit hash
@@ -51,15 +159,14 @@ std::string CommitManager::createCommit(const std::string& message,
         return "";
     }
     
-    // Update HEAD
-    currentHead = commit.hash;
-    std::ofstream headFile(mimirionDir / "refs" / "heads" / "master");
-    if (!headFile) {
+    // Advance the current branch, unless another worktree moved it meanwhile
+    RefStore refs(mimirionDir);
+    std::string branch = refs.currentBranch();
+    if (!refs.writeRef("refs/heads/" + (branch.empty() ? "master" : branch), commit.hash, &currentHead)) {
         std::cerr << "Failed to update HEAD" << std::endl;
         return "";
     }
-    headFile << commit.hash << std::endl;
-    headFile.close();
+    currentHead = commit.hash;
     
     // Save state
     saveState();
@@ -67,6 +174,58 @@ std::string CommitManager::createCommit(const std::string& message,
     return commit.hash;
 }
 
+void CommitManager::loadIdentity(std::string& name, std::string& email) const {
+    // Identity from the configuration, cached there by an earlier commit
+    auto config = Config::load(mimirionDir);
+    name = config->getString("user.name");
+    email = config->getString("user.email");
+    
+    const char* envName = getenv("GIT_AUTHOR_NAME");
+    const char* envEmail = getenv("GIT_AUTHOR_EMAIL");
+    bool fromEnv = (envName && *envName) || (envEmail && *envEmail);
+    
+    if (name.empty() || email.empty()) {
+        // Look it up once (this may spawn git) and remember the answer;
+        // values from the environment are per invocation, don't persist them
+        if (name.empty()) {
+            name = utils::getUserName();
+            if (!fromEnv) {
+                Config::set(mimirionDir, Config::Scope::REPOSITORY, "user.name", name);
+            }
+        }
+        if (email.empty()) {
+            email = utils::getUserEmail();
+            if (!fromEnv) {
+                Config::set(mimirionDir, Config::Scope::REPOSITORY, "user.email", email);
+            }
+        }
+    }
+    
+    // The environment always overrides the configuration
+    if (envName && *envName) {
+        name = envName;
+    }
+    if (envEmail && *envEmail) {
+        email = envEmail;
+    }
+}
+
+std::string CommitManager::hashCommit(CommitInfo& commit) const {
+    while (!commit.message.empty() && (commit.message.back() == '\n' || commit.message.back() == '\r')) {
+        commit.message.pop_back();
+    }
+    commit.hash = generateCommitHash(commit);
+    return commit.hash;
+}
+
+bool CommitManager::storeCommit(const CommitInfo& commit, ObjectStore& objects) const {
+    if (commit.hash.empty() || !objects.storeObject(commit.hash, serializeCommit(commit))) {
+        std::cerr << "Failed to save commit object" << std::endl;
+        return false;
+    }
+    return true;
+}
+
 CommitInfo* CommitManager::getCommit(const std::string& hash) {
     // Check if commit is already loaded
     auto it = commits.find(hash);
@@ -85,6 +244,56 @@ CommitInfo* CommitManager::getCommit(const std::string& hash) {
     return &(commits[hash]);
 }
 
+bool CommitManager::readCommit(const std::string& hash, CommitInfo& commit) const {
+    commit = loadCommitObject(hash);
+    return !commit.hash.empty();
+}
+
+bool CommitManager::readCommit(const std::string& hash, ObjectStore& objects, CommitRecord& commit) const {
+    commit.content.clear();
+    bool read = objects.readStream(hash, [&commit](const char* data, size_t size) {
+        commit.content.append(data, size);
+        return true;
+    });
+    if (!read || !parseCommit(commit.content, commit)) {
+        return false;
+    }
+    commit.hash = hash;
+    return true;
+}
+
+bool CommitManager::verifyCommit(const std::string& hash, const std::string& content) const {
+    CommitInfo commit = parseCommitObject(hash, content);
+    if (commit.hash.empty()) {
+        return false;
+    }
+    
+    // Written out again, the commit must read the same; file lines come
+    // out in hash table order, so they are compared as sorted sets
+    auto split = [](const std::string& text, std::string& head, std::vector<std::string>& files) {
+        size_t at = text.find("\nfiles:\n");
+        if (at == std::string::npos) {
+            return false;
+        }
+        head = text.substr(0, at);
+        std::istringstream lines(text.substr(at + 8));
+        for (std::string line; std::getline(lines, line);) {
+            files.push_back(line);
+        }
+        std::sort(files.begin(), files.end());
+        return true;
+    };
+    std::string head;
+    std::string expectedHead;
+    std::vector<std::string> files;
+    std::vector<std::string> expectedFiles;
+    if (!split(content, head, files) || !split(serializeCommit(commit), expectedHead, expectedFiles) ||
+        head != expectedHead || files != expectedFiles) {
+        return false;
+    }
+    return generateCommitHash(commit) == hash || generateCommitHash(commit, true) == hash;
+}
+
 CommitInfo* CommitManager::getHeadCommit() {
     if (currentHead.empty()) {
         return nullptr;
@@ -124,24 +333,21 @@ std::vector<CommitInfo> CommitManager::getHistory(size_t maxCount) const {
 
 bool CommitManager::saveState() const {
     // Create config directory if it doesn't exist
-    fs::create_directories(mimirionDir / "config");
-    
-    // Save HEAD
-    std::ofstream headRefFile(mimirionDir / "HEAD");
-    if (!headRefFile) {
-        std::cerr << "Failed to save HEAD reference" << std::endl;
-        return false;
+    std::error_code ec;
+    if (!fs::is_directory(mimirionDir / "config", ec)) {
+        fs::create_directories(mimirionDir / "config");
     }
     
-    headRefFile << "ref: refs/heads/master" << std::endl;
-    headRefFile.close();
-    
-    return true;
+    // Save HEAD, keeping the branch it points to
+    RefStore refs(mimirionDir);
+    std::string branch = refs.currentBranch();
+    return refs.setHead(branch.empty() ? "master" : branch);
 }
 
 bool CommitManager::loadState() {
-    // Read current HEAD from refs
-    std::ifstream headFile(mimirionDir / "refs" / "heads" / "master");
+    // Read the commit of the branch HEAD points to
+    std::string branch = RefStore(mimirionDir).currentBranch();
+    std::ifstream headFile(mimirionDir / "refs" / "heads" / (branch.empty() ? "master" : branch));
     if (headFile) {
         std::getline(headFile, currentHead);
         headFile.close();
@@ -152,10 +358,27 @@ bool CommitManager::loadState() {
     return true;
 }
 
-std::string CommitManager::generateCommitHash(const CommitInfo& commit) const {
+std::string CommitManager::generateCommitHash(const CommitInfo& commit, bool placeholderTree) const {
     // Create a string representation of the commit
     std::stringstream ss;
-    ss << "tree " << "dummy-tree-hash" << "\n"; // Placeholder for tree hash
+    
+    if (placeholderTree) {
+        // How commits were named before their snapshot had a digest
+        ss << "tree " << "dummy-tree-hash" << "\n";
+    } else {
+        // The snapshot is named by a digest of its sorted file list
+        std::vector<const std::pair<const std::string, std::string>*> files;
+        files.reserve(commit.fileHashes.size());
+        for (const auto& file : commit.fileHashes) {
+            files.push_back(&file);
+        }
+        std::sort(files.begin(), files.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+        std::string listing;
+        for (const auto* file : files) {
+            listing += file->first + "\t" + file->second + "\n";
+        }
+        ss << "tree " << utils::sha256(listing) << "\n";
+    }
     
     // Add parent commits
     for (const auto& parent : commit.parentHashes) {
@@ -176,48 +399,43 @@ std::string CommitManager::generateCommitHash(const CommitInfo& commit) const {
 }
 
 bool CommitManager::saveCommitObject(const CommitInfo& commit) const {
-    // Create objects directory if it doesn't exist
-    fs::path objectsDir = mimirionDir / "objects";
-    fs::create_directories(objectsDir);
-    
-    // Create subdirectory based on first 2 characters of hash
-    std::string prefix = commit.hash.substr(0, 2);
-    std::string suffix = commit.hash.substr(2);
-    fs::path commitDir = objectsDir / prefix;
-    fs::create_directories(commitDir);
-    
-    // Create commit file
-    std::ofstream commitFile(commitDir / suffix);
-    if (!commitFile) {
+    // Commit objects are named by their commit hash, not their content hash
+    ObjectStore objects(mimirionDir);
+    if (!objects.storeObject(commit.hash, serializeCommit(commit))) {
         std::cerr << "Failed to save commit object" << std::endl;
         return false;
     }
     
+    return true;
+}
+
+std::string CommitManager::serializeCommit(const CommitInfo& commit) const {
+    std::ostringstream commitText;
+    
     // Write commit information
-    commitFile << "commit " << commit.hash << "\n";
+    commitText << "commit " << commit.hash << "\n";
     
     // Write parent commits
     for (const auto& parent : commit.parentHashes) {
-        commitFile << "parent " << parent << "\n";
+        commitText << "parent " << parent << "\n";
     }
     
     // Write author and committer information
-    commitFile << "author " << commit.author << " <" << commit.email << "> "
-             << utils::formatTimestamp(commit.timestamp) << "\n";
-    commitFile << "committer " << commit.author << " <" << commit.email << "> "
-             << utils::formatTimestamp(commit.timestamp) << "\n";
+    commitText << "author " << commit.author << " <" << commit.email << "> "
+               << utils::formatTimestamp(commit.timestamp) << "\n";
+    commitText << "committer " << commit.author << " <" << commit.email << "> "
+               << utils::formatTimestamp(commit.timestamp) << "\n";
     
     // Write message
-    commitFile << "\n" << commit.message << "\n";
+    commitText << "\n" << commit.message << "\n";
     
     // Write file hashes
-    commitFile << "\nfiles:\n";
+    commitText << "\nfiles:\n";
     for (const auto& file : commit.fileHashes) {
-        commitFile << file.first << "\t" << file.second << "\n";
+        commitText << file.first << "\t" << file.second << "\n";
     }
     
-    commitFile.close();
-    return true;
+    return commitText.str();
 }
 
 CommitInfo CommitManager::loadCommitObject(const std::string& hash) const {
@@ -229,81 +447,40 @@ CommitInfo CommitManager::loadCommitObject(const std::string& hash) const {
         return commit;
     }
     
-    // Get object path
-    std::string prefix = hash.substr(0, 2);
-    std::string suffix = hash.substr(2);
-    fs::path commitPath = mimirionDir / "objects" / prefix / suffix;
-    
-    // Check if file exists
-    if (!fs::exists(commitPath)) {
-        return commit;
-    }
-    
-    // Open commit file
-    std::ifstream commitFile(commitPath);
-    if (!commitFile) {
+    // Read through the object store, which undoes any compression
+    ObjectStore objects(mimirionDir);
+    if (!objects.hasObject(hash)) {
         return commit;
     }
-    
-    // Read commit information
-    std::string line;
-    
-    // Read type and hash
-    if (!std::getline(commitFile, line)) {
+    std::shared_ptr<const std::string> stored = objects.readObject(hash);
+    if (!stored) {
         return commit;
     }
+    return parseCommitObject(hash, *stored);
+}
+
+CommitInfo CommitManager::parseCommitObject(const std::string& hash, const std::string& content) const {
+    CommitInfo commit;
     
-    // Verify it's a commit object
-    if (line.substr(0, 7) != "commit ") {
+    // Line table and views live on the stack unless the commit is unusually large
+    char scratch[4096];
+    Arena arena(scratch, sizeof(scratch));
+    CommitRecord record(arena);
+    if (!parseCommit(content, record)) {
         return commit;
     }
     
-    // Set hash
     commit.hash = hash;
-    
-    // Read parent commits
-    while (std::getline(commitFile, line) && !line.empty()) {
-        if (line.substr(0, 7) == "parent ") {
-            commit.parentHashes.push_back(line.substr(7));
-        } else if (line.substr(0, 7) == "author ") {
-            // Parse author information
-            // Format: "author Name <email> timestamp"
-            size_t emailStart = line.find('<');
-            size_t emailEnd = line.find('>');
-            if (emailStart != std::string::npos && emailEnd != std::string::npos) {
-                commit.author = line.substr(7, emailStart - 8);
-                commit.email = line.substr(emailStart + 1, emailEnd - emailStart - 1);
-                // TODO: Parse timestamp
-            }
-        }
-        // Skip other headers
-    }
-    
-    // Read message
-    std::stringstream messageStream;
-    while (std::getline(commitFile, line) && line != "files:") {
-        messageStream << line << "\n";
-    }
-    std::string fullMessage = messageStream.str();
-    // Strip trailing newlines for consistency
-    while (!fullMessage.empty() && (fullMessage.back() == '\n' || fullMessage.back() == '\r')) {
-        fullMessage.pop_back();
-    }
-    commit.message = fullMessage;
-    
-    // Read file hashes if available
-    if (line == "files:") {
-        while (std::getline(commitFile, line)) {
-            size_t tabPos = line.find('\t');
-            if (tabPos != std::string::npos) {
-                std::string path = line.substr(0, tabPos);
-                std::string fileHash = line.substr(tabPos + 1);
-                commit.fileHashes[path] = fileHash;
-            }
-        }
+    commit.message = std::string(record.message);
+    commit.author = std::string(record.author);
+    commit.email = std::string(record.email);
+    commit.timestamp = record.timestamp;
+    commit.parentHashes.assign(record.parentHashes.begin(), record.parentHashes.end());
+    commit.fileHashes.reserve(record.files.size());
+    for (const auto& [path, fileHash] : record.files) {
+        commit.fileHashes[std::string(path)] = std::string(fileHash);
     }
     
-    commitFile.close();
     return commit;
 }
 
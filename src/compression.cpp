@@ -0,0 +1,431 @@
+/**
+ * @file compression.cpp
+ * @brief Implementation of the Compressor and Decompressor classes
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/compression.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <zlib.h>
+
+namespace mimirion {
+
+namespace {
+
+// Size of the chunks handed to sinks
+constexpr size_t kChunkSize = 64 * 1024;
+
+// Largest input or output span zlib accepts in one call
+constexpr size_t kMaxSpan = UINT_MAX;
+
+int zlibLevel(CompressionLevel level) {
+    switch (level) {
+        case CompressionLevel::FAST: return Z_BEST_SPEED;
+        case CompressionLevel::BEST: return Z_BEST_COMPRESSION;
+        case CompressionLevel::DEFAULT: break;
+    }
+    return Z_DEFAULT_COMPRESSION;
+}
+
+} // namespace
+
+struct ZlibContext {
+    z_stream stream;
+    std::unique_ptr<char[]> buffer;
+    bool deflater = false;
+    bool initialized = false;
+    bool inUse = false;
+
+    ZlibContext() {
+        std::memset(&stream, 0, sizeof(stream));
+    }
+
+    ~ZlibContext() {
+        if (initialized) {
+            if (deflater) {
+                deflateEnd(&stream);
+            } else {
+                inflateEnd(&stream);
+            }
+        }
+    }
+};
+
+namespace {
+
+// Window bits selecting each CompressionFormat's framing
+int windowBits(CompressionFormat format) {
+    switch (format) {
+        case CompressionFormat::GZIP: return MAX_WBITS + 16;
+        case CompressionFormat::RAW: return -MAX_WBITS;
+        case CompressionFormat::ZLIB: break;
+    }
+    return MAX_WBITS;
+}
+
+// One cached context per deflate format and level plus one inflater, per thread
+struct ThreadContexts {
+    ZlibContext deflaters[3][3];
+    ZlibContext inflater;
+};
+
+ThreadContexts& threadContexts() {
+    thread_local ThreadContexts contexts;
+    return contexts;
+}
+
+// Take the thread's cached context, or a private one if it is busy
+ZlibContext* acquire(ZlibContext& cached, bool& owned) {
+    ZlibContext* context = &cached;
+    owned = cached.inUse;
+    if (owned) {
+        context = new ZlibContext();
+    }
+    context->inUse = true;
+
+    // A previous user may have left pointers into its buffers behind
+    context->stream.next_in = nullptr;
+    context->stream.avail_in = 0;
+    context->stream.next_out = nullptr;
+    context->stream.avail_out = 0;
+    return context;
+}
+
+} // namespace
+
+Compressor::Compressor(CompressionLevel level, CompressionFormat format)
+    : context(nullptr), owned(false), ok(true) {
+    context = acquire(threadContexts().deflaters[static_cast<int>(format)][static_cast<int>(level)], owned);
+    if (!context->initialized) {
+        context->deflater = true;
+        context->initialized = deflateInit2(&context->stream, zlibLevel(level), Z_DEFLATED,
+                                            windowBits(format), 8, Z_DEFAULT_STRATEGY) == Z_OK;
+        ok = context->initialized;
+    }
+}
+
+Compressor::~Compressor() {
+    if (owned) {
+        delete context;
+        return;
+    }
+
+    // Keep the allocated state for the next compressor on this thread
+    if (context->initialized) {
+        deflateReset(&context->stream);
+    }
+    context->inUse = false;
+}
+
+bool Compressor::pump(int flush, const CompressionSink& sink) {
+    if (!context->buffer) {
+        context->buffer = std::make_unique<char[]>(kChunkSize);
+    }
+
+    z_stream& zs = context->stream;
+    while (true) {
+        zs.next_out = reinterpret_cast<Bytef*>(context->buffer.get());
+        zs.avail_out = kChunkSize;
+
+        int ret = deflate(&zs, flush);
+        if (ret == Z_STREAM_ERROR) {
+            return false;
+        }
+
+        size_t produced = kChunkSize - zs.avail_out;
+        if (produced > 0 && !sink(context->buffer.get(), produced)) {
+            return false;
+        }
+
+        if (flush == Z_FINISH ? ret == Z_STREAM_END : zs.avail_out != 0) {
+            return true;
+        }
+    }
+}
+
+bool Compressor::write(const char* data, size_t size, const CompressionSink& sink) {
+    if (!ok) {
+        return false;
+    }
+
+    z_stream& zs = context->stream;
+    while (size > 0) {
+        size_t span = std::min(size, kMaxSpan);
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        zs.avail_in = static_cast<uInt>(span);
+        if (!pump(Z_NO_FLUSH, sink)) {
+            ok = false;
+            return false;
+        }
+        data += span;
+        size -= span;
+    }
+    return true;
+}
+
+bool Compressor::finish(const CompressionSink& sink) {
+    if (!ok) {
+        return false;
+    }
+
+    context->stream.next_in = nullptr;
+    context->stream.avail_in = 0;
+    ok = pump(Z_FINISH, sink);
+    return ok;
+}
+
+uint64_t Compressor::totalIn() const {
+    return context->stream.total_in;
+}
+
+uint64_t Compressor::totalOut() const {
+    return context->stream.total_out;
+}
+
+bool Compressor::compress(std::string_view data, std::string& out, CompressionLevel level) {
+    Compressor compressor(level);
+    if (!compressor.ok) {
+        return false;
+    }
+
+    out.clear();
+    if (data.size() > kMaxSpan) {
+        // Too large for a single zlib call: stream it
+        auto append = [&out](const char* chunk, size_t size) {
+            out.append(chunk, size);
+            return true;
+        };
+        return compressor.write(data.data(), data.size(), append) && compressor.finish(append);
+    }
+
+    // Worst-case size up front, then one deflate call straight into place
+    z_stream& zs = compressor.context->stream;
+    out.resize(deflateBound(&zs, static_cast<uLong>(data.size())));
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(std::min(out.size(), kMaxSpan));
+
+    if (deflate(&zs, Z_FINISH) != Z_STREAM_END) {
+        out.clear();
+        return false;
+    }
+    out.resize(zs.total_out);
+    return true;
+}
+
+Decompressor::Decompressor() : context(nullptr), owned(false), ok(true), done(false) {
+    context = acquire(threadContexts().inflater, owned);
+    if (!context->initialized) {
+        context->deflater = false;
+        context->initialized = inflateInit(&context->stream) == Z_OK;
+        ok = context->initialized;
+    }
+}
+
+Decompressor::~Decompressor() {
+    if (owned) {
+        delete context;
+        return;
+    }
+
+    if (context->initialized) {
+        inflateReset(&context->stream);
+    }
+    context->inUse = false;
+}
+
+bool Decompressor::write(const char* data, size_t size, const CompressionSink& sink) {
+    if (!ok) {
+        return false;
+    }
+    if (done) {
+        // Nothing may follow the end of the stream
+        ok = size == 0;
+        return ok;
+    }
+
+    if (!context->buffer) {
+        context->buffer = std::make_unique<char[]>(kChunkSize);
+    }
+
+    z_stream& zs = context->stream;
+    while (size > 0 && !done) {
+        size_t span = std::min(size, kMaxSpan);
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        zs.avail_in = static_cast<uInt>(span);
+
+        do {
+            zs.next_out = reinterpret_cast<Bytef*>(context->buffer.get());
+            zs.avail_out = kChunkSize;
+
+            int ret = inflate(&zs, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+                ok = false;
+                return false;
+            }
+
+            size_t produced = kChunkSize - zs.avail_out;
+            if (produced > 0 && !sink(context->buffer.get(), produced)) {
+                ok = false;
+                return false;
+            }
+
+            if (ret == Z_STREAM_END) {
+                done = true;
+            } else if (ret == Z_BUF_ERROR && produced == 0) {
+                break;
+            }
+        } while (!done && (zs.avail_in > 0 || zs.avail_out == 0));
+
+        size_t consumed = span - zs.avail_in;
+        data += consumed;
+        size -= consumed;
+    }
+
+    if (done && size > 0) {
+        ok = false;
+    }
+    return ok;
+}
+
+bool Decompressor::finished() const {
+    return done;
+}
+
+bool Decompressor::decompress(std::string_view data, std::string& out, size_t sizeHint) {
+    Decompressor decompressor;
+    if (!decompressor.ok) {
+        return false;
+    }
+
+    // Inflate straight into the output, growing it only if the hint was short
+    z_stream& zs = decompressor.context->stream;
+    out.resize(sizeHint > 0 ? sizeHint : std::max<size_t>(data.size() * 4, 256));
+
+    const char* input = data.data();
+    size_t remaining = data.size();
+    size_t produced = 0;
+
+    while (true) {
+        if (zs.avail_in == 0 && remaining > 0) {
+            size_t span = std::min(remaining, kMaxSpan);
+            zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+            zs.avail_in = static_cast<uInt>(span);
+            input += span;
+            remaining -= span;
+        }
+
+        if (produced == out.size()) {
+            // An exact hint leaves no room, but the stream trailer needs none
+            zs.next_out = reinterpret_cast<Bytef*>(&out[0] + produced);
+            zs.avail_out = 0;
+            int ret = inflate(&zs, Z_NO_FLUSH);
+            if (ret == Z_STREAM_END) {
+                break;
+            }
+            if (ret != Z_OK && ret != Z_BUF_ERROR) {
+                out.clear();
+                return false;
+            }
+            out.resize(out.size() + std::max(out.size() / 2, kChunkSize));
+        }
+        size_t space = std::min(out.size() - produced, kMaxSpan);
+        zs.next_out = reinterpret_cast<Bytef*>(&out[produced]);
+        zs.avail_out = static_cast<uInt>(space);
+
+        int ret = inflate(&zs, Z_NO_FLUSH);
+        produced += space - zs.avail_out;
+
+        if (ret == Z_STREAM_END) {
+            break;
+        }
+        if ((ret != Z_OK && ret != Z_BUF_ERROR) ||
+            (zs.avail_out > 0 && zs.avail_in == 0 && remaining == 0)) {
+            // Corrupt or truncated input
+            out.clear();
+            return false;
+        }
+    }
+
+    if (zs.avail_in > 0 || remaining > 0) {
+        // Trailing bytes after the stream: not a single zlib stream
+        out.clear();
+        return false;
+    }
+
+    out.resize(produced);
+    return true;
+}
+
+bool Decompressor::decompressPrefix(std::string_view data, std::string& out, size_t size,
+                                    size_t* consumed) {
+    Decompressor decompressor;
+    if (!decompressor.ok) {
+        return false;
+    }
+
+    z_stream& zs = decompressor.context->stream;
+    out.resize(size);
+    const char* input = data.data();
+    size_t remaining = data.size();
+    size_t produced = 0;
+
+    while (true) {
+        if (zs.avail_in == 0 && remaining > 0) {
+            size_t span = std::min(remaining, kMaxSpan);
+            zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+            zs.avail_in = static_cast<uInt>(span);
+            input += span;
+            remaining -= span;
+        }
+
+        // One spare byte of output space exposes streams longer than size
+        char spare;
+        size_t space = std::min(size - produced, kMaxSpan);
+        zs.next_out = reinterpret_cast<Bytef*>(space > 0 ? &out[produced] : &spare);
+        zs.avail_out = static_cast<uInt>(space > 0 ? space : 1);
+        uInt before = zs.avail_out;
+
+        int ret = inflate(&zs, Z_NO_FLUSH);
+        size_t written = before - zs.avail_out;
+        if (space == 0 && written > 0) {
+            break;
+        }
+        produced += written;
+
+        if (ret == Z_STREAM_END) {
+            if (produced != size) {
+                break;
+            }
+            if (consumed) {
+                *consumed = static_cast<size_t>(input - data.data()) - zs.avail_in;
+            }
+            return true;
+        }
+        if ((ret != Z_OK && ret != Z_BUF_ERROR) || (zs.avail_in == 0 && remaining == 0)) {
+            break;
+        }
+    }
+
+    out.clear();
+    return false;
+}
+
+bool Decompressor::looksCompressed(std::string_view data) {
+    if (data.size() < 2) {
+        return false;
+    }
+
+    // CMF: deflate method with a window of at most 32 KiB; FCHECK makes the
+    // header a multiple of 31
+    unsigned cmf = static_cast<unsigned char>(data[0]);
+    unsigned flg = static_cast<unsigned char>(data[1]);
+    return (cmf & 0x0f) == 8 && (cmf >> 4) <= 7 && ((cmf << 8) | flg) % 31 == 0;
+}
+
+} // namespace mimirion
@@ -0,0 +1,464 @@
+/**
+ * @file config.cpp
+ * @brief Implementation of the Config class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/config.hpp"
+#include "../include/utils.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace mimirion {
+
+namespace {
+
+const char cacheMagic[] = "MCFG1\n";
+
+struct Snapshot {
+    std::string stamp;
+    std::shared_ptr<const Config> config;
+};
+
+std::mutex snapshotMutex;
+std::unordered_map<std::string, Snapshot> snapshots;
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string trim(const std::string& text) {
+    size_t start = text.find_first_not_of(" \t\r");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(start, end - start + 1);
+}
+
+// Split a normalized key into section, subsection and name
+void splitKey(const std::string& key, std::string& section, std::string& subsection,
+              std::string& name) {
+    size_t first = key.find('.');
+    size_t last = key.rfind('.');
+    section = key.substr(0, first);
+    subsection = first == last ? "" : key.substr(first + 1, last - first - 1);
+    name = key.substr(last + 1);
+}
+
+// Identify the state of every scope file, so a snapshot is reused only
+// while none of them changed
+std::string computeStamp(const std::vector<fs::path>& paths) {
+    std::string stamp;
+    for (const auto& path : paths) {
+        std::error_code ec;
+        auto mtime = fs::last_write_time(path, ec);
+        long long ticks = ec ? -1 : static_cast<long long>(mtime.time_since_epoch().count());
+        auto size = ec ? 0 : fs::file_size(path, ec);
+        stamp += path.string();
+        stamp += '\0';
+        stamp += std::to_string(ticks) + ":" + std::to_string(ec ? 0 : size);
+        stamp += '\n';
+    }
+    return stamp;
+}
+
+void appendChunk(std::string& out, const std::string& chunk) {
+    uint32_t size = static_cast<uint32_t>(chunk.size());
+    out.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    out += chunk;
+}
+
+bool readChunk(const std::string& in, size_t& pos, std::string& chunk) {
+    uint32_t size;
+    if (in.size() - pos < sizeof(size)) {
+        return false;
+    }
+    std::memcpy(&size, in.data() + pos, sizeof(size));
+    pos += sizeof(size);
+    if (in.size() - pos < size) {
+        return false;
+    }
+    chunk.assign(in, pos, size);
+    pos += size;
+    return true;
+}
+
+bool readCache(const fs::path& path, const std::string& stamp,
+               std::map<std::string, std::string>& values) {
+    std::string data = utils::readFile(path);
+    size_t magicSize = sizeof(cacheMagic) - 1;
+    if (data.compare(0, magicSize, cacheMagic) != 0) {
+        return false;
+    }
+
+    size_t pos = magicSize;
+    std::string cachedStamp;
+    if (!readChunk(data, pos, cachedStamp) || cachedStamp != stamp) {
+        return false;
+    }
+
+    std::string key, value;
+    while (pos < data.size()) {
+        if (!readChunk(data, pos, key) || !readChunk(data, pos, value)) {
+            values.clear();
+            return false;
+        }
+        values[key] = value;
+    }
+    return true;
+}
+
+void writeCache(const fs::path& path, const std::string& stamp,
+                const std::map<std::string, std::string>& values) {
+    std::string data = cacheMagic;
+    appendChunk(data, stamp);
+    for (const auto& entry : values) {
+        appendChunk(data, entry.first);
+        appendChunk(data, entry.second);
+    }
+
+    // Write to the side and rename so readers never see half a cache
+    fs::path temp = path;
+    temp += ".tmp";
+    if (utils::writeFile(temp, data)) {
+        std::error_code ec;
+        fs::rename(temp, path, ec);
+        if (ec) {
+            fs::remove(temp, ec);
+        }
+    }
+}
+
+fs::path cachePath(const fs::path& mimirionDir) {
+    return mimirionDir / "config" / "settings.cache";
+}
+
+} // namespace
+
+std::shared_ptr<const Config> Config::load(const fs::path& mimirionDir, bool useCache) {
+    std::vector<fs::path> paths = {
+        scopePath(mimirionDir, Scope::SYSTEM),
+        scopePath(mimirionDir, Scope::USER),
+    };
+    if (!mimirionDir.empty()) {
+        paths.push_back(scopePath(mimirionDir, Scope::REPOSITORY));
+    }
+    std::string stamp = computeStamp(paths);
+
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    auto it = snapshots.find(mimirionDir.string());
+    if (it != snapshots.end() && it->second.stamp == stamp) {
+        return it->second.config;
+    }
+
+    auto config = std::make_shared<Config>();
+    bool cacheable = useCache && !mimirionDir.empty() && fs::is_directory(mimirionDir);
+    if (!cacheable || !readCache(cachePath(mimirionDir), stamp, config->values)) {
+        // Later scopes override earlier ones
+        for (const auto& path : paths) {
+            if (fs::exists(path)) {
+                parseInto(utils::readFile(path), config->values);
+            }
+        }
+        if (cacheable) {
+            writeCache(cachePath(mimirionDir), stamp, config->values);
+        }
+    }
+
+    snapshots[mimirionDir.string()] = {stamp, config};
+    return config;
+}
+
+std::shared_ptr<const Config> Config::parse(const std::string& text) {
+    auto config = std::make_shared<Config>();
+    parseInto(text, config->values);
+    return config;
+}
+
+fs::path Config::scopePath(const fs::path& mimirionDir, Scope scope) {
+    switch (scope) {
+        case Scope::SYSTEM: {
+            const char* path = getenv("MIMIRION_CONFIG_SYSTEM");
+            return path ? fs::path(path) : fs::path("/etc/mimirionconfig");
+        }
+        case Scope::USER: {
+            const char* path = getenv("MIMIRION_CONFIG_GLOBAL");
+            if (path) {
+                return path;
+            }
+            const char* home = getenv("HOME");
+            return fs::path(home ? home : ".") / ".mimirionconfig";
+        }
+        case Scope::REPOSITORY:
+            break;
+    }
+    return mimirionDir / "config" / "settings";
+}
+
+bool Config::set(const fs::path& mimirionDir, Scope scope,
+                 const std::string& key, const std::string& value) {
+    std::string normalized = normalizeKey(key);
+    if (normalized.empty()) {
+        std::cerr << "Invalid configuration key: " << key << std::endl;
+        return false;
+    }
+    return edit(mimirionDir, scope, [&](std::map<std::string, std::string>& values) {
+        values[normalized] = value;
+    });
+}
+
+bool Config::unset(const fs::path& mimirionDir, Scope scope, const std::string& key) {
+    std::string normalized = normalizeKey(key);
+    return edit(mimirionDir, scope, [&](std::map<std::string, std::string>& values) {
+        values.erase(normalized);
+    });
+}
+
+bool Config::edit(const fs::path& mimirionDir, Scope scope,
+                  const std::function<void(std::map<std::string, std::string>&)>& editor) {
+    fs::path path = scopePath(mimirionDir, scope);
+
+    std::map<std::string, std::string> values;
+    if (fs::exists(path)) {
+        parseInto(utils::readFile(path), values);
+    }
+    editor(values);
+
+    fs::path temp = path;
+    temp += ".tmp";
+    std::error_code ec;
+    if (!utils::writeFile(temp, serialize(values))) {
+        std::cerr << "Failed to write configuration file " << path << std::endl;
+        return false;
+    }
+    fs::rename(temp, path, ec);
+    if (ec) {
+        std::cerr << "Failed to write configuration file " << path << ": " << ec.message() << std::endl;
+        fs::remove(temp, ec);
+        return false;
+    }
+
+    // A rewrite within the same timestamp tick must not hit a stale cache
+    if (!mimirionDir.empty()) {
+        fs::remove(cachePath(mimirionDir), ec);
+    }
+    invalidate();
+    return true;
+}
+
+void Config::invalidate() {
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    snapshots.clear();
+}
+
+std::string Config::normalizeKey(const std::string& key) {
+    size_t first = key.find('.');
+    size_t last = key.rfind('.');
+    if (first == std::string::npos || first == 0 || last == key.size() - 1) {
+        return "";
+    }
+
+    std::string section = toLower(key.substr(0, first));
+    std::string name = toLower(key.substr(last + 1));
+    if (first == last) {
+        return section + "." + name;
+    }
+    return section + "." + key.substr(first + 1, last - first - 1) + "." + name;
+}
+
+std::optional<std::string> Config::get(const std::string& key) const {
+    auto it = values.find(normalizeKey(key));
+    if (it == values.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::string Config::getString(const std::string& key, const std::string& defaultValue) const {
+    return get(key).value_or(defaultValue);
+}
+
+bool Config::getBool(const std::string& key, bool defaultValue) const {
+    auto value = get(key);
+    if (!value) {
+        return defaultValue;
+    }
+
+    std::string lower = toLower(*value);
+    if (lower == "true" || lower == "yes" || lower == "on" || lower == "1") {
+        return true;
+    }
+    if (lower == "false" || lower == "no" || lower == "off" || lower == "0" || lower.empty()) {
+        return false;
+    }
+    return defaultValue;
+}
+
+int64_t Config::getInt(const std::string& key, int64_t defaultValue) const {
+    auto value = get(key);
+    if (!value || value->empty()) {
+        return defaultValue;
+    }
+
+    int64_t number = 0;
+    const char* begin = value->data();
+    const char* end = begin + value->size();
+    auto result = std::from_chars(begin, end, number);
+    if (result.ec != std::errc()) {
+        return defaultValue;
+    }
+
+    // Optional binary unit suffix
+    if (result.ptr != end) {
+        if (result.ptr + 1 != end) {
+            return defaultValue;
+        }
+        switch (std::tolower(static_cast<unsigned char>(*result.ptr))) {
+            case 'k': return number * 1024;
+            case 'm': return number * 1024 * 1024;
+            case 'g': return number * 1024 * 1024 * 1024;
+            default: return defaultValue;
+        }
+    }
+    return number;
+}
+
+std::vector<std::string> Config::getSubsections(const std::string& section) const {
+    std::string prefix = toLower(section) + ".";
+    std::vector<std::string> names;
+
+    for (auto it = values.lower_bound(prefix);
+         it != values.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+        size_t last = it->first.rfind('.');
+        if (last > prefix.size()) {
+            std::string name = it->first.substr(prefix.size(), last - prefix.size());
+            if (names.empty() || names.back() != name) {
+                names.push_back(name);
+            }
+        }
+    }
+
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    return names;
+}
+
+const std::map<std::string, std::string>& Config::entries() const {
+    return values;
+}
+
+void Config::parseInto(const std::string& text, std::map<std::string, std::string>& values) {
+    std::istringstream stream(text);
+    std::string line;
+    std::string prefix;
+
+    while (std::getline(stream, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';') {
+            continue;
+        }
+
+        if (line[0] == '[') {
+            // [section], [section "subsection"] or [section.subsection]
+            size_t close = line.rfind(']');
+            if (close == std::string::npos) {
+                prefix.clear();
+                continue;
+            }
+            std::string header = trim(line.substr(1, close - 1));
+            size_t quote = header.find('"');
+            if (quote != std::string::npos) {
+                size_t endQuote = header.rfind('"');
+                std::string section = toLower(trim(header.substr(0, quote)));
+                std::string subsection = endQuote > quote
+                    ? header.substr(quote + 1, endQuote - quote - 1) : "";
+                prefix = section + "." + subsection + ".";
+            } else {
+                size_t dot = header.find('.');
+                prefix = dot == std::string::npos
+                    ? toLower(header) + "."
+                    : toLower(header.substr(0, dot)) + "." + header.substr(dot + 1) + ".";
+            }
+            continue;
+        }
+
+        if (prefix.empty()) {
+            continue;
+        }
+
+        // name = value; a bare name means true
+        size_t equals = line.find('=');
+        std::string name = toLower(trim(line.substr(0, equals)));
+        std::string value = equals == std::string::npos ? "true" : trim(line.substr(equals + 1));
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
+            std::string unquoted;
+            for (size_t i = 1; i + 1 < value.size(); ++i) {
+                if (value[i] == '\\' && i + 2 < value.size()) {
+                    ++i;
+                }
+                unquoted += value[i];
+            }
+            value = unquoted;
+        }
+        if (!name.empty()) {
+            values[prefix + name] = value;
+        }
+    }
+}
+
+std::string Config::serialize(const std::map<std::string, std::string>& values) {
+    std::ostringstream out;
+    std::string currentSection;
+    std::string currentSubsection;
+    bool first = true;
+
+    for (const auto& entry : values) {
+        std::string section, subsection, name;
+        splitKey(entry.first, section, subsection, name);
+
+        if (first || section != currentSection || subsection != currentSubsection) {
+            out << "[" << section;
+            if (!subsection.empty()) {
+                out << " \"" << subsection << "\"";
+            }
+            out << "]\n";
+            currentSection = section;
+            currentSubsection = subsection;
+            first = false;
+        }
+
+        const std::string& value = entry.second;
+        bool quote = !value.empty() &&
+            (value.front() == ' ' || value.back() == ' ' || value.front() == '"');
+        out << "\t" << name << " = ";
+        if (quote) {
+            out << '"';
+            for (char c : value) {
+                if (c == '"' || c == '\\') {
+                    out << '\\';
+                }
+                out << c;
+            }
+            out << '"';
+        } else {
+            out << value;
+        }
+        out << "\n";
+    }
+
+    return out.str();
+}
+
+} // namespace mimirion
@@ -0,0 +1,331 @@
+/**
+ * @file daemon.cpp
+ * @brief Implementation of the repository daemon and its client
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/daemon.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace mimirion {
+
+namespace {
+
+// Upper bound for a single message, protects the daemon from garbage input
+constexpr uint32_t kMaxMessageSize = 64 * 1024 * 1024;
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t got = recv(fd, data, size, 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        data += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+void putUint32(std::string& out, uint32_t value) {
+    out.push_back(static_cast<char>((value >> 24) & 0xff));
+    out.push_back(static_cast<char>((value >> 16) & 0xff));
+    out.push_back(static_cast<char>((value >> 8) & 0xff));
+    out.push_back(static_cast<char>(value & 0xff));
+}
+
+uint32_t getUint32(const char* data) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+bool writeMessage(int fd, const std::string& payload) {
+    std::string header;
+    putUint32(header, static_cast<uint32_t>(payload.size()));
+    return writeAll(fd, header.data(), header.size()) &&
+           writeAll(fd, payload.data(), payload.size());
+}
+
+bool readMessage(int fd, std::string& payload) {
+    char header[4];
+    if (!readAll(fd, header, sizeof(header))) {
+        return false;
+    }
+    uint32_t size = getUint32(header);
+    if (size > kMaxMessageSize) {
+        return false;
+    }
+    payload.assign(size, '\0');
+    return size == 0 || readAll(fd, &payload[0], size);
+}
+
+bool makeAddress(const fs::path& socketFile, sockaddr_un& addr) {
+    std::string path = socketFile.string();
+    if (path.size() >= sizeof(addr.sun_path)) {
+        return false;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+void setTimeouts(int fd, int seconds) {
+    timeval timeout = {seconds, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+int connectTo(const fs::path& socketFile) {
+    sockaddr_un addr;
+    if (!makeAddress(socketFile, addr)) {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    // Never let a wedged daemon hang the CLI; the caller falls back instead
+    setTimeouts(fd, 30);
+    return fd;
+}
+
+} // namespace
+
+Daemon::Daemon(const fs::path& repoPath, const fs::path& mimirDir)
+    : repositoryPath(repoPath), mimirionDir(mimirDir), listenFd(-1), running(false) {
+}
+
+Daemon::~Daemon() {
+    if (listenFd >= 0) {
+        close(listenFd);
+        std::error_code ec;
+        fs::remove(socketPath(mimirionDir), ec);
+    }
+}
+
+fs::path Daemon::socketPath(const fs::path& mimirionDir) {
+    return mimirionDir / "daemon.sock";
+}
+
+bool Daemon::start() {
+    if (!repository.load(repositoryPath.string())) {
+        std::cerr << "Not a valid mimirion repository" << std::endl;
+        return false;
+    }
+    refreshIfStale();
+
+    fs::path socketFile = socketPath(mimirionDir);
+    sockaddr_un addr;
+    if (!makeAddress(socketFile, addr)) {
+        std::cerr << "Daemon socket path is too long: " << socketFile << std::endl;
+        return false;
+    }
+
+    // Refuse to start twice, but clean up after a daemon that died
+    if (fs::exists(socketFile)) {
+        if (DaemonClient::isRunning(mimirionDir)) {
+            std::cerr << "A daemon is already running for this repository" << std::endl;
+            return false;
+        }
+        std::error_code ec;
+        fs::remove(socketFile, ec);
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        std::cerr << "Failed to create daemon socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listenFd, 16) != 0) {
+        std::cerr << "Failed to bind daemon socket: " << strerror(errno) << std::endl;
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+
+    running = true;
+    return true;
+}
+
+void Daemon::serve() {
+    while (running) {
+        // Poll with a timeout so stop() is noticed without a wake-up connection
+        pollfd pfd = {listenFd, POLLIN, 0};
+        int ready = poll(&pfd, 1, 200);
+        if (ready <= 0) {
+            continue;
+        }
+
+        int clientFd = accept(listenFd, nullptr, nullptr);
+        if (clientFd < 0) {
+            continue;
+        }
+        // A stalled client would hold up every other one
+        setTimeouts(clientFd, kConnectionTimeout);
+        handleConnection(clientFd);
+        close(clientFd);
+    }
+}
+
+void Daemon::stop() {
+    running = false;
+}
+
+bool Daemon::refreshIfStale() {
+    // Files whose change invalidates the in-memory repository state
+    static const char* const watched[] = {"HEAD", "config/settings", "index"};
+
+    bool stale = false;
+    for (const char* name : watched) {
+        std::error_code ec;
+        fs::file_time_type stamp = fs::last_write_time(mimirionDir / name, ec);
+        if (ec) {
+            stamp = fs::file_time_type::min();
+        }
+
+        auto it = stamps.find(name);
+        if (it == stamps.end() || it->second != stamp) {
+            stamps[name] = stamp;
+            stale = true;
+        }
+    }
+
+    if (stale) {
+        repository = Repository();
+        return repository.load(repositoryPath.string());
+    }
+    return true;
+}
+
+std::string Daemon::handleRequest(const std::vector<std::string>& args, int& exitCode) {
+    exitCode = 0;
+    if (args.empty()) {
+        exitCode = 1;
+        return "Empty request";
+    }
+
+    const std::string& command = args[0];
+    if (command == "ping") {
+        return "pong";
+    }
+    if (command == "shutdown") {
+        stop();
+        return "Daemon stopped";
+    }
+    if (command == "status") {
+        if (!refreshIfStale()) {
+            exitCode = 1;
+            return "Not a Mimirion repository";
+        }
+        return repository.status();
+    }
+
+    exitCode = 1;
+    return "Unsupported daemon command: " + command;
+}
+
+void Daemon::handleConnection(int clientFd) {
+    std::string request;
+    if (!readMessage(clientFd, request)) {
+        return;
+    }
+
+    // Arguments are NUL separated
+    std::vector<std::string> args;
+    size_t start = 0;
+    while (start <= request.size()) {
+        size_t end = request.find('\0', start);
+        if (end == std::string::npos) {
+            end = request.size();
+        }
+        if (end > start) {
+            args.push_back(request.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+
+    int exitCode = 0;
+    std::string output = handleRequest(args, exitCode);
+
+    std::string response;
+    putUint32(response, static_cast<uint32_t>(exitCode));
+    response += output;
+    writeMessage(clientFd, response);
+}
+
+bool DaemonClient::forward(const fs::path& mimirionDir, const std::vector<std::string>& args,
+                           std::string& output, int& exitCode) {
+    fs::path socketFile = Daemon::socketPath(mimirionDir);
+    if (!fs::exists(socketFile)) {
+        return false;
+    }
+
+    int fd = connectTo(socketFile);
+    if (fd < 0) {
+        return false;
+    }
+
+    std::string request;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (i > 0) {
+            request.push_back('\0');
+        }
+        request += args[i];
+    }
+
+    std::string response;
+    bool ok = writeMessage(fd, request) && readMessage(fd, response) && response.size() >= 4;
+    close(fd);
+    if (!ok) {
+        return false;
+    }
+
+    exitCode = static_cast<int>(getUint32(response.data()));
+    output = response.substr(4);
+    return true;
+}
+
+bool DaemonClient::isRunning(const fs::path& mimirionDir) {
+    std::string output;
+    int exitCode = 0;
+    return forward(mimirionDir, {"ping"}, output, exitCode) && exitCode == 0;
+}
+
+} // namespace mimirion
@@ -11,12 +11,15 @@
 
 #include "../include/diff.hpp"
 #include "../include/utils.hpp"
+#include "../include/arena.hpp"
+#include "../include/file_view.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <vector>
 #include <string>
+#include <charconv>
 
 namespace mimirion {
 
@@ -42,12 +45,12 @@ DiffEngine::DiffEngine() {
  * @throws std::runtime_error if files cannot be read
  */
 FileDiff DiffEngine::generateDiff(const fs::path& oldFile, const fs::path& newFile, int contextLines) const {
-    // Read file contents
-    std::string oldContent = utils::readFile(oldFile);
-    std::string newContent = utils::readFile(newFile);
+    // View file contents in place; only the split lines are copied
+    FileView oldContent(oldFile);
+    FileView newContent(newFile);
     
     // Generate diff from strings
-    FileDiff diff = generateDiffFromStrings(oldContent, newContent, contextLines);
+    FileDiff diff = generateDiffFromStrings(oldContent.view(), newContent.view(), contextLines);
     
     // Set file paths
     diff.oldFile = oldFile.string();
@@ -64,13 +67,13 @@ FileDiff DiffEngine::generateDiff(const fs::path& oldFile, const fs::path& newFi
  * compared line by line, with the specified number of context lines
  * included around each change.
  * 
- * @param oldContent Original content as a string
- * @param newContent Modified content as a string
+ * @param oldContent Original content
+ * @param newContent Modified content
  * @param contextLines Number of unchanged lines to include before and after changes
  * @return FileDiff object containing the differences
  */
-FileDiff DiffEngine::generateDiffFromStrings(const std::string& oldContent, 
-                                       const std::string& newContent, 
+FileDiff DiffEngine::generateDiffFromStrings(std::string_view oldContent, 
+                                       std::string_view newContent, 
                                        int contextLines) const {
     // Split content into lines
     std::vector<std::string> oldLines = splitLines(oldContent);
@@ -163,8 +166,10 @@ std::string DiffEngine::diffToString(const FileDiff& diff) const {
 FileDiff DiffEngine::parseDiff(const std::string& diffStr) const {
     FileDiff diff;
     
-    // Split into lines
-    std::vector<std::string> lines = splitLines(diffStr);
+    // Split into lines; the line table is scratch and goes away with the
+    // arena, the returned diff owns copies of its lines
+    Arena arena;
+    std::pmr::vector<std::string_view> lines = utils::splitLines(diffStr, arena.resource());
     
     // Parse diff header
     if (lines.size() < 2) {
@@ -172,17 +177,22 @@ FileDiff DiffEngine::parseDiff(const std::string& diffStr) const {
     }
     
     if (lines[0].substr(0, 4) == "--- ") {
-        diff.oldFile = lines[0].substr(4);
+        diff.oldFile = std::string(lines[0].substr(4));
     } else {
         return diff;
     }
     
     if (lines[1].substr(0, 4) == "+++ ") {
-        diff.newFile = lines[1].substr(4);
+        diff.newFile = std::string(lines[1].substr(4));
     } else {
         return diff;
     }
     
+    // Parse an integer field of the hunk header
+    auto parseNumber = [](std::string_view text, int& value) {
+        return std::from_chars(text.data(), text.data() + text.size(), value).ec == std::errc();
+    };
+    
     // Parse hunks
     size_t i = 2;
     while (i < lines.size()) {
@@ -194,47 +204,60 @@ FileDiff DiffEngine::parseDiff(const std::string& diffStr) const {
         
         // Parse hunk header
         // Format: "@@ -oldStart,oldCount +newStart,newCount @@"
-        std::string header = lines[i];
+        std::string_view header = lines[i];
         size_t minusPos = header.find('-');
         size_t commaPos1 = header.find(',', minusPos);
         size_t plusPos = header.find('+', commaPos1);
         size_t commaPos2 = header.find(',', plusPos);
         size_t atPos = header.find(" @@", commaPos2);
         
-        if (minusPos == std::string::npos || commaPos1 == std::string::npos || 
-            plusPos == std::string::npos || commaPos2 == std::string::npos || 
-            atPos == std::string::npos) {
+        if (minusPos == std::string_view::npos || commaPos1 == std::string_view::npos || 
+            plusPos == std::string_view::npos || commaPos2 == std::string_view::npos || 
+            atPos == std::string_view::npos) {
             ++i;
             continue;
         }
         
         DiffHunk hunk;
-        hunk.oldStart = std::stoi(header.substr(minusPos + 1, commaPos1 - minusPos - 1));
-        hunk.oldCount = std::stoi(header.substr(commaPos1 + 1, plusPos - commaPos1 - 1));
-        hunk.newStart = std::stoi(header.substr(plusPos + 1, commaPos2 - plusPos - 1));
-        hunk.newCount = std::stoi(header.substr(commaPos2 + 1, atPos - commaPos2 - 1));
+        if (!parseNumber(header.substr(minusPos + 1, commaPos1 - minusPos - 1), hunk.oldStart) ||
+            !parseNumber(header.substr(commaPos1 + 1, plusPos - commaPos1 - 1), hunk.oldCount) ||
+            !parseNumber(header.substr(plusPos + 1, commaPos2 - plusPos - 1), hunk.newStart) ||
+            !parseNumber(header.substr(commaPos2 + 1, atPos - commaPos2 - 1), hunk.newCount)) {
+            ++i;
+            continue;
+        }
         
         // Parse hunk lines
         ++i;
-        while (i < lines.size() && lines[i].substr(0, 3) != "@@ ") {
-            hunk.lines.push_back(lines[i]);
-            ++i;
+        size_t end = i;
+        while (end < lines.size() && lines[end].substr(0, 3) != "@@ ") {
+            ++end;
+        }
+        hunk.lines.reserve(end - i);
+        for (; i < end; ++i) {
+            hunk.lines.emplace_back(lines[i]);
         }
         
         // Add hunk to diff
-        diff.hunks.push_back(hunk);
+        diff.hunks.push_back(std::move(hunk));
     }
     
     return diff;
 }
 
-std::vector<std::string> DiffEngine::splitLines(const std::string& content) const {
+std::vector<std::string> DiffEngine::splitLines(std::string_view content) const {
     std::vector<std::string> lines;
-    std::istringstream stream(content);
-    std::string line;
+    lines.reserve(std::count(content.begin(), content.end(), '\n') + 1);
     
-    while (std::getline(stream, line)) {
-        lines.push_back(line);
+    // Same lines std::getline would produce: no entry after a final newline
+    size_t start = 0;
+    while (start < content.size()) {
+        size_t end = content.find('\n', start);
+        if (end == std::string_view::npos) {
+            end = content.size();
+        }
+        lines.emplace_back(content.substr(start, end - start));
+        start = end + 1;
     }
     
     return lines;
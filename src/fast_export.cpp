@@ -0,0 +1,361 @@
+/**
+ * @file fast_export.cpp
+ * @brief Implementation of the FastExporter class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/fast_export.hpp"
+#include "../include/commit.hpp"
+#include "../include/object_store.hpp"
+#include "../include/refs.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace mimirion {
+
+namespace {
+
+// Exported commits kept to diff their children against
+constexpr size_t kRecentCommits = 64;
+
+// Reads the parent lines of a commit, inflating no more than its headers
+bool readParents(ObjectStore& objects, const std::string& hash, std::vector<std::string>& parents) {
+    std::string headers;
+    bool complete = false;
+    bool ok = objects.readStream(hash, [&](const char* data, size_t size) {
+        headers.append(data, size);
+        size_t end = headers.find("\n\n");
+        if (end == std::string::npos) {
+            return true;
+        }
+        headers.resize(end + 1);
+        complete = true;
+        return false;
+    });
+    if ((!ok && !complete) || headers.compare(0, 7, "commit ") != 0) {
+        return false;
+    }
+
+    parents.clear();
+    size_t pos = 0;
+    while (pos < headers.size()) {
+        size_t end = headers.find('\n', pos);
+        if (headers.compare(pos, 7, "parent ") == 0) {
+            parents.push_back(headers.substr(pos + 7, end - pos - 7));
+        }
+        pos = end + 1;
+    }
+    return true;
+}
+
+// C-quotes paths that would not survive a plain M or D line
+std::string quotePath(const std::string& path) {
+    bool plain = !path.empty() && path[0] != '"' &&
+                 std::none_of(path.begin(), path.end(), [](char c) {
+                     return c == '\\' || static_cast<unsigned char>(c) < 0x20 || c == 0x7f;
+                 });
+    if (plain) {
+        return path;
+    }
+    static const char digits[] = "01234567";
+    std::string quoted = "\"";
+    for (unsigned char c : path) {
+        switch (c) {
+            case '"': quoted += "\\\""; break;
+            case '\\': quoted += "\\\\"; break;
+            case '\n': quoted += "\\n"; break;
+            case '\t': quoted += "\\t"; break;
+            default:
+                if (c < 0x20 || c == 0x7f) {
+                    quoted += '\\';
+                    quoted += digits[c >> 6];
+                    quoted += digits[(c >> 3) & 7];
+                    quoted += digits[c & 7];
+                } else {
+                    quoted += static_cast<char>(c);
+                }
+        }
+    }
+    return quoted + "\"";
+}
+
+class Exporter {
+public:
+    Exporter(const fs::path& repoPath, const fs::path& mimirionDir, std::ostream& out, FastExportStats& stats)
+        : objects(mimirionDir), refs(mimirionDir), commits(repoPath, mimirionDir), out(out), stats(stats), nextMark(1) {}
+
+    bool run(const std::vector<std::string>& revisions) {
+        std::vector<std::pair<std::string, std::string>> tips;
+        std::vector<std::string> negatives;
+        if (revisions.empty()) {
+            listRefs(tips);
+        }
+        for (const auto& revision : revisions) {
+            size_t range = revision.find("..");
+            if (!revision.empty() && revision[0] == '^') {
+                if (!addNegative(revision.substr(1), negatives)) {
+                    return false;
+                }
+            } else if (range != std::string::npos) {
+                if (!addNegative(revision.substr(0, range), negatives) ||
+                    !addTip(revision.substr(range + 2), tips)) {
+                    return false;
+                }
+            } else if (!addTip(revision, tips)) {
+                return false;
+            }
+        }
+
+        // Everything reachable from an exclusion is taken to exist already
+        for (const auto& hash : negatives) {
+            std::vector<std::string> stack{hash};
+            while (!stack.empty()) {
+                std::string id = std::move(stack.back());
+                stack.pop_back();
+                std::vector<std::string> parents;
+                if (!excluded.insert(id).second) {
+                    continue;
+                }
+                if (!readParents(objects, id, parents)) {
+                    return fail("cannot read commit " + id);
+                }
+                stack.insert(stack.end(), parents.begin(), parents.end());
+            }
+        }
+
+        // Each commit is written once its parents are
+        std::unordered_set<std::string> visited;
+        for (const auto& [ref, hash] : tips) {
+            std::vector<std::pair<std::string, bool>> stack{{hash, false}};
+            while (!stack.empty()) {
+                auto [id, expanded] = stack.back();
+                stack.pop_back();
+                if (expanded) {
+                    if (!writeCommit(id, ref)) {
+                        return false;
+                    }
+                    continue;
+                }
+                if (excluded.count(id) || !visited.insert(id).second) {
+                    continue;
+                }
+                std::vector<std::string> parents;
+                if (!readParents(objects, id, parents)) {
+                    return fail("cannot read commit " + id);
+                }
+                stack.emplace_back(id, true);
+                for (auto parent = parents.rbegin(); parent != parents.rend(); ++parent) {
+                    stack.emplace_back(*parent, false);
+                }
+            }
+        }
+
+        for (const auto& [ref, hash] : tips) {
+            out << "reset " << ref << "\nfrom " << commitRef(hash) << "\n\n";
+            ++stats.refs;
+        }
+        out.flush();
+        return out.good() || fail("write error");
+    }
+
+private:
+    using Snapshot = std::shared_ptr<const CommitInfo>;
+
+    ObjectStore objects;
+    RefStore refs;
+    CommitManager commits;
+    std::ostream& out;
+    FastExportStats& stats;
+
+    uint64_t nextMark;
+    std::unordered_set<std::string> excluded;
+    std::unordered_map<std::string, uint64_t> commitMarks;
+    std::unordered_map<std::string, uint64_t> blobMarks;
+    std::unordered_map<std::string, Snapshot> recent;
+
+    bool fail(const std::string& message) {
+        std::cerr << "export: " << message << std::endl;
+        return false;
+    }
+
+    // Every branch and tag
+    void listRefs(std::vector<std::pair<std::string, std::string>>& tips) {
+        for (const char* root : {"refs/heads", "refs/tags"}) {
+            for (const auto& name : refs.listRefs(root)) {
+                std::string hash = refs.readRef(name);
+                if (ObjectStore::isValidHash(hash)) {
+                    tips.emplace_back(name, hash);
+                }
+            }
+        }
+    }
+
+    bool addTip(const std::string& name, std::vector<std::pair<std::string, std::string>>& tips) {
+        std::string ref;
+        if (name == "HEAD") {
+            std::string branch = refs.currentBranch();
+            ref = branch.empty() ? "" : "refs/heads/" + branch;
+        } else if (name.compare(0, 5, "refs/") == 0) {
+            ref = name;
+        } else if (!refs.readRef("refs/heads/" + name).empty()) {
+            ref = "refs/heads/" + name;
+        } else if (!refs.readRef("refs/tags/" + name).empty()) {
+            ref = "refs/tags/" + name;
+        }
+        std::string hash = ref.empty() ? "" : refs.readRef(ref);
+        if (hash.empty()) {
+            return fail("'" + name + "' is not a branch, tag or ref");
+        }
+        tips.emplace_back(ref, hash);
+        return true;
+    }
+
+    bool addNegative(const std::string& name, std::vector<std::string>& negatives) {
+        std::string hash = refs.resolve(name, &objects);
+        if (hash.empty()) {
+            return fail("unknown revision '" + name + "'");
+        }
+        negatives.push_back(hash);
+        return true;
+    }
+
+    std::string commitRef(const std::string& hash) const {
+        auto it = commitMarks.find(hash);
+        return it == commitMarks.end() ? hash : ":" + std::to_string(it->second);
+    }
+
+    Snapshot snapshotOf(const std::string& hash) {
+        auto it = recent.find(hash);
+        if (it != recent.end()) {
+            return it->second;
+        }
+        auto commit = std::make_shared<CommitInfo>();
+        return commits.readCommit(hash, *commit) ? commit : nullptr;
+    }
+
+    bool writeBlob(const std::string& hash) {
+        uint64_t size = 0;
+        std::shared_ptr<const std::string> content;
+        if (!objects.objectSize(hash, size)) {
+            // Objects without a size header are read whole
+            content = objects.readObject(hash);
+            if (!content) {
+                return fail("cannot read blob " + hash);
+            }
+            size = content->size();
+        }
+
+        uint64_t mark = nextMark++;
+        out << "blob\nmark :" << mark << "\ndata " << size << '\n';
+        if (content) {
+            out.write(content->data(), static_cast<std::streamsize>(content->size()));
+        } else {
+            uint64_t written = 0;
+            bool ok = objects.readStream(hash, [&](const char* data, size_t length) {
+                written += length;
+                out.write(data, static_cast<std::streamsize>(length));
+                return out.good();
+            });
+            if (!ok || written != size) {
+                return fail("cannot read blob " + hash);
+            }
+        }
+        out << '\n';
+        blobMarks[hash] = mark;
+        ++stats.blobs;
+        return true;
+    }
+
+    bool writeCommit(const std::string& hash, const std::string& ref) {
+        auto commit = std::make_shared<CommitInfo>();
+        if (!commits.readCommit(hash, *commit)) {
+            return fail("cannot read commit " + hash);
+        }
+        Snapshot parent;
+        if (!commit->parentHashes.empty()) {
+            parent = snapshotOf(commit->parentHashes[0]);
+            if (!parent) {
+                return fail("cannot read commit " + commit->parentHashes[0]);
+            }
+        }
+
+        // Changes against the first parent, in path order
+        std::vector<const std::pair<const std::string, std::string>*> changed;
+        for (const auto& file : commit->fileHashes) {
+            auto old = parent ? parent->fileHashes.find(file.first) : commit->fileHashes.end();
+            if (!parent || old == parent->fileHashes.end() || old->second != file.second) {
+                changed.push_back(&file);
+            }
+        }
+        std::sort(changed.begin(), changed.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+        std::vector<std::string> deleted;
+        if (parent) {
+            for (const auto& file : parent->fileHashes) {
+                if (!commit->fileHashes.count(file.first)) {
+                    deleted.push_back(file.first);
+                }
+            }
+            std::sort(deleted.begin(), deleted.end());
+        }
+
+        for (const auto* file : changed) {
+            if (!blobMarks.count(file->second) && !writeBlob(file->second)) {
+                return false;
+            }
+        }
+
+        uint64_t mark = nextMark++;
+        if (!parent) {
+            // Without "from" the importer would continue the ref
+            out << "reset " << ref << '\n';
+        }
+        long long seconds = std::chrono::system_clock::to_time_t(commit->timestamp);
+        std::string identity = commit->author + " <" + commit->email + "> " + std::to_string(seconds) + " +0000\n";
+        out << "commit " << ref << "\nmark :" << mark << "\nauthor " << identity << "committer " << identity
+            << "data " << commit->message.size() << '\n' << commit->message << '\n';
+        for (size_t i = 0; i < commit->parentHashes.size(); ++i) {
+            out << (i == 0 ? "from " : "merge ") << commitRef(commit->parentHashes[i]) << '\n';
+        }
+        for (const auto& path : deleted) {
+            out << "D " << quotePath(path) << '\n';
+        }
+        for (const auto* file : changed) {
+            out << "M 100644 :" << blobMarks[file->second] << ' ' << quotePath(file->first) << '\n';
+        }
+        out << '\n';
+        if (!out) {
+            return fail("write error");
+        }
+
+        commitMarks[hash] = mark;
+        if (recent.size() >= kRecentCommits) {
+            recent.clear();
+        }
+        recent[hash] = commit;
+        ++stats.commits;
+        return true;
+    }
+};
+
+} // namespace
+
+FastExporter::FastExporter(const fs::path& repoPath, const fs::path& mimirDir)
+    : repositoryPath(repoPath), mimirionDir(mimirDir) {
+}
+
+bool FastExporter::run(const std::vector<std::string>& revisions, std::ostream& out, FastExportStats* stats) {
+    FastExportStats counts;
+    Exporter exporter(repositoryPath, mimirionDir, out, counts);
+    bool ok = exporter.run(revisions);
+    if (stats) {
+        *stats = counts;
+    }
+    return ok;
+}
+
+} // namespace mimirion
@@ -0,0 +1,611 @@
+/**
+ * @file fast_import.cpp
+ * @brief Implementation of the FastImporter class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/fast_import.hpp"
+#include "../include/commit.hpp"
+#include "../include/object_store.hpp"
+#include "../include/refs.hpp"
+#include "../include/scheduler.hpp"
+#include "../include/utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+
+namespace mimirion {
+
+namespace {
+
+using Snapshot = std::shared_ptr<const CommitInfo>;
+
+// Commits kept in memory to start later commits from without a disk read
+constexpr size_t kRecentCommits = 256;
+
+bool parseMark(const std::string& text, uint64_t& mark) {
+    if (text.size() < 2 || text[0] != ':' ||
+        !std::all_of(text.begin() + 1, text.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return false;
+    }
+    mark = std::strtoull(text.c_str() + 1, nullptr, 10);
+    return mark != 0;
+}
+
+std::string fullRef(const std::string& name) {
+    return name.compare(0, 5, "refs/") == 0 ? name : "refs/heads/" + name;
+}
+
+// Parses a path that runs to the end of the line, C-quoted or plain
+bool parsePath(const std::string& text, std::string& path) {
+    path.clear();
+    if (text.empty() || text[0] != '"') {
+        path = text;
+    } else {
+        size_t i = 1;
+        for (; i < text.size() && text[i] != '"'; ++i) {
+            char c = text[i];
+            if (c != '\\') {
+                path += c;
+                continue;
+            }
+            if (++i >= text.size()) {
+                return false;
+            }
+            c = text[i];
+            if (c >= '0' && c <= '7') {
+                // Octal escapes are always three digits and name one byte
+                auto octal = [](char d) { return d >= '0' && d <= '7'; };
+                if (c > '3' || i + 2 >= text.size() || !octal(text[i + 1]) || !octal(text[i + 2])) {
+                    return false;
+                }
+                path += static_cast<char>(((c - '0') << 6) | ((text[i + 1] - '0') << 3) | (text[i + 2] - '0'));
+                i += 2;
+                continue;
+            }
+            switch (c) {
+                case 'a': path += '\a'; break;
+                case 'b': path += '\b'; break;
+                case 'f': path += '\f'; break;
+                case 'n': path += '\n'; break;
+                case 'r': path += '\r'; break;
+                case 't': path += '\t'; break;
+                case 'v': path += '\v'; break;
+                default: path += c; break;
+            }
+        }
+        if (i + 1 != text.size()) {
+            return false;
+        }
+    }
+
+    return utils::isSafePath(path);
+}
+
+// "<name> <<email>> <seconds> <zone>"
+bool parseIdentity(const std::string& text, CommitInfo& commit) {
+    size_t open = text.find('<');
+    size_t close = text.find('>', open);
+    if (open == std::string::npos || close == std::string::npos || close + 1 >= text.size()) {
+        return false;
+    }
+    std::string name = text.substr(0, open);
+    while (!name.empty() && name.back() == ' ') {
+        name.pop_back();
+    }
+    char* end = nullptr;
+    long long seconds = std::strtoll(text.c_str() + close + 1, &end, 10);
+    if (end == text.c_str() + close + 1) {
+        return false;
+    }
+    commit.author = name;
+    commit.email = text.substr(open + 1, close - open - 1);
+    commit.timestamp = std::chrono::system_clock::from_time_t(static_cast<time_t>(seconds));
+    return true;
+}
+
+class StreamReader {
+public:
+    explicit StreamReader(std::istream& in) : in(in), lineNumber(0), hasPending(false) {}
+
+    // Reads the next line; between records blank and comment lines are skipped
+    bool next(std::string& line, bool betweenRecords = false) {
+        if (hasPending) {
+            hasPending = false;
+            line = std::move(pending);
+            return true;
+        }
+        while (std::getline(in, line)) {
+            ++lineNumber;
+            if (!betweenRecords || (!line.empty() && line[0] != '#')) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void unread(std::string line) {
+        pending = std::move(line);
+        hasPending = true;
+    }
+
+    // Reads the payload announced by a "data" line
+    bool data(const std::string& header, std::string& out) {
+        out.clear();
+        if (header.compare(0, 7, "data <<") == 0) {
+            std::string delimiter = header.substr(7);
+            std::string line;
+            while (std::getline(in, line)) {
+                ++lineNumber;
+                if (line == delimiter) {
+                    return !delimiter.empty();
+                }
+                out += line;
+                out += '\n';
+            }
+            return false;
+        }
+
+        if (header.compare(0, 5, "data ") != 0 || header.size() == 5 ||
+            !std::all_of(header.begin() + 5, header.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            return false;
+        }
+        size_t size = std::strtoull(header.c_str() + 5, nullptr, 10);
+        out.resize(size);
+        in.read(out.data(), static_cast<std::streamsize>(size));
+        if (static_cast<size_t>(in.gcount()) != size) {
+            return false;
+        }
+        lineNumber += std::count(out.begin(), out.end(), '\n');
+        if (in.peek() == '\n') {
+            in.get();
+            ++lineNumber;
+        }
+        return true;
+    }
+
+    size_t line() const {
+        return lineNumber;
+    }
+
+private:
+    std::istream& in;
+    size_t lineNumber;
+    bool hasPending;
+    std::string pending;
+};
+
+class Session {
+public:
+    Session(const fs::path& repoPath, const fs::path& mimirionDir, std::istream& in,
+            std::unordered_map<uint64_t, std::string>& marks, FastImportStats& stats)
+        : objects(mimirionDir), commits(repoPath, mimirionDir), refs(mimirionDir), reader(in),
+          marks(marks), stats(stats), pendingBytes(0), unsynced(false) {}
+
+    bool run() {
+        std::string line;
+        while (reader.next(line, true)) {
+            bool ok;
+            if (line == "blob") {
+                ok = blob();
+            } else if (line.compare(0, 7, "commit ") == 0) {
+                ok = commit(fullRef(line.substr(7)));
+            } else if (line.compare(0, 6, "reset ") == 0) {
+                ok = reset(fullRef(line.substr(6)));
+            } else if (line == "checkpoint") {
+                ok = checkpoint();
+            } else if (line == "done") {
+                break;
+            } else {
+                ok = fail("unknown command '" + line + "'");
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+        return checkpoint();
+    }
+
+private:
+    struct Branch {
+        std::string head;
+        Snapshot snapshot;
+    };
+
+    ObjectStore objects;
+    CommitManager commits;
+    RefStore refs;
+    StreamReader reader;
+    std::unordered_map<uint64_t, std::string>& marks;
+    FastImportStats& stats;
+
+    std::unordered_map<std::string, Branch> branches;
+    std::map<std::string, std::string> updates;
+    std::unordered_map<std::string, Snapshot> recent;
+
+    // Objects hashed but not written yet
+    std::vector<std::pair<std::string, std::string>> pendingBlobs;
+    std::vector<Snapshot> pendingCommits;
+    std::unordered_set<std::string> pendingHashes;
+    size_t pendingBytes;
+    bool unsynced;
+
+    bool fail(const std::string& message) {
+        std::cerr << "fast-import: line " << reader.line() << ": " << message << std::endl;
+        return false;
+    }
+
+    // An optional "mark :<n>" line
+    bool readMark(std::string& line, uint64_t& mark) {
+        mark = 0;
+        if (line.compare(0, 5, "mark ") == 0) {
+            if (!parseMark(line.substr(5), mark)) {
+                return fail("bad mark '" + line.substr(5) + "'");
+            }
+            if (!reader.next(line)) {
+                return fail("unexpected end of stream");
+            }
+        }
+        return true;
+    }
+
+    bool readData(const std::string& header, std::string& out) {
+        if (!reader.data(header, out)) {
+            return fail(header.compare(0, 5, "data ") == 0 ? "truncated data" : "expected data");
+        }
+        return true;
+    }
+
+    bool blob() {
+        std::string line;
+        uint64_t mark = 0;
+        std::string content;
+        if (!reader.next(line) || !readMark(line, mark) || !readData(line, content)) {
+            return line.empty() ? fail("unexpected end of stream") : false;
+        }
+        std::string hash = storeBlob(std::move(content));
+        if (mark != 0) {
+            marks[mark] = hash;
+        }
+        return maybeFlush();
+    }
+
+    bool commit(const std::string& ref) {
+        auto commit = std::make_shared<CommitInfo>();
+        std::string line;
+        uint64_t mark = 0;
+        if (!reader.next(line) || !readMark(line, mark)) {
+            return line.empty() ? fail("unexpected end of stream") : false;
+        }
+
+        // The author's identity wins over the committer's
+        bool hasIdentity = false;
+        while (line.compare(0, 7, "author ") == 0 || line.compare(0, 10, "committer ") == 0) {
+            bool author = line[0] == 'a';
+            if (author || !hasIdentity) {
+                if (!parseIdentity(line.substr(author ? 7 : 10), *commit)) {
+                    return fail("bad identity '" + line + "'");
+                }
+                hasIdentity = true;
+            }
+            if (!reader.next(line)) {
+                return fail("unexpected end of stream");
+            }
+        }
+        if (!hasIdentity) {
+            return fail("commit without author or committer");
+        }
+        if (!readData(line, commit->message)) {
+            return false;
+        }
+
+        // Parents: "from", or where the ref stands
+        Branch& branch = lookupBranch(ref);
+        std::string parent = branch.head;
+        Snapshot base = branch.snapshot;
+        bool more = reader.next(line);
+        if (more && line.compare(0, 5, "from ") == 0) {
+            parent = resolveCommit(line.substr(5));
+            if (parent.empty()) {
+                return fail("unknown commit '" + line.substr(5) + "'");
+            }
+            base = nullptr;
+            more = reader.next(line);
+        }
+        if (!parent.empty()) {
+            if (!base || base->hash != parent) {
+                base = snapshotOf(parent);
+                if (!base) {
+                    return fail("cannot read commit " + parent);
+                }
+            }
+            commit->parentHashes.push_back(parent);
+            commit->fileHashes = base->fileHashes;
+        }
+        while (more && line.compare(0, 6, "merge ") == 0) {
+            std::string merged = resolveCommit(line.substr(6));
+            if (merged.empty()) {
+                return fail("unknown commit '" + line.substr(6) + "'");
+            }
+            commit->parentHashes.push_back(merged);
+            more = reader.next(line);
+        }
+
+        // File changes until the first line that is not one
+        for (; more; more = reader.next(line)) {
+            if (line.empty()) {
+                break;
+            }
+            if (line.compare(0, 2, "M ") == 0) {
+                if (!modify(line, commit->fileHashes)) {
+                    return false;
+                }
+            } else if (line.compare(0, 2, "D ") == 0) {
+                std::string path;
+                if (!parsePath(line.substr(2), path)) {
+                    return fail("bad path '" + line.substr(2) + "'");
+                }
+                if (commit->fileHashes.erase(path) == 0) {
+                    std::string prefix = path + "/";
+                    for (auto it = commit->fileHashes.begin(); it != commit->fileHashes.end();) {
+                        it = it->first.compare(0, prefix.size(), prefix) == 0 ? commit->fileHashes.erase(it)
+                                                                               : std::next(it);
+                    }
+                }
+            } else if (line == "deleteall") {
+                commit->fileHashes.clear();
+            } else {
+                reader.unread(std::move(line));
+                break;
+            }
+        }
+
+        std::string hash = commits.hashCommit(*commit);
+        if (mark != 0) {
+            marks[mark] = hash;
+        }
+        if (pendingHashes.insert(hash).second && !objects.hasObject(hash)) {
+            pendingCommits.push_back(commit);
+            ++stats.commits;
+        }
+        if (recent.size() >= kRecentCommits) {
+            recent.clear();
+        }
+        recent[hash] = commit;
+        branch.head = hash;
+        branch.snapshot = commit;
+        updates[ref] = hash;
+        return maybeFlush();
+    }
+
+    // "M <mode> <dataref> <path>"
+    bool modify(const std::string& line, std::unordered_map<std::string, std::string>& files) {
+        size_t modeEnd = line.find(' ', 2);
+        size_t refEnd = modeEnd == std::string::npos ? modeEnd : line.find(' ', modeEnd + 1);
+        if (refEnd == std::string::npos) {
+            return fail("bad file command '" + line + "'");
+        }
+        std::string mode = line.substr(2, modeEnd - 2);
+        std::string dataRef = line.substr(modeEnd + 1, refEnd - modeEnd - 1);
+        std::string path;
+        if (mode != "100644" && mode != "644" && mode != "100755" && mode != "755" && mode != "120000") {
+            return fail("unsupported mode " + mode);
+        }
+        if (!parsePath(line.substr(refEnd + 1), path)) {
+            return fail("bad path '" + line.substr(refEnd + 1) + "'");
+        }
+
+        std::string hash;
+        uint64_t mark = 0;
+        if (dataRef == "inline") {
+            std::string header;
+            std::string content;
+            if (!reader.next(header) || !readData(header, content)) {
+                return header.empty() ? fail("unexpected end of stream") : false;
+            }
+            hash = storeBlob(std::move(content));
+        } else if (parseMark(dataRef, mark)) {
+            auto it = marks.find(mark);
+            if (it == marks.end()) {
+                return fail("unknown mark " + dataRef);
+            }
+            hash = it->second;
+        } else if (ObjectStore::isValidHash(dataRef) &&
+                   (pendingHashes.count(dataRef) || objects.hasObject(dataRef))) {
+            hash = dataRef;
+        } else {
+            return fail("unknown blob " + dataRef);
+        }
+        files[path] = hash;
+        return true;
+    }
+
+    bool reset(const std::string& ref) {
+        Branch& branch = branches[ref];
+        branch.head.clear();
+        branch.snapshot = nullptr;
+
+        std::string line;
+        if (reader.next(line)) {
+            if (line.compare(0, 5, "from ") != 0) {
+                reader.unread(std::move(line));
+            } else {
+                branch.head = resolveCommit(line.substr(5));
+                if (branch.head.empty()) {
+                    return fail("unknown commit '" + line.substr(5) + "'");
+                }
+                updates[ref] = branch.head;
+            }
+        }
+        return true;
+    }
+
+    // Starts a branch from the repository's ref the first time it is used
+    Branch& lookupBranch(const std::string& ref) {
+        auto [it, inserted] = branches.try_emplace(ref);
+        if (inserted) {
+            it->second.head = refs.readRef(ref);
+        }
+        return it->second;
+    }
+
+    std::string resolveCommit(const std::string& name) {
+        uint64_t mark = 0;
+        if (parseMark(name, mark)) {
+            auto it = marks.find(mark);
+            return it == marks.end() ? "" : it->second;
+        }
+        auto branch = branches.find(fullRef(name));
+        if (branch != branches.end() && !branch->second.head.empty()) {
+            return branch->second.head;
+        }
+        if (recent.count(name) || pendingHashes.count(name)) {
+            return name;
+        }
+        return refs.resolve(name, &objects);
+    }
+
+    Snapshot snapshotOf(const std::string& hash) {
+        auto it = recent.find(hash);
+        if (it != recent.end()) {
+            return it->second;
+        }
+        // Older commits of this stream have to reach the store first
+        if (pendingHashes.count(hash) && !flush()) {
+            return nullptr;
+        }
+        CommitInfo* stored = commits.getCommit(hash);
+        return stored ? std::make_shared<const CommitInfo>(*stored) : nullptr;
+    }
+
+    std::string storeBlob(std::string content) {
+        std::string hash = utils::sha256(content);
+        if (!pendingHashes.count(hash) && !objects.hasObject(hash)) {
+            pendingHashes.insert(hash);
+            pendingBytes += content.size();
+            pendingBlobs.emplace_back(hash, std::move(content));
+            ++stats.blobs;
+        }
+        return hash;
+    }
+
+    bool maybeFlush() {
+        if (pendingBytes < FastImporter::kBatchBytes &&
+            pendingBlobs.size() + pendingCommits.size() < FastImporter::kBatchObjects) {
+            return true;
+        }
+        return flush();
+    }
+
+    // Writes the buffered objects on the task scheduler
+    bool flush() {
+        std::atomic<bool> failed{false};
+        parallelFor(pendingBlobs.size(), [&](size_t i) {
+            if (!objects.storeObject(pendingBlobs[i].first, pendingBlobs[i].second)) {
+                failed = true;
+            }
+        }, 8);
+        parallelFor(pendingCommits.size(), [&](size_t i) {
+            if (!commits.storeCommit(*pendingCommits[i], objects)) {
+                failed = true;
+            }
+        }, 8);
+        if (failed) {
+            return fail("failed to write objects");
+        }
+        unsynced = unsynced || !pendingHashes.empty();
+        pendingBlobs.clear();
+        pendingCommits.clear();
+        pendingHashes.clear();
+        pendingBytes = 0;
+        return true;
+    }
+
+    // Makes everything so far durable, then publishes the refs
+    bool checkpoint() {
+        if (!flush()) {
+            return false;
+        }
+        if (unsynced && !objects.sync()) {
+            return false;
+        }
+        unsynced = false;
+        for (const auto& [ref, hash] : updates) {
+            if (!refs.writeRef(ref, hash)) {
+                return false;
+            }
+            ++stats.refs;
+        }
+        updates.clear();
+        return true;
+    }
+};
+
+} // namespace
+
+FastImporter::FastImporter(const fs::path& repoPath, const fs::path& mimirDir)
+    : repositoryPath(repoPath), mimirionDir(mimirDir) {
+}
+
+bool FastImporter::importMarks(const fs::path& path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Cannot read marks file " << path.string() << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t space = line.find(' ');
+        uint64_t mark = 0;
+        if (space != std::string::npos && parseMark(line.substr(0, space), mark)) {
+            marks[mark] = line.substr(space + 1);
+        }
+    }
+    return true;
+}
+
+bool FastImporter::exportMarks(const fs::path& path) const {
+    std::vector<std::pair<uint64_t, std::string>> sorted(marks.begin(), marks.end());
+    std::sort(sorted.begin(), sorted.end());
+
+    fs::path temp = path;
+    temp += ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream file(temp, std::ios::trunc);
+        for (const auto& [mark, hash] : sorted) {
+            file << ':' << mark << ' ' << hash << '\n';
+        }
+        if (!file) {
+            std::cerr << "Cannot write marks file " << path.string() << std::endl;
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(temp, path, ec);
+    if (ec) {
+        std::cerr << "Cannot write marks file " << path.string() << ": " << ec.message() << std::endl;
+        fs::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+bool FastImporter::run(std::istream& in, FastImportStats* stats) {
+    FastImportStats counts;
+    Session session(repositoryPath, mimirionDir, in, marks, counts);
+    bool ok = session.run();
+    if (stats) {
+        *stats = counts;
+    }
+    return ok;
+}
+
+} // namespace mimirion
@@ -1,10 +1,15 @@
 #include "../include/file_tracker.hpp"
 #include "../include/utils.hpp"
+#include "../include/scheduler.hpp"
+#include "../include/arena.hpp"
+#include "../include/file_view.hpp"
+#include "../include/lfs.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <iterator>
+#include <charconv>
 
 namespace mimirion {
 
@@ -16,11 +21,21 @@ void FileTracker::updateStatus() {
     // Update the status of all files in the repository
     std::unordered_map<std::string, FileInfo> oldFiles = files;
     files.clear();
+    filters = std::make_shared<FilterPipeline>(repositoryPath, mimirionDir);
     
     // Walk through repository and collect files
-    for (const auto& entry : fs::recursive_directory_iterator(repositoryPath)) {
-        // Skip .mimirion directory
-        if (entry.path().string().find(mimirionDir.string()) == 0) {
+    std::vector<FileInfo> found;
+    std::vector<fs::path> fullPaths;
+    ignoreRules = IgnoreRules::load(repositoryPath);
+    for (auto it = fs::recursive_directory_iterator(repositoryPath); it != fs::recursive_directory_iterator(); ++it) {
+        const auto& entry = *it;
+        
+        // Skip ignored files, and don't descend into ignored directories
+        bool directory = entry.is_directory();
+        if (isIgnored(entry.path(), directory)) {
+            if (directory) {
+                it.disable_recursion_pending();
+            }
             continue;
         }
         
@@ -29,21 +44,23 @@ void FileTracker::updateStatus() {
             continue;
         }
         
-        // Skip ignored files
-        if (isIgnored(entry.path())) {
-            continue;
-        }
-        
         // Get relative path to the repository
-        std::string relativePath = fs::relative(entry.path(), repositoryPath).string();
-        
-        // Create or update file info
         FileInfo fileInfo;
-        fileInfo.path = relativePath;
-        fileInfo.hash = calculateFileHash(entry.path());
-        
+        fileInfo.path = fs::relative(entry.path(), repositoryPath).string();
+        found.push_back(fileInfo);
+        fullPaths.push_back(entry.path());
+    }
+    
+    // Hashing dominates the walk, spread it over the shared scheduler;
+    // files whose size and mtime match the index are not read at all
+    parallelFor(found.size(), [&](size_t i) {
+        auto old = oldFiles.find(found[i].path);
+        scanFile(fullPaths[i], found[i], old != oldFiles.end() ? &old->second : nullptr);
+    });
+    
+    for (auto& fileInfo : found) {
         // Check if file was previously tracked
-        auto it = oldFiles.find(relativePath);
+        auto it = oldFiles.find(fileInfo.path);
         if (it != oldFiles.end()) {
             fileInfo.lastCommitHash = it->second.lastCommitHash;
             
@@ -58,7 +75,7 @@ void FileTracker::updateStatus() {
             fileInfo.status = FileStatus::UNTRACKED;
         }
         
-        files[relativePath] = fileInfo;
+        files[fileInfo.path] = fileInfo;
     }
     
     // Check for deleted files
@@ -100,23 +117,21 @@ bool FileTracker::stageFile(const std::string& path) {
     // Get relative path
     std::string relativePath = fs::relative(fullPath, repositoryPath).string();
     
-    // Calculate hash
-    std::string hash = calculateFileHash(fullPath);
-    
     // Create or update file info
     auto it = files.find(relativePath);
+    FileInfo fileInfo;
     if (it != files.end()) {
-        it->second.hash = hash;
-        it->second.status = FileStatus::STAGED;
+        fileInfo = it->second;
     } else {
-        FileInfo fileInfo;
         fileInfo.path = relativePath;
-        fileInfo.hash = hash;
         fileInfo.lastCommitHash = "";
-        fileInfo.status = FileStatus::STAGED;
-        files[relativePath] = fileInfo;
     }
     
+    // Calculate hash
+    scanFile(fullPath, fileInfo, it != files.end() ? &it->second : nullptr);
+    fileInfo.status = FileStatus::STAGED;
+    files[relativePath] = std::move(fileInfo);
+    
     return saveState();
 }
 
@@ -136,7 +151,7 @@ bool FileTracker::unstageFile(const std::string& path) {
         it->second.status = FileStatus::UNTRACKED;
     } else {
         fs::path fullPath = repositoryPath / path;
-        std::string currentHash = calculateFileHash(fullPath);
+        std::string currentHash = calculateFileHash(fullPath, &it->second);
         
         if (currentHash == it->second.lastCommitHash) {
             it->second.status = FileStatus::COMMITTED;
@@ -148,6 +163,34 @@ bool FileTracker::unstageFile(const std::string& path) {
     return saveState();
 }
 
+FileStatus FileTracker::getFileStatus(const std::string& path) const {
+    auto it = files.find(path);
+    if (it == files.end()) {
+        return FileStatus::UNTRACKED;
+    }
+    
+    fs::path fullPath = repositoryPath / path;
+    if (!fs::exists(fullPath)) {
+        return FileStatus::DELETED;
+    }
+    
+    std::string currentHash = calculateFileHash(fullPath, &it->second);
+    if (it->second.status == FileStatus::STAGED && currentHash == it->second.hash) {
+        return FileStatus::STAGED;
+    }
+    if (it->second.status == FileStatus::UNTRACKED) {
+        return FileStatus::UNTRACKED;
+    }
+    if (currentHash == it->second.lastCommitHash) {
+        return FileStatus::COMMITTED;
+    }
+    return FileStatus::MODIFIED;
+}
+
+bool FileTracker::isTracked(const std::string& path) const {
+    return files.find(path) != files.end();
+}
+
 std::vector<FileInfo> FileTracker::getStagedFiles() const {
     std::vector<FileInfo> result;
     
@@ -179,7 +222,12 @@ bool FileTracker::saveState() const {
         indexFile << file.second.path << "\t"
                  << file.second.hash << "\t"
                  << file.second.lastCommitHash << "\t"
-                 << static_cast<int>(file.second.status) << std::endl;
+                 << static_cast<int>(file.second.status) << "\t"
+                 << file.second.size << "\t"
+                 << file.second.mtime << "\t"
+                 << (file.second.binary ? 1 : 0) << "\t"
+                 << file.second.lineCount << "\t"
+                 << static_cast<int>(file.second.newlines) << "\n";
     }
     
     indexFile.close();
@@ -189,43 +237,156 @@ bool FileTracker::saveState() const {
 bool FileTracker::loadState() {
     // Clear current files
     files.clear();
+    filters = std::make_shared<FilterPipeline>(repositoryPath, mimirionDir);
     
-    // Open index file
-    std::ifstream indexFile(mimirionDir / "index");
-    if (!indexFile) {
-        // Index file doesn't exist yet, that's ok
+    // Index file doesn't exist yet, that's ok
+    fs::path indexPath = mimirionDir / "index";
+    if (!fs::exists(indexPath)) {
         return true;
     }
     
+    FileView index(indexPath, FileView::Advice::SEQUENTIAL);
+    std::string_view content = index.view();
+    std::error_code ec;
+    indexTime = fs::last_write_time(indexPath, ec).time_since_epoch().count();
+    
+    // Line and field views only live for the duration of the parse; the
+    // entries outlive it, so they copy what they keep
+    Arena arena;
+    std::pmr::vector<std::string_view> lines = utils::splitLines(content, arena.resource());
+    files.reserve(lines.size());
+    
     // Read file information
-    std::string line;
-    while (std::getline(indexFile, line)) {
-        std::istringstream iss(line);
-        std::string path, hash, lastCommitHash;
-        int status;
+    for (std::string_view line : lines) {
+        // Format: path \t hash \t lastCommitHash \t status, optionally
+        // followed by size \t mtime \t binary \t lines \t newlines
+        std::string_view fields[3];
+        bool complete = true;
+        for (auto& field : fields) {
+            size_t tab = line.find('\t');
+            if (tab == std::string_view::npos) {
+                complete = false;
+                break;
+            }
+            field = line.substr(0, tab);
+            line.remove_prefix(tab + 1);
+        }
         
-        if (std::getline(iss, path, '\t') && 
-            std::getline(iss, hash, '\t') && 
-            std::getline(iss, lastCommitHash, '\t') && 
-            (iss >> status)) {
-            
-            FileInfo fileInfo;
-            fileInfo.path = path;
-            fileInfo.hash = hash;
-            fileInfo.lastCommitHash = lastCommitHash;
-            fileInfo.status = static_cast<FileStatus>(status);
-            
-            files[path] = fileInfo;
+        while (!line.empty() && (line.front() == ' ' || line.front() == '\t')) {
+            line.remove_prefix(1);
+        }
+        const char* end = line.data() + line.size();
+        int status = 0;
+        auto parsed = std::from_chars(line.data(), end, status);
+        if (!complete || parsed.ec != std::errc()) {
+            continue;
+        }
+        
+        FileInfo fileInfo;
+        fileInfo.path = std::string(fields[0]);
+        fileInfo.hash = std::string(fields[1]);
+        fileInfo.lastCommitHash = std::string(fields[2]);
+        fileInfo.status = static_cast<FileStatus>(status);
+        
+        // Cached scan results; an entry without them is simply rehashed
+        int64_t cache[5] = {0, 0, 0, 0, 0};
+        const char* p = parsed.ptr;
+        bool cached = true;
+        for (int64_t& value : cache) {
+            if (p == end || *p != '\t') {
+                cached = false;
+                break;
+            }
+            parsed = std::from_chars(p + 1, end, value);
+            if (parsed.ec != std::errc()) {
+                cached = false;
+                break;
+            }
+            p = parsed.ptr;
+        }
+        if (cached) {
+            fileInfo.size = static_cast<uint64_t>(cache[0]);
+            fileInfo.mtime = cache[1];
+            fileInfo.binary = cache[2] != 0;
+            fileInfo.lineCount = static_cast<uint64_t>(cache[3]);
+            fileInfo.newlines = static_cast<NewlineStyle>(cache[4]);
         }
+        
+        files[fileInfo.path] = std::move(fileInfo);
     }
     
-    indexFile.close();
     return true;
 }
 
-std::string FileTracker::calculateFileHash(const fs::path& filePath) const {
-    // Use the utility function to calculate SHA-256 hash
-    return utils::sha256File(filePath);
+std::string FileTracker::calculateFileHash(const fs::path& filePath, const FileInfo* cached) const {
+    FileInfo file;
+    scanFile(filePath, file, cached);
+    return file.hash;
+}
+
+bool FileTracker::scanFile(const fs::path& filePath, FileInfo& file, const FileInfo* cached) const {
+    std::error_code ec;
+    uint64_t size = fs::file_size(filePath, ec);
+    int64_t mtime = ec ? 0 : fs::last_write_time(filePath, ec).time_since_epoch().count();
+    
+    // A file changed in the same clock tick the index was written may still
+    // show the old mtime, so only entries older than the index are trusted
+    if (!ec && cached && !cached->hash.empty() && cached->mtime != 0 &&
+        cached->mtime == mtime && cached->size == size && mtime < indexTime) {
+        file.hash = cached->hash;
+        file.size = cached->size;
+        file.mtime = cached->mtime;
+        file.binary = cached->binary;
+        file.lineCount = cached->lineCount;
+        file.newlines = cached->newlines;
+        return true;
+    }
+    
+    // One read yields the hash and the content facts kept in the index;
+    // filtered files are hashed as they would be stored
+    std::string relative = filePath.lexically_relative(repositoryPath).generic_string();
+    bool filtered = filters && filters->hasFilters(relative);
+    thread_local FileScanner scanner;
+    ScanResult result;
+    bool scanned = false;
+    if (!ec && filtered) {
+        ScanStream stream;
+        scanned = filters->clean(filePath, relative, [&stream](const char* data, size_t size) {
+            stream.update(data, size);
+            return true;
+        });
+        result = stream.finish();
+    } else if (!ec) {
+        scanned = scanner.scan(filePath, result);
+    }
+    if (!scanned) {
+        file.hash = "";
+        file.size = 0;
+        file.mtime = 0;
+        file.binary = false;
+        file.lineCount = 0;
+        file.newlines = NewlineStyle::NONE;
+        return false;
+    }
+    
+    file.hash = result.hash;
+    if (filters && !filters->attributes().empty()) {
+        // Large files are tracked as their pointer, so a materialized file
+        // and its pointer file both match the committed pointer object
+        auto filter = filters->attributes().get(relative, "filter");
+        LfsPointer pointer{result.hash, result.size};
+        if (filter && *filter == "lfs" &&
+            (result.size > LargeFileStore::kMaxPointerSize ||
+             !LargeFileStore::readPointerFile(filePath, pointer))) {
+            file.hash = utils::sha256(LargeFileStore::formatPointer(pointer));
+        }
+    }
+    file.size = size;
+    file.mtime = mtime;
+    file.binary = result.binary;
+    file.lineCount = result.lines;
+    file.newlines = result.newlines;
+    return true;
 }
 
 void FileTracker::updateFileStatus(FileInfo& file) {
@@ -236,7 +397,7 @@ void FileTracker::updateFileStatus(FileInfo& file) {
         return;
     }
     
-    std::string currentHash = calculateFileHash(fullPath);
+    std::string currentHash = calculateFileHash(fullPath, &file);
     
     if (file.lastCommitHash.empty()) {
         file.status = FileStatus::UNTRACKED;
@@ -247,18 +408,15 @@ void FileTracker::updateFileStatus(FileInfo& file) {
     }
 }
 
-bool FileTracker::isIgnored(const fs::path& path) const {
-    // Check for .mimirionignore file
-    fs::path ignoreFile = repositoryPath / ".mimirionignore";
-    if (!fs::exists(ignoreFile)) {
-        // No ignore file, only ignore .mimirion directory
-        return path.string().find(mimirionDir.string()) == 0;
+bool FileTracker::isIgnored(const fs::path& path, bool directory) const {
+    // The .mimirion directory, or a linked worktree's .mimirion file, is
+    // never part of the working tree
+    if (path.string().find(mimirionDir.string()) == 0 || path == repositoryPath / ".mimirion") {
+        return true;
     }
     
-    // TODO: Implement more sophisticated ignore pattern matching
-    
-    // For now, just ignore .mimirion directory
-    return path.string().find(mimirionDir.string()) == 0;
+    std::string relative = path.lexically_relative(repositoryPath).generic_string();
+    return ignoreRules.isIgnored(relative, directory);
 }
 
 } // namespace mimirion
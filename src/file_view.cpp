@@ -0,0 +1,176 @@
+/**
+ * @file file_view.cpp
+ * @brief Implementation of the FileView class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/file_view.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mimirion {
+
+namespace {
+
+int adviceFlag(FileView::Advice advice) {
+    switch (advice) {
+        case FileView::Advice::SEQUENTIAL: return MADV_SEQUENTIAL;
+        case FileView::Advice::RANDOM: return MADV_RANDOM;
+        case FileView::Advice::WILL_NEED: return MADV_WILLNEED;
+        case FileView::Advice::NORMAL: break;
+    }
+    return MADV_NORMAL;
+}
+
+} // namespace
+
+FileView::FileView() : contents(nullptr), length(0), mapped(false), opened(false) {
+}
+
+FileView::FileView(const fs::path& path, Advice advice) : FileView() {
+    open(path, advice);
+}
+
+FileView::~FileView() {
+    close();
+}
+
+FileView::FileView(FileView&& other) noexcept : FileView() {
+    *this = std::move(other);
+}
+
+FileView& FileView::operator=(FileView&& other) noexcept {
+    if (this != &other) {
+        close();
+        buffer = std::move(other.buffer);
+        contents = other.mapped ? other.contents : buffer.data();
+        length = other.length;
+        mapped = other.mapped;
+        opened = other.opened;
+
+        // The mapping now belongs to this view
+        other.mapped = false;
+        other.close();
+    }
+    return *this;
+}
+
+bool FileView::open(const fs::path& path, Advice advice) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // Only regular files have a size that can be trusted and mapped
+    bool regular = S_ISREG(st.st_mode);
+    size_t size = regular ? static_cast<size_t>(st.st_size) : 0;
+    if (regular && size >= kMapThreshold) {
+        void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            ::close(fd);
+            contents = static_cast<const char*>(address);
+            length = size;
+            mapped = true;
+            opened = true;
+            advise(advice);
+            return true;
+        }
+    }
+
+    bool ok = readAll(fd, size);
+    ::close(fd);
+    return ok;
+}
+
+bool FileView::readAll(int fd, size_t sizeHint) {
+    // One spare byte lets a correct hint end with a read that returns 0
+    buffer.resize(sizeHint > 0 ? sizeHint + 1 : 16 * 1024);
+    size_t total = 0;
+    while (true) {
+        if (total == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        }
+        ssize_t count = ::read(fd, &buffer[total], buffer.size() - total);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            buffer.clear();
+            return false;
+        }
+        if (count == 0) {
+            break;
+        }
+        total += static_cast<size_t>(count);
+    }
+
+    buffer.resize(total);
+    contents = buffer.data();
+    length = total;
+    opened = true;
+    return true;
+}
+
+void FileView::close() {
+    if (mapped) {
+        munmap(const_cast<char*>(contents), length);
+    }
+    buffer.clear();
+    buffer.shrink_to_fit();
+    contents = nullptr;
+    length = 0;
+    mapped = false;
+    opened = false;
+}
+
+bool FileView::isOpen() const {
+    return opened;
+}
+
+bool FileView::isMapped() const {
+    return mapped;
+}
+
+const char* FileView::data() const {
+    return contents;
+}
+
+size_t FileView::size() const {
+    return length;
+}
+
+std::string_view FileView::view() const {
+    return std::string_view(contents, length);
+}
+
+std::string_view FileView::view(size_t offset, size_t count) const {
+    offset = std::min(offset, length);
+    return std::string_view(contents + offset, std::min(count, length - offset));
+}
+
+void FileView::advise(Advice advice, size_t offset, size_t count) const {
+    if (!mapped || offset >= length) {
+        return;
+    }
+
+    // madvise works on whole pages
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t start = offset - offset % page;
+    size_t end = count == 0 ? length : std::min(length, offset + count);
+    madvise(const_cast<char*>(contents) + start, end - start, adviceFlag(advice));
+}
+
+} // namespace mimirion
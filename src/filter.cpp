@@ -0,0 +1,685 @@
+/**
+ * @file filter.cpp
+ * @brief Implementation of the filter pipeline
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/filter.hpp"
+#include "../include/config.hpp"
+#include "../include/file_view.hpp"
+#include "../include/scanner.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace mimirion {
+
+namespace {
+
+// Pieces in which working tree files are fed to a chain
+constexpr size_t kCleanChunkSize = 64 * 1024;
+
+// Longest expanded keyword recognized, `$Id: ... $`
+constexpr size_t kMaxKeywordLength = 256;
+
+// pkt-line limits of the filter protocol
+constexpr size_t kMaxPacketSize = 65520;
+constexpr size_t kPacketHeaderSize = 4;
+
+struct FilterSelection {
+    bool normalize = false;  // CRLF to LF when cleaning
+    bool autoDetect = false; // ... only for text content
+    bool crlf = false;       // LF to CRLF when smudging
+    bool ident = false;      // $Id$ keywords
+    std::string driver;      // filter process
+
+    bool any() const { return normalize || crlf || ident || !driver.empty(); }
+};
+
+FilterSelection selectFilters(const Attributes& attributes, const std::string& path) {
+    FilterSelection selection;
+    if (attributes.empty()) {
+        return selection;
+    }
+
+    auto values = attributes.getAll(path);
+    auto value = [&values](const char* name) {
+        auto it = values.find(name);
+        return it == values.end() ? std::string() : it->second;
+    };
+
+    std::string text = value("text");
+    std::string eol = value("eol");
+    if (text != "false") {
+        selection.normalize = text == "true" || text == "auto" || !eol.empty();
+        selection.autoDetect = text == "auto";
+        selection.crlf = eol == "crlf";
+    }
+    selection.ident = value("ident") == "true";
+
+    std::string driver = value("filter");
+    if (driver != "lfs" && driver != "true" && driver != "false") {
+        selection.driver = driver;
+    }
+    return selection;
+}
+
+// CRLF to LF; a CR ending one piece is held until the next one shows
+// whether an LF follows
+class LineEndingCleaner : public FilterStage {
+public:
+    explicit LineEndingCleaner(bool autoDetect) : autoDetect(autoDetect) {}
+
+    bool write(const char* data, size_t size, const CompressionSink& next) override {
+        if (size == 0) {
+            return true;
+        }
+        if (!decided) {
+            size_t inspect = std::min(size, FileScanner::kBinaryCheckSize);
+            convert = !autoDetect || !FileScanner::looksBinary(std::string_view(data, inspect));
+            decided = true;
+        }
+        if (!convert) {
+            return next(data, size);
+        }
+
+        output.clear();
+        if (heldCR && data[0] != '\n') {
+            output += '\r';
+        }
+        heldCR = false;
+
+        const char* end = data + size;
+        const char* start = data;
+        for (const char* p = data; (p = static_cast<const char*>(std::memchr(p, '\r', end - p)));
+             ++p) {
+            if (p + 1 == end) {
+                output.append(start, p);
+                heldCR = true;
+                start = end;
+                break;
+            }
+            if (p[1] == '\n') {
+                output.append(start, p);
+                start = p + 1;
+            }
+        }
+        output.append(start, end);
+        return output.empty() || next(output.data(), output.size());
+    }
+
+    bool finish(const CompressionSink& next) override {
+        bool ok = !heldCR || next("\r", 1);
+        heldCR = false;
+        return ok;
+    }
+
+private:
+    bool autoDetect;
+    bool decided = false;
+    bool convert = true;
+    bool heldCR = false;
+    std::string output;
+};
+
+// LF to CRLF, leaving existing CRLF alone
+class LineEndingSmudger : public FilterStage {
+public:
+    bool write(const char* data, size_t size, const CompressionSink& next) override {
+        if (size == 0) {
+            return true;
+        }
+
+        output.clear();
+        const char* end = data + size;
+        const char* start = data;
+        for (const char* p = data; (p = static_cast<const char*>(std::memchr(p, '\n', end - p)));
+             ++p) {
+            output.append(start, p);
+            char previous = p == data ? lastByte : p[-1];
+            if (previous != '\r') {
+                output += '\r';
+            }
+            output += '\n';
+            start = p + 1;
+        }
+        output.append(start, end);
+        lastByte = end[-1];
+        return next(output.data(), output.size());
+    }
+
+    bool finish(const CompressionSink&) override {
+        return true;
+    }
+
+private:
+    char lastByte = '\0';
+    std::string output;
+};
+
+// Replaces `$Id$` and `$Id: ... $` with a fixed expansion
+class KeywordFilter : public FilterStage {
+public:
+    explicit KeywordFilter(std::string expansion) : expansion(std::move(expansion)) {}
+
+    bool write(const char* data, size_t size, const CompressionSink& next) override {
+        pending.append(data, size);
+        return process(false, next);
+    }
+
+    bool finish(const CompressionSink& next) override {
+        return process(true, next);
+    }
+
+private:
+    enum class Match { NONE, KEYWORD, INCOMPLETE };
+
+    std::string expansion;
+    std::string pending;
+    std::string output;
+
+    static Match match(std::string_view rest, bool final, size_t& length) {
+        static constexpr std::string_view kKeyword = "$Id";
+        size_t compared = std::min(rest.size(), kKeyword.size());
+        if (rest.substr(0, compared) != kKeyword.substr(0, compared)) {
+            return Match::NONE;
+        }
+        if (rest.size() <= kKeyword.size()) {
+            return final ? Match::NONE : Match::INCOMPLETE;
+        }
+        if (rest[3] == '$') {
+            length = 4;
+            return Match::KEYWORD;
+        }
+        if (rest[3] != ':') {
+            return Match::NONE;
+        }
+        for (size_t i = 4; i < rest.size() && i < kMaxKeywordLength; ++i) {
+            if (rest[i] == '$') {
+                length = i + 1;
+                return Match::KEYWORD;
+            }
+            if (rest[i] == '\n') {
+                return Match::NONE;
+            }
+        }
+        return final || rest.size() >= kMaxKeywordLength ? Match::NONE : Match::INCOMPLETE;
+    }
+
+    bool process(bool final, const CompressionSink& next) {
+        std::string_view work = pending;
+        output.clear();
+        size_t pos = 0;
+        while (pos < work.size()) {
+            size_t dollar = work.find('$', pos);
+            if (dollar == std::string_view::npos) {
+                output.append(work.substr(pos));
+                pos = work.size();
+                break;
+            }
+            output.append(work.substr(pos, dollar - pos));
+
+            size_t length = 0;
+            Match found = match(work.substr(dollar), final, length);
+            if (found == Match::INCOMPLETE) {
+                pos = dollar;
+                break;
+            }
+            if (found == Match::KEYWORD) {
+                output += expansion;
+                pos = dollar + length;
+            } else {
+                output += '$';
+                pos = dollar + 1;
+            }
+        }
+
+        // Only a possible keyword at the very end is held back
+        pending.erase(0, pos);
+        return output.empty() || next(output.data(), output.size());
+    }
+};
+
+} // namespace
+
+/**
+ * @class FilterProcess
+ * @brief A long-running filter command speaking git's filter protocol
+ *
+ * Messages are pkt-lines: four hex digits giving the length including the
+ * header, then the payload; "0000" is a flush packet ending a list or the
+ * content. After the handshake each file is sent as a command list and its
+ * content, and answered with a status list, the filtered content and a
+ * final status list.
+ */
+class FilterProcess {
+public:
+    std::mutex mutex;
+
+    static std::shared_ptr<FilterProcess> start(const std::string& command,
+                                                const fs::path& workingDir) {
+        int sockets[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0) {
+            return nullptr;
+        }
+
+        // Only async-signal-safe calls between fork and exec
+        std::string dir = workingDir.string();
+        pid_t pid = fork();
+        if (pid < 0) {
+            ::close(sockets[0]);
+            ::close(sockets[1]);
+            return nullptr;
+        }
+        if (pid == 0) {
+            dup2(sockets[1], STDIN_FILENO);
+            dup2(sockets[1], STDOUT_FILENO);
+            if (chdir(dir.c_str()) != 0) {
+                _exit(127);
+            }
+            execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        ::close(sockets[1]);
+
+        auto process = std::shared_ptr<FilterProcess>(new FilterProcess(sockets[0], pid));
+        if (!process->handshake()) {
+            std::cerr << "Filter process failed to start: " << command << std::endl;
+            return nullptr;
+        }
+        return process;
+    }
+
+    ~FilterProcess() {
+        // Closing the connection tells the filter to exit
+        ::close(fd);
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+        }
+    }
+
+    bool supports(FilterDirection direction) const {
+        return direction == FilterDirection::CLEAN ? canClean : canSmudge;
+    }
+
+    bool usable() const {
+        return !broken;
+    }
+
+    bool beginRequest(FilterDirection direction, const std::string& path) {
+        const char* command = direction == FilterDirection::CLEAN ? "clean" : "smudge";
+        inRequest = true;
+        return writeText(std::string("command=") + command + "\n") &&
+               writeText("pathname=" + path + "\n") && writeFlush();
+    }
+
+    bool writeContent(const char* data, size_t size) {
+        while (size > 0) {
+            size_t piece = std::min(size, kMaxPacketSize - kPacketHeaderSize);
+            if (!writePacket(std::string_view(data, piece))) {
+                return false;
+            }
+            data += piece;
+            size -= piece;
+        }
+        return true;
+    }
+
+    bool finishRequest(const std::string& path, const CompressionSink& next) {
+        if (!writeFlush()) {
+            return false;
+        }
+
+        std::string status;
+        if (!readStatus(status)) {
+            return false;
+        }
+        if (status != "success") {
+            inRequest = false;
+            std::cerr << "Filter failed on " << path << " (" << status << ")" << std::endl;
+            return false;
+        }
+
+        std::string payload;
+        bool flush = false;
+        while (readPacket(payload, flush) && !flush) {
+            if (!next(payload.data(), payload.size())) {
+                // The rest of the reply is still in the connection
+                broken = true;
+                return false;
+            }
+        }
+        if (!flush) {
+            return false;
+        }
+
+        // An empty list keeps the status given before the content
+        if (!readStatus(status)) {
+            return false;
+        }
+        inRequest = false;
+        if (!status.empty() && status != "success") {
+            std::cerr << "Filter failed on " << path << " (" << status << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void abandonRequest() {
+        // A request cut short leaves the protocol out of step
+        if (inRequest) {
+            broken = true;
+        }
+    }
+
+private:
+    int fd;
+    pid_t pid;
+    bool canClean = false;
+    bool canSmudge = false;
+    bool broken = false;
+    bool inRequest = false;
+    std::string packet;
+
+    FilterProcess(int fd, pid_t pid) : fd(fd), pid(pid) {}
+
+    bool handshake() {
+        if (!writeText("git-filter-client\n") || !writeText("version=2\n") || !writeFlush()) {
+            return false;
+        }
+        std::vector<std::string> reply;
+        if (!readList(reply) || reply.size() < 2 || reply[0] != "git-filter-server" ||
+            reply[1] != "version=2") {
+            return false;
+        }
+        if (!writeText("capability=clean\n") || !writeText("capability=smudge\n") ||
+            !writeFlush() || !readList(reply)) {
+            return false;
+        }
+        for (const auto& line : reply) {
+            canClean = canClean || line == "capability=clean";
+            canSmudge = canSmudge || line == "capability=smudge";
+        }
+        return true;
+    }
+
+    bool sendAll(const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                broken = true;
+                return false;
+            }
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    bool receiveAll(char* data, size_t size) {
+        while (size > 0) {
+            ssize_t received = ::read(fd, data, size);
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received <= 0) {
+                broken = true;
+                return false;
+            }
+            data += received;
+            size -= static_cast<size_t>(received);
+        }
+        return true;
+    }
+
+    bool writePacket(std::string_view payload) {
+        if (broken) {
+            return false;
+        }
+        static const char hex[] = "0123456789abcdef";
+        size_t length = payload.size() + kPacketHeaderSize;
+        packet.assign(kPacketHeaderSize, '0');
+        for (size_t i = 0; i < kPacketHeaderSize; ++i) {
+            packet[kPacketHeaderSize - 1 - i] = hex[(length >> (4 * i)) & 0xf];
+        }
+        packet.append(payload.data(), payload.size());
+        return sendAll(packet.data(), packet.size());
+    }
+
+    bool writeText(const std::string& line) {
+        return writePacket(line);
+    }
+
+    bool writeFlush() {
+        return !broken && sendAll("0000", kPacketHeaderSize);
+    }
+
+    bool readPacket(std::string& payload, bool& flush) {
+        char header[kPacketHeaderSize];
+        if (broken || !receiveAll(header, sizeof(header))) {
+            return false;
+        }
+        size_t length = 0;
+        auto parsed = std::from_chars(header, header + sizeof(header), length, 16);
+        if (parsed.ptr != header + sizeof(header) ||
+            (length != 0 && (length <= kPacketHeaderSize || length > kMaxPacketSize))) {
+            broken = true;
+            return false;
+        }
+
+        flush = length == 0;
+        payload.resize(flush ? 0 : length - kPacketHeaderSize);
+        return receiveAll(&payload[0], payload.size());
+    }
+
+    bool readList(std::vector<std::string>& lines) {
+        lines.clear();
+        std::string payload;
+        bool flush = false;
+        while (readPacket(payload, flush)) {
+            if (flush) {
+                return true;
+            }
+            if (!payload.empty() && payload.back() == '\n') {
+                payload.pop_back();
+            }
+            lines.push_back(payload);
+        }
+        return false;
+    }
+
+    bool readStatus(std::string& status) {
+        std::vector<std::string> lines;
+        if (!readList(lines)) {
+            return false;
+        }
+        status.clear();
+        for (const auto& line : lines) {
+            if (line.compare(0, 7, "status=") == 0) {
+                status = line.substr(7);
+            }
+        }
+        return true;
+    }
+};
+
+namespace {
+
+// Hands content to a filter process; holds the process for the whole file
+class ProcessFilter : public FilterStage {
+public:
+    ProcessFilter(std::shared_ptr<FilterProcess> process, FilterDirection direction,
+                  std::string path)
+        : process(std::move(process)), direction(direction), path(std::move(path)) {}
+
+    ~ProcessFilter() override {
+        if (lock.owns_lock()) {
+            process->abandonRequest();
+        }
+    }
+
+    bool write(const char* data, size_t size, const CompressionSink&) override {
+        return begin() && process->writeContent(data, size);
+    }
+
+    bool finish(const CompressionSink& next) override {
+        bool ok = begin() && process->finishRequest(path, next);
+        lock.unlock();
+        return ok;
+    }
+
+private:
+    std::shared_ptr<FilterProcess> process;
+    FilterDirection direction;
+    std::string path;
+    std::unique_lock<std::mutex> lock;
+    bool started = false;
+    bool ok = false;
+
+    bool begin() {
+        if (!started) {
+            started = true;
+            lock = std::unique_lock<std::mutex>(process->mutex);
+            ok = process->usable() && process->beginRequest(direction, path);
+        }
+        return ok;
+    }
+};
+
+} // namespace
+
+FilterChain::FilterChain(std::vector<std::unique_ptr<FilterStage>> stageList, CompressionSink output)
+    : stages(std::move(stageList)), sinks(stages.size() + 1) {
+    sinks.back() = std::move(output);
+    for (size_t i = stages.size(); i-- > 0;) {
+        sinks[i] = [this, i](const char* data, size_t size) {
+            return stages[i]->write(data, size, sinks[i + 1]);
+        };
+    }
+}
+
+bool FilterChain::write(const char* data, size_t size) {
+    return sinks.front()(data, size);
+}
+
+bool FilterChain::finish() {
+    // Each stage flushes into the next before that one finishes
+    for (size_t i = 0; i < stages.size(); ++i) {
+        if (!stages[i]->finish(sinks[i + 1])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FilterChain::empty() const {
+    return stages.empty();
+}
+
+FilterPipeline::FilterPipeline(const fs::path& repoPath, const fs::path& mimirDir)
+    : repositoryPath(repoPath), mimirionDir(mimirDir), rules(Attributes::load(repoPath)) {
+}
+
+FilterPipeline::~FilterPipeline() = default;
+
+bool FilterPipeline::hasFilters(const std::string& path) const {
+    return selectFilters(rules, path).any();
+}
+
+std::unique_ptr<FilterChain> FilterPipeline::open(const std::string& path,
+                                                  FilterDirection direction,
+                                                  CompressionSink output,
+                                                  const std::string& objectHash) {
+    FilterSelection selection = selectFilters(rules, path);
+
+    std::unique_ptr<FilterStage> driver;
+    if (!selection.driver.empty()) {
+        auto filterProcess = process(selection.driver);
+        if (filterProcess && filterProcess->supports(direction)) {
+            driver = std::make_unique<ProcessFilter>(filterProcess, direction, path);
+        } else if (!filterProcess &&
+                   Config::load(mimirionDir)->getBool("filter." + selection.driver + ".required")) {
+            std::cerr << "Required filter '" << selection.driver << "' is not available for "
+                      << path << std::endl;
+            return nullptr;
+        }
+    }
+
+    std::vector<std::unique_ptr<FilterStage>> stages;
+    if (direction == FilterDirection::CLEAN) {
+        if (driver) {
+            stages.push_back(std::move(driver));
+        }
+        if (selection.normalize) {
+            stages.push_back(std::make_unique<LineEndingCleaner>(selection.autoDetect));
+        }
+        if (selection.ident) {
+            stages.push_back(std::make_unique<KeywordFilter>("$Id$"));
+        }
+    } else {
+        if (selection.ident) {
+            std::string expansion = objectHash.empty() ? "$Id$" : "$Id: " + objectHash + " $";
+            stages.push_back(std::make_unique<KeywordFilter>(expansion));
+        }
+        if (selection.crlf) {
+            stages.push_back(std::make_unique<LineEndingSmudger>());
+        }
+        if (driver) {
+            stages.push_back(std::move(driver));
+        }
+    }
+    return std::make_unique<FilterChain>(std::move(stages), std::move(output));
+}
+
+bool FilterPipeline::clean(const fs::path& file, const std::string& path,
+                           const CompressionSink& output) {
+    FileView view(file, FileView::Advice::SEQUENTIAL);
+    if (!view.isOpen()) {
+        return false;
+    }
+    auto chain = open(path, FilterDirection::CLEAN, output);
+    if (!chain) {
+        return false;
+    }
+    for (size_t offset = 0; offset < view.size(); offset += kCleanChunkSize) {
+        std::string_view chunk = view.view(offset, kCleanChunkSize);
+        if (!chain->write(chunk.data(), chunk.size())) {
+            return false;
+        }
+    }
+    return chain->finish();
+}
+
+const Attributes& FilterPipeline::attributes() const {
+    return rules;
+}
+
+std::shared_ptr<FilterProcess> FilterPipeline::process(const std::string& driver) {
+    std::lock_guard<std::mutex> guard(processMutex);
+    auto it = processes.find(driver);
+    if (it != processes.end()) {
+        return it->second;
+    }
+
+    // Started on first use and kept for the pipeline's lifetime; a failed
+    // start is remembered too, so it is not retried for every file
+    std::string command = Config::load(mimirionDir)->getString("filter." + driver + ".process");
+    std::shared_ptr<FilterProcess> started;
+    if (!command.empty()) {
+        started = FilterProcess::start(command, repositoryPath);
+    }
+    processes[driver] = started;
+    return started;
+}
+
+} // namespace mimirion
@@ -0,0 +1,412 @@
+/**
+ * @file fsck.cpp
+ * @brief Implementation of the IntegrityChecker class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/fsck.hpp"
+#include "../include/bitmap.hpp"
+#include "../include/commit.hpp"
+#include "../include/file_tracker.hpp"
+#include "../include/object_store.hpp"
+#include "../include/pack.hpp"
+#include "../include/refs.hpp"
+#include "../include/scanner.hpp"
+#include "../include/scheduler.hpp"
+#include "../include/worktree.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+
+namespace mimirion {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// What the object phase found out about an object
+constexpr char kSound = 1;
+constexpr char kBroken = 2;
+
+// Calls the progress callback at most once per interval, from any thread
+class ProgressMeter {
+public:
+    explicit ProgressMeter(const std::function<void(const FsckProgress&)>& callback) : callback(callback) {}
+
+    void start(const char* phase, size_t total) {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = FsckProgress{phase, 0, total, 0};
+        last = Clock::time_point();
+    }
+
+    void update(size_t done, uint64_t bytes, bool force = false) {
+        if (!callback) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+        if (!lock.owns_lock() && !force) {
+            return;
+        }
+        if (!lock.owns_lock()) {
+            lock.lock();
+        }
+        Clock::time_point now = Clock::now();
+        if (!force && now - last < IntegrityChecker::kProgressInterval) {
+            return;
+        }
+        last = now;
+        current.done = done;
+        current.bytes = bytes;
+        callback(current);
+    }
+
+private:
+    const std::function<void(const FsckProgress&)>& callback;
+    std::mutex mutex;
+    FsckProgress current;
+    Clock::time_point last;
+};
+
+class Checker {
+public:
+    Checker(const fs::path& repoPath, const fs::path& mimirionDir, const FsckOptions& options, FsckReport& report)
+        : repositoryPath(repoPath), mimirionDir(mimirionDir), mainDir(WorktreeManager::commonDir(mimirionDir)),
+          objects(mimirionDir), commits(repoPath, mimirionDir), options(options), report(report),
+          meter(options.progress) {
+        if (options.budget.count() > 0) {
+            deadline = Clock::now() + options.budget;
+        }
+    }
+
+    void run() {
+        checkPacks();
+        checkObjects();
+        if (options.connectivity && !stopped()) {
+            checkConnectivity();
+        }
+        if (!stopped()) {
+            checkIndexes();
+        }
+        report.complete = !stopped();
+    }
+
+private:
+    fs::path repositoryPath;
+    fs::path mimirionDir;
+    fs::path mainDir;
+    ObjectStore objects;
+    CommitManager commits;
+    const FsckOptions& options;
+    FsckReport& report;
+    ProgressMeter meter;
+    Clock::time_point deadline;
+    std::atomic<bool> outOfTime{false};
+    std::mutex errorMutex;
+
+    std::vector<std::unique_ptr<PackFile>> packs;
+    std::vector<std::string> sound;
+    std::unordered_set<std::string> broken;
+    std::unordered_set<std::string> reached;
+
+    bool stopped() {
+        if (!outOfTime && deadline != Clock::time_point() && Clock::now() >= deadline) {
+            outOfTime = true;
+        }
+        return outOfTime;
+    }
+
+    void problem(size_t FsckReport::*counter, const std::string& message) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        ++(report.*counter);
+        std::cerr << "error: " << message << std::endl;
+    }
+
+    // Loose and packed objects of this repository in hash order; alternates
+    // are checked by their own repositories
+    std::vector<std::string> listObjects() {
+        std::vector<std::string> hashes;
+        std::error_code ec;
+        for (fs::directory_iterator dir(mimirionDir / "objects", ec), end; !ec && dir != end; dir.increment(ec)) {
+            std::string prefix = dir->path().filename().string();
+            bool fanOut = prefix.size() == 2 && std::all_of(prefix.begin(), prefix.end(), [](char c) {
+                return std::isxdigit(static_cast<unsigned char>(c)) != 0;
+            });
+            if (!dir->is_directory() || !fanOut) {
+                continue;
+            }
+            std::error_code inner;
+            for (fs::directory_iterator it(dir->path(), inner); !inner && it != end; it.increment(inner)) {
+                std::string hash = prefix + it->path().filename().string();
+                if (ObjectStore::isValidHash(hash)) {
+                    hashes.push_back(hash);
+                } else {
+                    std::cerr << "warning: garbage found: " << it->path().string() << std::endl;
+                }
+            }
+        }
+        for (const auto& pack : packs) {
+            for (size_t i = 0; i < pack->objectCount(); ++i) {
+                hashes.push_back(pack->hashAt(i));
+            }
+        }
+        std::sort(hashes.begin(), hashes.end());
+        hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+        return hashes;
+    }
+
+    // Pack and bitmap files carry checksums of their whole contents
+    void checkPacks() {
+        fs::path packDir = mimirionDir / "objects" / "pack";
+        std::error_code ec;
+        for (fs::directory_iterator it(packDir, ec), end; !ec && it != end; it.increment(ec)) {
+            std::string name = it->path().filename().string();
+            if (name.compare(0, 5, "pack-") != 0 || it->path().extension() != ".idx") {
+                continue;
+            }
+            auto pack = std::make_unique<PackFile>();
+            if (!pack->open(it->path())) {
+                problem(&FsckReport::corrupt, "cannot read pack " + name);
+                continue;
+            }
+            packs.push_back(std::move(pack));
+        }
+
+        if (!packs.empty()) {
+            meter.start("Checking packs", packs.size());
+            std::atomic<size_t> done{0};
+            parallelFor(packs.size(), [&](size_t i) {
+                if (!stopped() && !packs[i]->verify()) {
+                    problem(&FsckReport::corrupt, "pack " + packs[i]->packPath().filename().string() +
+                                                      " does not match its checksum");
+                }
+                meter.update(++done, 0);
+            }, 1);
+            meter.update(done, 0, true);
+        }
+
+        fs::path bitmaps = mimirionDir / "objects" / "info" / "bitmaps";
+        if (fs::exists(bitmaps, ec) && !BitmapIndex::verify(bitmaps)) {
+            problem(&FsckReport::corrupt, "bitmap index does not match its checksum");
+        }
+    }
+
+    void checkObjects() {
+        std::vector<std::string> hashes = listObjects();
+        report.totalObjects = hashes.size();
+        meter.start("Checking objects", hashes.size());
+
+        // A blob is named after its content, a commit after its parsed fields
+        std::vector<char> state(hashes.size(), 0);
+        std::atomic<size_t> done{0};
+        std::atomic<uint64_t> bytes{0};
+        TaskGroup group;
+        for (size_t first = 0; first < hashes.size(); first += IntegrityChecker::kChunkObjects) {
+            size_t last = std::min(first + IntegrityChecker::kChunkObjects, hashes.size());
+            group.run([&, first, last]() {
+                for (size_t i = first; i < last; ++i) {
+                    if (stopped()) {
+                        group.cancel();
+                        return;
+                    }
+                    const std::string& hash = hashes[i];
+                    std::string header = "commit " + hash + "\n";
+                    std::string head;
+                    std::string content; // kept while it may be a commit
+                    ScanStream scan;
+                    uint64_t size = 0;
+                    bool read = objects.readStream(hash, [&](const char* data, size_t length) {
+                        if (head.size() < header.size()) {
+                            head.append(data, std::min(length, header.size() - head.size()));
+                        }
+                        if (header.compare(0, head.size(), head) == 0) {
+                            content.append(data, length);
+                        }
+                        scan.update(data, length);
+                        size += length;
+                        return true;
+                    });
+                    if (!read) {
+                        problem(&FsckReport::corrupt, "cannot read object " + hash);
+                        state[i] = kBroken;
+                    } else if (scan.finish().hash != hash &&
+                               (head != header || !commits.verifyCommit(hash, content))) {
+                        problem(&FsckReport::corrupt, "object " + hash + " does not match its name");
+                        state[i] = kBroken;
+                    } else {
+                        state[i] = kSound;
+                    }
+                    bytes += size;
+                    meter.update(++done, bytes);
+                }
+            });
+        }
+        group.wait();
+        meter.update(done, bytes, true);
+
+        report.objects = done;
+        report.bytes = bytes;
+        for (size_t i = 0; i < hashes.size(); ++i) {
+            if (state[i] == kSound) {
+                sound.push_back(hashes[i]);
+            } else if (state[i] == kBroken) {
+                broken.insert(hashes[i]);
+            }
+        }
+    }
+
+    // Every ref in the shared store and the HEAD of every worktree
+    std::vector<std::string> listRoots() {
+        std::vector<std::string> roots;
+        RefStore refs(mainDir);
+        for (const auto& name : refs.listRefs()) {
+            std::string value = refs.readRef(name);
+            std::string target;
+            if (value.empty() || RefStore::parseSymbolicRef(value, target)) {
+                continue;
+            }
+            if (!ObjectStore::isValidHash(value)) {
+                problem(&FsckReport::badRefs, name + ": invalid hash '" + value + "'");
+                continue;
+            }
+            roots.push_back(value);
+        }
+        for (const auto& worktree : WorktreeManager(repositoryPath, mimirionDir).list()) {
+            if (!worktree.head.empty()) {
+                roots.push_back(worktree.head);
+            }
+        }
+        return roots;
+    }
+
+    void checkConnectivity() {
+        meter.start("Checking connectivity", 0);
+        std::vector<std::string> frontier;
+        for (const auto& root : listRoots()) {
+            if (reached.insert(root).second) {
+                frontier.push_back(root);
+            }
+        }
+
+        // Each generation of commits is read in parallel
+        while (!frontier.empty() && !stopped()) {
+            std::vector<CommitInfo> level(frontier.size());
+            std::vector<char> read(frontier.size(), 0);
+            parallelFor(frontier.size(), [&](size_t i) {
+                read[i] = commits.readCommit(frontier[i], level[i]);
+            }, 4);
+
+            std::vector<std::string> next;
+            for (size_t i = 0; i < frontier.size(); ++i) {
+                if (!read[i]) {
+                    // Corrupt objects were already reported when they were rehashed
+                    if (!broken.count(frontier[i])) {
+                        problem(objects.hasObject(frontier[i]) ? &FsckReport::corrupt : &FsckReport::missing,
+                                "cannot read commit " + frontier[i]);
+                    }
+                    continue;
+                }
+                ++report.commits;
+                for (const auto& parent : level[i].parentHashes) {
+                    if (reached.insert(parent).second) {
+                        next.push_back(parent);
+                    }
+                }
+                for (const auto& file : level[i].fileHashes) {
+                    if (reached.insert(file.second).second && !objects.hasObject(file.second)) {
+                        problem(&FsckReport::missing, "missing blob " + file.second + " for " + file.first +
+                                                          " in commit " + frontier[i]);
+                    }
+                }
+            }
+            meter.update(report.commits, 0);
+            frontier = std::move(next);
+        }
+        meter.update(report.commits, 0, true);
+
+        if (!stopped()) {
+            for (const auto& hash : sound) {
+                report.dangling += reached.count(hash) == 0;
+            }
+        }
+    }
+
+    void checkIndex(const fs::path& index, const std::string& name) {
+        std::ifstream file(index);
+        std::unordered_set<std::string> paths;
+        std::string line;
+        for (size_t number = 1; std::getline(file, line); ++number) {
+            std::string where = name + ": line " + std::to_string(number) + ": ";
+            std::vector<std::string> fields;
+            size_t pos = 0;
+            for (size_t tab; (tab = line.find('\t', pos)) != std::string::npos; pos = tab + 1) {
+                fields.push_back(line.substr(pos, tab - pos));
+            }
+            fields.push_back(line.substr(pos));
+            int status = -1;
+            if (fields.size() >= 4) {
+                const std::string& text = fields[3];
+                auto parsed = std::from_chars(text.data(), text.data() + text.size(), status);
+                if (parsed.ec != std::errc() || parsed.ptr != text.data() + text.size()) {
+                    status = -1;
+                }
+            }
+
+            fs::path path = fields[0];
+            bool escapes = std::any_of(path.begin(), path.end(), [](const fs::path& part) { return part == ".."; });
+            if (fields.size() < 4) {
+                problem(&FsckReport::badIndexEntries, where + "truncated entry");
+            } else if (fields[0].empty() || path.is_absolute() || escapes) {
+                problem(&FsckReport::badIndexEntries, where + "invalid path '" + fields[0] + "'");
+            } else if (!paths.insert(fields[0]).second) {
+                problem(&FsckReport::badIndexEntries, where + "duplicate entry for " + fields[0]);
+            } else if (status < 0 || status > static_cast<int>(FileStatus::DELETED)) {
+                problem(&FsckReport::badIndexEntries, where + "invalid status '" + fields[3] + "'");
+            } else if ((!fields[1].empty() && !ObjectStore::isValidHash(fields[1])) ||
+                       (!fields[2].empty() && !ObjectStore::isValidHash(fields[2]))) {
+                problem(&FsckReport::badIndexEntries, where + "invalid hash for " + fields[0]);
+            } else if (!fields[2].empty() && !objects.hasObject(fields[2])) {
+                // Staged content is only stored on commit, committed content must exist
+                problem(&FsckReport::missing, where + "missing blob " + fields[2] + " for " + fields[0]);
+            }
+        }
+    }
+
+    void checkIndexes() {
+        auto worktrees = WorktreeManager(repositoryPath, mimirionDir).list();
+        meter.start("Checking indexes", worktrees.size());
+        size_t done = 0;
+        for (const auto& worktree : worktrees) {
+            fs::path dir = worktree.name.empty() ? mainDir : mainDir / "worktrees" / worktree.name;
+            std::error_code ec;
+            if (fs::exists(dir / "index", ec)) {
+                checkIndex(dir / "index", worktree.name.empty() ? "index" : "worktrees/" + worktree.name + "/index");
+            }
+            meter.update(++done, 0, true);
+        }
+    }
+};
+
+} // namespace
+
+IntegrityChecker::IntegrityChecker(const fs::path& repoPath, const fs::path& mimirDir)
+    : repositoryPath(repoPath), mimirionDir(mimirDir) {
+}
+
+bool IntegrityChecker::run(const FsckOptions& options, FsckReport* report) {
+    FsckReport found;
+    Checker checker(repositoryPath, mimirionDir, options, found);
+    checker.run();
+    if (report) {
+        *report = found;
+    }
+    return found.complete && found.errors() == 0;
+}
+
+} // namespace mimirion
@@ -0,0 +1,894 @@
+/**
+ * @file git_import.cpp
+ * @brief Implementation of the GitObjectReader and GitImporter classes
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/git_import.hpp"
+#include "../include/commit.hpp"
+#include "../include/compression.hpp"
+#include "../include/file_view.hpp"
+#include "../include/object_store.hpp"
+#include "../include/refs.hpp"
+#include "../include/scheduler.hpp"
+#include "../include/utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <unordered_set>
+
+namespace mimirion {
+
+namespace {
+
+constexpr size_t kRawIdSize = 20;
+constexpr size_t kHexIdSize = 40;
+
+// Pack object types that only exist inside packs
+constexpr int kOfsDelta = 6;
+constexpr int kRefDelta = 7;
+
+// Longest delta chain followed before a pack is considered corrupt
+constexpr size_t kMaxChain = 10000;
+
+// Annotated tags pointing at annotated tags, at most this deep
+constexpr int kMaxTagDepth = 8;
+
+// idx v2: magic, version, 256 fan-out entries
+constexpr size_t kIndexHeaderSize = 8 + 256 * 4;
+// Trailing pack and index checksums
+constexpr size_t kIndexTrailerSize = 2 * kRawIdSize;
+constexpr size_t kPackHeaderSize = 12;
+
+// Delta bases are looked up by "<pack>:<offset>"; loose objects by id
+std::string baseKey(size_t pack, uint64_t offset) {
+    return std::to_string(pack) + ":" + std::to_string(offset);
+}
+
+uint32_t readBig32(const unsigned char* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+uint64_t readBig64(const unsigned char* p) {
+    return (uint64_t(readBig32(p)) << 32) | readBig32(p + 4);
+}
+
+bool isHexId(std::string_view id) {
+    return id.size() == kHexIdSize &&
+           std::all_of(id.begin(), id.end(), [](char c) {
+               return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+           });
+}
+
+std::string toHex(std::string_view raw) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(raw.size() * 2);
+    for (unsigned char c : raw) {
+        hex += digits[c >> 4];
+        hex += digits[c & 15];
+    }
+    return hex;
+}
+
+std::string fromHex(std::string_view hex) {
+    auto value = [](char c) { return c <= '9' ? c - '0' : c - 'a' + 10; };
+    std::string raw(hex.size() / 2, '\0');
+    for (size_t i = 0; i < raw.size(); ++i) {
+        raw[i] = static_cast<char>((value(hex[2 * i]) << 4) | value(hex[2 * i + 1]));
+    }
+    return raw;
+}
+
+// Git delta instructions, see pack-format: copy ranges of the base or
+// insert literal bytes
+bool readDeltaSize(std::string_view delta, size_t& pos, uint64_t& size) {
+    size = 0;
+    int shift = 0;
+    while (pos < delta.size() && shift < 64) {
+        unsigned char c = static_cast<unsigned char>(delta[pos++]);
+        size |= uint64_t(c & 0x7f) << shift;
+        shift += 7;
+        if (!(c & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool applyDelta(std::string_view base, std::string_view delta, std::string& out) {
+    size_t pos = 0;
+    uint64_t baseSize = 0;
+    uint64_t resultSize = 0;
+    if (!readDeltaSize(delta, pos, baseSize) || !readDeltaSize(delta, pos, resultSize) ||
+        baseSize != base.size()) {
+        return false;
+    }
+
+    out.resize(resultSize);
+    size_t written = 0;
+    while (pos < delta.size()) {
+        unsigned char op = static_cast<unsigned char>(delta[pos++]);
+        if (op & 0x80) {
+            // Offset and size bytes are present only where their bit is set
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            for (int i = 0; i < 7; ++i) {
+                if (!(op & (1 << i))) {
+                    continue;
+                }
+                if (pos >= delta.size()) {
+                    return false;
+                }
+                uint64_t byte = static_cast<unsigned char>(delta[pos++]);
+                if (i < 4) {
+                    offset |= byte << (8 * i);
+                } else {
+                    size |= byte << (8 * (i - 4));
+                }
+            }
+            if (size == 0) {
+                size = 0x10000;
+            }
+            if (offset + size > base.size() || written + size > resultSize) {
+                return false;
+            }
+            std::memcpy(&out[written], base.data() + offset, size);
+            written += size;
+        } else if (op != 0) {
+            if (pos + op > delta.size() || written + op > resultSize) {
+                return false;
+            }
+            std::memcpy(&out[written], delta.data() + pos, op);
+            pos += op;
+            written += op;
+        } else {
+            return false;
+        }
+    }
+    return written == resultSize;
+}
+
+GitObjectType typeFromName(std::string_view name) {
+    if (name == "commit") return GitObjectType::COMMIT;
+    if (name == "tree") return GitObjectType::TREE;
+    if (name == "blob") return GitObjectType::BLOB;
+    if (name == "tag") return GitObjectType::TAG;
+    return GitObjectType::NONE;
+}
+
+std::string firstLine(const fs::path& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+        line.pop_back();
+    }
+    return line;
+}
+
+struct GitCommit {
+    std::string tree;
+    std::vector<std::string> parents;
+    std::string author;
+    std::string email;
+    std::chrono::system_clock::time_point timestamp;
+    std::string message;
+};
+
+// Headers up to the first blank line, then the message. Only the author
+// is kept: Mimirion commits have one identity and one time. The time zone
+// is dropped, the seconds since the epoch already being UTC.
+bool parseCommit(std::string_view data, GitCommit& commit) {
+    size_t pos = 0;
+    while (pos < data.size()) {
+        size_t end = data.find('\n', pos);
+        if (end == std::string_view::npos) {
+            end = data.size();
+        }
+        std::string_view line = data.substr(pos, end - pos);
+        pos = end + 1;
+
+        if (line.empty()) {
+            commit.message = std::string(data.substr(std::min(pos, data.size())));
+            break;
+        }
+        if (line.compare(0, 5, "tree ") == 0) {
+            commit.tree = std::string(line.substr(5));
+        } else if (line.compare(0, 7, "parent ") == 0) {
+            commit.parents.emplace_back(line.substr(7));
+        } else if (line.compare(0, 7, "author ") == 0) {
+            size_t open = line.find('<');
+            size_t close = line.find('>', open);
+            if (open == std::string_view::npos || close == std::string_view::npos) {
+                return false;
+            }
+            std::string_view name = line.substr(7, open - 7);
+            while (!name.empty() && name.back() == ' ') {
+                name.remove_suffix(1);
+            }
+            commit.author = std::string(name);
+            commit.email = std::string(line.substr(open + 1, close - open - 1));
+            long long seconds = std::strtoll(std::string(line.substr(close + 1)).c_str(), nullptr, 10);
+            commit.timestamp = std::chrono::system_clock::from_time_t(static_cast<time_t>(seconds));
+        }
+    }
+    return isHexId(commit.tree);
+}
+
+// Escapes tabs and newlines, which would otherwise garble an error message
+std::string printablePath(const std::string& path) {
+    std::string printable;
+    for (char c : path) {
+        if (c == '\t') {
+            printable += "\\t";
+        } else if (c == '\n') {
+            printable += "\\n";
+        } else {
+            printable += c;
+        }
+    }
+    return printable;
+}
+
+using Entries = std::vector<std::pair<std::string, std::string>>;
+
+// Flattens trees into path -> blob id lists. Subtrees are shared between
+// most consecutive commits, so their flattened form is kept and reused.
+class TreeFlattener {
+public:
+    explicit TreeFlattener(GitObjectReader& reader) : reader(reader), cachedEntries(0) {}
+
+    std::shared_ptr<const Entries> flatten(const std::string& id) {
+        rejected.clear();
+        auto it = cache.find(id);
+        if (it != cache.end()) {
+            return it->second;
+        }
+
+        GitObjectType type;
+        std::string data;
+        if (!reader.read(id, type, data) || type != GitObjectType::TREE) {
+            std::cerr << "Failed to read tree " << id << std::endl;
+            return nullptr;
+        }
+
+        auto entries = std::make_shared<Entries>();
+        size_t pos = 0;
+        while (pos < data.size()) {
+            // "<mode> <name>\0<20-byte id>"
+            size_t space = data.find(' ', pos);
+            size_t nul = data.find('\0', space);
+            if (space == std::string::npos || nul == std::string::npos || nul + 1 + kRawIdSize > data.size()) {
+                std::cerr << "Corrupt tree " << id << std::endl;
+                return nullptr;
+            }
+            std::string_view mode(data.data() + pos, space - pos);
+            std::string name = data.substr(space + 1, nul - space - 1);
+            std::string child = toHex(std::string_view(data.data() + nul + 1, kRawIdSize));
+            pos = nul + 1 + kRawIdSize;
+
+            // Every flattened path is made of checked names, so it is safe too
+            if (mode != "160000" && (name.find('/') != std::string::npos || !utils::isSafePath(name))) {
+                rejected = name;
+                return nullptr;
+            }
+            if (mode == "40000") {
+                auto sub = flatten(child);
+                if (!sub) {
+                    if (!rejected.empty()) {
+                        rejected = name + "/" + rejected;
+                    }
+                    return nullptr;
+                }
+                for (const auto& [path, blob] : *sub) {
+                    entries->emplace_back(name + "/" + path, blob);
+                }
+            } else if (mode != "160000") {
+                // Submodule links name commits of another repository
+                entries->emplace_back(std::move(name), std::move(child));
+            }
+        }
+
+        if (cachedEntries + entries->size() > GitImporter::kTreeCacheEntries) {
+            cache.clear();
+            cachedEntries = 0;
+        }
+        cachedEntries += entries->size();
+        cache.emplace(id, entries);
+        return entries;
+    }
+
+    // Path of the entry that made the last flatten() fail, if a path did
+    const std::string& rejectedPath() const {
+        return rejected;
+    }
+
+private:
+    GitObjectReader& reader;
+    std::unordered_map<std::string, std::shared_ptr<const Entries>> cache;
+    size_t cachedEntries;
+    std::string rejected;
+};
+
+// Peels annotated tags down to the commit they name
+std::string peelToCommit(GitObjectReader& reader, std::string id) {
+    for (int depth = 0; depth < kMaxTagDepth; ++depth) {
+        GitObjectType type;
+        std::string data;
+        if (!reader.read(id, type, data)) {
+            return "";
+        }
+        if (type == GitObjectType::COMMIT) {
+            return id;
+        }
+        if (type != GitObjectType::TAG || data.compare(0, 7, "object ") != 0) {
+            return "";
+        }
+        id = data.substr(7, kHexIdSize);
+    }
+    return "";
+}
+
+// Branches and tags, from packed-refs overridden by loose refs
+void readGitRefs(const fs::path& gitDir, std::map<std::string, std::string>& refs) {
+    std::ifstream packed(gitDir / "packed-refs");
+    std::string line;
+    while (std::getline(packed, line)) {
+        // Comments and "^<id>" peeled lines; tags are peeled on import
+        if (line.size() < kHexIdSize + 2 || line[0] == '#' || line[0] == '^') {
+            continue;
+        }
+        std::string id = line.substr(0, kHexIdSize);
+        if (isHexId(id) && line[kHexIdSize] == ' ') {
+            refs[line.substr(kHexIdSize + 1)] = id;
+        }
+    }
+
+    for (const char* root : {"refs/heads", "refs/tags"}) {
+        std::error_code ec;
+        fs::recursive_directory_iterator it(gitDir / root, ec), end;
+        for (; !ec && it != end; it.increment(ec)) {
+            if (!it->is_regular_file()) {
+                continue;
+            }
+            std::string id = firstLine(it->path());
+            if (isHexId(id)) {
+                refs[fs::relative(it->path(), gitDir).generic_string()] = id;
+            }
+        }
+    }
+}
+
+// Id map from earlier imports: one "<git id> <mimirion hash>" per line
+void loadMap(const fs::path& path, std::unordered_map<std::string, std::string>& map) {
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.size() > kHexIdSize + 1 && line[kHexIdSize] == ' ') {
+            map[line.substr(0, kHexIdSize)] = line.substr(kHexIdSize + 1);
+        }
+    }
+}
+
+} // namespace
+
+struct GitObjectReader::Pack {
+    FileView data;
+    FileView index;
+    const unsigned char* fanout = nullptr;
+    const unsigned char* ids = nullptr;
+    const unsigned char* offsets = nullptr;
+    const unsigned char* largeOffsets = nullptr;
+    uint32_t count = 0;
+    size_t largeCount = 0;
+
+    bool open(const fs::path& packPath, const fs::path& indexPath) {
+        if (!index.open(indexPath, FileView::Advice::RANDOM) || !data.open(packPath, FileView::Advice::RANDOM)) {
+            return false;
+        }
+        const auto* idx = reinterpret_cast<const unsigned char*>(index.data());
+        if (index.size() < kIndexHeaderSize + kIndexTrailerSize || std::memcmp(idx, "\377tOc", 4) != 0 ||
+            readBig32(idx + 4) != 2) {
+            return false;
+        }
+        fanout = idx + 8;
+        count = readBig32(fanout + 255 * 4);
+        size_t tables = kIndexHeaderSize + size_t(count) * (kRawIdSize + 8);
+        if (index.size() < tables + kIndexTrailerSize) {
+            return false;
+        }
+        ids = idx + kIndexHeaderSize;
+        offsets = ids + size_t(count) * (kRawIdSize + 4);
+        largeOffsets = offsets + size_t(count) * 4;
+        largeCount = (index.size() - tables - kIndexTrailerSize) / 8;
+
+        return data.size() >= kPackHeaderSize + kRawIdSize && std::memcmp(data.data(), "PACK", 4) == 0;
+    }
+
+    bool find(std::string_view rawId, uint64_t& offset) const {
+        auto first = static_cast<unsigned char>(rawId[0]);
+        uint32_t low = first == 0 ? 0 : readBig32(fanout + (first - 1) * 4);
+        uint32_t high = readBig32(fanout + first * 4);
+        while (low < high) {
+            uint32_t mid = low + (high - low) / 2;
+            int cmp = std::memcmp(ids + size_t(mid) * kRawIdSize, rawId.data(), kRawIdSize);
+            if (cmp == 0) {
+                uint32_t small = readBig32(offsets + size_t(mid) * 4);
+                if (!(small & 0x80000000u)) {
+                    offset = small;
+                    return true;
+                }
+                // Offsets past 2 GiB live in a separate 64-bit table
+                size_t large = small & 0x7fffffffu;
+                if (large >= largeCount) {
+                    return false;
+                }
+                offset = readBig64(largeOffsets + large * 8);
+                return true;
+            }
+            if (cmp < 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return false;
+    }
+};
+
+GitObjectReader::GitObjectReader(const fs::path& gitDir)
+    : objectsDir(gitDir / "objects"), cacheBytes(0) {
+    std::error_code ec;
+    std::vector<fs::path> indexes;
+    for (fs::directory_iterator it(objectsDir / "pack", ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() == ".idx") {
+            indexes.push_back(it->path());
+        }
+    }
+    std::sort(indexes.begin(), indexes.end());
+
+    for (const auto& indexPath : indexes) {
+        auto pack = std::make_unique<Pack>();
+        fs::path packPath = indexPath;
+        packPath.replace_extension(".pack");
+        if (pack->open(packPath, indexPath)) {
+            packs.push_back(std::move(pack));
+        } else {
+            std::cerr << "Skipping unreadable pack " << packPath.filename().string() << std::endl;
+        }
+    }
+}
+
+GitObjectReader::~GitObjectReader() = default;
+
+size_t GitObjectReader::packCount() const {
+    return packs.size();
+}
+
+fs::path GitObjectReader::findGitDir(const fs::path& path) {
+    std::error_code ec;
+    fs::path dotGit = path / ".git";
+    if (fs::is_directory(dotGit, ec)) {
+        return dotGit;
+    }
+    if (fs::is_regular_file(dotGit, ec)) {
+        // Linked worktrees and submodules: "gitdir: <path>"
+        std::string line = firstLine(dotGit);
+        if (line.compare(0, 8, "gitdir: ") == 0) {
+            fs::path target = line.substr(8);
+            return target.is_absolute() ? target : path / target;
+        }
+    }
+    if (fs::is_directory(path / "objects", ec) && fs::exists(path / "HEAD", ec)) {
+        return path;
+    }
+    return fs::path();
+}
+
+bool GitObjectReader::read(const std::string& id, GitObjectType& type, std::string& data) {
+    type = GitObjectType::NONE;
+    if (!isHexId(id)) {
+        return false;
+    }
+    size_t pack = 0;
+    uint64_t offset = 0;
+    if (findPacked(fromHex(id), pack, offset)) {
+        return readPacked(pack, offset, type, data);
+    }
+    return readLoose(id, type, data);
+}
+
+bool GitObjectReader::findPacked(std::string_view rawId, size_t& pack, uint64_t& offset) const {
+    for (size_t i = 0; i < packs.size(); ++i) {
+        if (packs[i]->find(rawId, offset)) {
+            pack = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool GitObjectReader::readLoose(const std::string& id, GitObjectType& type, std::string& data) const {
+    FileView file(objectsDir / id.substr(0, 2) / id.substr(2));
+    std::string raw;
+    if (!file.isOpen() || !Decompressor::decompress(file.view(), raw)) {
+        return false;
+    }
+
+    // "<type> <size>\0<content>"
+    size_t space = raw.find(' ');
+    size_t nul = raw.find('\0');
+    if (space == std::string::npos || nul == std::string::npos || space > nul) {
+        return false;
+    }
+    type = typeFromName(std::string_view(raw).substr(0, space));
+    if (type == GitObjectType::NONE ||
+        std::strtoull(raw.c_str() + space + 1, nullptr, 10) != raw.size() - nul - 1) {
+        return false;
+    }
+    raw.erase(0, nul + 1);
+    data = std::move(raw);
+    return true;
+}
+
+bool GitObjectReader::readPacked(size_t pack, uint64_t offset, GitObjectType& type, std::string& data) {
+    // A delta still to be applied: where its instructions start and their size
+    struct Link {
+        std::string key;
+        std::string_view body;
+        uint64_t size;
+    };
+    std::vector<Link> chain;
+    std::string current;
+
+    // Walk down the chain to a cached base or a whole object
+    while (true) {
+        std::string key = baseKey(pack, offset);
+        Cached cached;
+        if (lookupBase(key, cached)) {
+            type = cached.first;
+            current = *cached.second;
+            break;
+        }
+
+        const Pack& file = *packs[pack];
+        const auto* bytes = reinterpret_cast<const unsigned char*>(file.data.data());
+        size_t end = file.data.size() - kRawIdSize;
+        size_t pos = offset;
+        if (offset < kPackHeaderSize || pos >= end || chain.size() > kMaxChain) {
+            return false;
+        }
+
+        // Type in bits 4-6 of the first byte, size as a little-endian varint
+        unsigned char c = bytes[pos++];
+        int kind = (c >> 4) & 7;
+        uint64_t size = c & 15;
+        int shift = 4;
+        while ((c & 0x80) && pos < end && shift < 64) {
+            c = bytes[pos++];
+            size |= uint64_t(c & 0x7f) << shift;
+            shift += 7;
+        }
+
+        if (kind >= 1 && kind <= 4) {
+            type = static_cast<GitObjectType>(kind);
+            if (!Decompressor::decompressPrefix(file.data.view(pos, end - pos), current, size)) {
+                return false;
+            }
+            if (!chain.empty()) {
+                storeBase(key, type, current);
+            }
+            break;
+        }
+
+        if (kind == kOfsDelta) {
+            // Base offset relative to this object, big-endian with an
+            // implicit +1 per continuation byte
+            if (pos >= end) {
+                return false;
+            }
+            c = bytes[pos++];
+            uint64_t distance = c & 0x7f;
+            while ((c & 0x80) && pos < end) {
+                c = bytes[pos++];
+                distance = ((distance + 1) << 7) | (c & 0x7f);
+            }
+            if (distance == 0 || distance > offset) {
+                return false;
+            }
+            chain.push_back({key, file.data.view(pos, end - pos), size});
+            offset -= distance;
+        } else if (kind == kRefDelta) {
+            if (pos + kRawIdSize > end) {
+                return false;
+            }
+            std::string_view baseId(file.data.data() + pos, kRawIdSize);
+            chain.push_back({key, file.data.view(pos + kRawIdSize, end - pos - kRawIdSize), size});
+            if (!findPacked(baseId, pack, offset)) {
+                if (!readLoose(toHex(baseId), type, current)) {
+                    return false;
+                }
+                break;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    // Apply the deltas from the base upwards, keeping intermediate results
+    // as they are likely bases of nearby objects too
+    for (size_t i = chain.size(); i-- > 0;) {
+        std::string delta;
+        std::string result;
+        if (!Decompressor::decompressPrefix(chain[i].body, delta, chain[i].size) ||
+            !applyDelta(current, delta, result)) {
+            return false;
+        }
+        if (i > 0) {
+            storeBase(chain[i].key, type, result);
+        }
+        current = std::move(result);
+    }
+    data = std::move(current);
+    return true;
+}
+
+bool GitObjectReader::lookupBase(const std::string& key, Cached& object) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = cache.find(key);
+    if (it == cache.end()) {
+        return false;
+    }
+    cacheOrder.splice(cacheOrder.begin(), cacheOrder, it->second);
+    object = it->second->second;
+    return true;
+}
+
+void GitObjectReader::storeBase(const std::string& key, GitObjectType type, const std::string& data) {
+    if (data.size() > kBaseCacheBytes / 4) {
+        return;
+    }
+    auto copy = std::make_shared<const std::string>(data);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (cache.count(key)) {
+        return;
+    }
+    cacheOrder.emplace_front(key, Cached(type, std::move(copy)));
+    cache[key] = cacheOrder.begin();
+    cacheBytes += data.size();
+    while (cacheBytes > kBaseCacheBytes && !cacheOrder.empty()) {
+        cacheBytes -= cacheOrder.back().second.second->size();
+        cache.erase(cacheOrder.back().first);
+        cacheOrder.pop_back();
+    }
+}
+
+GitImporter::GitImporter(const fs::path& repoPath, const fs::path& mimirDir)
+    : repositoryPath(repoPath), mimirionDir(mimirDir) {
+}
+
+bool GitImporter::run(const fs::path& source, GitImportStats* stats) {
+    GitImportStats counts;
+    fs::path gitDir = GitObjectReader::findGitDir(source);
+    if (gitDir.empty()) {
+        std::cerr << "Not a Git repository: " << source.string() << std::endl;
+        return false;
+    }
+    GitObjectReader reader(gitDir);
+
+    // Branches and tags become Mimirion refs of the same name
+    std::map<std::string, std::string> gitRefs;
+    readGitRefs(gitDir, gitRefs);
+    std::vector<std::pair<std::string, std::string>> refs;
+    std::vector<std::string> tips;
+    for (const auto& [name, id] : gitRefs) {
+        std::string commit = peelToCommit(reader, id);
+        if (commit.empty()) {
+            std::cerr << "Skipping " << name << ": not a commit" << std::endl;
+            continue;
+        }
+        refs.emplace_back(name, commit);
+        tips.push_back(commit);
+    }
+
+    std::string head = firstLine(gitDir / "HEAD");
+    std::string headBranch;
+    if (head.compare(0, 16, "ref: refs/heads/") == 0) {
+        headBranch = head.substr(16);
+    } else if (isHexId(head)) {
+        // A detached HEAD is imported but gets no ref
+        tips.push_back(head);
+    }
+
+    // Commits listed as shallow have parents that were never fetched
+    std::unordered_set<std::string> shallow;
+    {
+        std::ifstream file(gitDir / "shallow");
+        std::string line;
+        while (std::getline(file, line)) {
+            shallow.insert(line);
+        }
+    }
+
+    fs::path mapPath = mimirionDir / "import" / "git-map";
+    std::unordered_map<std::string, std::string> imported;
+    loadMap(mapPath, imported);
+
+    // Order the new commits parents first, stopping at imported ones
+    std::unordered_map<std::string, GitCommit> pending;
+    std::vector<std::string> order;
+    std::unordered_set<std::string> done;
+    for (const auto& tip : tips) {
+        std::vector<std::pair<std::string, bool>> stack{{tip, false}};
+        while (!stack.empty()) {
+            auto [id, expanded] = stack.back();
+            stack.pop_back();
+            if (expanded) {
+                order.push_back(id);
+                continue;
+            }
+            if (imported.count(id) || !done.insert(id).second) {
+                continue;
+            }
+
+            GitObjectType type;
+            std::string data;
+            GitCommit commit;
+            if (!reader.read(id, type, data) || type != GitObjectType::COMMIT || !parseCommit(data, commit)) {
+                std::cerr << "Failed to read commit " << id << std::endl;
+                return false;
+            }
+            if (shallow.count(id)) {
+                commit.parents.clear();
+            }
+            stack.emplace_back(id, true);
+            for (auto parent = commit.parents.rbegin(); parent != commit.parents.rend(); ++parent) {
+                stack.emplace_back(*parent, false);
+            }
+            pending.emplace(id, std::move(commit));
+        }
+    }
+
+    ObjectStore objects(mimirionDir);
+    CommitManager commits(repositoryPath, mimirionDir);
+    TreeFlattener trees(reader);
+    std::vector<std::string> newEntries;
+    std::unordered_map<std::string, std::string> written;
+
+    for (size_t next = 0; next < order.size();) {
+        // Take commits until the batch is full
+        std::vector<std::shared_ptr<const Entries>> snapshots;
+        size_t files = 0;
+        size_t end = next;
+        while (end < order.size() && end - next < kBatchCommits && (end == next || files < kBatchFiles)) {
+            auto entries = trees.flatten(pending[order[end]].tree);
+            if (!entries) {
+                if (!trees.rejectedPath().empty()) {
+                    std::cerr << "Cannot import commit " << order[end] << ": unsafe path \""
+                              << printablePath(trees.rejectedPath()) << "\"" << std::endl;
+                }
+                return false;
+            }
+            files += entries->size();
+            snapshots.push_back(std::move(entries));
+            ++end;
+        }
+
+        // Convert the blobs this batch introduces in parallel
+        std::vector<std::string> blobs;
+        std::unordered_set<std::string> queued;
+        for (const auto& snapshot : snapshots) {
+            for (const auto& entry : *snapshot) {
+                if (!imported.count(entry.second) && queued.insert(entry.second).second) {
+                    blobs.push_back(entry.second);
+                }
+            }
+        }
+        std::vector<std::string> hashes(blobs.size());
+        std::atomic<bool> failed{false};
+        parallelFor(blobs.size(), [&](size_t i) {
+            if (failed.load(std::memory_order_relaxed)) {
+                return;
+            }
+            GitObjectType type;
+            std::string data;
+            if (!reader.read(blobs[i], type, data) || type != GitObjectType::BLOB) {
+                std::cerr << "Failed to read blob " << blobs[i] << std::endl;
+                failed = true;
+                return;
+            }
+            hashes[i] = objects.writeObject(data);
+            if (hashes[i].empty()) {
+                failed = true;
+            }
+        }, 4);
+        if (failed) {
+            return false;
+        }
+        for (size_t i = 0; i < blobs.size(); ++i) {
+            imported[blobs[i]] = hashes[i];
+            newEntries.push_back(blobs[i] + " " + hashes[i]);
+        }
+        counts.blobs += blobs.size();
+
+        // Then name the batch's commits in order, each after its parents,
+        // and store them in parallel
+        std::vector<CommitInfo> batch(end - next);
+        for (size_t i = next; i < end; ++i) {
+            GitCommit& original = pending[order[i]];
+            CommitInfo& commit = batch[i - next];
+            commit.author = original.author;
+            commit.email = original.email;
+            commit.timestamp = original.timestamp;
+            commit.message = std::move(original.message);
+            for (const auto& parent : original.parents) {
+                commit.parentHashes.push_back(imported.at(parent));
+            }
+            for (const auto& [path, blob] : *snapshots[i - next]) {
+                commit.fileHashes[path] = imported.at(blob);
+            }
+
+            std::string hash = commits.hashCommit(commit);
+            auto [first, unique] = written.emplace(hash, order[i]);
+            if (!unique) {
+                // Git commits differing only in committer or time zone
+                std::cerr << "Warning: commits " << first->second << " and " << order[i]
+                          << " map to the same commit " << hash << std::endl;
+                commit.hash.clear();
+            }
+            imported[order[i]] = hash;
+            newEntries.push_back(order[i] + " " + hash);
+            pending.erase(order[i]);
+        }
+        parallelFor(batch.size(), [&](size_t i) {
+            if (!batch[i].hash.empty() && !commits.storeCommit(batch[i], objects)) {
+                failed = true;
+            }
+        }, 4);
+        if (failed) {
+            return false;
+        }
+        counts.commits += batch.size();
+        next = end;
+    }
+
+    // Everything written so far must be durable before refs point at it
+    if (!order.empty() && !objects.sync()) {
+        return false;
+    }
+    if (!newEntries.empty()) {
+        utils::createDirectory(mapPath.parent_path());
+        std::ofstream map(mapPath, std::ios::app);
+        for (const auto& entry : newEntries) {
+            map << entry << '\n';
+        }
+        if (!map) {
+            std::cerr << "Failed to record imported ids" << std::endl;
+            return false;
+        }
+    }
+
+    RefStore refStore(mimirionDir);
+    for (const auto& [name, commit] : refs) {
+        if (!refStore.writeRef(name, imported.at(commit))) {
+            return false;
+        }
+        ++counts.refs;
+    }
+    if (!headBranch.empty() && gitRefs.count("refs/heads/" + headBranch) && !refStore.setHead(headBranch)) {
+        return false;
+    }
+
+    if (stats) {
+        *stats = counts;
+    }
+    return true;
+}
+
+} // namespace mimirion
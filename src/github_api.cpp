@@ -12,6 +12,8 @@
 #include "../include/github_api.hpp"
 #include "../include/utils.hpp"
 #include "../include/commit.hpp"
+#include "../include/base64.hpp"
+#include "../include/file_view.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -26,15 +28,10 @@ namespace mimirion {
 /**
  * @brief Constructor for the GitHubProvider class
  * 
- * Initializes the libcurl library and creates a new cURL handle for
- * making HTTP requests to the GitHub API.
+ * Does not touch libcurl; the library and the cURL handle are set up by
+ * ensureHandle() the first time a request is made.
  */
-GitHubProvider::GitHubProvider() : curl(nullptr) {
-    // Initialize the global cURL library
-    curl_global_init(CURL_GLOBAL_DEFAULT);
-    
-    // Create a new cURL handle for HTTP requests
-    curl = curl_easy_init();
+GitHubProvider::GitHubProvider() : curl(nullptr), curlInitialized(false) {
 }
 
 GitHubProvider::~GitHubProvider() {
@@ -42,7 +39,32 @@ GitHubProvider::~GitHubProvider() {
         curl_easy_cleanup(curl);
         curl = nullptr;
     }
-    curl_global_cleanup();
+    if (curlInitialized) {
+        curl_global_cleanup();
+    }
+}
+
+bool GitHubProvider::ensureHandle() {
+    if (curl) {
+        return true;
+    }
+    
+    // Initialize the global cURL library (and TLS) on first use
+    if (!curlInitialized) {
+        if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK) {
+            std::cerr << "Error: Failed to initialize cURL" << std::endl;
+            return false;
+        }
+        curlInitialized = true;
+    }
+    
+    // Create a new cURL handle for HTTP requests
+    curl = curl_easy_init();
+    if (!curl) {
+        std::cerr << "Error: cURL handle not initialized" << std::endl;
+        return false;
+    }
+    return true;
 }
 
 void GitHubProvider::setCredentials(const std::string& username, const std::string& token) {
@@ -96,8 +118,7 @@ bool GitHubProvider::saveCredentialsToFile(const fs::path& path) const {
 
 bool GitHubProvider::push(const fs::path& localDir, const std::string& remoteName,
                       const std::string& remoteUrl, const std::string& branch) {
-    if (!curl) {
-        std::cerr << "Error: cURL handle not initialized" << std::endl;
+    if (!ensureHandle()) {
         return false;
     }
     
@@ -174,12 +195,15 @@ bool GitHubProvider::push(const fs::path& localDir, const std::string& remoteNam
     
     // Create a blob for each file
     for (const auto& [filePath, fileHash] : headCommit->fileHashes) {
-        // Read the file content
-        std::string fileContent = utils::readFile(localDir / filePath);
+        // View the file content without copying it
+        FileView fileContent(localDir / filePath);
         
-        // Create a JSON payload for the blob
-        std::string blobData = "{\"content\":\"" + utils::base64Encode(fileContent) + 
-                             "\",\"encoding\":\"base64\"}";
+        // Create a JSON payload for the blob, encoding straight into it
+        std::string blobData;
+        blobData.reserve(Base64Encoder::encodedSize(fileContent.size()) + 64);
+        blobData += "{\"content\":\"";
+        Base64Encoder::encode(fileContent.view(), blobData);
+        blobData += "\",\"encoding\":\"base64\"}";
         
         // Upload the blob (not implemented here - would be another curl request)
     }
@@ -313,9 +337,8 @@ std::vector<std::string> GitHubProvider::getRepositories() {
 
 bool GitHubProvider::executeRequest(const std::string& url, const std::string& method,
                                 const std::string& data, std::string* response) {
-    // Check if curl was initialized
-    if (!curl) {
-        std::cerr << "CURL not initialized" << std::endl;
+    // Set up curl on the first request
+    if (!ensureHandle()) {
         return false;
     }
     
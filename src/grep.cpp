@@ -0,0 +1,521 @@
+/**
+ * @file grep.cpp
+ * @brief Implementation of the Grep and LineMatcher classes
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/grep.hpp"
+#include "../include/attributes.hpp"
+#include "../include/commit.hpp"
+#include "../include/file_tracker.hpp"
+#include "../include/file_view.hpp"
+#include "../include/ignore.hpp"
+#include "../include/object_store.hpp"
+#include "../include/refs.hpp"
+#include "../include/scanner.hpp"
+#include "../include/scheduler.hpp"
+#include "../include/trigram.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <regex.h>
+#include <unordered_set>
+
+namespace mimirion {
+
+namespace {
+
+// Files searched before their output is printed
+constexpr size_t kBatchSize = 256;
+
+// Bytes roughly ordered from most to least common in source code and text;
+// the literal's byte that appears latest here, or not at all, is searched
+// for with memchr, so candidate hits are as rare as possible
+constexpr std::string_view kCommonBytes =
+    " etaoinsrhldcumfpgwybvkxjqz\n_.,;()=-\"'/*{}ETAOINSRHLDCUMFPGWYBVKXJQZ0123456789\t:<>[]";
+
+size_t commonness(unsigned char c) {
+    size_t index = kCommonBytes.find(static_cast<char>(c));
+    return index == std::string_view::npos ? 0 : kCommonBytes.size() - index;
+}
+
+unsigned char lower(unsigned char c) {
+    return static_cast<unsigned char>(std::tolower(c));
+}
+
+size_t skipBracket(const std::string& pattern, size_t i) {
+    size_t j = i + 1;
+    if (j < pattern.size() && pattern[j] == '^') {
+        ++j;
+    }
+    if (j < pattern.size() && pattern[j] == ']') {
+        ++j;
+    }
+    while (j < pattern.size() && pattern[j] != ']') {
+        // Classes such as [:alpha:] may contain a ']' of their own
+        if (pattern[j] == '[' && j + 1 < pattern.size() &&
+            (pattern[j + 1] == ':' || pattern[j + 1] == '.' || pattern[j + 1] == '=')) {
+            size_t close = pattern.find(std::string(1, pattern[j + 1]) + "]", j + 2);
+            j = close == std::string::npos ? pattern.size() : close + 2;
+            continue;
+        }
+        ++j;
+    }
+    return j + 1;
+}
+
+uint64_t countNewlines(std::string_view text, size_t from, size_t to) {
+    uint64_t count = 0;
+    const char* p = text.data() + from;
+    const char* end = text.data() + to;
+    while ((p = static_cast<const char*>(std::memchr(p, '\n', end - p)))) {
+        ++count;
+        ++p;
+    }
+    return count;
+}
+
+// Appends a file's results to out; returns whether anything matched
+bool searchText(const LineMatcher& matcher, const GrepOptions& options, const std::string& name,
+                std::string_view text, std::string& out) {
+    bool binary = FileScanner::looksBinary(text.substr(0, FileScanner::kBinaryCheckSize));
+    bool listOnly = options.filesWithMatches || (binary && !options.count);
+
+    uint64_t matches = 0;
+    uint64_t line = 1;
+    size_t counted = 0;
+    size_t offset = 0;
+    size_t start = 0;
+    size_t end = 0;
+    while (matcher.next(text, offset, start, end)) {
+        ++matches;
+        if (listOnly) {
+            break;
+        }
+        if (options.count) {
+            continue;
+        }
+
+        out += name;
+        out += ':';
+        if (options.lineNumbers) {
+            line += countNewlines(text, counted, start);
+            counted = start;
+            out += std::to_string(line);
+            out += ':';
+        }
+        out.append(text.data() + start, end - start);
+        out += '\n';
+    }
+
+    if (matches == 0) {
+        return false;
+    }
+    if (options.filesWithMatches) {
+        out += name + "\n";
+    } else if (options.count) {
+        out += name + ":" + std::to_string(matches) + "\n";
+    } else if (binary) {
+        out += "Binary file " + name + " matches\n";
+    }
+    return true;
+}
+
+} // namespace
+
+struct LineMatcher::Regex {
+    regex_t compiled;
+
+    ~Regex() { regfree(&compiled); }
+};
+
+std::unique_ptr<LineMatcher> LineMatcher::create(const GrepOptions& options, std::string& error) {
+    std::unique_ptr<LineMatcher> matcher(new LineMatcher());
+    matcher->ignoreCase = options.ignoreCase;
+
+    if (options.fixedStrings && !options.pattern.empty()) {
+        matcher->literal = options.pattern;
+    } else {
+        std::string pattern = options.fixedStrings ? "" : options.pattern;
+        auto regex = std::make_unique<Regex>();
+        int flags = REG_EXTENDED | REG_NEWLINE | (options.ignoreCase ? REG_ICASE : 0);
+        int rc = regcomp(&regex->compiled, pattern.c_str(), flags);
+        if (rc != 0) {
+            char message[256];
+            regerror(rc, &regex->compiled, message, sizeof(message));
+            error = "Invalid pattern '" + pattern + "': " + message;
+            // regfree is only valid after a successful regcomp
+            std::memset(&regex->compiled, 0, sizeof(regex->compiled));
+            regex.release();
+            return nullptr;
+        }
+        matcher->regex = std::move(regex);
+        matcher->literal = extractLiteral(pattern);
+    }
+
+    if (matcher->ignoreCase) {
+        std::transform(matcher->literal.begin(), matcher->literal.end(), matcher->literal.begin(),
+                       [](char c) { return static_cast<char>(lower(static_cast<unsigned char>(c))); });
+    }
+
+    // Search for the rarest byte, compare the rest around it
+    size_t best = SIZE_MAX;
+    for (size_t i = 0; i < matcher->literal.size(); ++i) {
+        size_t rank = commonness(static_cast<unsigned char>(matcher->literal[i]));
+        if (rank < best) {
+            best = rank;
+            matcher->rareIndex = i;
+        }
+    }
+    return matcher;
+}
+
+LineMatcher::~LineMatcher() = default;
+
+const std::string& LineMatcher::requiredLiteral() const {
+    return literal;
+}
+
+std::string LineMatcher::extractLiteral(const std::string& pattern) {
+    std::string best;
+    for (auto& literal : requiredLiterals(pattern)) {
+        if (literal.size() > best.size()) {
+            best = std::move(literal);
+        }
+    }
+    return best;
+}
+
+std::vector<std::string> LineMatcher::requiredLiterals(const std::string& pattern) {
+    std::vector<std::string> literals;
+    std::string current;
+    auto endRun = [&]() {
+        if (!current.empty()) {
+            literals.push_back(std::move(current));
+        }
+        current.clear();
+    };
+
+    int depth = 0;
+    size_t i = 0;
+    while (i < pattern.size()) {
+        char c = pattern[i];
+        if (c == '[') {
+            endRun();
+            i = skipBracket(pattern, i);
+            continue;
+        }
+        if (c == '(' || c == ')') {
+            // Groups may be optional or repeated, their content is skipped
+            depth += c == '(' ? 1 : -1;
+            endRun();
+            ++i;
+            continue;
+        }
+        if (depth > 0) {
+            i += c == '\\' ? 2 : 1;
+            continue;
+        }
+        if (c == '|') {
+            // Top-level alternation: no literal is required
+            return {};
+        }
+
+        char atom;
+        if (c == '\\' && i + 1 < pattern.size() &&
+            std::ispunct(static_cast<unsigned char>(pattern[i + 1]))) {
+            atom = pattern[i + 1];
+            i += 2;
+        } else if (c == '\\' || std::strchr(".^$*+?{", c)) {
+            endRun();
+            i += c == '\\' ? 2 : 1;
+            continue;
+        } else {
+            atom = c;
+            ++i;
+        }
+
+        char quantifier = i < pattern.size() ? pattern[i] : '\0';
+        if (quantifier == '*' || quantifier == '?' || quantifier == '{') {
+            // The atom may be absent or its count is unknown
+            endRun();
+            continue;
+        }
+        current += atom;
+        if (quantifier == '+') {
+            endRun();
+            ++i;
+        }
+    }
+    endRun();
+    return literals;
+}
+
+size_t LineMatcher::findLiteral(std::string_view text, size_t offset) const {
+    size_t length = literal.size();
+    if (text.size() < length || offset > text.size() - length) {
+        return std::string_view::npos;
+    }
+
+    const char* base = text.data();
+    auto equal = [&](size_t candidate) {
+        if (!ignoreCase) {
+            return std::memcmp(base + candidate, literal.data(), length) == 0;
+        }
+        for (size_t i = 0; i < length; ++i) {
+            if (lower(static_cast<unsigned char>(base[candidate + i])) !=
+                static_cast<unsigned char>(literal[i])) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // The rare byte of a candidate lies in [first, last)
+    const char* p = base + offset + rareIndex;
+    const char* last = base + text.size() - length + rareIndex + 1;
+    unsigned char rare = static_cast<unsigned char>(literal[rareIndex]);
+    unsigned char upper = ignoreCase ? static_cast<unsigned char>(std::toupper(rare)) : rare;
+
+    const char* nextRare = nullptr;
+    const char* nextUpper = upper == rare ? last : nullptr;
+    while (p < last) {
+        // Both cases are scanned with memchr, each cursor only moves forward
+        if (!nextRare || nextRare < p) {
+            nextRare = static_cast<const char*>(std::memchr(p, rare, last - p));
+            nextRare = nextRare ? nextRare : last;
+        }
+        if (!nextUpper || nextUpper < p) {
+            nextUpper = static_cast<const char*>(std::memchr(p, upper, last - p));
+            nextUpper = nextUpper ? nextUpper : last;
+        }
+        const char* hit = std::min(nextRare, nextUpper);
+        if (hit >= last) {
+            break;
+        }
+        size_t candidate = static_cast<size_t>(hit - base) - rareIndex;
+        if (equal(candidate)) {
+            return candidate;
+        }
+        p = hit + 1;
+    }
+    return std::string_view::npos;
+}
+
+bool LineMatcher::matchRegex(std::string_view text, size_t start, size_t end, size_t& found) const {
+    regmatch_t match[1];
+    match[0].rm_so = static_cast<regoff_t>(start);
+    match[0].rm_eo = static_cast<regoff_t>(end);
+    if (regexec(&regex->compiled, text.data(), 1, match, REG_STARTEND) != 0) {
+        return false;
+    }
+    found = static_cast<size_t>(match[0].rm_so);
+    return true;
+}
+
+bool LineMatcher::next(std::string_view text, size_t& offset, size_t& lineStart,
+                       size_t& lineEnd) const {
+    const char* base = text.data();
+    size_t pos = offset;
+    while (pos < text.size()) {
+        size_t hit = 0;
+        if (!literal.empty()) {
+            hit = findLiteral(text, pos);
+            if (hit == std::string_view::npos) {
+                return false;
+            }
+        } else if (!matchRegex(text, pos, text.size(), hit) || hit == text.size()) {
+            // An empty match after the final newline is not a line
+            return false;
+        }
+
+        const void* newline = hit > pos ? memrchr(base + pos, '\n', hit - pos) : nullptr;
+        size_t start = newline ? static_cast<const char*>(newline) - base + 1 : pos;
+        const void* after = std::memchr(base + hit, '\n', text.size() - hit);
+        size_t end = after ? static_cast<const char*>(after) - base : text.size();
+
+        // The literal only says the line may match
+        size_t found = 0;
+        if (!regex || literal.empty() || matchRegex(text, start, end, found)) {
+            lineStart = start;
+            lineEnd = end;
+            offset = std::min(end + 1, text.size());
+            return true;
+        }
+        pos = end + 1;
+    }
+    return false;
+}
+
+Grep::Grep(const fs::path& repoPath, const fs::path& mimirDir)
+    : repositoryPath(repoPath), mimirionDir(mimirDir) {
+}
+
+int Grep::run(const GrepOptions& options, std::ostream& out) {
+    std::string error;
+    auto matcher = LineMatcher::create(options, error);
+    if (!matcher) {
+        std::cerr << error << std::endl;
+        return -1;
+    }
+
+    std::vector<Target> targets;
+    if (!collectTargets(options, targets)) {
+        return -1;
+    }
+
+    std::string prefix = options.source == GrepSource::COMMIT ? options.revision + ":" : "";
+    ObjectStore objects(mimirionDir);
+    int matchedFiles = 0;
+    std::vector<std::string> outputs;
+    std::vector<char> matched;
+    for (size_t batch = 0; batch < targets.size(); batch += kBatchSize) {
+        size_t count = std::min(kBatchSize, targets.size() - batch);
+        outputs.assign(count, std::string());
+        matched.assign(count, 0);
+
+        // One file per task, the files differ too much in size for chunks
+        parallelFor(count, [&](size_t i) {
+            const Target& target = targets[batch + i];
+            FileView view;
+            std::string content;
+            std::string_view text;
+            if (target.hash.empty()) {
+                if (!view.open(repositoryPath / target.path, FileView::Advice::SEQUENTIAL)) {
+                    return;
+                }
+                text = view.view();
+            } else {
+                bool read = objects.readStream(target.hash, [&content](const char* data, size_t size) {
+                    content.append(data, size);
+                    return true;
+                });
+                if (!read) {
+                    return;
+                }
+                text = content;
+            }
+            matched[i] = searchText(*matcher, options, prefix + target.path, text, outputs[i]);
+        }, 1);
+
+        for (size_t i = 0; i < count; ++i) {
+            out << outputs[i];
+            matchedFiles += matched[i];
+        }
+    }
+    out.flush();
+    return matchedFiles;
+}
+
+bool Grep::collectTargets(const GrepOptions& options, std::vector<Target>& targets) {
+    ObjectStore objects(mimirionDir);
+    CommitManager commits(repositoryPath, mimirionDir);
+    std::map<std::string, std::string> chosen;
+
+    if (options.source == GrepSource::COMMIT) {
+        std::string hash = RefStore(mimirionDir).resolve(options.revision, &objects);
+        CommitInfo* commit = hash.empty() ? nullptr : commits.getCommit(hash);
+        if (!commit) {
+            std::cerr << "Unknown revision: " << options.revision << std::endl;
+            return false;
+        }
+        chosen.insert(commit->fileHashes.begin(), commit->fileHashes.end());
+
+        if (options.useIndex) {
+            // Index the snapshot's new blobs, then skip those that cannot match
+            TrigramIndex index(mimirionDir);
+            std::vector<std::string> blobs;
+            for (const auto& [path, blob] : chosen) {
+                blobs.push_back(blob);
+            }
+            std::vector<std::string> literals = options.fixedStrings
+                ? std::vector<std::string>{options.pattern}
+                : LineMatcher::requiredLiterals(options.pattern);
+            std::unordered_set<std::string> candidates;
+            if (index.update(blobs) && index.candidates(literals, candidates)) {
+                for (auto it = chosen.begin(); it != chosen.end();) {
+                    it = candidates.count(it->second) ? std::next(it) : chosen.erase(it);
+                }
+            }
+        }
+    } else {
+        // Tracked files: those in HEAD, updated by what the index holds
+        commits.loadState();
+        if (CommitInfo* head = commits.getHeadCommit()) {
+            chosen.insert(head->fileHashes.begin(), head->fileHashes.end());
+        }
+
+        FileTracker tracker(repositoryPath, mimirionDir);
+        tracker.loadState();
+        for (const auto& file : tracker.getFiles()) {
+            if (file.status == FileStatus::UNTRACKED) {
+                continue;
+            }
+            chosen[file.path] = file.status == FileStatus::STAGED ? file.hash : file.lastCommitHash;
+        }
+
+        for (auto it = chosen.begin(); it != chosen.end();) {
+            if (options.source == GrepSource::WORKING_TREE) {
+                it->second.clear();
+            } else if (!objects.hasObject(it->second)) {
+                // Staged content is only written when committed; while the
+                // file still matches the index, the file is that content
+                if (tracker.getFileStatus(it->first) != FileStatus::STAGED) {
+                    std::cerr << "Staged content of " << it->first << " is not available" << std::endl;
+                    it = chosen.erase(it);
+                    continue;
+                }
+                it->second.clear();
+            }
+            ++it;
+        }
+
+        if (options.untracked && options.source == GrepSource::WORKING_TREE) {
+            IgnoreRules ignore = IgnoreRules::load(repositoryPath);
+            std::error_code ec;
+            for (fs::recursive_directory_iterator it(repositoryPath, ec), end; it != end && !ec;
+                 it.increment(ec)) {
+                std::string path = it->path().lexically_relative(repositoryPath).generic_string();
+                bool directory = it->is_directory();
+                if (it->path() == mimirionDir || path == ".mimirion" || ignore.isIgnored(path, directory)) {
+                    if (directory) {
+                        it.disable_recursion_pending();
+                    }
+                    continue;
+                }
+                if (it->is_regular_file()) {
+                    chosen.emplace(path, "");
+                }
+            }
+        }
+    }
+
+    for (auto& [path, hash] : chosen) {
+        if (selected(options, path)) {
+            targets.push_back(Target{path, hash});
+        }
+    }
+    return true;
+}
+
+bool Grep::selected(const GrepOptions& options, const std::string& path) {
+    if (options.paths.empty()) {
+        return true;
+    }
+    for (std::string spec : options.paths) {
+        while (spec.size() > 1 && spec.back() == '/') {
+            spec.pop_back();
+        }
+        if (spec == "." || path == spec ||
+            (path.compare(0, spec.size(), spec) == 0 && path[spec.size()] == '/') ||
+            Attributes::matches(spec, path)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace mimirion
@@ -0,0 +1,79 @@
+/**
+ * @file ignore.cpp
+ * @brief Implementation of the IgnoreRules class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/ignore.hpp"
+#include "../include/attributes.hpp"
+#include "../include/utils.hpp"
+#include <sstream>
+
+namespace mimirion {
+
+IgnoreRules IgnoreRules::load(const fs::path& repoPath) {
+    fs::path file = repoPath / kFileName;
+    if (!fs::is_regular_file(file)) {
+        return IgnoreRules();
+    }
+    return parse(utils::readFile(file));
+}
+
+IgnoreRules IgnoreRules::parse(const std::string& text) {
+    IgnoreRules ignore;
+    std::istringstream stream(text);
+    std::string line;
+    while (std::getline(stream, line)) {
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t')) {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        Rule rule;
+        if (line[0] == '!') {
+            rule.negated = true;
+            line.erase(0, 1);
+        }
+        if (!line.empty() && line.back() == '/') {
+            rule.directoryOnly = true;
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            rule.pattern = line;
+            ignore.rules.push_back(std::move(rule));
+        }
+    }
+    return ignore;
+}
+
+bool IgnoreRules::isIgnored(const std::string& path, bool directory) const {
+    if (rules.empty()) {
+        return false;
+    }
+
+    // Nothing below an ignored directory can be re-included
+    for (size_t slash = path.find('/'); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+        if (matchesEntry(path.substr(0, slash), true)) {
+            return true;
+        }
+    }
+    return matchesEntry(path, directory);
+}
+
+bool IgnoreRules::empty() const {
+    return rules.empty();
+}
+
+bool IgnoreRules::matchesEntry(const std::string& path, bool directory) const {
+    for (auto rule = rules.rbegin(); rule != rules.rend(); ++rule) {
+        if ((directory || !rule->directoryOnly) && Attributes::matches(rule->pattern, path)) {
+            return !rule->negated;
+        }
+    }
+    return false;
+}
+
+} // namespace mimirion
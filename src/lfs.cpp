@@ -0,0 +1,266 @@
+/**
+ * @file lfs.cpp
+ * @brief Implementation of the LargeFileStore class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/lfs.hpp"
+#include "../include/file_view.hpp"
+#include "../include/object_store.hpp"
+#include "../include/scanner.hpp"
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <vector>
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
+namespace mimirion {
+
+namespace {
+
+constexpr std::string_view kOidPrefix = "oid sha256:";
+constexpr std::string_view kSizePrefix = "size ";
+
+// Closes a descriptor when it goes out of scope
+class FileDescriptor {
+public:
+    explicit FileDescriptor(int fd) : fd(fd) {}
+    ~FileDescriptor() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+    int get() const { return fd; }
+    bool valid() const { return fd >= 0; }
+
+private:
+    int fd;
+};
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Make target share source's extents; fails on filesystems without reflinks
+bool cloneFile(int source, int target) {
+#ifdef FICLONE
+    return ioctl(target, FICLONE, source) == 0;
+#else
+    (void)source;
+    (void)target;
+    return false;
+#endif
+}
+
+// Copy source into a new target file, by reflink where possible
+bool copyFile(const fs::path& source, const fs::path& target) {
+    FileDescriptor in(::open(source.c_str(), O_RDONLY | O_CLOEXEC));
+    FileDescriptor out(::open(target.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    if (!in.valid() || !out.valid()) {
+        return false;
+    }
+    if (cloneFile(in.get(), out.get())) {
+        return true;
+    }
+
+    std::vector<char> buffer(LargeFileStore::kChunkSize);
+    while (true) {
+        ssize_t count = ::read(in.get(), buffer.data(), buffer.size());
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (count == 0) {
+            return true;
+        }
+        if (!writeAll(out.get(), buffer.data(), static_cast<size_t>(count))) {
+            return false;
+        }
+    }
+}
+
+} // namespace
+
+LargeFileStore::LargeFileStore(const fs::path& repoPath, const fs::path& mimirionDir)
+    : repositoryPath(repoPath), storeDir(mimirionDir / "lfs"),
+      attributes(Attributes::load(repoPath)) {
+}
+
+bool LargeFileStore::isTracked(const std::string& path) const {
+    auto filter = attributes.get(path, "filter");
+    return filter && *filter == "lfs";
+}
+
+bool LargeFileStore::store(const fs::path& file, LfsPointer& pointer) {
+    if (readPointerFile(file, pointer)) {
+        return true;
+    }
+
+    fs::path temp = temporaryPath();
+    ScanResult result;
+    bool copied = false;
+    {
+        FileDescriptor in(::open(file.c_str(), O_RDONLY | O_CLOEXEC));
+        FileDescriptor out(::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+        if (in.valid() && out.valid()) {
+            // With a reflink the copy is free and hashing it reads the
+            // stored bytes; otherwise hash and copy in the same pass
+            FileScanner scanner(kChunkSize);
+            if (cloneFile(in.get(), out.get())) {
+                copied = scanner.scan(temp, result);
+            } else {
+                copied = scanner.scan(file, result, [&](const char* data, size_t size) {
+                    return writeAll(out.get(), data, size);
+                });
+            }
+        }
+    }
+
+    std::error_code ec;
+    if (!copied) {
+        std::cerr << "Failed to store large file " << file << std::endl;
+        fs::remove(temp, ec);
+        return false;
+    }
+
+    pointer.oid = result.hash;
+    pointer.size = result.size;
+    if (hasObject(pointer.oid)) {
+        fs::remove(temp, ec);
+        return true;
+    }
+
+    fs::path target = objectPath(pointer.oid);
+    fs::create_directories(target.parent_path(), ec);
+    fs::rename(temp, target, ec);
+    if (ec) {
+        std::cerr << "Failed to store large file " << file << ": " << ec.message() << std::endl;
+        fs::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+bool LargeFileStore::materialize(const LfsPointer& pointer, const fs::path& target) const {
+    if (!hasObject(pointer.oid)) {
+        return false;
+    }
+
+    static std::atomic<unsigned> counter{0};
+    std::error_code ec;
+    fs::create_directories(target.parent_path(), ec);
+    fs::path temp = target.parent_path() /
+                    ("." + target.filename().string() + ".lfs-" + std::to_string(getpid()) + "-" +
+                     std::to_string(counter++));
+
+    if (!copyFile(objectPath(pointer.oid), temp)) {
+        std::cerr << "Failed to materialize " << target << std::endl;
+        fs::remove(temp, ec);
+        return false;
+    }
+    fs::rename(temp, target, ec);
+    if (ec) {
+        std::cerr << "Failed to materialize " << target << ": " << ec.message() << std::endl;
+        fs::remove(temp, ec);
+        return false;
+    }
+    return true;
+}
+
+bool LargeFileStore::hasObject(const std::string& oid) const {
+    return ObjectStore::isValidHash(oid) && fs::is_regular_file(objectPath(oid));
+}
+
+fs::path LargeFileStore::objectPath(const std::string& oid) const {
+    return storeDir / "objects" / oid.substr(0, 2) / oid.substr(2, 2) / oid;
+}
+
+std::string LargeFileStore::formatPointer(const LfsPointer& pointer) {
+    std::string text(kPointerVersion);
+    text += '\n';
+    text += kOidPrefix;
+    text += pointer.oid;
+    text += '\n';
+    text += kSizePrefix;
+    text += std::to_string(pointer.size);
+    text += '\n';
+    return text;
+}
+
+bool LargeFileStore::parsePointer(std::string_view text, LfsPointer& pointer) {
+    if (text.size() > kMaxPointerSize) {
+        return false;
+    }
+
+    std::string_view lines[3];
+    for (auto& line : lines) {
+        size_t newline = text.find('\n');
+        if (newline == std::string_view::npos) {
+            return false;
+        }
+        line = text.substr(0, newline);
+        text.remove_prefix(newline + 1);
+    }
+    if (!text.empty() || lines[0] != kPointerVersion ||
+        lines[1].substr(0, kOidPrefix.size()) != kOidPrefix ||
+        lines[2].substr(0, kSizePrefix.size()) != kSizePrefix) {
+        return false;
+    }
+
+    std::string oid(lines[1].substr(kOidPrefix.size()));
+    std::string_view size = lines[2].substr(kSizePrefix.size());
+    uint64_t value = 0;
+    auto parsed = std::from_chars(size.data(), size.data() + size.size(), value);
+    if (oid.size() != 64 || !ObjectStore::isValidHash(oid) || parsed.ec != std::errc() ||
+        parsed.ptr != size.data() + size.size()) {
+        return false;
+    }
+
+    pointer.oid = std::move(oid);
+    pointer.size = value;
+    return true;
+}
+
+bool LargeFileStore::readPointerFile(const fs::path& file, LfsPointer& pointer) {
+    std::error_code ec;
+    uintmax_t size = fs::file_size(file, ec);
+    if (ec || size > kMaxPointerSize) {
+        return false;
+    }
+    FileView view(file);
+    return view.isOpen() && parsePointer(view.view(), pointer);
+}
+
+fs::path LargeFileStore::temporaryPath() const {
+    // Unique across processes and across stores within this process
+    static std::atomic<unsigned> counter{0};
+    fs::path dir = storeDir / "tmp";
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    return dir / (std::to_string(getpid()) + "-" + std::to_string(counter++));
+}
+
+} // namespace mimirion
@@ -4,14 +4,64 @@
 #include <unordered_map>
 #include <filesystem>
 #include <functional>
+#include <fstream>
 #include "../include/repository.hpp"
 #include "../include/github_api.hpp"
+#include "../include/daemon.hpp"
+#include "../include/batch.hpp"
+#include "../include/config.hpp"
+#include "../include/object_store.hpp"
+#include "../include/commit.hpp"
+#include "../include/lfs.hpp"
+#include "../include/grep.hpp"
+#include "../include/archive.hpp"
+#include "../include/git_import.hpp"
+#include "../include/fast_import.hpp"
+#include "../include/fast_export.hpp"
+#include "../include/worktree.hpp"
+#include "../include/fsck.hpp"
+#include "../include/bitmap.hpp"
+#include "../include/maintenance.hpp"
+#include "../include/refs.hpp"
+#include <cmath>
+#include <csignal>
+#include <unistd.h>
 
 // Main program for Mimirion VCS
 // A custom version control system with GitHub integration
 
 namespace fs = std::filesystem;
 
+// Daemon served by `mimirion daemon`, stopped on SIGINT/SIGTERM
+static mimirion::Daemon* activeDaemon = nullptr;
+
+static void stopDaemon(int) {
+    if (activeDaemon) {
+        activeDaemon->stop();
+    }
+}
+
+// Forward a command to the repository daemon if one is running.
+// Returns true if the daemon handled it; set MIMIRION_NO_DAEMON to bypass.
+static bool forwardToDaemon(const std::vector<std::string>& args, int& exitCode) {
+    if (getenv("MIMIRION_NO_DAEMON")) {
+        return false;
+    }
+    
+    fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+    if (root.empty()) {
+        return false;
+    }
+    
+    std::string output;
+    if (!mimirion::DaemonClient::forward(mimirion::Repository::findMimirionDir(root), args, output, exitCode)) {
+        return false;
+    }
+    
+    (exitCode == 0 ? std::cout : std::cerr) << output << std::endl;
+    return true;
+}
+
 void printUsage() {
     std::cout << "Mimirion - Custom Version Control System\n"
               << "Usage: mimirion <command> [<args>]\n\n"
@@ -29,10 +79,85 @@ void printUsage() {
               << "  pull [<remote>] [<branch>]  Pull from a remote repository\n"
               << "  github login        Set GitHub credentials\n"
               << "  github create <name> Create a new GitHub repository\n"
+              << "  config [--global|--system] <key> [<value>]  Get or set a configuration value\n"
+              << "  config --list       Show the effective configuration\n"
+              << "  codec [list]        Show the object compression codecs\n"
+              << "  codec train [--size <bytes>]  Train a zstd dictionary on small objects\n"
+              << "  lfs track <pattern>  Store files matching a pattern in the large file store\n"
+              << "  lfs ls              List large files in HEAD (* materialized, - pointer)\n"
+              << "  lfs pull            Replace pointer files with their content\n"
+              << "  grep [-n] [-i] [-F] [-l] [-c] <pattern> [-- <path>...]  Search tracked files\n"
+              << "  grep --cached | --commit <rev> | --untracked ...  Search the index, a commit or untracked files too\n"
+              << "  search [-n] [-i] [-F] [-l] [-c] <pattern> [<rev>]  Search a commit using the trigram index\n"
+              << "  archive [--format=tar|tgz|zip] [--prefix=<dir>/] [-o <file>] [<commit>]  Export a commit as an archive\n"
+              << "  import-git <path>   Import the history of a Git repository\n"
+              << "  fast-import [--import-marks=<file>] [--export-marks=<file>]  Import a commit stream from stdin\n"
+              << "  export [<rev>...]   Write history as a fast-import stream to stdout\n"
+              << "  worktree add <path> <branch>  Check out a branch into a linked worktree\n"
+              << "  worktree list | remove [--force] <worktree> | prune  Manage linked worktrees\n"
+              << "  alternates [list]   List the object stores reads fall back to\n"
+              << "  alternates add <repository>  Read missing objects from another repository\n"
+              << "  fsck [--budget=<seconds>] [--progress] [--no-connectivity]  Verify objects, refs and indexes\n"
+              << "  rev-list [--objects] [--count] <rev>... [^<rev>...]  List what some commits reach and others do not\n"
+              << "  bitmap [show|write]  Show or rebuild the reachability bitmaps\n"
+              << "  maintenance run [--auto] [--task=<name>]... [--budget=<seconds>] [--detach]  Pack, index and prune\n"
+              << "  maintenance status  Show what maintenance would do\n"
+              << "  batch [-z]          Answer queries read from stdin\n"
+              << "  daemon [stop|status]  Run, stop or query the repository daemon\n"
               << "  help                Show this help message\n"
               << std::endl;
 }
 
+// Parses the options shared by grep and search; operands after the pattern
+// and before "--" are returned, paths after "--" go to options.paths
+static bool parseGrepArguments(int argc, char** argv, mimirion::GrepOptions& options,
+                               std::vector<std::string>& operands) {
+    bool hasPattern = false;
+    bool pathsOnly = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (pathsOnly) {
+            options.paths.push_back(arg);
+        } else if (arg == "--") {
+            pathsOnly = true;
+        } else if (arg == "-n") {
+            options.lineNumbers = true;
+        } else if (arg == "-i") {
+            options.ignoreCase = true;
+        } else if (arg == "-F") {
+            options.fixedStrings = true;
+        } else if (arg == "-l") {
+            options.filesWithMatches = true;
+        } else if (arg == "-c") {
+            options.count = true;
+        } else if (arg == "--cached") {
+            options.source = mimirion::GrepSource::INDEX;
+        } else if (arg == "--untracked") {
+            options.untracked = true;
+        } else if (arg == "--commit" && i + 1 < argc) {
+            options.source = mimirion::GrepSource::COMMIT;
+            options.revision = argv[++i];
+        } else if (arg == "-e" && i + 1 < argc) {
+            options.pattern = argv[++i];
+            hasPattern = true;
+        } else if (!hasPattern) {
+            options.pattern = arg;
+            hasPattern = true;
+        } else {
+            operands.push_back(arg);
+        }
+    }
+    return hasPattern;
+}
+
+// Starts background maintenance when a command has left enough work for it
+static void maintainInBackground(const fs::path& root) {
+    mimirion::MaintenanceManager maintenance(root, mimirion::Repository::findMimirionDir(root));
+    if (maintenance.spawnIfDue()) {
+        std::cerr << "Running maintenance in the background" << std::endl;
+    }
+}
+
 int main(int argc, char** argv) {
     // Check if any command was provided
     if (argc < 2) {
@@ -45,9 +170,6 @@ int main(int argc, char** argv) {
     // Create repository instance
     mimirion::Repository repo;
     
-    // Create GitHub API instance
-    mimirion::GitHubProvider github;
-    
     // Command handlers
     if (command == "init") {
         // Initialize a new repository
@@ -65,6 +187,12 @@ int main(int argc, char** argv) {
         }
     } 
     else if (command == "status") {
+        // Let a running daemon answer from its warm state
+        int exitCode = 0;
+        if (forwardToDaemon({"status"}, exitCode)) {
+            return exitCode;
+        }
+        
         // Load repository
         if (!repo.load(".")) {
             std::cerr << "Not a Mimirion repository" << std::endl;
@@ -115,6 +243,7 @@ int main(int argc, char** argv) {
         std::string commitHash = repo.commit(message);
         if (!commitHash.empty()) {
             std::cout << "Committed changes [" << commitHash.substr(0, 8) << "]: " << message << std::endl;
+            maintainInBackground(mimirion::Repository::findRepositoryRoot(fs::current_path()));
             return 0;
         } else {
             std::cerr << "Failed to commit changes" << std::endl;
@@ -276,6 +405,9 @@ int main(int argc, char** argv) {
             return 1;
         }
         
+        // Only the github commands need the API client
+        mimirion::GitHubProvider github;
+        
         std::string subcommand = argv[2];
         if (subcommand == "login") {
             // Get GitHub credentials
@@ -342,6 +474,684 @@ int main(int argc, char** argv) {
             return 1;
         }
     }
+    else if (command == "config") {
+        // Repository scope unless told otherwise; outside a repository only
+        // the user and system scopes are available
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        fs::path mimirionDir = root.empty() ? fs::path() : mimirion::Repository::findMimirionDir(root);
+        mimirion::Config::Scope scope = mimirion::Config::Scope::REPOSITORY;
+        
+        std::vector<std::string> args;
+        bool list = false;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--global") {
+                scope = mimirion::Config::Scope::USER;
+            } else if (arg == "--system") {
+                scope = mimirion::Config::Scope::SYSTEM;
+            } else if (arg == "--list" || arg == "-l") {
+                list = true;
+            } else {
+                args.push_back(arg);
+            }
+        }
+        
+        if (list) {
+            auto config = mimirion::Config::load(mimirionDir);
+            for (const auto& entry : config->entries()) {
+                std::cout << entry.first << "=" << entry.second << std::endl;
+            }
+            return 0;
+        }
+        
+        if (args.empty() || args.size() > 2) {
+            std::cerr << "Usage: mimirion config [--global|--system] <key> [<value>]" << std::endl;
+            return 1;
+        }
+        
+        if (args.size() == 1) {
+            auto value = mimirion::Config::load(mimirionDir)->get(args[0]);
+            if (!value) {
+                return 1;
+            }
+            std::cout << *value << std::endl;
+            return 0;
+        }
+        
+        if (scope == mimirion::Config::Scope::REPOSITORY && mimirionDir.empty()) {
+            std::cerr << "Not a Mimirion repository (use --global to set a user value)" << std::endl;
+            return 1;
+        }
+        return mimirion::Config::set(mimirionDir, scope, args[0], args[1]) ? 0 : 1;
+    }
+    else if (command == "codec") {
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 1;
+        }
+        mimirion::ObjectStore objects(mimirion::Repository::findMimirionDir(root));
+        
+        std::string subcommand = argc > 2 ? argv[2] : "list";
+        if (subcommand == "list") {
+            for (const mimirion::Codec* codec : mimirion::Codec::available()) {
+                bool current = codec == &objects.writeCodec();
+                std::cout << (current ? "* " : "  ") << codec->name();
+                if (current && objects.writeDictionary() != 0) {
+                    std::cout << " (dictionary " << std::hex << objects.writeDictionary() << std::dec << ")";
+                }
+                std::cout << std::endl;
+            }
+            return 0;
+        }
+        else if (subcommand == "train") {
+            size_t maxSize = 64 * 1024;
+            if (argc > 4 && std::string(argv[3]) == "--size") {
+                maxSize = std::strtoul(argv[4], nullptr, 10);
+            }
+            uint32_t id = objects.trainDictionary(maxSize);
+            if (id == 0) {
+                return 1;
+            }
+            std::cout << "Trained dictionary " << std::hex << id << std::dec << std::endl;
+            return 0;
+        }
+        
+        std::cerr << "Unknown codec subcommand: " << subcommand << std::endl;
+        return 1;
+    }
+    else if (command == "lfs") {
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 1;
+        }
+        fs::path mimirionDir = mimirion::Repository::findMimirionDir(root);
+        
+        std::string subcommand = argc > 2 ? argv[2] : "ls";
+        if (subcommand == "track") {
+            if (argc < 4) {
+                std::cerr << "Usage: mimirion lfs track <pattern>" << std::endl;
+                return 1;
+            }
+            if (!mimirion::Attributes::addRule(root, argv[3], "filter=lfs")) {
+                return 1;
+            }
+            std::cout << "Tracking " << argv[3] << std::endl;
+            return 0;
+        }
+        else if (subcommand != "ls" && subcommand != "pull") {
+            std::cerr << "Unknown lfs subcommand: " << subcommand << std::endl;
+            return 1;
+        }
+        
+        mimirion::CommitManager commits(root, mimirionDir);
+        commits.loadState();
+        mimirion::CommitInfo* head = commits.getHeadCommit();
+        if (!head) {
+            return 0;
+        }
+        
+        mimirion::ObjectStore objects(mimirionDir);
+        mimirion::LargeFileStore largeFiles(root, mimirionDir);
+        bool ok = true;
+        for (const auto& [path, hash] : head->fileHashes) {
+            // Only pointer blobs of large file paths refer to large files
+            if (!largeFiles.isTracked(path)) {
+                continue;
+            }
+            auto content = objects.readObject(hash);
+            mimirion::LfsPointer pointer;
+            if (!content || !mimirion::LargeFileStore::parsePointer(*content, pointer)) {
+                continue;
+            }
+            
+            mimirion::LfsPointer working;
+            bool isPointer = mimirion::LargeFileStore::readPointerFile(root / path, working);
+            if (subcommand == "ls") {
+                std::cout << pointer.oid.substr(0, 10) << (isPointer ? " - " : " * ") << path
+                          << " (" << pointer.size << " bytes)" << std::endl;
+            } else if (isPointer) {
+                if (!largeFiles.materialize(working, root / path)) {
+                    std::cerr << "Content of " << path << " is not stored locally" << std::endl;
+                    ok = false;
+                }
+            }
+        }
+        return ok ? 0 : 1;
+    }
+    else if (command == "grep") {
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 2;
+        }
+        
+        mimirion::GrepOptions options;
+        std::vector<std::string> operands;
+        bool hasPattern = parseGrepArguments(argc, argv, options, operands);
+        options.paths.insert(options.paths.begin(), operands.begin(), operands.end());
+        if (!hasPattern) {
+            std::cerr << "Usage: mimirion grep [-n] [-i] [-F] [-l] [-c] [--cached | --commit <rev> | --untracked] <pattern> [-- <path>...]" << std::endl;
+            return 2;
+        }
+        
+        mimirion::Grep grep(root, mimirion::Repository::findMimirionDir(root));
+        int matched = grep.run(options, std::cout);
+        return matched < 0 ? 2 : (matched > 0 ? 0 : 1);
+    }
+    else if (command == "search") {
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 2;
+        }
+        
+        mimirion::GrepOptions options;
+        std::vector<std::string> operands;
+        if (!parseGrepArguments(argc, argv, options, operands) ||
+            options.source != mimirion::GrepSource::WORKING_TREE || options.untracked) {
+            std::cerr << "Usage: mimirion search [-n] [-i] [-F] [-l] [-c] <pattern> [<rev>] [-- <path>...]" << std::endl;
+            return 2;
+        }
+        options.source = mimirion::GrepSource::COMMIT;
+        options.revision = operands.empty() ? "HEAD" : operands[0];
+        options.paths.insert(options.paths.begin(), operands.begin() + (operands.empty() ? 0 : 1),
+                             operands.end());
+        options.useIndex = true;
+        
+        mimirion::Grep grep(root, mimirion::Repository::findMimirionDir(root));
+        int matched = grep.run(options, std::cout);
+        return matched < 0 ? 2 : (matched > 0 ? 0 : 1);
+    }
+    else if (command == "archive") {
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 1;
+        }
+        
+        mimirion::ArchiveOptions options;
+        std::string revision = "HEAD";
+        fs::path output;
+        bool formatGiven = false;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--format=", 0) == 0) {
+                if (!mimirion::Archiver::parseFormat(arg.substr(9), options.format)) {
+                    std::cerr << "Unknown archive format: " << arg.substr(9) << std::endl;
+                    return 1;
+                }
+                formatGiven = true;
+            } else if (arg.rfind("--prefix=", 0) == 0) {
+                options.prefix = arg.substr(9);
+            } else if (arg == "-o" && i + 1 < argc) {
+                output = argv[++i];
+            } else if (arg.rfind("--output=", 0) == 0) {
+                output = arg.substr(9);
+            } else {
+                revision = arg;
+            }
+        }
+        if (!output.empty() && !formatGiven) {
+            mimirion::Archiver::formatForPath(output, options.format);
+        }
+        
+        std::ofstream file;
+        if (!output.empty()) {
+            file.open(output, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                std::cerr << "Cannot write " << output << std::endl;
+                return 1;
+            }
+        }
+        std::ostream& stream = output.empty() ? std::cout : file;
+        mimirion::Archiver archiver(root, mimirion::Repository::findMimirionDir(root));
+        bool ok = archiver.write(revision, options, [&stream](const char* data, size_t size) {
+            stream.write(data, static_cast<std::streamsize>(size));
+            return stream.good();
+        });
+        stream.flush();
+        if (!ok && !output.empty()) {
+            file.close();
+            fs::remove(output);
+        }
+        return ok && stream.good() ? 0 : 1;
+    }
+    else if (command == "import-git") {
+        if (argc < 3) {
+            std::cerr << "Usage: mimirion import-git <path>" << std::endl;
+            return 1;
+        }
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 1;
+        }
+        
+        mimirion::GitImporter importer(root, mimirion::Repository::findMimirionDir(root));
+        mimirion::GitImportStats stats;
+        if (!importer.run(argv[2], &stats)) {
+            std::cerr << "Import failed" << std::endl;
+            return 1;
+        }
+        std::cout << "Imported " << stats.commits << " commits and " << stats.blobs
+                  << " blobs, updated " << stats.refs << " refs" << std::endl;
+        maintainInBackground(root);
+        return 0;
+    }
+    else if (command == "fast-import") {
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 1;
+        }
+        
+        mimirion::FastImporter importer(root, mimirion::Repository::findMimirionDir(root));
+        fs::path exportMarks;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--import-marks=", 0) == 0) {
+                if (!importer.importMarks(arg.substr(15))) {
+                    return 1;
+                }
+            } else if (arg.rfind("--export-marks=", 0) == 0) {
+                exportMarks = arg.substr(15);
+            } else {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return 1;
+            }
+        }
+        
+        // The stream is read in bulk; stdin need not stay in step with stdio
+        std::ios::sync_with_stdio(false);
+        mimirion::FastImportStats stats;
+        bool ok = importer.run(std::cin, &stats);
+        if (!exportMarks.empty() && !importer.exportMarks(exportMarks)) {
+            ok = false;
+        }
+        std::cout << "Imported " << stats.commits << " commits and " << stats.blobs
+                  << " blobs, updated " << stats.refs << " refs" << std::endl;
+        if (ok) {
+            maintainInBackground(root);
+        }
+        return ok ? 0 : 1;
+    }
+    else if (command == "export") {
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 1;
+        }
+        
+        // The stream goes to stdout, which may be a pipe into fast-import
+        std::ios::sync_with_stdio(false);
+        std::vector<std::string> revisions(argv + 2, argv + argc);
+        mimirion::FastExporter exporter(root, mimirion::Repository::findMimirionDir(root));
+        return exporter.run(revisions, std::cout) ? 0 : 1;
+    }
+    else if (command == "worktree") {
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 1;
+        }
+        
+        mimirion::WorktreeManager worktrees(root, mimirion::Repository::findMimirionDir(root));
+        std::string subcommand = argc > 2 ? argv[2] : "list";
+        if (subcommand == "add") {
+            if (argc < 5) {
+                std::cerr << "Usage: mimirion worktree add <path> <branch>" << std::endl;
+                return 1;
+            }
+            return worktrees.add(argv[3], argv[4]) ? 0 : 1;
+        }
+        else if (subcommand == "list") {
+            for (const auto& worktree : worktrees.list()) {
+                std::cout << worktree.path.string() << "  "
+                          << (worktree.head.empty() ? "(none)" : worktree.head.substr(0, 8)) << " ["
+                          << (worktree.branch.empty() ? "detached" : worktree.branch) << "]" << std::endl;
+            }
+            return 0;
+        }
+        else if (subcommand == "remove") {
+            bool force = argc > 3 && std::string(argv[3]) == "--force";
+            if (argc < (force ? 5 : 4)) {
+                std::cerr << "Usage: mimirion worktree remove [--force] <worktree>" << std::endl;
+                return 1;
+            }
+            return worktrees.remove(argv[force ? 4 : 3], force) ? 0 : 1;
+        }
+        else if (subcommand == "prune") {
+            std::cout << "Pruned " << worktrees.prune() << " worktrees" << std::endl;
+            return 0;
+        }
+        std::cerr << "Unknown worktree subcommand: " << subcommand << std::endl;
+        return 1;
+    }
+    else if (command == "alternates") {
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 1;
+        }
+        
+        mimirion::ObjectStore objects(mimirion::Repository::findMimirionDir(root));
+        std::string subcommand = argc > 2 ? argv[2] : "list";
+        if (subcommand == "add") {
+            if (argc < 4) {
+                std::cerr << "Usage: mimirion alternates add <repository>" << std::endl;
+                return 1;
+            }
+            // A repository root stands for its .mimirion, which may be a worktree link
+            fs::path source = argv[3];
+            if (fs::exists(source / ".mimirion")) {
+                source = mimirion::Repository::findMimirionDir(source);
+            }
+            return objects.addAlternate(source) ? 0 : 1;
+        }
+        else if (subcommand == "list") {
+            for (const auto& dir : objects.alternateDirs()) {
+                std::cout << dir.string() << std::endl;
+            }
+            return 0;
+        }
+        std::cerr << "Unknown alternates subcommand: " << subcommand << std::endl;
+        return 1;
+    }
+    else if (command == "fsck") {
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 1;
+        }
+        
+        mimirion::FsckOptions options;
+        bool progress = isatty(STDERR_FILENO);
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--budget=", 0) == 0) {
+                double seconds = std::strtod(arg.c_str() + 9, nullptr);
+                options.budget = std::chrono::milliseconds(static_cast<long long>(std::ceil(seconds * 1000)));
+            } else if (arg == "--progress") {
+                progress = true;
+            } else if (arg == "--no-progress") {
+                progress = false;
+            } else if (arg == "--no-connectivity") {
+                options.connectivity = false;
+            } else {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return 1;
+            }
+        }
+        if (progress) {
+            options.progress = [](const mimirion::FsckProgress& state) {
+                std::cerr << "\r" << state.phase << ": " << state.done;
+                if (state.total) {
+                    std::cerr << "/" << state.total << " (" << state.done * 100 / state.total << "%)";
+                }
+                if (state.bytes) {
+                    std::cerr << ", " << (state.bytes >> 20) << " MiB";
+                }
+                std::cerr << "   " << std::flush;
+            };
+        }
+        
+        mimirion::IntegrityChecker checker(root, mimirion::Repository::findMimirionDir(root));
+        mimirion::FsckReport report;
+        checker.run(options, &report);
+        if (progress) {
+            std::cerr << std::endl;
+        }
+        std::cout << "Checked " << report.objects << " of " << report.totalObjects << " objects ("
+                  << (report.bytes >> 20) << " MiB), " << report.commits << " commits reachable, "
+                  << report.dangling << " dangling" << std::endl;
+        if (report.errors()) {
+            std::cout << "Problems found: " << report.errors() << std::endl;
+            return 1;
+        }
+        if (!report.complete) {
+            std::cout << "Stopped early: the budget ran out" << std::endl;
+            return 2;
+        }
+        return 0;
+    }
+    else if (command == "rev-list") {
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 1;
+        }
+        
+        fs::path mimirionDir = mimirion::Repository::findMimirionDir(root);
+        mimirion::ObjectStore objects(mimirionDir);
+        mimirion::RefStore refs(mimirionDir);
+        bool listObjects = false;
+        bool count = false;
+        std::vector<std::string> include;
+        std::vector<std::string> exclude;
+        auto add = [&](const std::string& name, std::vector<std::string>& list) {
+            std::string hash = refs.resolve(name, &objects);
+            if (hash.empty()) {
+                std::cerr << "Unknown revision: " << name << std::endl;
+                return false;
+            }
+            list.push_back(hash);
+            return true;
+        };
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            size_t range = arg.find("..");
+            bool ok = true;
+            if (arg == "--objects") {
+                listObjects = true;
+            } else if (arg == "--count") {
+                count = true;
+            } else if (arg.rfind("--", 0) == 0) {
+                std::cerr << "Unknown option: " << arg << std::endl;
+                return 1;
+            } else if (arg[0] == '^') {
+                ok = add(arg.substr(1), exclude);
+            } else if (range != std::string::npos) {
+                ok = add(arg.substr(0, range), exclude) && add(arg.substr(range + 2), include);
+            } else {
+                ok = add(arg, include);
+            }
+            if (!ok) {
+                return 1;
+            }
+        }
+        if (include.empty()) {
+            std::cerr << "Usage: mimirion rev-list [--objects] [--count] <rev>... [^<rev>...]" << std::endl;
+            return 1;
+        }
+        
+        // Counting never needs the hashes, only the bitmaps
+        mimirion::ReachableObjects result;
+        if (!mimirion::BitmapIndex(mimirionDir).reachable(include, exclude, result, !count)) {
+            return 1;
+        }
+        if (count) {
+            std::cout << result.commits + (listObjects ? result.blobs : 0) << std::endl;
+            return 0;
+        }
+        for (const auto& hash : result.commitHashes) {
+            std::cout << hash << "\n";
+        }
+        if (listObjects) {
+            for (const auto& hash : result.blobHashes) {
+                std::cout << hash << "\n";
+            }
+        }
+        std::cout << std::flush;
+        return 0;
+    }
+    else if (command == "bitmap") {
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 1;
+        }
+        
+        mimirion::BitmapIndex index(mimirion::Repository::findMimirionDir(root));
+        std::string subcommand = argc > 2 ? argv[2] : "show";
+        if (subcommand == "write") {
+            mimirion::BitmapWriteStats stats;
+            if (!index.write(&stats)) {
+                return 1;
+            }
+            std::cout << "Wrote " << stats.bitmaps << " bitmaps over " << stats.objects << " objects ("
+                      << stats.commits << " commits, " << stats.bytes << " bytes)" << std::endl;
+            return 0;
+        }
+        else if (subcommand == "show") {
+            if (!index.loaded()) {
+                std::cout << "No reachability bitmaps" << std::endl;
+            } else {
+                std::cout << index.bitmapCount() << " bitmaps over " << index.objectCount() << " objects" << std::endl;
+            }
+            return 0;
+        }
+        std::cerr << "Unknown bitmap subcommand: " << subcommand << std::endl;
+        return 1;
+    }
+    else if (command == "maintenance") {
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 1;
+        }
+        
+        mimirion::MaintenanceManager maintenance(root, mimirion::Repository::findMimirionDir(root));
+        std::string subcommand = argc > 2 ? argv[2] : "run";
+        if (subcommand == "run") {
+            mimirion::MaintenanceOptions options;
+            bool detach = false;
+            for (int i = 3; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (arg == "--auto") {
+                    options.autoOnly = true;
+                } else if (arg.rfind("--task=", 0) == 0) {
+                    options.tasks.push_back(arg.substr(7));
+                } else if (arg.rfind("--budget=", 0) == 0) {
+                    double seconds = std::strtod(arg.c_str() + 9, nullptr);
+                    options.budget = std::chrono::milliseconds(static_cast<long long>(std::ceil(seconds * 1000)));
+                } else if (arg == "--detach") {
+                    detach = true;
+                } else {
+                    std::cerr << "Unknown option: " << arg << std::endl;
+                    return 1;
+                }
+            }
+            if (detach) {
+                if (!maintenance.spawn(options)) {
+                    std::cerr << "Failed to start maintenance in the background" << std::endl;
+                    return 1;
+                }
+                return 0;
+            }
+            
+            mimirion::MaintenanceReport report;
+            bool ok = maintenance.run(options, &report);
+            if (report.packedObjects) {
+                std::cout << "Packed " << report.packedObjects << " loose objects into "
+                          << report.packsWritten << " packs" << std::endl;
+            }
+            if (report.mergedPacks) {
+                std::cout << "Merged " << report.mergedPacks << " packs" << std::endl;
+            }
+            if (report.bitmapObjects) {
+                std::cout << "Wrote bitmaps over " << report.bitmapObjects << " objects" << std::endl;
+            }
+            if (report.unpackedObjects) {
+                std::cout << "Unpacked " << report.unpackedObjects << " unreachable objects" << std::endl;
+            }
+            if (report.prunedObjects || report.removedTemporaries) {
+                std::cout << "Pruned " << report.prunedObjects << " objects and "
+                          << report.removedTemporaries << " temporary files" << std::endl;
+            }
+            if (!ok) {
+                return 1;
+            }
+            if (!report.complete) {
+                std::cout << "Stopped early: the budget ran out" << std::endl;
+                return 2;
+            }
+            return 0;
+        }
+        else if (subcommand == "status") {
+            std::cout << "About " << maintenance.estimateLooseObjects() << " loose objects, "
+                      << maintenance.packCount() << " packs" << std::endl;
+            std::vector<std::string> due = maintenance.dueTasks();
+            std::cout << "Due:";
+            for (const auto& task : due) {
+                std::cout << " " << task;
+            }
+            std::cout << (due.empty() ? " nothing" : "") << std::endl;
+            if (long pid = maintenance.runningProcess()) {
+                std::cout << "Running as process " << pid << std::endl;
+            }
+            return 0;
+        }
+        std::cerr << "Unknown maintenance subcommand: " << subcommand << std::endl;
+        return 1;
+    }
+    else if (command == "batch") {
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 1;
+        }
+        
+        // -z switches requests and responses to NUL termination
+        char delimiter = (argc > 2 && std::string(argv[2]) == "-z") ? '\0' : '\n';
+        mimirion::BatchProcessor batch(root, mimirion::Repository::findMimirionDir(root));
+        batch.run(std::cin, std::cout, delimiter);
+        return 0;
+    }
+    else if (command == "daemon") {
+        fs::path root = mimirion::Repository::findRepositoryRoot(fs::current_path());
+        if (root.empty()) {
+            std::cerr << "Not a Mimirion repository" << std::endl;
+            return 1;
+        }
+        fs::path mimirionDir = mimirion::Repository::findMimirionDir(root);
+        
+        std::string subcommand = argc > 2 ? argv[2] : "";
+        if (subcommand == "stop") {
+            std::string output;
+            int exitCode = 0;
+            if (!mimirion::DaemonClient::forward(mimirionDir, {"shutdown"}, output, exitCode)) {
+                std::cerr << "No daemon is running for this repository" << std::endl;
+                return 1;
+            }
+            std::cout << output << std::endl;
+            return exitCode;
+        }
+        else if (subcommand == "status") {
+            bool isRunning = mimirion::DaemonClient::isRunning(mimirionDir);
+            std::cout << (isRunning ? "Daemon is running" : "Daemon is not running") << std::endl;
+            return isRunning ? 0 : 1;
+        }
+        else if (!subcommand.empty()) {
+            std::cerr << "Unknown daemon subcommand: " << subcommand << std::endl;
+            return 1;
+        }
+        
+        // Serve in the foreground until stopped
+        mimirion::Daemon daemon(root, mimirionDir);
+        if (!daemon.start()) {
+            return 1;
+        }
+        activeDaemon = &daemon;
+        std::signal(SIGINT, stopDaemon);
+        std::signal(SIGTERM, stopDaemon);
+        
+        std::cout << "Mimirion daemon listening on " << mimirion::Daemon::socketPath(mimirionDir) << std::endl;
+        daemon.serve();
+        activeDaemon = nullptr;
+        return 0;
+    }
     else if (command == "help") {
         printUsage();
         return 0;
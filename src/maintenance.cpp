@@ -0,0 +1,681 @@
+/**
+ * @file maintenance.cpp
+ * @brief Implementation of the MaintenanceManager class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/maintenance.hpp"
+#include "../include/bitmap.hpp"
+#include "../include/config.hpp"
+#include "../include/file_view.hpp"
+#include "../include/object_store.hpp"
+#include "../include/pack.hpp"
+#include "../include/utils.hpp"
+#include "../include/worktree.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_set>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace mimirion {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Loose objects are counted in one fan-out directory and scaled up
+const char kSampleDir[] = "17";
+
+// Background runs are niced this much
+constexpr int kNiceness = 10;
+
+bool isFanOut(const std::string& name) {
+    return name.size() == 2 && std::all_of(name.begin(), name.end(), [](char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+    });
+}
+
+bool olderThan(const fs::path& path, std::chrono::hours age) {
+    std::error_code ec;
+    auto written = fs::last_write_time(path, ec);
+    return !ec && written < fs::file_time_type::clock::now() - age;
+}
+
+// .mimirion/maintenance holds one key=value pair per line
+std::map<std::string, std::string> readState(const fs::path& path) {
+    std::map<std::string, std::string> state;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t equals = line.find('=');
+        if (equals != std::string::npos) {
+            state[line.substr(0, equals)] = line.substr(equals + 1);
+        }
+    }
+    return state;
+}
+
+bool writeState(const fs::path& path, const std::map<std::string, std::string>& state) {
+    std::string text;
+    for (const auto& [key, value] : state) {
+        text += key + "=" + value + "\n";
+    }
+    fs::path temp = path.string() + ".tmp";
+    std::error_code ec;
+    if (utils::writeFile(temp, text)) {
+        fs::rename(temp, path, ec);
+    } else {
+        ec = std::make_error_code(std::errc::io_error);
+    }
+    if (ec) {
+        std::cerr << "Failed to write " << path.string() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int64_t secondsSinceEpoch() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Packs of one store, smallest first
+std::vector<std::unique_ptr<PackFile>> openPacks(const fs::path& packDir) {
+    std::vector<std::unique_ptr<PackFile>> packs;
+    std::error_code ec;
+    for (fs::directory_iterator it(packDir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (name.compare(0, 5, "pack-") != 0 || it->path().extension() != ".idx") {
+            continue;
+        }
+        auto pack = std::make_unique<PackFile>();
+        if (pack->open(it->path())) {
+            packs.push_back(std::move(pack));
+        }
+    }
+    std::sort(packs.begin(), packs.end(), [](const auto& a, const auto& b) {
+        return a->size() != b->size() ? a->size() < b->size() : a->packPath() < b->packPath();
+    });
+    return packs;
+}
+
+// Holds .mimirion/maintenance.lock for the lifetime of the object. The
+// lock is a flock() on the file, which the kernel drops when its holder
+// dies; the process id written into it is only there to be reported
+class RunLock {
+public:
+    explicit RunLock(const fs::path& path) : path(path) {
+        // A holder removes the file when it is done, so a lock taken on an
+        // already removed file is no lock, and the file is opened again
+        for (int attempt = 0; attempt < 3 && fd < 0; ++attempt) {
+            int file = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+            if (file < 0) {
+                break;
+            }
+            if (::flock(file, LOCK_EX | LOCK_NB) != 0) {
+                ::close(file);
+                break;
+            }
+            struct stat opened;
+            struct stat current;
+            if (::fstat(file, &opened) == 0 && ::stat(path.c_str(), &current) == 0 &&
+                opened.st_dev == current.st_dev && opened.st_ino == current.st_ino) {
+                fd = file;
+            } else {
+                ::close(file);
+            }
+        }
+        if (fd >= 0) {
+            std::string pid = std::to_string(getpid()) + "\n";
+            if (::ftruncate(fd, 0) != 0 ||
+                ::pwrite(fd, pid.data(), pid.size(), 0) != static_cast<ssize_t>(pid.size())) {
+                std::cerr << "Failed to record the maintenance process id" << std::endl;
+            }
+        }
+    }
+
+    ~RunLock() {
+        if (fd >= 0) {
+            ::unlink(path.c_str());
+            ::close(fd);
+        }
+    }
+
+    RunLock(const RunLock&) = delete;
+    RunLock& operator=(const RunLock&) = delete;
+
+    bool isHeld() const { return fd >= 0; }
+
+    // Process id of the holder as it recorded it, 0 if that process is gone
+    static long holder(const fs::path& path) {
+        std::ifstream file(path);
+        long pid = 0;
+        if (!(file >> pid) || pid <= 0) {
+            return 0;
+        }
+        return ::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM ? pid : 0;
+    }
+
+private:
+    fs::path path;
+    int fd = -1;
+};
+
+class Maintainer {
+public:
+    Maintainer(const fs::path& repoPath, const fs::path& mimirionDir, const fs::path& mainDir,
+               const MaintenanceOptions& options, MaintenanceReport& report)
+        : repositoryPath(repoPath), mimirionDir(mimirionDir), mainDir(mainDir),
+          objectsDir(mainDir / "objects"), statePath(mainDir / "maintenance"), objects(mimirionDir),
+          report(report) {
+        if (options.budget.count() > 0) {
+            deadline = Clock::now() + options.budget;
+        }
+    }
+
+    bool run(const std::vector<std::string>& tasks) {
+        // Every run takes at least one step, however small its budget;
+        // tasks with nothing to do do not count
+        bool ok = true;
+        for (const auto& task : tasks) {
+            if (progressed && stopped()) {
+                break;
+            }
+            bool done = false;
+            if (task == "loose-objects") {
+                ok = packLooseObjects(done) && ok;
+            } else if (task == "bitmaps") {
+                ok = writeBitmaps(done) && ok;
+            } else if (task == "prune") {
+                ok = prune(done) && ok;
+            }
+            if (done) {
+                report.tasks.push_back(task);
+            }
+        }
+        report.complete = report.tasks.size() == tasks.size();
+        return ok;
+    }
+
+private:
+    fs::path repositoryPath;
+    fs::path mimirionDir;
+    fs::path mainDir;
+    fs::path objectsDir;
+    fs::path statePath;
+    ObjectStore objects;
+    MaintenanceReport& report;
+    Clock::time_point deadline;
+    std::unique_ptr<std::unordered_set<std::string>> reachable;
+    bool progressed = false;
+
+    bool stopped() const {
+        return deadline != Clock::time_point() && Clock::now() >= deadline;
+    }
+
+    // Everything the refs, the worktree HEADs and the indexes refer to;
+    // computed once and shared by the tasks of a run
+    const std::unordered_set<std::string>* reachableObjects() {
+        if (reachable) {
+            return reachable.get();
+        }
+        BitmapIndex index(mimirionDir);
+        ReachableObjects result;
+        if (!index.reachable(index.tips(), {}, result)) {
+            std::cerr << "Cannot tell which objects are reachable" << std::endl;
+            return nullptr;
+        }
+        auto set = std::make_unique<std::unordered_set<std::string>>();
+        set->insert(result.commitHashes.begin(), result.commitHashes.end());
+        set->insert(result.blobHashes.begin(), result.blobHashes.end());
+
+        // Index lines are path, working hash, committed hash and status
+        for (const auto& worktree : WorktreeManager(repositoryPath, mimirionDir).list()) {
+            fs::path dir = worktree.name.empty() ? mainDir : mainDir / "worktrees" / worktree.name;
+            std::ifstream file(dir / "index");
+            std::string line;
+            while (std::getline(file, line)) {
+                size_t first = line.find('\t');
+                size_t second = first == std::string::npos ? first : line.find('\t', first + 1);
+                size_t third = second == std::string::npos ? second : line.find('\t', second + 1);
+                if (third != std::string::npos) {
+                    set->insert(line.substr(first + 1, second - first - 1));
+                    set->insert(line.substr(second + 1, third - second - 1));
+                }
+            }
+        }
+        reachable = std::move(set);
+        return reachable.get();
+    }
+
+    // Loose objects of this store, fan-out directory by directory
+    std::vector<std::pair<std::string, fs::path>> listLooseObjects() const {
+        std::vector<std::pair<std::string, fs::path>> loose;
+        std::error_code ec;
+        for (fs::directory_iterator dir(objectsDir, ec), end; !ec && dir != end; dir.increment(ec)) {
+            std::string prefix = dir->path().filename().string();
+            if (!isFanOut(prefix)) {
+                continue;
+            }
+            std::error_code inner;
+            for (fs::directory_iterator it(dir->path(), inner); !inner && it != end; it.increment(inner)) {
+                std::string hash = prefix + it->path().filename().string();
+                if (ObjectStore::isValidHash(hash)) {
+                    loose.emplace_back(std::move(hash), it->path());
+                }
+            }
+        }
+        std::sort(loose.begin(), loose.end());
+        return loose;
+    }
+
+    // Moves the objects into place and only then lets go of their old copies
+    bool finishPack(PackWriter& writer, const std::vector<fs::path>& replaced) {
+        fs::path written;
+        if (writer.objectCount() > 0 && !writer.finish(&written)) {
+            return false;
+        }
+        if (!objects.sync()) {
+            return false;
+        }
+        std::error_code ec;
+        for (const auto& path : replaced) {
+            // A merge of packs the new one already contains may produce one of them again
+            if (path != written && path != fs::path(written).replace_extension(".pack")) {
+                fs::remove(path, ec);
+            }
+        }
+        return true;
+    }
+
+    // Writes the reachable objects of some packs into one new pack and
+    // turns the others back into loose objects, which prune removes once
+    // they are old; the old packs are removed last
+    bool rewritePacks(const std::vector<const PackFile*>& packs) {
+        const auto* wanted = reachableObjects();
+        if (!wanted) {
+            return false;
+        }
+        PackWriter writer(objectsDir / "pack");
+        std::unordered_set<std::string> added;
+        std::vector<fs::path> replaced;
+        for (const auto* pack : packs) {
+            for (size_t i = 0; i < pack->objectCount(); ++i) {
+                std::string hash = pack->hashAt(i);
+                if (!added.insert(hash).second) {
+                    continue;
+                }
+                bool ok = wanted->count(hash) ? writer.add(hash, pack->storedAt(i))
+                                              : unpack(hash, pack->storedAt(i));
+                if (!ok) {
+                    std::cerr << "Failed to rewrite packs" << std::endl;
+                    return false;
+                }
+            }
+            replaced.push_back(pack->indexPath());
+            replaced.push_back(pack->packPath());
+        }
+        if (!finishPack(writer, replaced)) {
+            std::cerr << "Failed to rewrite packs" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // The grace period starts now: a writer may just have reused the
+    // packed copy, and only loose objects can be freshened
+    bool unpack(const std::string& hash, std::string_view stored) {
+        fs::path path = objects.objectPath(hash);
+        std::error_code ec;
+        if (fs::exists(path, ec)) {
+            fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+            return true;
+        }
+        if (!objects.writeLoose(hash, stored)) {
+            return false;
+        }
+        ++report.unpackedObjects;
+        return true;
+    }
+
+    bool packLooseObjects(bool& done) {
+        const auto* wanted = reachableObjects();
+        if (!wanted) {
+            return false;
+        }
+
+        // Unreachable objects stay loose, for prune to decide on
+        std::vector<std::pair<std::string, fs::path>> loose = listLooseObjects();
+        auto writer = std::make_unique<PackWriter>(objectsDir / "pack");
+        std::vector<fs::path> packed;
+        bool ok = true;
+        bool finished = true;
+        for (size_t i = 0; i < loose.size() && ok; ++i) {
+            if (!wanted->count(loose[i].first)) {
+                continue;
+            }
+            if (progressed && stopped()) {
+                finished = false;
+                break;
+            }
+            FileView file(loose[i].second, FileView::Advice::SEQUENTIAL);
+            if (!file.isOpen()) {
+                continue;
+            }
+            ok = writer->add(loose[i].first, file.view());
+            packed.push_back(loose[i].second);
+            progressed = true;
+            if (ok && writer->objectCount() == MaintenanceManager::kPackObjects) {
+                ok = finishPack(*writer, packed);
+                report.packedObjects += packed.size();
+                ++report.packsWritten;
+                packed.clear();
+                writer = std::make_unique<PackWriter>(objectsDir / "pack");
+            }
+        }
+
+        // Whatever was added before the budget ran out is kept
+        if (ok && !packed.empty()) {
+            ok = finishPack(*writer, packed);
+            report.packedObjects += packed.size();
+            ++report.packsWritten;
+        }
+        if (!ok) {
+            std::cerr << "Failed to pack loose objects" << std::endl;
+            return false;
+        }
+        return !finished || mergePacks(done);
+    }
+
+    // A merge is one step: it is not started once the budget is spent
+    // and not interrupted
+    bool mergePacks(bool& done) {
+        auto packs = openPacks(objectsDir / "pack");
+        if (packs.size() <= MaintenanceManager::kMaxPacks) {
+            done = true;
+            return true;
+        }
+        if (progressed && stopped()) {
+            return true;
+        }
+
+        // The smallest packs are combined until half the limit remains
+        size_t merge = packs.size() - MaintenanceManager::kMaxPacks / 2 + 1;
+        std::vector<const PackFile*> merged;
+        for (size_t p = 0; p < merge; ++p) {
+            merged.push_back(packs[p].get());
+        }
+        if (!rewritePacks(merged)) {
+            return false;
+        }
+        report.mergedPacks += merge;
+        progressed = true;
+        done = true;
+        return true;
+    }
+
+    bool writeBitmaps(bool& done) {
+        // An index that covers every tip is left as it is
+        BitmapIndex index(mimirionDir);
+        BitmapWriteStats stats;
+        if (index.loaded() && index.unindexedCommits(1) == 0) {
+            done = true;
+            return true;
+        }
+        if (!index.write(&stats)) {
+            return false;
+        }
+        report.bitmapObjects = stats.objects;
+        progressed = true;
+        done = true;
+        return true;
+    }
+
+    // Removes files of a directory that are older than the grace period
+    // and that keep() does not claim
+    template <typename Keep>
+    size_t removeOld(const fs::path& dir, Keep keep) {
+        size_t removed = 0;
+        std::error_code ec;
+        for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+            std::error_code inner;
+            if (it->is_regular_file(inner) && !keep(it->path()) &&
+                olderThan(it->path(), MaintenanceManager::kPruneGrace) && fs::remove(it->path(), inner)) {
+                ++removed;
+            }
+        }
+        return removed;
+    }
+
+    bool prune(bool& done) {
+        const auto* wanted = reachableObjects();
+        if (!wanted) {
+            return false;
+        }
+
+        // Fan-out directories are pruned in order; the next one to do is
+        // remembered, so a run cut short by its budget is picked up later
+        auto state = readState(statePath);
+        int cursor = std::clamp(std::atoi(state["prune.cursor"].c_str()), 0, 256);
+        for (; cursor < 256; ++cursor) {
+            if (progressed && stopped()) {
+                state["prune.cursor"] = std::to_string(cursor);
+                return writeState(statePath, state);
+            }
+            char prefix[3];
+            std::snprintf(prefix, sizeof(prefix), "%02x", cursor);
+            report.prunedObjects += removeOld(objectsDir / prefix, [&](const fs::path& path) {
+                return wanted->count(prefix + path.filename().string()) != 0;
+            });
+            progressed = true;
+        }
+
+        // Packs holding objects nothing refers to any more are rewritten,
+        // one per step, so those objects become loose and age out too
+        for (const auto& pack : openPacks(objectsDir / "pack")) {
+            if (progressed && stopped()) {
+                state["prune.cursor"] = std::to_string(cursor);
+                return writeState(statePath, state);
+            }
+            bool garbage = false;
+            for (size_t i = 0; i < pack->objectCount() && !garbage; ++i) {
+                garbage = !wanted->count(pack->hashAt(i));
+            }
+            if (garbage) {
+                if (!rewritePacks({pack.get()})) {
+                    return false;
+                }
+                progressed = true;
+            }
+        }
+
+        // Writers that died left their temporary files behind
+        auto any = [](const fs::path&) { return false; };
+        auto finished = [](const fs::path& path) { return path.filename().string().compare(0, 5, "pack-") == 0; };
+        report.removedTemporaries += removeOld(objectsDir / "tmp", any);
+        report.removedTemporaries += removeOld(objectsDir / "pack", finished);
+
+        state.erase("prune.cursor");
+        state["prune.last"] = std::to_string(secondsSinceEpoch());
+        done = true;
+        return writeState(statePath, state);
+    }
+};
+
+} // namespace
+
+MaintenanceManager::MaintenanceManager(const fs::path& repoPath, const fs::path& mimirDir)
+    : repositoryPath(repoPath), mimirionDir(mimirDir), mainDir(WorktreeManager::commonDir(mimirDir)) {
+}
+
+const std::vector<std::string>& MaintenanceManager::taskNames() {
+    static const std::vector<std::string> names{"loose-objects", "bitmaps", "prune"};
+    return names;
+}
+
+size_t MaintenanceManager::estimateLooseObjects() const {
+    size_t count = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(mainDir / "objects" / kSampleDir, ec), end; !ec && it != end;
+         it.increment(ec)) {
+        ++count;
+    }
+    return count * 256;
+}
+
+size_t MaintenanceManager::packCount() const {
+    return openPacks(mainDir / "objects" / "pack").size();
+}
+
+std::vector<std::string> MaintenanceManager::dueTasks() const {
+    auto config = Config::load(mimirionDir);
+    int64_t looseLimit = config->getInt("maintenance.autoLooseObjects", kAutoLooseObjects);
+    int64_t commitLimit = config->getInt("maintenance.autoUnindexedCommits", kAutoUnindexedCommits);
+
+    std::vector<std::string> due;
+    if ((looseLimit > 0 && estimateLooseObjects() >= static_cast<size_t>(looseLimit)) || packCount() > kMaxPacks) {
+        due.push_back("loose-objects");
+    }
+    if (commitLimit > 0 &&
+        BitmapIndex(mimirionDir).unindexedCommits(static_cast<size_t>(commitLimit)) >= static_cast<size_t>(commitLimit)) {
+        due.push_back("bitmaps");
+    }
+
+    // Pruning walks the whole history, so it rides along with other work
+    auto state = readState(mainDir / "maintenance");
+    int64_t last = std::atoll(state["prune.last"].c_str());
+    int64_t interval = std::chrono::duration_cast<std::chrono::seconds>(kPruneInterval).count();
+    if (!due.empty() && (state.count("prune.cursor") || secondsSinceEpoch() - last >= interval)) {
+        due.push_back("prune");
+    }
+    return due;
+}
+
+bool MaintenanceManager::run(const MaintenanceOptions& options, MaintenanceReport* report) {
+    std::vector<std::string> tasks;
+    for (const auto& name : taskNames()) {
+        if (options.tasks.empty() || std::find(options.tasks.begin(), options.tasks.end(), name) != options.tasks.end()) {
+            tasks.push_back(name);
+        }
+    }
+    for (const auto& name : options.tasks) {
+        if (std::find(taskNames().begin(), taskNames().end(), name) == taskNames().end()) {
+            std::cerr << "Unknown maintenance task: " << name << std::endl;
+            return false;
+        }
+    }
+
+    RunLock lock(mainDir / "maintenance.lock");
+    if (!lock.isHeld()) {
+        std::cerr << "Maintenance is already running for this repository" << std::endl;
+        return false;
+    }
+    if (options.autoOnly) {
+        std::vector<std::string> due = dueTasks();
+        tasks.erase(std::remove_if(tasks.begin(), tasks.end(), [&](const std::string& name) {
+            return std::find(due.begin(), due.end(), name) == due.end();
+        }), tasks.end());
+    }
+
+    MaintenanceReport done;
+    Maintainer maintainer(repositoryPath, mimirionDir, mainDir, options, done);
+    bool ok = maintainer.run(tasks);
+    if (report) {
+        *report = done;
+    }
+    return ok;
+}
+
+bool MaintenanceManager::spawn(const MaintenanceOptions& options) const {
+#ifdef __linux__
+    // Everything the child needs is prepared first; between fork and exec
+    // only async-signal-safe calls are made
+    std::vector<std::string> args{"mimirion", "maintenance", "run"};
+    if (options.autoOnly) {
+        args.push_back("--auto");
+    }
+    for (const auto& task : options.tasks) {
+        args.push_back("--task=" + task);
+    }
+    if (options.budget.count() > 0) {
+        char budget[32];
+        std::snprintf(budget, sizeof(budget), "--budget=%.3f", options.budget.count() / 1000.0);
+        args.push_back(budget);
+    }
+    std::vector<char*> argv;
+    for (auto& arg : args) {
+        argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+    std::string directory = repositoryPath.string();
+
+    // Fork twice so the run is adopted by init and outlives the command
+    pid_t child = fork();
+    if (child < 0) {
+        return false;
+    }
+    if (child == 0) {
+        setsid();
+        if (fork() != 0) {
+            _exit(0);
+        }
+        setpriority(PRIO_PROCESS, 0, kNiceness);
+        // I/O priority class idle, for the whole process
+        syscall(SYS_ioprio_set, 1, 0, 3 << 13);
+        int null = ::open("/dev/null", O_RDWR);
+        if (null >= 0) {
+            dup2(null, STDIN_FILENO);
+            dup2(null, STDOUT_FILENO);
+            dup2(null, STDERR_FILENO);
+        }
+        if (chdir(directory.c_str()) == 0) {
+            execv("/proc/self/exe", argv.data());
+        }
+        _exit(127);
+    }
+    int status = 0;
+    while (waitpid(child, &status, 0) < 0 && errno == EINTR) {
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#else
+    // Without /proc/self/exe there is no reliable way to start this program again
+    (void)options;
+    return false;
+#endif
+}
+
+long MaintenanceManager::runningProcess() const {
+    return RunLock::holder(mainDir / "maintenance.lock");
+}
+
+bool MaintenanceManager::spawnIfDue() const {
+    auto config = Config::load(mimirionDir);
+    if (!config->getBool("maintenance.auto", true)) {
+        return false;
+    }
+    if (runningProcess() != 0 || dueTasks().empty()) {
+        return false;
+    }
+
+    MaintenanceOptions options;
+    options.autoOnly = true;
+    options.budget = std::chrono::seconds(config->getInt("maintenance.autoBudget", kAutoBudget.count()));
+    return spawn(options);
+}
+
+} // namespace mimirion
@@ -0,0 +1,791 @@
+/**
+ * @file object_store.cpp
+ * @brief Implementation of the ObjectStore class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/object_store.hpp"
+#include "../include/utils.hpp"
+#include "../include/config.hpp"
+#include "../include/file_view.hpp"
+#include "../include/pack.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+#include <iostream>
+#include <unordered_set>
+#include <vector>
+
+namespace mimirion {
+
+namespace {
+
+// Cached object bytes kept before the cache is emptied
+constexpr size_t kMaxCacheBytes = 64 * 1024 * 1024;
+
+// Larger zlib objects are compressed straight to disk
+constexpr size_t kStreamThreshold = 4 * 1024 * 1024;
+
+// Pieces in which stored objects are handed to readStream() sinks
+constexpr size_t kReadChunkSize = 64 * 1024;
+
+// Objects up to this size are compressed with the trained dictionary
+constexpr size_t kDictionaryObjectLimit = 64 * 1024;
+
+// Training samples: objects in this size range, up to this many bytes
+constexpr size_t kMinSampleSize = 16;
+constexpr size_t kMaxSampleSize = 16 * 1024;
+constexpr size_t kMaxSampleBytes = 8 * 1024 * 1024;
+
+// Reads the objects directories an objects directory's alternates file lists
+std::vector<fs::path> readAlternates(const fs::path& dir) {
+    std::vector<fs::path> dirs;
+    std::ifstream file(dir / "info" / "alternates");
+    std::string line;
+    while (std::getline(file, line)) {
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        fs::path path = line;
+        dirs.push_back(path.is_relative() ? dir / path : path);
+    }
+    return dirs;
+}
+
+CompressionLevel parseLevel(const std::string& name) {
+    if (name == "best") {
+        return CompressionLevel::BEST;
+    }
+    if (name == "default") {
+        return CompressionLevel::DEFAULT;
+    }
+    return CompressionLevel::FAST;
+}
+
+} // namespace
+
+ObjectStore::ObjectStore(const fs::path& mimirionDir)
+    : objectsDir(mimirionDir / "objects"), cacheBytes(0),
+      codec(Codec::find(CodecId::ZLIB)), level(CompressionLevel::FAST), dictionaryId(0) {
+    auto config = Config::load(mimirionDir);
+
+    std::string codecName = config->getString("core.compression", "zlib");
+    if (const Codec* configured = Codec::find(codecName)) {
+        codec = configured;
+    } else {
+        std::cerr << "Compression codec '" << codecName
+                  << "' is not available, using zlib" << std::endl;
+    }
+    level = parseLevel(config->getString("core.compressionLevel", "fast"));
+    loadAlternates();
+    packs = std::make_shared<const PackSet>();
+    refreshPacks();
+
+    // The current dictionary is named by objects/info/dictionaries/current
+    if (codec->supportsDictionaries() && config->getBool("core.compressionDictionary", true)) {
+        std::ifstream current(objectsDir / "info" / "dictionaries" / "current");
+        std::string id;
+        if (current && std::getline(current, id) && !id.empty()) {
+            uint32_t parsed = static_cast<uint32_t>(std::strtoul(id.c_str(), nullptr, 16));
+            if (loadDictionary(*codec, parsed)) {
+                dictionaryId = parsed;
+            }
+        }
+    }
+}
+
+void ObjectStore::loadAlternates() {
+    alternates.clear();
+    std::vector<fs::path> level = readAlternates(objectsDir);
+    if (level.empty()) {
+        return;
+    }
+
+    // Breadth first, so nearer stores are searched first
+    std::error_code ec;
+    std::unordered_set<std::string> seen{fs::weakly_canonical(objectsDir, ec).string()};
+    for (int depth = 0; depth < kMaxAlternateDepth && !level.empty(); ++depth) {
+        std::vector<fs::path> next;
+        for (const auto& alternate : level) {
+            fs::path canonical = fs::weakly_canonical(alternate, ec);
+            if (ec || !fs::is_directory(canonical, ec)) {
+                std::cerr << "Alternate object store " << alternate.string() << " does not exist" << std::endl;
+                continue;
+            }
+            if (seen.insert(canonical.string()).second) {
+                alternates.push_back(canonical);
+                for (auto& further : readAlternates(canonical)) {
+                    next.push_back(std::move(further));
+                }
+            }
+        }
+        level = std::move(next);
+    }
+}
+
+bool ObjectStore::addAlternate(const fs::path& dir) {
+    std::error_code ec;
+    fs::path target = fs::is_directory(dir / "objects", ec) ? dir / "objects" : dir;
+    fs::path canonical = fs::weakly_canonical(target, ec);
+    if (ec || !fs::is_directory(canonical, ec)) {
+        std::cerr << "Not an object store: " << dir.string() << std::endl;
+        return false;
+    }
+    if (canonical == fs::weakly_canonical(objectsDir, ec)) {
+        std::cerr << "An object store cannot be its own alternate" << std::endl;
+        return false;
+    }
+    for (const auto& existing : readAlternates(objectsDir)) {
+        if (fs::weakly_canonical(existing, ec) == canonical) {
+            return true;
+        }
+    }
+
+    fs::path file = objectsDir / "info" / "alternates";
+    fs::create_directories(file.parent_path(), ec);
+    std::ofstream out(file, std::ios::app);
+    out << canonical.string() << '\n';
+    if (!out) {
+        std::cerr << "Failed to update " << file.string() << std::endl;
+        return false;
+    }
+    out.close();
+    loadAlternates();
+    refreshPacks();
+    return true;
+}
+
+const std::vector<fs::path>& ObjectStore::alternateDirs() const {
+    return alternates;
+}
+
+bool ObjectStore::locate(const std::string& hash, fs::path& path) const {
+    std::error_code ec;
+    path = objectPath(hash);
+    if (fs::is_regular_file(path, ec)) {
+        return true;
+    }
+    for (const auto& dir : alternates) {
+        fs::path candidate = dir / hash.substr(0, 2) / hash.substr(2);
+        if (fs::is_regular_file(candidate, ec)) {
+            path = std::move(candidate);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ObjectStore::freshen(const std::string& hash) const {
+    fs::path path;
+    if (!locate(hash, path)) {
+        return false;
+    }
+
+    // A loose object that is about to be used again must not look like
+    // old garbage to maintenance; alternates are left alone
+    if (path == objectPath(hash)) {
+        std::error_code ec;
+        fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    }
+    return true;
+}
+
+bool ObjectStore::refreshPacks() const {
+    std::vector<fs::path> dirs{objectsDir / "pack"};
+    for (const auto& dir : alternates) {
+        dirs.push_back(dir / "pack");
+    }
+    std::vector<fs::file_time_type> stamps;
+    for (const auto& dir : dirs) {
+        std::error_code ec;
+        auto stamp = fs::last_write_time(dir, ec);
+        stamps.push_back(ec ? fs::file_time_type::min() : stamp);
+    }
+
+    // Renaming a pack into place or removing one touches its directory
+    auto current = std::atomic_load(&packs);
+    if (current->stamps == stamps) {
+        return false;
+    }
+
+    // Packs that are still there stay open
+    std::unordered_map<std::string, std::shared_ptr<const PackFile>> open;
+    for (const auto& pack : current->files) {
+        open[pack->indexPath().string()] = pack;
+    }
+    auto next = std::make_shared<PackSet>();
+    next->stamps = std::move(stamps);
+    for (const auto& dir : dirs) {
+        std::vector<fs::path> indexes;
+        std::error_code ec;
+        for (fs::directory_iterator it(dir, ec), end; it != end && !ec; it.increment(ec)) {
+            // Unfinished packs have a temporary name
+            std::string name = it->path().filename().string();
+            if (name.compare(0, 5, "pack-") == 0 && it->path().extension() == ".idx") {
+                indexes.push_back(it->path());
+            }
+        }
+        std::sort(indexes.begin(), indexes.end());
+        for (const auto& index : indexes) {
+            auto found = open.find(index.string());
+            if (found != open.end()) {
+                next->files.push_back(found->second);
+                continue;
+            }
+            auto pack = std::make_shared<PackFile>();
+            if (pack->open(index)) {
+                next->files.push_back(std::move(pack));
+            } else {
+                std::cerr << "Ignoring corrupt pack " << index.string() << std::endl;
+            }
+        }
+    }
+    std::atomic_store(&packs, std::shared_ptr<const PackSet>(std::move(next)));
+    return true;
+}
+
+bool ObjectStore::findPacked(const std::string& hash) const {
+    auto current = std::atomic_load(&packs);
+    std::string_view stored;
+    for (const auto& pack : current->files) {
+        if (pack->find(hash, stored)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ObjectStore::openStored(const std::string& hash, Stored& stored) const {
+    // A loose object may be packed and removed between the lookup and the
+    // open, so a miss rescans the packs and looks once more; another
+    // thread may already have swapped in the new packs
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        stored.packs = std::atomic_load(&packs);
+        for (const auto& pack : stored.packs->files) {
+            if (pack->find(hash, stored.bytes)) {
+                return true;
+            }
+        }
+        fs::path path;
+        if (locate(hash, path) && stored.file.open(path, FileView::Advice::SEQUENTIAL)) {
+            stored.bytes = stored.file.view();
+            return true;
+        }
+        if (!refreshPacks() && std::atomic_load(&packs) == stored.packs) {
+            break;
+        }
+    }
+    return false;
+}
+
+bool ObjectStore::isValidHash(const std::string& hash) {
+    if (hash.length() < 4) {
+        return false;
+    }
+    for (char c : hash) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+fs::path ObjectStore::objectPath(const std::string& hash) const {
+    return objectsDir / hash.substr(0, 2) / hash.substr(2);
+}
+
+bool ObjectStore::hasObject(const std::string& hash) const {
+    if (!isValidHash(hash)) {
+        return false;
+    }
+    if (cache.find(hash) != cache.end()) {
+        return true;
+    }
+    // Taken before the loose lookup, see openStored
+    auto seen = std::atomic_load(&packs);
+    fs::path path;
+    return findPacked(hash) || locate(hash, path) ||
+           ((refreshPacks() || std::atomic_load(&packs) != seen) && findPacked(hash));
+}
+
+bool ObjectStore::objectSize(const std::string& hash, uint64_t& size) const {
+    Stored stored;
+    if (!isValidHash(hash) || !openStored(hash, stored)) {
+        return false;
+    }
+    ObjectHeader header;
+    if (!ObjectHeader::decode(stored.bytes, header)) {
+        return false;
+    }
+    size = header.size;
+    return true;
+}
+
+std::shared_ptr<const std::string> ObjectStore::readObject(const std::string& hash) {
+    auto it = cache.find(hash);
+    if (it != cache.end()) {
+        return it->second;
+    }
+
+    Stored stored;
+    if (!isValidHash(hash) || !openStored(hash, stored)) {
+        return nullptr;
+    }
+
+    // Decode straight from the file's pages, without an intermediate copy
+    std::string decoded;
+    if (!decodeObject(stored.bytes, decoded)) {
+        std::cerr << "Failed to decode object " << hash << std::endl;
+        return nullptr;
+    }
+    auto content = std::make_shared<const std::string>(std::move(decoded));
+
+    // Keep the cache bounded; callers still own the buffers they were handed
+    if (cacheBytes + content->size() > kMaxCacheBytes) {
+        clearCache();
+    }
+    cacheBytes += content->size();
+    cache[hash] = content;
+    return content;
+}
+
+std::string ObjectStore::writeObject(const std::string& content) {
+    std::string hash = utils::sha256(content);
+    return storeObject(hash, content) ? hash : "";
+}
+
+std::string ObjectStore::writeFile(const fs::path& path, ScanResult* result) {
+    FileView file(path, FileView::Advice::SEQUENTIAL);
+    if (!file.isOpen()) {
+        std::cerr << "Failed to read " << path.string() << std::endl;
+        return "";
+    }
+
+    ScanResult scan = FileScanner::scanBuffer(file.view());
+    if (result) {
+        *result = scan;
+    }
+
+    // Unchanged content is never compressed a second time
+    if (findPacked(scan.hash) || freshen(scan.hash)) {
+        return scan.hash;
+    }
+
+    bool stored = codec->id() == CodecId::ZLIB && file.size() > kStreamThreshold
+                      ? streamObject(scan.hash, file.view())
+                      : storeObject(scan.hash, file.view());
+    return stored ? scan.hash : "";
+}
+
+bool ObjectStore::streamObject(const std::string& hash, std::string_view content) {
+    // Stream to the side and rename, so the object never appears half written
+    fs::path temp = temporaryPath();
+    std::ofstream out(temp, std::ios::binary);
+    if (!out) {
+        std::cerr << "Failed to write object " << hash << std::endl;
+        return false;
+    }
+
+    ObjectHeader header;
+    header.codec = CodecId::ZLIB;
+    header.size = content.size();
+    std::string encodedHeader;
+    header.encode(encodedHeader);
+    out.write(encodedHeader.data(), encodedHeader.size());
+
+    Compressor compressor(level);
+    auto sink = [&out](const char* data, size_t size) {
+        out.write(data, static_cast<std::streamsize>(size));
+        return out.good();
+    };
+    bool ok = compressor.write(content.data(), content.size(), sink) && compressor.finish(sink);
+    out.close();
+    ok = ok && out.good();
+
+    std::error_code ec;
+    fs::path target;
+    if (ok && !findPacked(hash) && !locate(hash, target)) {
+        target = objectPath(hash);
+        fs::create_directories(target.parent_path(), ec);
+        fs::rename(temp, target, ec);
+        ok = !ec;
+    }
+    fs::remove(temp, ec);
+
+    if (!ok) {
+        std::cerr << "Failed to write object " << hash << std::endl;
+    }
+    return ok;
+}
+
+std::string ObjectStore::writeStream(const std::function<bool(const CompressionSink&)>& producer,
+                                     ScanResult* result) {
+    fs::path temp = temporaryPath();
+    std::ofstream out(temp, std::ios::binary);
+    if (!out) {
+        std::cerr << "Failed to write object" << std::endl;
+        return "";
+    }
+
+    // The header records the content size, so it is rewritten at the end
+    ObjectHeader header;
+    header.codec = CodecId::ZLIB;
+    std::string encodedHeader;
+    header.encode(encodedHeader);
+    out.write(encodedHeader.data(), encodedHeader.size());
+
+    Compressor compressor(level);
+    ScanStream scan;
+    auto fileSink = [&out](const char* data, size_t size) {
+        out.write(data, static_cast<std::streamsize>(size));
+        return out.good();
+    };
+    auto contentSink = [&](const char* data, size_t size) {
+        scan.update(data, size);
+        return compressor.write(data, size, fileSink);
+    };
+    bool ok = producer(contentSink) && compressor.finish(fileSink);
+    ScanResult scanned = scan.finish();
+    if (ok) {
+        header.size = scanned.size;
+        encodedHeader.clear();
+        header.encode(encodedHeader);
+        out.seekp(0);
+        out.write(encodedHeader.data(), encodedHeader.size());
+    }
+    out.close();
+    ok = ok && out.good();
+
+    std::error_code ec;
+    fs::path target;
+    if (ok && !findPacked(scanned.hash) && !locate(scanned.hash, target)) {
+        target = objectPath(scanned.hash);
+        fs::create_directories(target.parent_path(), ec);
+        fs::rename(temp, target, ec);
+        ok = !ec;
+    }
+    fs::remove(temp, ec);
+
+    if (!ok) {
+        std::cerr << "Failed to write object" << std::endl;
+        return "";
+    }
+    if (result) {
+        *result = scanned;
+    }
+    return scanned.hash;
+}
+
+bool ObjectStore::readStream(const std::string& hash, const CompressionSink& sink) {
+    Stored object;
+    if (!isValidHash(hash) || !openStored(hash, object)) {
+        return false;
+    }
+
+    std::string_view stored = object.bytes;
+    ObjectHeader header;
+    bool streamable = ObjectHeader::decode(stored, header) && header.dictionaryId == 0 &&
+                      (header.codec == CodecId::ZLIB || header.codec == CodecId::RAW);
+    if (!streamable) {
+        std::string content;
+        if (!decodeObject(stored, content)) {
+            std::cerr << "Failed to decode object " << hash << std::endl;
+            return false;
+        }
+        return sink(content.data(), content.size());
+    }
+
+    stored.remove_prefix(ObjectHeader::kSize);
+    uint64_t produced = 0;
+    auto counted = [&](const char* data, size_t size) {
+        produced += size;
+        return sink(data, size);
+    };
+
+    Decompressor decompressor;
+    bool raw = header.codec == CodecId::RAW;
+    for (size_t offset = 0; offset < stored.size(); offset += kReadChunkSize) {
+        std::string_view chunk = stored.substr(offset, kReadChunkSize);
+        bool ok = raw ? counted(chunk.data(), chunk.size())
+                      : decompressor.write(chunk.data(), chunk.size(), counted);
+        if (!ok) {
+            return false;
+        }
+    }
+    if ((!raw && !decompressor.finished()) || produced != header.size) {
+        std::cerr << "Failed to decode object " << hash << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ObjectStore::storeObject(const std::string& hash, std::string_view content) {
+    // Objects are immutable, an existing file already has this content,
+    // and one in an alternate does not need a local copy
+    if (findPacked(hash) || freshen(hash)) {
+        return true;
+    }
+
+    std::string encoded = encodeObject(content);
+    if (encoded.empty() || !writeLoose(hash, encoded)) {
+        std::cerr << "Failed to write object " << hash << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ObjectStore::writeLoose(const std::string& hash, std::string_view encoded) {
+    fs::path temp = temporaryPath();
+    std::ofstream out(temp, std::ios::binary);
+    out.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+    out.close();
+    bool ok = out.good();
+
+    std::error_code ec;
+    if (ok) {
+        fs::path target = objectPath(hash);
+        fs::create_directories(target.parent_path(), ec);
+        fs::rename(temp, target, ec);
+        ok = !ec;
+    }
+    fs::remove(temp, ec);
+    return ok;
+}
+
+std::string ObjectStore::encodeObject(std::string_view content) {
+    ObjectHeader header;
+    header.codec = codec->id();
+    header.size = content.size();
+    if (dictionaryId != 0 && content.size() <= kDictionaryObjectLimit) {
+        header.dictionaryId = dictionaryId;
+    }
+
+    std::string payload;
+    if (!codec->compress(content, payload, level, header.dictionaryId)) {
+        return "";
+    }
+
+    // Incompressible content is cheaper to keep as it is
+    std::string_view body = payload;
+    if (payload.size() >= content.size()) {
+        header.codec = CodecId::RAW;
+        header.dictionaryId = 0;
+        body = content;
+    }
+
+    std::string encoded;
+    encoded.reserve(ObjectHeader::kSize + body.size());
+    header.encode(encoded);
+    encoded += body;
+    return encoded;
+}
+
+bool ObjectStore::decodeObject(std::string_view stored, std::string& content) {
+    ObjectHeader header;
+    if (!ObjectHeader::decode(stored, header)) {
+        // Written before object headers existed: a zlib stream or raw bytes
+        if (!Decompressor::looksCompressed(stored) || !Decompressor::decompress(stored, content)) {
+            content.assign(stored.data(), stored.size());
+        }
+        return true;
+    }
+
+    const Codec* objectCodec = Codec::find(header.codec);
+    if (!objectCodec) {
+        std::cerr << "Object uses codec " << static_cast<int>(header.codec)
+                  << ", which this build does not support" << std::endl;
+        return false;
+    }
+    if (header.dictionaryId != 0 && !loadDictionary(*objectCodec, header.dictionaryId)) {
+        std::cerr << "Missing compression dictionary " << std::hex << header.dictionaryId
+                  << std::dec << std::endl;
+        return false;
+    }
+
+    stored.remove_prefix(ObjectHeader::kSize);
+    return objectCodec->decompress(stored, content, header.size, header.dictionaryId) &&
+           content.size() == header.size;
+}
+
+uint32_t ObjectStore::trainDictionary(size_t maxSize) {
+    const Codec* zstd = Codec::find(CodecId::ZSTD);
+    if (!zstd) {
+        std::cerr << "Dictionaries need zstd, which this build does not include" << std::endl;
+        return 0;
+    }
+
+    // Sample the small objects, which benefit most from a dictionary
+    std::vector<std::string> samples;
+    size_t sampleBytes = 0;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(objectsDir, ec), end; it != end && !ec; it.increment(ec)) {
+        if (it.depth() == 0 && it->is_directory() && it->path().filename().string().size() != 2) {
+            // Skip info/ and anything else that is not an object directory
+            it.disable_recursion_pending();
+            continue;
+        }
+        if (!it->is_regular_file() || it->file_size() > kMaxSampleSize * 4) {
+            continue;
+        }
+
+        std::string content;
+        if (!decodeObject(utils::readFile(it->path()), content) ||
+            content.size() < kMinSampleSize || content.size() > kMaxSampleSize) {
+            continue;
+        }
+        sampleBytes += content.size();
+        samples.push_back(std::move(content));
+        if (sampleBytes >= kMaxSampleBytes) {
+            break;
+        }
+    }
+
+    // Packed objects are sampled once the loose ones run out
+    for (const auto& pack : std::atomic_load(&packs)->files) {
+        for (size_t i = 0; i < pack->objectCount() && sampleBytes < kMaxSampleBytes; ++i) {
+            std::string_view stored = pack->storedAt(i);
+            std::string content;
+            if (stored.size() > kMaxSampleSize * 4 || !decodeObject(stored, content) ||
+                content.size() < kMinSampleSize || content.size() > kMaxSampleSize) {
+                continue;
+            }
+            sampleBytes += content.size();
+            samples.push_back(std::move(content));
+        }
+    }
+
+    std::string dictionary = zstd->trainDictionary(samples, maxSize);
+    uint32_t id = dictionary.empty() ? 0 : zstd->addDictionary(dictionary);
+    if (id == 0) {
+        std::cerr << "Dictionary training failed (" << samples.size()
+                  << " samples); the repository may have too few small objects" << std::endl;
+        return 0;
+    }
+
+    char name[16];
+    std::snprintf(name, sizeof(name), "%08x", id);
+    if (!utils::writeFile(dictionaryPath(id), dictionary) ||
+        !utils::writeFile(objectsDir / "info" / "dictionaries" / "current", std::string(name) + "\n")) {
+        std::cerr << "Failed to store dictionary " << name << std::endl;
+        return 0;
+    }
+
+    if (codec == zstd) {
+        dictionaryId = id;
+    }
+    return id;
+}
+
+const Codec& ObjectStore::writeCodec() const {
+    return *codec;
+}
+
+uint32_t ObjectStore::writeDictionary() const {
+    return dictionaryId;
+}
+
+fs::path ObjectStore::dictionaryPath(uint32_t id) const {
+    char name[16];
+    std::snprintf(name, sizeof(name), "%08x", id);
+    return objectsDir / "info" / "dictionaries" / name;
+}
+
+fs::path ObjectStore::temporaryPath() const {
+    // Unique across processes and across stores within this process
+    static std::atomic<unsigned> counter{0};
+    fs::path dir = objectsDir / "tmp";
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    return dir / (std::to_string(getpid()) + "-" + std::to_string(counter++));
+}
+
+bool ObjectStore::loadDictionary(const Codec& dictionaryCodec, uint32_t id) {
+    if (dictionaryCodec.hasDictionary(id)) {
+        return true;
+    }
+
+    // Objects borrowed from an alternate may use one of its dictionaries
+    fs::path path = dictionaryPath(id);
+    for (size_t i = 0; !fs::is_regular_file(path) && i < alternates.size(); ++i) {
+        path = alternates[i] / "info" / "dictionaries" / path.filename();
+    }
+    if (!fs::is_regular_file(path)) {
+        return false;
+    }
+    return dictionaryCodec.addDictionary(utils::readFile(path)) == id;
+}
+
+std::string ObjectStore::resolvePrefix(const std::string& prefix) const {
+    if (!isValidHash(prefix)) {
+        return "";
+    }
+
+    // Every store may hold matches; the same object in two counts once
+    std::string rest = prefix.substr(2);
+    std::string match;
+    std::vector<fs::path> dirs{objectsDir};
+    dirs.insert(dirs.end(), alternates.begin(), alternates.end());
+    for (const auto& objects : dirs) {
+        fs::path dir = objects / prefix.substr(0, 2);
+        std::error_code ec;
+        for (fs::directory_iterator it(dir, ec), end; it != end && !ec; it.increment(ec)) {
+            std::string name = it->path().filename().string();
+            if (name.compare(0, rest.size(), rest) != 0) {
+                continue;
+            }
+            std::string hash = prefix.substr(0, 2) + name;
+            if (!match.empty() && match != hash) {
+                // Ambiguous prefix
+                return "";
+            }
+            match = hash;
+        }
+    }
+
+    refreshPacks();
+    std::vector<std::string> packed;
+    for (const auto& pack : std::atomic_load(&packs)->files) {
+        pack->findPrefix(prefix, packed);
+    }
+    for (const auto& hash : packed) {
+        if (!match.empty() && match != hash) {
+            return "";
+        }
+        match = hash;
+    }
+    return match;
+}
+
+void ObjectStore::clearCache() {
+    cache.clear();
+    cacheBytes = 0;
+}
+
+bool ObjectStore::sync() const {
+    int fd = ::open(objectsDir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return false;
+    }
+#ifdef __linux__
+    // One call flushes every object on the file system
+    bool ok = ::syncfs(fd) == 0;
+#else
+    ::sync();
+    bool ok = true;
+#endif
+    ::close(fd);
+    if (!ok) {
+        std::cerr << "Failed to flush objects to disk" << std::endl;
+    }
+    return ok;
+}
+
+} // namespace mimirion
@@ -0,0 +1,262 @@
+/**
+ * @file pack.cpp
+ * @brief Implementation of the PackFile and PackWriter classes
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/pack.hpp"
+#include "../include/scanner.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <unistd.h>
+
+namespace mimirion {
+
+namespace {
+
+const char kPackMagic[] = {'M', 'P', 'A', 'K'};
+const char kIndexMagic[] = {'M', 'I', 'D', 'X'};
+constexpr uint32_t kVersion = 1;
+
+// magic, version, object count, reserved
+constexpr size_t kHeaderSize = 16;
+constexpr size_t kHashBytes = 32;
+
+void put32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+void put64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+uint64_t get(std::string_view data, size_t offset, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(data[offset + i])) << (8 * i);
+    }
+    return value;
+}
+
+// Raw bytes of a hex hash; odd trailing digits are dropped
+std::string toRaw(const std::string& hex) {
+    auto nibble = [](char c) { return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10; };
+    std::string raw;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        raw.push_back(static_cast<char>(nibble(hex[i]) << 4 | nibble(hex[i + 1])));
+    }
+    return raw;
+}
+
+std::string toHex(std::string_view raw) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(raw.size() * 2);
+    for (unsigned char byte : raw) {
+        hex += digits[byte >> 4];
+        hex += digits[byte & 15];
+    }
+    return hex;
+}
+
+std::string header(const char* magic, size_t count) {
+    std::string out(magic, 4);
+    put32(out, kVersion);
+    put32(out, static_cast<uint32_t>(count));
+    put32(out, 0);
+    return out;
+}
+
+std::string checksumOf(std::string_view data) {
+    ScanStream scan;
+    scan.update(data.data(), data.size());
+    return scan.finish().hash;
+}
+
+} // namespace
+
+bool PackFile::open(const fs::path& idx) {
+    index = idx;
+    pack = fs::path(idx).replace_extension(".pack");
+    if (!indexView.open(index, FileView::Advice::RANDOM) || !packView.open(pack, FileView::Advice::RANDOM)) {
+        return false;
+    }
+
+    std::string_view table = indexView.view();
+    std::string_view data = packView.view();
+    if (table.size() < kHeaderSize + 2 * kHashBytes || data.size() < kHeaderSize + kHashBytes ||
+        !std::equal(kIndexMagic, kIndexMagic + 4, table.data()) || get(table, 4, 4) != kVersion ||
+        !std::equal(kPackMagic, kPackMagic + 4, data.data()) || get(data, 4, 4) != kVersion) {
+        return false;
+    }
+    count = static_cast<size_t>(get(table, 8, 4));
+    // Entries are only bounds-checked by verify(); slices are clamped to
+    // the file, so a damaged entry reads as a corrupt object
+    return get(data, 8, 4) == count && table.size() == kHeaderSize + count * kEntrySize + 2 * kHashBytes;
+}
+
+size_t PackFile::lowerBound(const std::string& raw) const {
+    const char* table = indexView.data() + kHeaderSize;
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (std::memcmp(table + middle * kEntrySize, raw.data(), raw.size()) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+bool PackFile::find(const std::string& hash, std::string_view& stored) const {
+    if (hash.size() != 2 * kHashBytes) {
+        return false;
+    }
+    std::string raw = toRaw(hash);
+    size_t at = lowerBound(raw);
+    if (at == count || std::memcmp(indexView.data() + kHeaderSize + at * kEntrySize, raw.data(), kHashBytes) != 0) {
+        return false;
+    }
+    stored = storedAt(at);
+    return true;
+}
+
+void PackFile::findPrefix(const std::string& prefix, std::vector<std::string>& matches) const {
+    for (size_t at = lowerBound(toRaw(prefix)); at < count; ++at) {
+        std::string hash = hashAt(at);
+        if (hash.compare(0, prefix.size(), prefix) != 0) {
+            break;
+        }
+        matches.push_back(std::move(hash));
+    }
+}
+
+std::string PackFile::hashAt(size_t i) const {
+    return toHex(indexView.view(kHeaderSize + i * kEntrySize, kHashBytes));
+}
+
+std::string_view PackFile::storedAt(size_t i) const {
+    size_t at = kHeaderSize + i * kEntrySize + kHashBytes;
+    std::string_view table = indexView.view();
+    return packView.view(static_cast<size_t>(get(table, at, 8)), static_cast<size_t>(get(table, at + 8, 8)));
+}
+
+bool PackFile::verify() const {
+    std::string_view data = packView.view();
+    std::string_view table = indexView.view();
+    std::string trailer = toHex(data.substr(data.size() - kHashBytes));
+    uint64_t end = data.size() - kHashBytes;
+    for (size_t i = 0; i < count; ++i) {
+        size_t at = kHeaderSize + i * kEntrySize + kHashBytes;
+        uint64_t offset = get(table, at, 8);
+        uint64_t length = get(table, at + 8, 8);
+        if (offset < kHeaderSize || offset > end || length > end - offset ||
+            (i > 0 && hashAt(i - 1) >= hashAt(i))) {
+            return false;
+        }
+    }
+    return checksumOf(data.substr(0, data.size() - kHashBytes)) == trailer &&
+           toHex(table.substr(table.size() - 2 * kHashBytes, kHashBytes)) == trailer &&
+           checksumOf(table.substr(0, table.size() - kHashBytes)) == toHex(table.substr(table.size() - kHashBytes)) &&
+           pack.stem().string() == "pack-" + trailer;
+}
+
+PackWriter::PackWriter(const fs::path& dir) : packDir(dir) {
+    // Unique across processes and across writers within this process
+    static std::atomic<unsigned> counter{0};
+    std::error_code ec;
+    if (!fs::is_directory(packDir, ec)) {
+        fs::create_directories(packDir, ec);
+    }
+    temp = packDir / ("tmp-" + std::to_string(getpid()) + "-" + std::to_string(counter++) + ".pack");
+    out.open(temp, std::ios::binary);
+    write(header(kPackMagic, 0));
+}
+
+PackWriter::~PackWriter() {
+    if (!finished) {
+        out.close();
+        std::error_code ec;
+        fs::remove(temp, ec);
+    }
+}
+
+bool PackWriter::write(std::string_view data) {
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    offset += data.size();
+    return out.good();
+}
+
+bool PackWriter::add(const std::string& hash, std::string_view stored) {
+    entries.push_back(Entry{hash, offset, stored.size()});
+    return write(stored);
+}
+
+bool PackWriter::finish(fs::path* indexPath) {
+    // The object count is only known now, so the checksum is taken in a
+    // second pass over the file with its final header
+    std::string head = header(kPackMagic, entries.size());
+    out.seekp(0);
+    out.write(head.data(), static_cast<std::streamsize>(head.size()));
+    out.close();
+    if (!out.good()) {
+        std::cerr << "Failed to write pack " << temp.string() << std::endl;
+        return false;
+    }
+    FileView written(temp, FileView::Advice::SEQUENTIAL);
+    std::string name = checksumOf(written.view());
+    written.close();
+    std::string trailer = toRaw(name);
+    std::ofstream append(temp, std::ios::binary | std::ios::app);
+    append.write(trailer.data(), static_cast<std::streamsize>(trailer.size()));
+    append.close();
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.hash < b.hash; });
+    std::string table = header(kIndexMagic, entries.size());
+    for (const auto& entry : entries) {
+        table += toRaw(entry.hash);
+        put64(table, entry.offset);
+        put64(table, entry.length);
+    }
+    table += trailer;
+    table += toRaw(checksumOf(table));
+
+    fs::path pack = packDir / ("pack-" + name + ".pack");
+    fs::path index = packDir / ("pack-" + name + ".idx");
+    fs::path tempIndex = fs::path(temp).replace_extension(".idx");
+    std::ofstream indexFile(tempIndex, std::ios::binary);
+    indexFile.write(table.data(), static_cast<std::streamsize>(table.size()));
+    indexFile.close();
+
+    std::error_code ec;
+    if (!append.good() || !indexFile.good()) {
+        ec = std::make_error_code(std::errc::io_error);
+    }
+    if (!ec) {
+        fs::rename(temp, pack, ec);
+    }
+    if (!ec) {
+        fs::rename(tempIndex, index, ec);
+    }
+    fs::remove(tempIndex, ec);
+    if (!fs::exists(index)) {
+        std::cerr << "Failed to write pack " << pack.string() << std::endl;
+        return false;
+    }
+    finished = true;
+    if (indexPath) {
+        *indexPath = index;
+    }
+    return true;
+}
+
+} // namespace mimirion
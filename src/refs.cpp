@@ -0,0 +1,153 @@
+/**
+ * @file refs.cpp
+ * @brief Implementation of the RefStore class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/refs.hpp"
+#include "../include/object_store.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+namespace mimirion {
+
+RefStore::RefStore(const fs::path& mimirDir) : mimirionDir(mimirDir) {
+}
+
+std::string RefStore::readRef(const std::string& ref) const {
+    // Refuse names that would escape the .mimirion directory
+    if (ref.empty() || ref.find("..") != std::string::npos) {
+        return "";
+    }
+
+    std::ifstream refFile(mimirionDir / ref);
+    std::string value;
+    if (refFile) {
+        std::getline(refFile, value);
+    }
+    return value;
+}
+
+bool RefStore::writeRef(const std::string& ref, const std::string& value, const std::string* expected) const {
+    if (ref.empty() || ref.find("..") != std::string::npos) {
+        return false;
+    }
+    fs::path path = mimirionDir / ref;
+    fs::path lock = path;
+    lock += ".lock";
+
+    // The lock file is the new value; whoever creates it owns the ref
+    std::error_code ec;
+    if (!fs::is_directory(path.parent_path(), ec)) {
+        fs::create_directories(path.parent_path(), ec);
+    }
+    int fd = ::open(lock.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        if (errno == EEXIST) {
+            std::cerr << "Cannot update " << ref << ": " << lock.string()
+                      << " exists, another process may be updating it" << std::endl;
+        } else {
+            std::cerr << "Failed to lock " << ref << ": " << std::strerror(errno) << std::endl;
+        }
+        return false;
+    }
+    std::string line = value + '\n';
+    bool ok = ::write(fd, line.data(), line.size()) == static_cast<ssize_t>(line.size());
+    ok = ::close(fd) == 0 && ok;
+    if (!ok) {
+        std::cerr << "Failed to write " << ref << std::endl;
+    } else if (expected && readRef(ref) != *expected) {
+        std::cerr << "Cannot update " << ref << ": it was changed by another process" << std::endl;
+        ok = false;
+    } else {
+        fs::rename(lock, path, ec);
+        if (ec) {
+            std::cerr << "Failed to update " << ref << ": " << ec.message() << std::endl;
+            ok = false;
+        }
+    }
+    if (!ok) {
+        fs::remove(lock, ec);
+    }
+    return ok;
+}
+
+std::string RefStore::resolve(const std::string& name, const ObjectStore* objects) const {
+    if (name.empty()) {
+        return "";
+    }
+
+    if (name == "HEAD") {
+        std::string head = readRef("HEAD");
+        std::string target;
+        if (parseSymbolicRef(head, target)) {
+            return readRef(target);
+        }
+        return head;
+    }
+
+    if (name.compare(0, 5, "refs/") == 0) {
+        return readRef(name);
+    }
+
+    std::string branch = readRef("refs/heads/" + name);
+    if (!branch.empty()) {
+        return branch;
+    }
+    std::string tag = readRef("refs/tags/" + name);
+    if (!tag.empty()) {
+        return tag;
+    }
+
+    if (objects && ObjectStore::isValidHash(name)) {
+        if (objects->hasObject(name)) {
+            return name;
+        }
+        return objects->resolvePrefix(name);
+    }
+
+    return "";
+}
+
+std::vector<std::string> RefStore::listRefs(const std::string& prefix) const {
+    std::vector<std::string> names;
+    std::error_code ec;
+    for (fs::recursive_directory_iterator it(mimirionDir / prefix, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file() && it->path().extension() != ".lock") {
+            names.push_back(it->path().lexically_relative(mimirionDir).generic_string());
+        }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+std::string RefStore::currentBranch() const {
+    std::string target;
+    if (!parseSymbolicRef(readRef("HEAD"), target) || target.compare(0, 11, "refs/heads/") != 0) {
+        return "";
+    }
+    return target.substr(11);
+}
+
+bool RefStore::setHead(const std::string& branch) const {
+    return writeRef("HEAD", "ref: refs/heads/" + branch);
+}
+
+bool RefStore::parseSymbolicRef(const std::string& value, std::string& target) {
+    if (value.compare(0, 5, "ref: ") != 0) {
+        return false;
+    }
+    target = value.substr(5);
+    while (!target.empty() && (target.back() == '\r' || target.back() == ' ')) {
+        target.pop_back();
+    }
+    return !target.empty();
+}
+
+} // namespace mimirion
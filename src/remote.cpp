@@ -1,8 +1,10 @@
 #include "../include/remote.hpp"
 #include "../include/github_api.hpp"
+#include "../include/config.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <iterator>
 
 namespace mimirion {
 
@@ -67,46 +69,59 @@ bool RemoteManager::pull(const std::string& name, const std::string& branch) {
 }
 
 bool RemoteManager::saveState() const {
-    // Create config directory if it doesn't exist
-    fs::create_directories(mimirionDir / "config");
-    
-    // Save remotes
-    std::ofstream remotesFile(mimirionDir / "config" / "remotes");
-    if (!remotesFile) {
-        std::cerr << "Failed to save remotes configuration" << std::endl;
-        return false;
-    }
-    
-    for (const auto& remote : remotes) {
-        remotesFile << remote.first << " " << remote.second << std::endl;
-    }
-    
-    remotesFile.close();
-    return true;
+    return saveRemotes(mimirionDir, remotes);
 }
 
 bool RemoteManager::loadState() {
-    // Clear current remotes
-    remotes.clear();
+    remotes = loadRemotes(mimirionDir);
+    return true;
+}
+
+std::unordered_map<std::string, std::string> RemoteManager::loadRemotes(const fs::path& mimirionDir) {
+    std::unordered_map<std::string, std::string> remotes;
     
-    // Load remotes
+    // Legacy format: one "name url" pair per line
     std::ifstream remotesFile(mimirionDir / "config" / "remotes");
-    if (!remotesFile) {
-        // File doesn't exist yet, that's ok
-        return true;
-    }
-    
     std::string line;
-    while (std::getline(remotesFile, line)) {
+    while (remotesFile && std::getline(remotesFile, line)) {
         size_t spacePos = line.find(' ');
         if (spacePos != std::string::npos) {
-            std::string name = line.substr(0, spacePos);
-            std::string url = line.substr(spacePos + 1);
-            remotes[name] = url;
+            remotes[line.substr(0, spacePos)] = line.substr(spacePos + 1);
+        }
+    }
+    
+    auto config = Config::load(mimirionDir);
+    for (const auto& name : config->getSubsections("remote")) {
+        auto url = config->get("remote." + name + ".url");
+        if (url) {
+            remotes[name] = *url;
         }
     }
     
-    remotesFile.close();
+    return remotes;
+}
+
+bool RemoteManager::saveRemotes(const fs::path& mimirionDir,
+                                const std::unordered_map<std::string, std::string>& remotes) {
+    bool saved = Config::edit(mimirionDir, Config::Scope::REPOSITORY,
+        [&remotes](std::map<std::string, std::string>& values) {
+            for (auto it = values.begin(); it != values.end();) {
+                bool remoteUrl = it->first.compare(0, 7, "remote.") == 0 &&
+                    it->first.size() > 4 && it->first.compare(it->first.size() - 4, 4, ".url") == 0;
+                it = remoteUrl ? values.erase(it) : std::next(it);
+            }
+            for (const auto& remote : remotes) {
+                values["remote." + remote.first + ".url"] = remote.second;
+            }
+        });
+    if (!saved) {
+        std::cerr << "Failed to save remotes configuration" << std::endl;
+        return false;
+    }
+    
+    // The configuration now holds everything the legacy file did
+    std::error_code ec;
+    fs::remove(mimirionDir / "config" / "remotes", ec);
     return true;
 }
 
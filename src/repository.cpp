@@ -8,6 +8,13 @@
 #include "../include/repository.hpp"
 #include "../include/commit.hpp"
 #include "../include/utils.hpp"
+#include "../include/refs.hpp"
+#include "../include/object_store.hpp"
+#include "../include/lfs.hpp"
+#include "../include/filter.hpp"
+#include "../include/config.hpp"
+#include "../include/remote.hpp"
+#include "../include/worktree.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -26,8 +33,14 @@ Repository::Repository() : currentBranch("master") {
     stagedFiles.clear();
     remotes.clear();
     
-    // Create GitHub provider instance
-    githubProvider = std::make_unique<GitHubProvider>();
+    // The GitHub provider is created lazily by getGitHubProvider()
+}
+
+GitHubProvider& Repository::getGitHubProvider() {
+    if (!githubProvider) {
+        githubProvider = std::make_unique<GitHubProvider>();
+    }
+    return *githubProvider;
 }
 
 /**
@@ -64,13 +77,9 @@ bool Repository::init(const std::string& path) {
     fs::create_directories(mimirionDir / "refs" / "remotes");
     
     // Create HEAD file pointing to master branch
-    std::ofstream headFile(mimirionDir / "HEAD");
-    if (!headFile) {
-        std::cerr << "Failed to create HEAD file" << std::endl;
+    if (!RefStore(mimirionDir).setHead("master")) {
         return false;
     }
-    headFile << "ref: refs/heads/master" << std::endl;
-    headFile.close();
     
     // Initialize state
     currentBranch = "master";
@@ -81,21 +90,16 @@ bool Repository::init(const std::string& path) {
 
 bool Repository::load(const std::string& path) {
     repositoryPath = fs::absolute(path);
-    mimirionDir = repositoryPath / ".mimirion";
     
     // Check if directory exists
-    if (!fs::exists(mimirionDir)) {
+    if (!fs::exists(repositoryPath / ".mimirion")) {
         // Search up the directory tree
-        fs::path current = repositoryPath;
-        while (current.has_parent_path()) {
-            if (fs::exists(current / ".mimirion")) {
-                repositoryPath = current;
-                mimirionDir = current / ".mimirion";
-                break;
-            }
-            current = current.parent_path();
+        fs::path root = findRepositoryRoot(repositoryPath);
+        if (!root.empty()) {
+            repositoryPath = root;
         }
     }
+    mimirionDir = findMimirionDir(repositoryPath);
     
     // Validate repository
     if (!isValidRepository()) {
@@ -194,16 +198,11 @@ std::string Repository::commit(const std::string& message) {
     // TODO: Implement real commit functionality using CommitManager class
     
     // Update the current branch reference
-    fs::create_directories(mimirionDir / "refs" / "heads");
-    std::ofstream branchFile(mimirionDir / "refs" / "heads" / currentBranch);
-    if (!branchFile) {
+    if (!RefStore(mimirionDir).writeRef("refs/heads/" + currentBranch, commitHash)) {
         std::cerr << "Failed to update branch reference" << std::endl;
         return "";
     }
     
-    branchFile << commitHash << std::endl;
-    branchFile.close();
-    
     return commitHash;
 }
 
@@ -230,17 +229,14 @@ bool Repository::createBranch(const std::string& name) {
         return false;
     }
     
-    // Create new branch pointing to the same commit
-    fs::create_directories(mimirionDir / "refs" / "heads");
-    std::ofstream branchFile(mimirionDir / "refs" / "heads" / name);
-    if (!branchFile) {
+    // Create new branch pointing to the same commit, unless another
+    // worktree created it first
+    const std::string none;
+    if (!RefStore(mimirionDir).writeRef("refs/heads/" + name, commitHash, &none)) {
         std::cerr << "Failed to create branch file" << std::endl;
         return false;
     }
     
-    branchFile << commitHash << std::endl;
-    branchFile.close();
-    
     std::cout << "Created branch: " << name << std::endl;
     return true;
 }
@@ -257,6 +253,16 @@ bool Repository::checkout(const std::string& name) {
         return false;
     }
     
+    // A branch is checked out in one worktree at a time, or commits in
+    // either would move it under the other
+    for (const auto& worktree : WorktreeManager(repositoryPath, mimirionDir).list()) {
+        std::error_code ec;
+        if (worktree.branch == name && !fs::equivalent(worktree.path, repositoryPath, ec)) {
+            std::cerr << "Branch " << name << " is already checked out at " << worktree.path.string() << std::endl;
+            return false;
+        }
+    }
+    
     // Get the commit hash from the branch reference
     std::ifstream branchFile(mimirionDir / "refs" / "heads" / name);
     if (!branchFile) {
@@ -269,7 +275,7 @@ bool Repository::checkout(const std::string& name) {
     branchFile.close();
     
     // Create a commit manager to handle file restoration
-    CommitManager commitManager(fs::current_path(), mimirionDir);
+    CommitManager commitManager(repositoryPath, mimirionDir);
     
     // Save any uncommitted changes if needed
     // TODO: Implement stashing functionality for uncommitted changes
@@ -285,36 +291,66 @@ bool Repository::checkout(const std::string& name) {
     
     // Restore files from the commit
     if (commitPtr && !commitPtr->hash.empty()) {
+        ObjectStore objects(mimirionDir);
+        LargeFileStore largeFiles(repositoryPath, mimirionDir);
+        FilterPipeline filters(repositoryPath, mimirionDir);
+        bool lazy = Config::load(mimirionDir)->getBool("lfs.lazyCheckout");
         for (const auto& [filePath, fileHash] : commitPtr->fileHashes) {
-            fs::path targetPath = fs::current_path() / filePath;
-            fs::path contentPath = mimirionDir / "objects" / fileHash.substr(0, 2) / fileHash.substr(2);
+            fs::path targetPath = repositoryPath / filePath;
             
-            if (fs::exists(contentPath)) {
-                // Create parent directories if they don't exist
-                if (!fs::exists(targetPath.parent_path())) {
-                    fs::create_directories(targetPath.parent_path());
+            // Filtered files stream from the object through the smudge chain
+            if (filters.hasFilters(filePath)) {
+                std::error_code ec;
+                fs::create_directories(targetPath.parent_path(), ec);
+                std::ofstream out(targetPath, std::ios::binary | std::ios::trunc);
+                auto chain = filters.open(filePath, FilterDirection::SMUDGE,
+                                          [&out](const char* data, size_t size) {
+                                              out.write(data, static_cast<std::streamsize>(size));
+                                              return out.good();
+                                          },
+                                          fileHash);
+                bool ok = out && chain &&
+                          objects.readStream(fileHash, [&chain](const char* data, size_t size) {
+                              return chain->write(data, size);
+                          }) &&
+                          chain->finish();
+                out.close();
+                if (!ok || !out) {
+                    std::cerr << "Failed to restore file " << filePath << std::endl;
                 }
-                
-                // Copy the file content
-                try {
-                    fs::copy_file(contentPath, targetPath, fs::copy_options::overwrite_existing);
-                } catch (const fs::filesystem_error& e) {
-                    std::cerr << "Failed to restore file " << filePath << ": " << e.what() << std::endl;
+                continue;
+            }
+            
+            auto content = objects.readObject(fileHash);
+            
+            // Pointers of large file paths are replaced by their content
+            // unless checkout is lazy or the content is not stored locally;
+            // `lfs pull` fills them in later. Elsewhere pointer text is content
+            LfsPointer pointer;
+            if (content && !lazy && largeFiles.isTracked(filePath) &&
+                LargeFileStore::parsePointer(*content, pointer) &&
+                largeFiles.materialize(pointer, targetPath)) {
+                objects.clearCache();
+                continue;
+            }
+            
+            if (content) {
+                // Write the blob content, creating parent directories as needed
+                if (!utils::writeFile(targetPath, *content)) {
+                    std::cerr << "Failed to restore file " << filePath << std::endl;
                 }
+                
+                // Blobs are only needed once, don't let them pile up in the cache
+                objects.clearCache();
             }
         }
     }
     
     // Update HEAD to point to the new branch
-    std::ofstream headFile(mimirionDir / "HEAD");
-    if (!headFile) {
-        std::cerr << "Failed to update HEAD file" << std::endl;
+    if (!RefStore(mimirionDir).setHead(name)) {
         return false;
     }
     
-    headFile << "ref: refs/heads/" << name << std::endl;
-    headFile.close();
-    
     // Update current branch
     currentBranch = name;
     
@@ -350,10 +386,10 @@ bool Repository::push(const std::string& remote, const std::string& branch) {
     // Use the GitHub provider to perform the push operation
     std::cout << "Pushing to " << remote << " (" << it->second << ") branch " << branchName << std::endl;
     
-    if (githubProvider && !it->second.empty()) {
-        return githubProvider->push(repositoryPath, remote, it->second, branchName);
+    if (!it->second.empty()) {
+        return getGitHubProvider().push(repositoryPath, remote, it->second, branchName);
     } else {
-        std::cerr << "GitHub provider not initialized or remote URL is empty" << std::endl;
+        std::cerr << "Remote URL is empty" << std::endl;
         return false;
     }
 }
@@ -388,6 +424,40 @@ bool Repository::addRemote(const std::string& name, const std::string& url) {
     return saveState();
 }
 
+fs::path Repository::findRepositoryRoot(const fs::path& start) {
+    fs::path current = fs::absolute(start);
+    while (true) {
+        if (fs::exists(current / ".mimirion")) {
+            return current;
+        }
+        if (!current.has_parent_path() || current.parent_path() == current) {
+            return fs::path();
+        }
+        current = current.parent_path();
+    }
+}
+
+fs::path Repository::findMimirionDir(const fs::path& root) {
+    fs::path dir = root / ".mimirion";
+    std::error_code ec;
+    if (!fs::is_regular_file(dir, ec)) {
+        return dir;
+    }
+    
+    // A linked worktree's .mimirion file names its directory in the main repository
+    std::ifstream link(dir);
+    std::string line;
+    std::getline(link, line);
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+        line.pop_back();
+    }
+    if (line.compare(0, 10, "mimirdir: ") != 0 || line.size() == 10) {
+        return dir;
+    }
+    fs::path target = line.substr(10);
+    return target.is_relative() ? root / target : target;
+}
+
 bool Repository::isValidRepository() const {
     // Check if .mimirion directory exists
     if (!fs::exists(mimirionDir)) {
@@ -405,51 +475,19 @@ bool Repository::isValidRepository() const {
 }
 
 bool Repository::saveState() const {
-    // Create config directory if it doesn't exist
-    fs::create_directories(mimirionDir / "config");
-    
-    // Save remotes
-    std::ofstream remotesFile(mimirionDir / "config" / "remotes");
-    if (!remotesFile) {
-        std::cerr << "Failed to save remotes configuration" << std::endl;
-        return false;
-    }
-    
-    for (const auto& remote : remotes) {
-        remotesFile << remote.first << " " << remote.second << std::endl;
-    }
-    remotesFile.close();
-    
-    return true;
+    // Remotes live in the repository configuration
+    return RemoteManager::saveRemotes(mimirionDir, remotes);
 }
 
 bool Repository::loadState() {
     // Read current branch from HEAD file
-    std::ifstream headFile(mimirionDir / "HEAD");
-    if (headFile) {
-        std::string headContent;
-        std::getline(headFile, headContent);
-        if (headContent.substr(0, 16) == "ref: refs/heads/") {
-            currentBranch = headContent.substr(16);
-        }
-        headFile.close();
+    std::string branch = RefStore(mimirionDir).currentBranch();
+    if (!branch.empty()) {
+        currentBranch = branch;
     }
     
     // Load remotes
-    remotes.clear();
-    std::ifstream remotesFile(mimirionDir / "config" / "remotes");
-    if (remotesFile) {
-        std::string line;
-        while (std::getline(remotesFile, line)) {
-            size_t spacePos = line.find(' ');
-            if (spacePos != std::string::npos) {
-                std::string name = line.substr(0, spacePos);
-                std::string url = line.substr(spacePos + 1);
-                remotes[name] = url;
-            }
-        }
-        remotesFile.close();
-    }
+    remotes = RemoteManager::loadRemotes(mimirionDir);
     
     return true;
 }
@@ -461,12 +499,7 @@ bool Repository::loadState() {
  * @return true if successful, false otherwise
  */
 bool Repository::setGitHubCredentials(const std::string& username, const std::string& token) {
-    if (!githubProvider) {
-        std::cerr << "GitHub provider not initialized" << std::endl;
-        return false;
-    }
-    
-    githubProvider->setCredentials(username, token);
+    getGitHubProvider().setCredentials(username, token);
     return true;
 }
 
@@ -476,12 +509,7 @@ bool Repository::setGitHubCredentials(const std::string& username, const std::st
  * @return true if successful, false otherwise
  */
 bool Repository::setGitHubCredentialsFromFile(const fs::path& tokenFilePath) {
-    if (!githubProvider) {
-        std::cerr << "GitHub provider not initialized" << std::endl;
-        return false;
-    }
-    
-    return githubProvider->setCredentialsFromFile(tokenFilePath);
+    return getGitHubProvider().setCredentialsFromFile(tokenFilePath);
 }
 
 } // namespace mimirion
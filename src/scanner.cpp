@@ -0,0 +1,141 @@
+/**
+ * @file scanner.cpp
+ * @brief Implementation of the FileScanner class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/scanner.hpp"
+#include "../include/file_view.hpp"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <openssl/evp.h>
+
+namespace mimirion {
+
+namespace {
+
+struct DigestDeleter {
+    void operator()(EVP_MD_CTX* ctx) const { EVP_MD_CTX_free(ctx); }
+};
+
+} // namespace
+
+// Accumulates everything a scan reports, one chunk at a time
+struct ScanStream::State {
+    ScanResult result;
+    std::unique_ptr<EVP_MD_CTX, DigestDeleter> ctx{EVP_MD_CTX_new()};
+    uint64_t lf = 0;
+    uint64_t crlf = 0;
+    char lastByte = '\0';
+};
+
+ScanStream::ScanStream() : state(std::make_unique<State>()) {
+    EVP_DigestInit_ex(state->ctx.get(), EVP_sha256(), nullptr);
+}
+
+ScanStream::~ScanStream() = default;
+
+void ScanStream::update(const char* data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    ScanResult& result = state->result;
+    EVP_DigestUpdate(state->ctx.get(), data, size);
+
+    if (result.size < FileScanner::kBinaryCheckSize && !result.binary) {
+        size_t inspect = std::min<size_t>(size, FileScanner::kBinaryCheckSize - result.size);
+        result.binary = FileScanner::looksBinary(std::string_view(data, inspect));
+    }
+
+    // A CR ending the previous chunk pairs with an LF starting this one
+    const char* end = data + size;
+    for (const char* p = data; (p = static_cast<const char*>(std::memchr(p, '\n', end - p)));
+         ++p) {
+        bool cr = p == data ? state->lastByte == '\r' : p[-1] == '\r';
+        ++(cr ? state->crlf : state->lf);
+    }
+
+    state->lastByte = end[-1];
+    result.size += size;
+}
+
+ScanResult ScanStream::finish() {
+    ScanResult& result = state->result;
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    EVP_DigestFinal_ex(state->ctx.get(), digest, &length);
+
+    static const char hex[] = "0123456789abcdef";
+    result.hash.resize(length * 2);
+    for (unsigned int i = 0; i < length; ++i) {
+        result.hash[2 * i] = hex[digest[i] >> 4];
+        result.hash[2 * i + 1] = hex[digest[i] & 0x0f];
+    }
+
+    uint64_t lf = state->lf;
+    uint64_t crlf = state->crlf;
+    result.lines = lf + crlf + (result.size > 0 && state->lastByte != '\n' ? 1 : 0);
+    if (lf > 0 && crlf > 0) {
+        result.newlines = NewlineStyle::MIXED;
+    } else if (crlf > 0) {
+        result.newlines = NewlineStyle::CRLF;
+    } else if (lf > 0) {
+        result.newlines = NewlineStyle::LF;
+    }
+    return result;
+}
+
+FileScanner::FileScanner(size_t chunkSize)
+    : chunkSize(std::max<size_t>(chunkSize, kBinaryCheckSize)) {
+}
+
+bool FileScanner::scan(const fs::path& path, ScanResult& result,
+                       const CompressionSink& contentSink) {
+    FileView file(path, FileView::Advice::SEQUENTIAL);
+    if (!file.isOpen()) {
+        return false;
+    }
+
+    // Chunks keep each pass over the data within the cache
+    ScanStream stream;
+    for (size_t offset = 0; offset < file.size(); offset += chunkSize) {
+        std::string_view chunk = file.view(offset, chunkSize);
+        stream.update(chunk.data(), chunk.size());
+        if (contentSink && !contentSink(chunk.data(), chunk.size())) {
+            return false;
+        }
+    }
+
+    result = stream.finish();
+    return true;
+}
+
+bool FileScanner::scan(const fs::path& path, ScanResult& result, Compressor& compressor,
+                       const CompressionSink& compressedSink) {
+    auto feed = [&](const char* data, size_t size) {
+        return compressor.write(data, size, compressedSink);
+    };
+    return scan(path, result, feed) && compressor.finish(compressedSink);
+}
+
+ScanResult FileScanner::scanBuffer(std::string_view data) {
+    ScanStream stream;
+    stream.update(data.data(), data.size());
+    return stream.finish();
+}
+
+bool FileScanner::looksBinary(std::string_view prefix) {
+    prefix = prefix.substr(0, kBinaryCheckSize);
+    for (char ch : prefix) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        if (c < 32 && c != '\n' && c != '\r' && c != '\t') {
+            // Includes NUL, the most common sign of binary content
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace mimirion
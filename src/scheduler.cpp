@@ -0,0 +1,273 @@
+/**
+ * @file scheduler.cpp
+ * @brief Implementation of the TaskScheduler and TaskGroup classes
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/scheduler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+namespace mimirion {
+
+namespace {
+
+// Scheduler and worker index owning the current thread; the pointer is
+// null outside any pool, so several schedulers can coexist.
+thread_local const TaskScheduler* currentScheduler = nullptr;
+thread_local size_t currentWorker = 0;
+
+} // namespace
+
+TaskScheduler::TaskScheduler(size_t threadCount)
+    : queued(0), nextWorker(0), stopping(false),
+      tasksExecuted(0), steals(0), maxQueueDepth(0) {
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&TaskScheduler::workerLoop, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+TaskScheduler& TaskScheduler::instance() {
+    static TaskScheduler scheduler(defaultThreadCount());
+    return scheduler;
+}
+
+size_t TaskScheduler::defaultThreadCount() {
+    const char* env = getenv("MIMIRION_THREADS");
+    if (env && *env) {
+        try {
+            return static_cast<size_t>(std::stoul(env));
+        } catch (const std::exception&) {
+            // Fall through to the hardware default
+        }
+    }
+
+    unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? hardware : 1;
+}
+
+size_t TaskScheduler::threadCount() const {
+    return threads.size();
+}
+
+TaskScheduler::Metrics TaskScheduler::getMetrics() const {
+    Metrics metrics;
+    metrics.tasksExecuted = tasksExecuted.load();
+    metrics.steals = steals.load();
+    metrics.maxQueueDepth = maxQueueDepth.load();
+    metrics.queuedTasks = queued.load();
+    metrics.threadCount = threads.size();
+    return metrics;
+}
+
+void TaskScheduler::resetMetrics() {
+    tasksExecuted = 0;
+    steals = 0;
+    maxQueueDepth = 0;
+}
+
+void TaskScheduler::submit(std::function<void()> task) {
+    if (workers.empty()) {
+        // No pool: run inline on the caller
+        task();
+        ++tasksExecuted;
+        return;
+    }
+
+    // Workers feed their own deque; outside threads spread work round-robin
+    size_t target = currentScheduler == this
+        ? currentWorker
+        : nextWorker.fetch_add(1) % workers.size();
+
+    // Count the task before it becomes visible so pops never underflow
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        ++queued;
+    }
+
+    size_t depth;
+    {
+        std::lock_guard<std::mutex> lock(workers[target]->mutex);
+        workers[target]->tasks.push_back(std::move(task));
+        depth = workers[target]->tasks.size();
+    }
+
+    size_t seen = maxQueueDepth.load();
+    while (depth > seen && !maxQueueDepth.compare_exchange_weak(seen, depth)) {
+    }
+
+    wake.notify_one();
+}
+
+bool TaskScheduler::popTask(size_t self, std::function<void()>& task) {
+    // Newest task from our own deque first, it is most likely cache-warm
+    if (self < workers.size()) {
+        std::lock_guard<std::mutex> lock(workers[self]->mutex);
+        if (!workers[self]->tasks.empty()) {
+            task = std::move(workers[self]->tasks.back());
+            workers[self]->tasks.pop_back();
+            --queued;
+            return true;
+        }
+    }
+
+    // Otherwise steal the oldest task from someone else
+    for (size_t i = 0; i < workers.size(); ++i) {
+        size_t victim = (self + 1 + i) % workers.size();
+        if (victim == self) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(workers[victim]->mutex);
+        if (!workers[victim]->tasks.empty()) {
+            task = std::move(workers[victim]->tasks.front());
+            workers[victim]->tasks.pop_front();
+            --queued;
+            ++steals;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TaskScheduler::runOneTask() {
+    size_t self = currentScheduler == this ? currentWorker : workers.size();
+    std::function<void()> task;
+    if (!popTask(self, task)) {
+        return false;
+    }
+    task();
+    ++tasksExecuted;
+    return true;
+}
+
+void TaskScheduler::workerLoop(size_t index) {
+    currentScheduler = this;
+    currentWorker = index;
+
+    while (true) {
+        std::function<void()> task;
+        if (popTask(index, task)) {
+            task();
+            ++tasksExecuted;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait_for(lock, std::chrono::milliseconds(100),
+                      [this]() { return stopping || queued > 0; });
+        if (stopping && queued == 0) {
+            return;
+        }
+    }
+}
+
+TaskGroup::TaskGroup(TaskScheduler& sched)
+    : scheduler(sched), outstanding(0), cancelled(false) {
+}
+
+TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch (...) {
+        // Errors are only reported through an explicit wait()
+    }
+}
+
+void TaskGroup::run(std::function<void()> task) {
+    ++outstanding;
+    scheduler.submit([this, task = std::move(task)]() {
+        if (!cancelled) {
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        finishTask();
+    });
+}
+
+void TaskGroup::finishTask() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--outstanding == 0) {
+        done.notify_all();
+    }
+}
+
+void TaskGroup::wait() {
+    while (outstanding > 0) {
+        // Help out instead of blocking; this also keeps nested groups live
+        if (scheduler.runOneTask()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait_for(lock, std::chrono::milliseconds(1), [this]() { return outstanding == 0; });
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (error) {
+        std::exception_ptr pending = error;
+        error = nullptr;
+        std::rethrow_exception(pending);
+    }
+}
+
+void TaskGroup::cancel() {
+    cancelled = true;
+}
+
+bool TaskGroup::isCancelled() const {
+    return cancelled;
+}
+
+void parallelFor(size_t count, const std::function<void(size_t)>& body, size_t grainSize) {
+    if (count == 0) {
+        return;
+    }
+
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    size_t workers = std::max<size_t>(scheduler.threadCount(), 1);
+
+    // Aim for a few chunks per worker so stealing can balance uneven work
+    size_t chunk = std::max(grainSize, (count + workers * 4 - 1) / (workers * 4));
+    if (chunk >= count || scheduler.threadCount() == 0) {
+        for (size_t i = 0; i < count; ++i) {
+            body(i);
+        }
+        return;
+    }
+
+    TaskGroup group(scheduler);
+    for (size_t begin = 0; begin < count; begin += chunk) {
+        size_t end = std::min(count, begin + chunk);
+        group.run([&body, begin, end]() {
+            for (size_t i = begin; i < end; ++i) {
+                body(i);
+            }
+        });
+    }
+    group.wait();
+}
+
+} // namespace mimirion
@@ -0,0 +1,519 @@
+/**
+ * @file trigram.cpp
+ * @brief Implementation of the TrigramIndex class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/trigram.hpp"
+#include "../include/compression.hpp"
+#include "../include/file_view.hpp"
+#include "../include/object_store.hpp"
+#include "../include/scanner.hpp"
+#include "../include/scheduler.hpp"
+#include "../include/utils.hpp"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <unistd.h>
+
+namespace mimirion {
+
+namespace {
+
+const char kMagic[] = {'M', 'T', 'R', 'I'};
+constexpr uint32_t kVersion = 2;
+constexpr const char* kBlobTable = "blobs";
+constexpr const char* kSegmentPrefix = "segment-";
+
+// magic, version, first id, blob count, trigram count, reserved
+constexpr size_t kHeaderSize = 24;
+// trigram, id count, list offset, list size
+constexpr size_t kEntrySize = 20;
+
+// Lists the blobs that were not tokenized; above every 24-bit trigram, so
+// it sorts last in a segment's directory and merges like any other list
+constexpr uint32_t kUnindexed = 0xffffffff;
+
+// Blobs read and tokenized at a time while indexing
+constexpr size_t kReadBatch = 256;
+
+struct Entry {
+    uint32_t trigram = 0;
+    uint32_t count = 0;
+    uint64_t offset = 0;
+    uint32_t size = 0;
+};
+
+void put32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+void put64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+uint64_t get(std::string_view data, size_t offset, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(data[offset + i])) << (8 * i);
+    }
+    return value;
+}
+
+Entry entryAt(std::string_view segment, size_t index) {
+    size_t at = kHeaderSize + index * kEntrySize;
+    Entry entry;
+    entry.trigram = static_cast<uint32_t>(get(segment, at, 4));
+    entry.count = static_cast<uint32_t>(get(segment, at + 4, 4));
+    entry.offset = get(segment, at + 8, 8);
+    entry.size = static_cast<uint32_t>(get(segment, at + 16, 4));
+    return entry;
+}
+
+bool validSegment(std::string_view segment) {
+    return segment.size() >= kHeaderSize && std::equal(kMagic, kMagic + 4, segment.data()) &&
+           get(segment, 4, 4) == kVersion &&
+           segment.size() >= kHeaderSize + get(segment, 16, 4) * kEntrySize;
+}
+
+bool olderSegment(std::string_view segment) {
+    return segment.size() >= kHeaderSize && std::equal(kMagic, kMagic + 4, segment.data()) &&
+           get(segment, 4, 4) < kVersion;
+}
+
+// Binary search of a segment's directory
+bool findEntry(std::string_view segment, uint32_t trigram, Entry& entry) {
+    size_t low = 0;
+    size_t high = static_cast<size_t>(get(segment, 16, 4));
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        Entry candidate = entryAt(segment, middle);
+        if (candidate.trigram == trigram) {
+            entry = candidate;
+            return true;
+        }
+        if (candidate.trigram < trigram) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return false;
+}
+
+void encodeList(const std::vector<uint32_t>& ids, std::string& out) {
+    std::string varints;
+    uint32_t previous = 0;
+    for (uint32_t id : ids) {
+        uint32_t delta = id - previous;
+        previous = id;
+        while (delta >= 0x80) {
+            varints.push_back(static_cast<char>((delta & 0x7f) | 0x80));
+            delta >>= 7;
+        }
+        varints.push_back(static_cast<char>(delta));
+    }
+    Compressor::compress(varints, out, CompressionLevel::BEST);
+}
+
+// Appends a list's ids to out
+bool decodeList(std::string_view segment, const Entry& entry, std::vector<uint32_t>& out) {
+    if (entry.offset + entry.size > segment.size()) {
+        return false;
+    }
+    std::string varints;
+    if (!Decompressor::decompress(segment.substr(entry.offset, entry.size), varints)) {
+        return false;
+    }
+
+    uint32_t id = 0;
+    uint32_t delta = 0;
+    int shift = 0;
+    size_t decoded = 0;
+    for (char c : varints) {
+        delta |= static_cast<uint32_t>(c & 0x7f) << shift;
+        if (c & 0x80) {
+            shift += 7;
+            continue;
+        }
+        id += delta;
+        out.push_back(id);
+        ++decoded;
+        delta = 0;
+        shift = 0;
+    }
+    return decoded == entry.count;
+}
+
+} // namespace
+
+TrigramIndex::TrigramIndex(const fs::path& mimirDir)
+    : mimirionDir(mimirDir), indexDir(mimirDir / "index.d") {
+    load();
+}
+
+void TrigramIndex::load() {
+    // Version 1 segments did not list unindexed blobs; the index is
+    // dropped and rebuilt by the next updates
+    std::error_code ec;
+    for (fs::directory_iterator it(indexDir, ec), end; it != end && !ec; it.increment(ec)) {
+        if (it->path().filename().string().rfind(kSegmentPrefix, 0) == 0 &&
+            olderSegment(FileView(it->path(), FileView::Advice::RANDOM).view())) {
+            fs::remove_all(indexDir, ec);
+            break;
+        }
+    }
+
+    std::string table = fs::exists(indexDir / kBlobTable) ? utils::readFile(indexDir / kBlobTable) : "";
+    // A line without its newline is the remains of an interrupted update
+    size_t start = 0;
+    for (size_t end = table.find('\n'); end != std::string::npos; end = table.find('\n', start)) {
+        blobs.push_back(table.substr(start, end - start));
+        start = end + 1;
+    }
+
+    for (fs::directory_iterator it(indexDir, ec), end; it != end && !ec; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (name.rfind(kSegmentPrefix, 0) != 0) {
+            continue;
+        }
+        FileView view(it->path(), FileView::Advice::RANDOM);
+        if (!view.isOpen() || !validSegment(view.view())) {
+            std::cerr << "Ignoring invalid index segment " << name << std::endl;
+            continue;
+        }
+        Segment segment;
+        segment.path = it->path();
+        segment.firstId = static_cast<uint32_t>(get(view.view(), 8, 4));
+        segment.blobCount = static_cast<uint32_t>(get(view.view(), 12, 4));
+        segments.push_back(segment);
+    }
+    std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+        return a.firstId < b.firstId || (a.firstId == b.firstId && a.blobCount > b.blobCount);
+    });
+
+    // A segment whose blobs never made it into the table is from an
+    // interrupted update; the table is cut back to before it
+    size_t valid = blobs.size();
+    for (const auto& segment : segments) {
+        if (static_cast<size_t>(segment.firstId) + segment.blobCount > blobs.size()) {
+            valid = std::min(valid, static_cast<size_t>(segment.firstId));
+        }
+    }
+
+    // Segments covered by a merged one are from an interrupted merge
+    size_t covered = 0;
+    std::vector<Segment> kept;
+    for (const auto& segment : segments) {
+        size_t end = static_cast<size_t>(segment.firstId) + segment.blobCount;
+        if (end > valid || segment.firstId < covered) {
+            fs::remove(segment.path, ec);
+            continue;
+        }
+        covered = end;
+        kept.push_back(segment);
+    }
+    segments.swap(kept);
+
+    if (valid < blobs.size() || start < table.size()) {
+        blobs.resize(valid);
+        std::string rewritten;
+        for (const auto& hash : blobs) {
+            rewritten += hash + "\n";
+        }
+        utils::writeFile(indexDir / kBlobTable, rewritten);
+    }
+
+    for (uint32_t id = 0; id < blobs.size(); ++id) {
+        ids[blobs[id]] = id;
+    }
+}
+
+bool TrigramIndex::update(const std::vector<std::string>& hashes, size_t* added) {
+    ObjectStore objects(mimirionDir);
+    std::vector<std::string> fresh;
+    std::unordered_set<std::string> seen;
+    for (const auto& hash : hashes) {
+        // Missing objects are left for a later update
+        if (!ids.count(hash) && seen.insert(hash).second && objects.hasObject(hash)) {
+            fresh.push_back(hash);
+        }
+    }
+    if (added) {
+        *added = fresh.size();
+    }
+    if (fresh.empty()) {
+        return true;
+    }
+
+    uint32_t firstId = static_cast<uint32_t>(blobs.size());
+    std::unordered_map<uint32_t, std::vector<uint32_t>> lists;
+    std::vector<std::vector<uint32_t>> grams;
+    std::vector<char> indexed;
+    for (size_t batch = 0; batch < fresh.size(); batch += kReadBatch) {
+        size_t count = std::min(kReadBatch, fresh.size() - batch);
+        grams.assign(count, {});
+        indexed.assign(count, 0);
+        parallelFor(count, [&](size_t i) {
+            std::string content;
+            bool read = objects.readStream(fresh[batch + i], [&content](const char* data, size_t size) {
+                content.append(data, size);
+                return content.size() <= kMaxIndexedSize;
+            });
+            if (read && !FileScanner::looksBinary(
+                            std::string_view(content).substr(0, FileScanner::kBinaryCheckSize))) {
+                grams[i] = trigrams(content);
+                indexed[i] = 1;
+            }
+        }, 1);
+
+        // Ids are added in increasing order, so every list stays sorted
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t id = firstId + static_cast<uint32_t>(batch + i);
+            if (!indexed[i]) {
+                lists[kUnindexed].push_back(id);
+            }
+            for (uint32_t gram : grams[i]) {
+                lists[gram].push_back(id);
+            }
+        }
+    }
+
+    std::vector<std::pair<uint32_t, std::vector<uint32_t>>> sorted(
+        std::make_move_iterator(lists.begin()), std::make_move_iterator(lists.end()));
+    std::sort(sorted.begin(), sorted.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    if (!writeSegment(firstId, static_cast<uint32_t>(fresh.size()), sorted)) {
+        return false;
+    }
+
+    // The segment is only used once its blobs are in the table
+    std::ofstream table(indexDir / kBlobTable, std::ios::binary | std::ios::app);
+    for (const auto& hash : fresh) {
+        table << hash << '\n';
+    }
+    table.flush();
+    if (!table) {
+        std::cerr << "Failed to update the trigram index blob table" << std::endl;
+        return false;
+    }
+    for (const auto& hash : fresh) {
+        ids[hash] = static_cast<uint32_t>(blobs.size());
+        blobs.push_back(hash);
+    }
+
+    return segments.size() <= kMaxSegments || merge();
+}
+
+bool TrigramIndex::writeSegment(uint32_t firstId, uint32_t blobCount,
+                                const std::vector<std::pair<uint32_t, std::vector<uint32_t>>>& lists) {
+    std::string directory;
+    std::string payload;
+    uint64_t base = kHeaderSize + lists.size() * kEntrySize;
+    std::string encoded;
+    for (const auto& [gram, ids] : lists) {
+        encoded.clear();
+        encodeList(ids, encoded);
+        put32(directory, gram);
+        put32(directory, static_cast<uint32_t>(ids.size()));
+        put64(directory, base + payload.size());
+        put32(directory, static_cast<uint32_t>(encoded.size()));
+        payload += encoded;
+    }
+
+    std::string segment(kMagic, 4);
+    put32(segment, kVersion);
+    put32(segment, firstId);
+    put32(segment, blobCount);
+    put32(segment, static_cast<uint32_t>(lists.size()));
+    put32(segment, 0);
+    segment += directory;
+    segment += payload;
+
+    fs::path path = indexDir / (kSegmentPrefix + std::to_string(firstId));
+    fs::path temp = indexDir / ("tmp-" + std::to_string(getpid()));
+    std::error_code ec;
+    if (utils::writeFile(temp, segment)) {
+        fs::rename(temp, path, ec);
+    } else {
+        ec = std::make_error_code(std::errc::io_error);
+    }
+    if (ec) {
+        std::cerr << "Failed to write trigram index segment " << path << std::endl;
+        fs::remove(temp, ec);
+        return false;
+    }
+
+    auto existing = std::find_if(segments.begin(), segments.end(),
+                                 [&path](const Segment& s) { return s.path == path; });
+    if (existing != segments.end()) {
+        segments.erase(existing);
+    }
+    segments.push_back(Segment{path, firstId, blobCount});
+    return true;
+}
+
+bool TrigramIndex::merge() {
+    std::map<uint32_t, std::vector<uint32_t>> merged;
+    uint32_t blobCount = 0;
+    for (const auto& segment : segments) {
+        FileView view(segment.path, FileView::Advice::SEQUENTIAL);
+        if (!view.isOpen()) {
+            return false;
+        }
+        std::string_view data = view.view();
+        size_t count = static_cast<size_t>(get(data, 16, 4));
+        // Segments are in id order, so appending keeps the lists sorted
+        for (size_t i = 0; i < count; ++i) {
+            Entry entry = entryAt(data, i);
+            if (!decodeList(data, entry, merged[entry.trigram])) {
+                std::cerr << "Corrupt trigram index segment " << segment.path << std::endl;
+                return false;
+            }
+        }
+        blobCount += segment.blobCount;
+    }
+
+    std::vector<Segment> old = segments;
+    uint32_t firstId = segments.front().firstId;
+    std::vector<std::pair<uint32_t, std::vector<uint32_t>>> lists(
+        std::make_move_iterator(merged.begin()), std::make_move_iterator(merged.end()));
+    if (!writeSegment(firstId, blobCount, lists)) {
+        return false;
+    }
+
+    std::error_code ec;
+    segments.clear();
+    for (const auto& segment : old) {
+        if (segment.firstId != firstId) {
+            fs::remove(segment.path, ec);
+        } else {
+            segments.push_back(Segment{segment.path, firstId, blobCount});
+        }
+    }
+    return true;
+}
+
+bool TrigramIndex::candidates(const std::vector<std::string>& literals,
+                              std::unordered_set<std::string>& hashes) const {
+    std::vector<uint32_t> wanted;
+    for (const auto& literal : literals) {
+        auto grams = trigrams(literal);
+        wanted.insert(wanted.end(), grams.begin(), grams.end());
+    }
+    std::sort(wanted.begin(), wanted.end());
+    wanted.erase(std::unique(wanted.begin(), wanted.end()), wanted.end());
+    if (wanted.empty()) {
+        return false;
+    }
+
+    std::vector<FileView> views(segments.size());
+    for (size_t i = 0; i < segments.size(); ++i) {
+        views[i].open(segments[i].path, FileView::Advice::RANDOM);
+    }
+
+    // Blobs without postings may match anything
+    std::vector<uint32_t> result;
+    for (const auto& view : views) {
+        Entry entry;
+        if (view.isOpen() && findEntry(view.view(), kUnindexed, entry) &&
+            !decodeList(view.view(), entry, result)) {
+            std::cerr << "Corrupt trigram index segment" << std::endl;
+            return false;
+        }
+    }
+    for (uint32_t id : result) {
+        if (id < blobs.size()) {
+            hashes.insert(blobs[id]);
+        }
+    }
+    result.clear();
+
+    // Plan: the shortest lists first, an absent trigram ends the search
+    std::vector<std::pair<uint64_t, uint32_t>> plan;
+    for (uint32_t gram : wanted) {
+        uint64_t count = 0;
+        for (const auto& view : views) {
+            Entry entry;
+            if (view.isOpen() && findEntry(view.view(), gram, entry)) {
+                count += entry.count;
+            }
+        }
+        if (count == 0) {
+            return true;
+        }
+        plan.emplace_back(count, gram);
+    }
+    std::sort(plan.begin(), plan.end());
+
+    std::vector<uint32_t> list;
+    std::vector<uint32_t> intersection;
+    for (size_t step = 0; step < plan.size(); ++step) {
+        list.clear();
+        for (const auto& view : views) {
+            Entry entry;
+            if (view.isOpen() && findEntry(view.view(), plan[step].second, entry) &&
+                !decodeList(view.view(), entry, list)) {
+                std::cerr << "Corrupt trigram index segment" << std::endl;
+                return false;
+            }
+        }
+        if (step == 0) {
+            result.swap(list);
+        } else {
+            intersection.clear();
+            std::set_intersection(result.begin(), result.end(), list.begin(), list.end(),
+                                  std::back_inserter(intersection));
+            result.swap(intersection);
+        }
+        if (result.empty()) {
+            break;
+        }
+    }
+
+    for (uint32_t id : result) {
+        if (id < blobs.size()) {
+            hashes.insert(blobs[id]);
+        }
+    }
+    return true;
+}
+
+bool TrigramIndex::contains(const std::string& hash) const {
+    return ids.count(hash) != 0;
+}
+
+size_t TrigramIndex::blobCount() const {
+    return blobs.size();
+}
+
+size_t TrigramIndex::segmentCount() const {
+    return segments.size();
+}
+
+std::vector<uint32_t> TrigramIndex::trigrams(std::string_view text) {
+    std::vector<uint32_t> grams;
+    if (text.size() < 3) {
+        return grams;
+    }
+    grams.reserve(text.size() - 2);
+
+    auto fold = [](char c) { return static_cast<uint32_t>(std::tolower(static_cast<unsigned char>(c))); };
+    uint32_t gram = (fold(text[0]) << 8) | fold(text[1]);
+    for (size_t i = 2; i < text.size(); ++i) {
+        gram = ((gram << 8) | fold(text[i])) & 0xffffff;
+        grams.push_back(gram);
+    }
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+} // namespace mimirion
@@ -1,4 +1,9 @@
 #include "../include/utils.hpp"
+#include "../include/scanner.hpp"
+#include "../include/base64.hpp"
+#include "../include/file_view.hpp"
+#include <algorithm>
+#include <charconv>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -6,9 +11,6 @@
 #include <ctime>
 #include <openssl/sha.h>
 #include <openssl/evp.h>
-#include <openssl/bio.h>
-#include <openssl/buffer.h>
-#include <zlib.h>
 #include <cstring>
 #include <sys/types.h>
 #include <pwd.h>
@@ -42,8 +44,8 @@ std::string sha256File(const fs::path& path) {
         return "";
     }
     
-    std::ifstream file(path, std::ios::binary);
-    if (!file) {
+    FileView view(path);
+    if (!view.isOpen()) {
         return "";
     }
     
@@ -54,17 +56,7 @@ std::string sha256File(const fs::path& path) {
     EVP_MD_CTX* ctx = EVP_MD_CTX_new();
     
     EVP_DigestInit_ex(ctx, md, nullptr);
-    
-    char buffer[4096];
-    while (file.read(buffer, sizeof(buffer))) {
-        EVP_DigestUpdate(ctx, buffer, static_cast<size_t>(file.gcount()));
-    }
-    
-    // Don't forget the last chunk if file size is not a multiple of the buffer size
-    if (file.gcount() > 0) {
-        EVP_DigestUpdate(ctx, buffer, static_cast<size_t>(file.gcount()));
-    }
-    
+    EVP_DigestUpdate(ctx, view.data(), view.size());
     EVP_DigestFinal_ex(ctx, hash, &length);
     EVP_MD_CTX_free(ctx);
     
@@ -160,111 +152,68 @@ std::string getUserEmail() {
 
 std::string formatTimestamp(const std::chrono::system_clock::time_point& timestamp) {
     std::time_t time = std::chrono::system_clock::to_time_t(timestamp);
-    std::tm* tm = std::gmtime(&time);
+    // Commits are hashed from several threads; gmtime shares its result
+    std::tm tm = {};
+    gmtime_r(&time, &tm);
     
     char buffer[32];
-    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", tm);
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &tm);
     
     return std::string(buffer);
 }
 
-std::chrono::system_clock::time_point parseTimestamp(const std::string& str) {
+std::chrono::system_clock::time_point parseTimestamp(std::string_view str) {
+    // The fixed layout formatTimestamp writes, read in place: history
+    // walks parse one of these per commit
+    auto field = [&str](size_t at, size_t width, int& value) {
+        const char* end = str.data() + at + width;
+        return std::from_chars(str.data() + at, end, value).ptr == end;
+    };
     std::tm tm = {};
-    std::istringstream ss(str);
-    ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%SZ");
+    int year = 0;
+    int month = 0;
+    if (str.size() < 19 || str[4] != '-' || str[7] != '-' || str[10] != 'T' || str[13] != ':' ||
+        str[16] != ':' || !field(0, 4, year) || !field(5, 2, month) || !field(8, 2, tm.tm_mday) ||
+        !field(11, 2, tm.tm_hour) || !field(14, 2, tm.tm_min) || !field(17, 2, tm.tm_sec)) {
+        tm = {};
+    } else {
+        tm.tm_year = year - 1900;
+        tm.tm_mon = month - 1;
+    }
     
-    return std::chrono::system_clock::from_time_t(std::mktime(&tm));
+    // The string is UTC, as written by formatTimestamp
+    return std::chrono::system_clock::from_time_t(timegm(&tm));
 }
 
-std::string compress(const std::string& data) {
-    z_stream zs;
-    memset(&zs, 0, sizeof(zs));
-    
-    if (deflateInit(&zs, Z_BEST_COMPRESSION) != Z_OK) {
-        return "";
-    }
-    
-    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
-    zs.avail_in = data.size();
-    
-    int ret;
-    char outbuffer[32768];
-    std::string outstring;
-    
-    do {
-        zs.next_out = reinterpret_cast<Bytef*>(outbuffer);
-        zs.avail_out = sizeof(outbuffer);
-        
-        ret = deflate(&zs, Z_FINISH);
-        
-        if (outstring.size() < zs.total_out) {
-            outstring.append(outbuffer, zs.total_out - outstring.size());
-        }
-    } while (ret == Z_OK);
-    
-    deflateEnd(&zs);
-    
-    if (ret != Z_STREAM_END) {
+std::string compress(const std::string& data, CompressionLevel level) {
+    std::string out;
+    if (!Compressor::compress(data, out, level)) {
         return "";
     }
-    
-    return outstring;
+    return out;
 }
 
-std::string decompress(const std::string& data) {
-    z_stream zs;
-    memset(&zs, 0, sizeof(zs));
-    
-    if (inflateInit(&zs) != Z_OK) {
+std::string decompress(const std::string& data, size_t sizeHint) {
+    std::string out;
+    if (!Decompressor::decompress(data, out, sizeHint)) {
         return "";
     }
-    
-    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
-    zs.avail_in = data.size();
-    
-    int ret;
-    char outbuffer[32768];
-    std::string outstring;
-    
-    do {
-        zs.next_out = reinterpret_cast<Bytef*>(outbuffer);
-        zs.avail_out = sizeof(outbuffer);
-        
-        ret = inflate(&zs, 0);
-        
-        if (outstring.size() < zs.total_out) {
-            outstring.append(outbuffer, zs.total_out - outstring.size());
-        }
-    } while (ret == Z_OK);
-    
-    inflateEnd(&zs);
-    
-    if (ret != Z_STREAM_END) {
-        return "";
-    }
-    
-    return outstring;
+    return out;
 }
 
 std::string readFile(const fs::path& path) {
-    std::ifstream file(path, std::ios::binary);
-    if (!file) {
-        return "";
-    }
-    
-    file.seekg(0, std::ios::end);
-    size_t size = file.tellg();
-    file.seekg(0, std::ios::beg);
-    
-    std::string buffer(size, '\0');
-    file.read(&buffer[0], size);
-    
-    return buffer;
+    // Callers that only look at the contents should use a FileView directly
+    FileView view(path);
+    return std::string(view.view());
 }
 
 bool writeFile(const fs::path& path, const std::string& contents) {
-    // Create parent directory if it doesn't exist
-    fs::create_directories(path.parent_path());
+    // Create parent directory if it doesn't exist; it may be a symbolic
+    // link, which some standard libraries refuse in create_directories
+    std::error_code ec;
+    if (!fs::is_directory(path.parent_path(), ec)) {
+        fs::create_directories(path.parent_path());
+    }
     
     std::ofstream file(path, std::ios::binary);
     if (!file) {
@@ -296,6 +245,43 @@ std::vector<std::string> split(const std::string& s, char delimiter) {
     return tokens;
 }
 
+bool isSafePath(std::string_view path) {
+    if (path.find_first_of("\t\n") != std::string_view::npos) {
+        return false;
+    }
+    // An empty path, a leading or trailing '/' and "//" all give an empty component
+    size_t start = 0;
+    while (true) {
+        size_t end = std::min(path.find('/', start), path.size());
+        std::string_view part = path.substr(start, end - start);
+        if (part.empty() || part == "." || part == ".." || part == ".mimirion") {
+            return false;
+        }
+        if (end == path.size()) {
+            return true;
+        }
+        start = end + 1;
+    }
+}
+
+std::pmr::vector<std::string_view> splitLines(std::string_view text,
+                                              std::pmr::memory_resource* resource) {
+    std::pmr::vector<std::string_view> lines(resource);
+    
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) {
+            lines.push_back(text.substr(start));
+            break;
+        }
+        lines.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    
+    return lines;
+}
+
 std::string join(const std::vector<std::string>& strings, const std::string& delimiter) {
     std::ostringstream oss;
     
@@ -315,70 +301,22 @@ bool isBinaryFile(const fs::path& path) {
         return false;
     }
     
-    char buffer[4096];
+    // Same rule FileScanner applies while scanning a whole file
+    char buffer[FileScanner::kBinaryCheckSize];
     size_t bytesRead = file.read(buffer, sizeof(buffer)).gcount();
-    
-    // Check for null bytes, which are common in binary files
-    for (size_t i = 0; i < bytesRead; ++i) {
-        if (buffer[i] == '\0') {
-            return true;
-        }
-    }
-    
-    // Check if the file contains non-printable characters
-    for (size_t i = 0; i < bytesRead; ++i) {
-        unsigned char c = static_cast<unsigned char>(buffer[i]);
-        if (c < 32 && c != '\n' && c != '\r' && c != '\t') {
-            return true;
-        }
-    }
-    
-    return false;
+    return FileScanner::looksBinary(std::string_view(buffer, bytesRead));
 }
 
 std::string base64Encode(const std::string& data) {
-    BIO *bio, *b64;
-    BUF_MEM *bufferPtr;
-    
-    b64 = BIO_new(BIO_f_base64());
-    bio = BIO_new(BIO_s_mem());
-    bio = BIO_push(b64, bio);
-    
-    // Do not use newlines
-    BIO_set_flags(bio, BIO_FLAGS_BASE64_NO_NL);
-    
-    BIO_write(bio, data.c_str(), data.length());
-    BIO_flush(bio);
-    
-    BIO_get_mem_ptr(bio, &bufferPtr);
-    std::string result(bufferPtr->data, bufferPtr->length);
-    
-    BIO_free_all(bio);
-    
+    std::string result;
+    Base64Encoder::encode(data, result);
     return result;
 }
 
 std::string base64Decode(const std::string& encoded) {
-    BIO *bio, *b64;
-    
-    int decodedLength = encoded.length();
-    char* buffer = new char[decodedLength + 1];
-    buffer[decodedLength] = '\0';
-    
-    bio = BIO_new_mem_buf(encoded.c_str(), -1);
-    b64 = BIO_new(BIO_f_base64());
-    
-    // Do not use newlines
-    BIO_set_flags(b64, BIO_FLAGS_BASE64_NO_NL);
-    
-    bio = BIO_push(b64, bio);
-    
-    int length = BIO_read(bio, buffer, decodedLength);
-    std::string result(buffer, length);
-    
-    delete[] buffer;
-    BIO_free_all(bio);
-    
+    // Invalid input decodes to nothing, as before
+    std::string result;
+    Base64Decoder::decode(encoded, result);
     return result;
 }
 
@@ -0,0 +1,221 @@
+/**
+ * @file worktree.cpp
+ * @brief Implementation of the WorktreeManager class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include "../include/worktree.hpp"
+#include "../include/commit.hpp"
+#include "../include/file_tracker.hpp"
+#include "../include/refs.hpp"
+#include "../include/repository.hpp"
+#include "../include/utils.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace mimirion {
+
+namespace {
+
+// Entries of the main .mimirion directory every worktree shares
+const char* const kSharedEntries[] = {"objects", "refs", "config", "lfs", "import"};
+
+std::string firstLine(const fs::path& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+} // namespace
+
+WorktreeManager::WorktreeManager(const fs::path& repoPath, const fs::path& mimirDir)
+    : repositoryPath(repoPath), mimirionDir(mimirDir), mainDir(commonDir(mimirDir)) {
+}
+
+fs::path WorktreeManager::commonDir(const fs::path& mimirionDir) {
+    std::string common = firstLine(mimirionDir / "commondir");
+    if (common.empty()) {
+        return mimirionDir;
+    }
+    fs::path path = common;
+    path = (path.is_relative() ? mimirionDir / path : path).lexically_normal();
+    return path.has_filename() ? path : path.parent_path();
+}
+
+bool WorktreeManager::add(const fs::path& path, const std::string& branch) {
+    fs::path target = fs::absolute(path).lexically_normal();
+    std::error_code ec;
+    if (fs::exists(target, ec) && !(fs::is_directory(target, ec) && fs::is_empty(target, ec))) {
+        std::cerr << "Worktree path already exists: " << target.string() << std::endl;
+        return false;
+    }
+    if (RefStore(mainDir).readRef("refs/heads/" + branch).empty()) {
+        std::cerr << "Branch does not exist: " << branch << std::endl;
+        return false;
+    }
+    for (const auto& worktree : list()) {
+        if (worktree.branch == branch) {
+            std::cerr << "Branch " << branch << " is already checked out at " << worktree.path.string() << std::endl;
+            return false;
+        }
+    }
+
+    // Name the worktree after its directory, numbered if that is taken
+    std::string base = target.filename().string();
+    if (base.empty() || base == "." || base == "..") {
+        base = "worktree";
+    }
+    std::string name = base;
+    for (int i = 1; fs::exists(mainDir / "worktrees" / name, ec); ++i) {
+        name = base + std::to_string(i);
+    }
+    fs::path admin = mainDir / "worktrees" / name;
+    bool created = !fs::exists(target, ec);
+
+    auto cleanUp = [&]() {
+        std::error_code ignored;
+        fs::remove_all(admin, ignored);
+        if (created) {
+            fs::remove_all(target, ignored);
+        } else {
+            fs::remove(target / ".mimirion", ignored);
+        }
+        return false;
+    };
+
+    // Only HEAD and the index are the worktree's own, the rest is linked
+    fs::create_directories(admin, ec);
+    for (const char* entry : kSharedEntries) {
+        fs::create_directories(mainDir / entry, ec);
+        fs::create_directory_symlink(fs::path("..") / ".." / entry, admin / entry, ec);
+        if (ec) {
+            std::cerr << "Failed to link " << entry << " into " << admin.string() << ": " << ec.message() << std::endl;
+            return cleanUp();
+        }
+    }
+    fs::create_directories(target, ec);
+    if (!utils::writeFile(admin / "commondir", "../..\n") ||
+        !utils::writeFile(admin / "worktree", target.string() + "\n") ||
+        !RefStore(admin).setHead(branch) ||
+        !utils::writeFile(target / ".mimirion", "mimirdir: " + admin.string() + "\n")) {
+        std::cerr << "Failed to set up worktree " << name << std::endl;
+        return cleanUp();
+    }
+
+    Repository worktree;
+    if (!worktree.load(target.string()) || !worktree.checkout(branch)) {
+        return cleanUp();
+    }
+    return true;
+}
+
+std::vector<WorktreeInfo> WorktreeManager::list() const {
+    std::vector<WorktreeInfo> worktrees;
+    auto describe = [](WorktreeInfo& info, const fs::path& dir) {
+        RefStore refs(dir);
+        info.branch = refs.currentBranch();
+        info.head = refs.resolve("HEAD");
+    };
+
+    WorktreeInfo main;
+    main.path = mainDir.parent_path();
+    describe(main, mainDir);
+    worktrees.push_back(main);
+
+    std::vector<std::string> names;
+    std::error_code ec;
+    for (fs::directory_iterator it(mainDir / "worktrees", ec), end; it != end && !ec; it.increment(ec)) {
+        if (it->is_directory()) {
+            names.push_back(it->path().filename().string());
+        }
+    }
+    std::sort(names.begin(), names.end());
+    for (const auto& name : names) {
+        WorktreeInfo info;
+        info.name = name;
+        info.path = firstLine(mainDir / "worktrees" / name / "worktree");
+        describe(info, mainDir / "worktrees" / name);
+        worktrees.push_back(info);
+    }
+    return worktrees;
+}
+
+bool WorktreeManager::find(const std::string& worktree, WorktreeInfo& info) const {
+    fs::path path = fs::absolute(worktree).lexically_normal();
+    for (const auto& candidate : list()) {
+        if (candidate.name == worktree || candidate.path == path) {
+            if (candidate.name.empty()) {
+                std::cerr << "The main worktree cannot be removed" << std::endl;
+                return false;
+            }
+            info = candidate;
+            return true;
+        }
+    }
+    std::cerr << "Not a worktree: " << worktree << std::endl;
+    return false;
+}
+
+bool WorktreeManager::isClean(const WorktreeInfo& info) const {
+    fs::path admin = mainDir / "worktrees" / info.name;
+    CommitInfo commit;
+    if (!info.head.empty() && !CommitManager(info.path, admin).readCommit(info.head, commit)) {
+        return false;
+    }
+
+    // Every file has to be the one committed, and every committed file there
+    FileTracker tracker(info.path, admin);
+    tracker.updateStatus();
+    size_t matched = 0;
+    for (const auto& file : tracker.getFiles()) {
+        auto it = commit.fileHashes.find(file.path);
+        if (it == commit.fileHashes.end() || it->second != file.hash) {
+            return false;
+        }
+        ++matched;
+    }
+    return matched == commit.fileHashes.size();
+}
+
+bool WorktreeManager::remove(const std::string& worktree, bool force) {
+    WorktreeInfo info;
+    if (!find(worktree, info)) {
+        return false;
+    }
+    fs::path admin = mainDir / "worktrees" / info.name;
+    std::error_code ec;
+    bool present = fs::is_regular_file(info.path / ".mimirion", ec) &&
+                   Repository::findMimirionDir(info.path) == admin;
+    if (present && !force && !isClean(info)) {
+        std::cerr << "Worktree " << info.name << " has changes, use --force to remove it anyway" << std::endl;
+        return false;
+    }
+
+    // The directory is only deleted while it still links to this worktree
+    if (present) {
+        fs::remove_all(info.path, ec);
+        if (ec) {
+            std::cerr << "Failed to remove " << info.path.string() << ": " << ec.message() << std::endl;
+            return false;
+        }
+    }
+    fs::remove_all(admin, ec);
+    return !ec;
+}
+
+size_t WorktreeManager::prune() {
+    size_t pruned = 0;
+    for (const auto& info : list()) {
+        std::error_code ec;
+        if (!info.name.empty() && !fs::exists(info.path / ".mimirion", ec)) {
+            fs::remove_all(mainDir / "worktrees" / info.name, ec);
+            ++pruned;
+        }
+    }
+    return pruned;
+}
+
+} // namespace mimirion
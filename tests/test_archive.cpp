@@ -0,0 +1,181 @@
+/**
+ * @file test_archive.cpp
+ * @brief Unit tests for archive export
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <string>
+#include "archive.hpp"
+#include "commit.hpp"
+#include "repository.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class ArchiveTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary repository for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_archive";
+        fs::create_directories(testDir);
+        mimirionDir = testDir / ".mimirion";
+        repo.init(testDir.string());
+
+        originalPath = fs::current_path();
+        fs::current_path(testDir);
+    }
+
+    void TearDown() override {
+        // Change back and clean up the temporary directory
+        fs::current_path(originalPath);
+        fs::remove_all(testDir);
+    }
+
+    void commitFiles(const std::map<std::string, std::string>& files) {
+        std::vector<std::string> paths;
+        for (const auto& [path, content] : files) {
+            mimirion::utils::writeFile(testDir / path, content);
+            paths.push_back(path);
+        }
+        mimirion::CommitManager commits(testDir, mimirionDir);
+        ASSERT_FALSE(commits.createCommit("Files", paths).empty());
+    }
+
+    std::string archive(mimirion::ArchiveFormat format, const std::string& prefix = "") {
+        mimirion::ArchiveOptions options;
+        options.format = format;
+        options.prefix = prefix;
+        std::string out;
+        mimirion::Archiver archiver(testDir, mimirionDir);
+        EXPECT_TRUE(archiver.write("HEAD", options, [&out](const char* data, size_t size) {
+            out.append(data, size);
+            return true;
+        }));
+        return out;
+    }
+
+    // Lists the files of an archive with Python's tarfile or zipfile module
+    std::string listWithPython(const std::string& archiveData, bool zip) {
+        fs::path file = testDir / (zip ? "out.zip" : "out.tar.gz");
+        fs::path listing = testDir / "listing.txt";
+        mimirion::utils::writeFile(file, archiveData);
+        std::string script = zip
+            ? "import sys,zipfile,zlib\n"
+              "z=zipfile.ZipFile(sys.argv[1])\n"
+              "assert z.testzip() is None\n"
+              "out=open(sys.argv[2],'w')\n"
+              "for i in z.infolist(): out.write('%s %d %08x\\n'%(i.filename,i.file_size,zlib.crc32(z.read(i))))\n"
+            : "import sys,tarfile,zlib\n"
+              "t=tarfile.open(sys.argv[1],'r:gz')\n"
+              "out=open(sys.argv[2],'w')\n"
+              "for m in t.getmembers(): out.write('%s %d %08x\\n'%(m.name,m.size,zlib.crc32(t.extractfile(m).read())))\n";
+        mimirion::utils::writeFile(testDir / "list.py", script);
+        std::string command = "python3 " + (testDir / "list.py").string() + " " + file.string() + " " +
+                              listing.string() + " > /dev/null 2>&1";
+        EXPECT_EQ(std::system(command.c_str()), 0);
+        return fs::exists(listing) ? mimirion::utils::readFile(listing) : "";
+    }
+
+    static bool hasPython() {
+        return std::system("python3 -c pass > /dev/null 2>&1") == 0;
+    }
+
+    mimirion::Repository repo;
+    fs::path testDir;
+    fs::path mimirionDir;
+    fs::path originalPath;
+};
+
+// Test the tar layout: headers, long names, padding and determinism
+TEST_F(ArchiveTest, Tar) {
+    std::string splitPath = std::string(60, 'd') + "/" + std::string(60, 'f') + ".txt";
+    std::string longName = std::string(120, 'n') + ".txt";
+    commitFiles({{"a.txt", "alpha\n"}, {"dir/b.txt", std::string(1000, 'b')},
+                 {splitPath, "split\n"}, {longName, "pax\n"}});
+
+    std::string tar = archive(mimirion::ArchiveFormat::TAR, "pkg/");
+    EXPECT_EQ(tar.size() % 10240, 0u);
+    EXPECT_EQ(tar, archive(mimirion::ArchiveFormat::TAR, "pkg/"));
+
+    // Walk the headers, applying pax path records
+    std::map<std::string, std::string> files;
+    std::string paxPath;
+    size_t offset = 0;
+    while (offset + 512 <= tar.size() && tar[offset] != '\0') {
+        std::string header = tar.substr(offset, 512);
+        EXPECT_EQ(header.substr(257, 5), "ustar");
+        size_t size = std::stoul(header.substr(124, 11), nullptr, 8);
+        char type = header[156];
+        std::string data = tar.substr(offset + 512, size);
+        offset += 512 + (size + 511) / 512 * 512;
+
+        if (type == 'g') {
+            EXPECT_NE(data.find("comment="), std::string::npos);
+        } else if (type == 'x') {
+            size_t at = data.find("path=");
+            ASSERT_NE(at, std::string::npos);
+            paxPath = data.substr(at + 5, data.find('\n', at) - at - 5);
+        } else {
+            EXPECT_EQ(type, '0');
+            std::string name = header.substr(0, 100).c_str();
+            std::string prefix = header.substr(345, 155).c_str();
+            std::string path = !paxPath.empty() ? paxPath : prefix.empty() ? name : prefix + "/" + name;
+            files[path] = data;
+            paxPath.clear();
+        }
+    }
+
+    ASSERT_EQ(files.size(), 4u);
+    EXPECT_EQ(files["pkg/a.txt"], "alpha\n");
+    EXPECT_EQ(files["pkg/dir/b.txt"], std::string(1000, 'b'));
+    EXPECT_EQ(files["pkg/" + splitPath], "split\n");
+    EXPECT_EQ(files["pkg/" + longName], "pax\n");
+
+    mimirion::Archiver archiver(testDir, mimirionDir);
+    EXPECT_FALSE(archiver.write("missing", mimirion::ArchiveOptions(),
+                                [](const char*, size_t) { return true; }));
+}
+
+// Test that zip and tgz archives read back with Python
+TEST_F(ArchiveTest, ZipAndTgz) {
+    if (!hasPython()) {
+        GTEST_SKIP() << "python3 is not available";
+    }
+    std::string text;
+    for (int i = 0; i < 2000; ++i) {
+        text += "line " + std::to_string(i) + "\n";
+    }
+    commitFiles({{"a.txt", "alpha\n"}, {"src/text.txt", text}, {"empty", ""}});
+
+    std::string zip = listWithPython(archive(mimirion::ArchiveFormat::ZIP), true);
+    EXPECT_NE(zip.find("a.txt 6 "), std::string::npos);
+    EXPECT_NE(zip.find("src/text.txt " + std::to_string(text.size())), std::string::npos);
+    EXPECT_NE(zip.find("empty 0 00000000"), std::string::npos);
+
+    std::string tgz = listWithPython(archive(mimirion::ArchiveFormat::TGZ), false);
+    EXPECT_EQ(tgz, zip);
+}
+
+// Test that blobs above the stream threshold are archived intact
+TEST_F(ArchiveTest, StreamedEntries) {
+    if (!hasPython()) {
+        GTEST_SKIP() << "python3 is not available";
+    }
+    std::string large;
+    large.reserve(mimirion::Archiver::kStreamThreshold + 4096);
+    for (size_t i = 0; large.size() <= mimirion::Archiver::kStreamThreshold; ++i) {
+        large += std::to_string(i * 7919) + "\n";
+    }
+    commitFiles({{"big.dat", large}, {"small.txt", "small\n"}});
+
+    std::string zip = listWithPython(archive(mimirion::ArchiveFormat::ZIP), true);
+    std::string tgz = listWithPython(archive(mimirion::ArchiveFormat::TGZ), false);
+    EXPECT_NE(zip.find("big.dat " + std::to_string(large.size())), std::string::npos);
+    EXPECT_NE(zip.find("small.txt 6 "), std::string::npos);
+    EXPECT_EQ(tgz, zip);
+}
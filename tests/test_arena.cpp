@@ -0,0 +1,137 @@
+/**
+ * @file test_arena.cpp
+ * @brief Unit tests for the Arena class and arena-backed parsing
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "arena.hpp"
+#include "commit.hpp"
+#include "object_store.hpp"
+#include "repository.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+// Test that containers allocate through the arena and release resets it
+TEST(ArenaTest, CountsAndReleases) {
+    mimirion::Arena arena;
+    
+    {
+        std::pmr::vector<int> numbers(arena.resource());
+        for (int i = 0; i < 100; ++i) {
+            numbers.push_back(i);
+        }
+        EXPECT_EQ(numbers.back(), 99);
+    }
+    
+    EXPECT_GT(arena.allocationCount(), 0u);
+    EXPECT_GE(arena.bytesAllocated(), 100 * sizeof(int));
+    
+    arena.release();
+    EXPECT_EQ(arena.allocationCount(), 0u);
+    EXPECT_EQ(arena.bytesAllocated(), 0u);
+}
+
+// Test an arena whose first block is a stack buffer
+TEST(ArenaTest, UsesCallerBuffer) {
+    alignas(std::max_align_t) char buffer[1024];
+    mimirion::Arena arena(buffer, sizeof(buffer));
+    
+    void* p = arena.resource()->allocate(64, alignof(std::max_align_t));
+    EXPECT_GE(static_cast<char*>(p), buffer);
+    EXPECT_LT(static_cast<char*>(p), buffer + sizeof(buffer));
+    
+    // Larger requests spill over to the heap transparently
+    void* big = arena.resource()->allocate(4096, 8);
+    EXPECT_NE(big, nullptr);
+    EXPECT_EQ(arena.allocationCount(), 2u);
+}
+
+// Test splitting text into line views
+TEST(ArenaTest, SplitLines) {
+    mimirion::Arena arena;
+    std::string text = "first\n\nthird\nlast";
+    
+    auto lines = mimirion::utils::splitLines(text, arena.resource());
+    ASSERT_EQ(lines.size(), 4u);
+    EXPECT_EQ(lines[0], "first");
+    EXPECT_EQ(lines[1], "");
+    EXPECT_EQ(lines[2], "third");
+    EXPECT_EQ(lines[3], "last");
+    EXPECT_EQ(lines[0].data(), text.data());
+    
+    // A trailing newline does not add an empty line
+    auto trailing = mimirion::utils::splitLines("a\nb\n", arena.resource());
+    EXPECT_EQ(trailing.size(), 2u);
+    
+    EXPECT_TRUE(mimirion::utils::splitLines("", arena.resource()).empty());
+}
+
+// Test reading commits into arena memory, one after another
+TEST(ArenaTest, ReadsCommitRecords) {
+    fs::path testDir = fs::temp_directory_path() / "mimirion_test_arena";
+    fs::remove_all(testDir);
+    fs::create_directories(testDir);
+    fs::path mimirionDir = testDir / ".mimirion";
+    mimirion::Repository repo;
+    ASSERT_TRUE(repo.init(testDir.string()));
+    
+    mimirion::CommitManager commits(testDir, mimirionDir);
+    mimirion::ObjectStore objects(mimirionDir);
+    mimirion::CommitInfo first;
+    first.message = "First\n\nWith a body\n";
+    first.author = "Ada";
+    first.email = "ada@example.com";
+    first.timestamp = mimirion::utils::parseTimestamp("2025-06-01T12:30:45Z");
+    first.fileHashes["a.txt"] = mimirion::utils::sha256("a");
+    first.fileHashes["dir/b.txt"] = mimirion::utils::sha256("b");
+    commits.hashCommit(first);
+    ASSERT_TRUE(commits.storeCommit(first, objects));
+    mimirion::CommitInfo second = first;
+    second.message = "Second";
+    second.parentHashes = {first.hash};
+    commits.hashCommit(second);
+    ASSERT_TRUE(commits.storeCommit(second, objects));
+    
+    alignas(std::max_align_t) char buffer[4096];
+    mimirion::Arena arena(buffer, sizeof(buffer));
+    for (const auto* expected : {&second, &first, &second}) {
+        arena.release();
+        mimirion::CommitRecord record(arena);
+        ASSERT_TRUE(commits.readCommit(expected->hash, objects, record));
+        mimirion::CommitInfo info;
+        ASSERT_TRUE(commits.readCommit(expected->hash, info));
+        
+        EXPECT_EQ(std::string_view(record.hash), expected->hash);
+        EXPECT_EQ(record.message, expected->message);
+        EXPECT_EQ(info.message, expected->message);
+        EXPECT_EQ(record.author, "Ada");
+        EXPECT_EQ(record.email, "ada@example.com");
+        EXPECT_EQ(record.timestamp, expected->timestamp);
+        ASSERT_EQ(record.parentHashes.size(), expected->parentHashes.size());
+        for (size_t i = 0; i < record.parentHashes.size(); ++i) {
+            EXPECT_EQ(record.parentHashes[i], expected->parentHashes[i]);
+        }
+        ASSERT_EQ(record.files.size(), 2u);
+        for (const auto& [path, hash] : record.files) {
+            EXPECT_EQ(expected->fileHashes.at(std::string(path)), hash);
+        }
+        
+        // The views point into the record's copy of the object
+        EXPECT_GE(record.message.data(), record.content.data());
+        EXPECT_LE(record.message.data() + record.message.size(),
+                  record.content.data() + record.content.size());
+        EXPECT_GT(arena.allocationCount(), 0u);
+    }
+    
+    mimirion::CommitRecord missing(arena);
+    EXPECT_FALSE(commits.readCommit(mimirion::utils::sha256("missing"), objects, missing));
+    
+    fs::remove_all(testDir);
+}
@@ -0,0 +1,85 @@
+/**
+ * @file test_attributes.cpp
+ * @brief Unit tests for the Attributes class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include "attributes.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class AttributesTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary directory for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_attributes";
+        fs::create_directories(testDir);
+    }
+
+    void TearDown() override {
+        // Clean up the temporary directory
+        fs::remove_all(testDir);
+    }
+
+    fs::path testDir;
+};
+
+// Test pattern matching against relative paths
+TEST_F(AttributesTest, MatchPatterns) {
+    using mimirion::Attributes;
+    EXPECT_TRUE(Attributes::matches("*.psd", "art.psd"));
+    EXPECT_TRUE(Attributes::matches("*.psd", "assets/deep/art.psd"));
+    EXPECT_FALSE(Attributes::matches("*.psd", "art.psd.txt"));
+
+    EXPECT_TRUE(Attributes::matches("assets/*.bin", "assets/a.bin"));
+    EXPECT_FALSE(Attributes::matches("assets/*.bin", "assets/sub/a.bin"));
+    EXPECT_TRUE(Attributes::matches("/assets/*.bin", "assets/a.bin"));
+
+    EXPECT_TRUE(Attributes::matches("assets/**", "assets/sub/a.bin"));
+    EXPECT_FALSE(Attributes::matches("assets/**", "other/a.bin"));
+    EXPECT_TRUE(Attributes::matches("**/build/*.o", "build/a.o"));
+    EXPECT_TRUE(Attributes::matches("**/build/*.o", "src/build/a.o"));
+    EXPECT_FALSE(Attributes::matches("**/build/*.o", "src/build/x/a.o"));
+}
+
+// Test parsing values, comments and rule precedence
+TEST_F(AttributesTest, ParseAndLookup) {
+    auto attributes = mimirion::Attributes::parse(
+        "# large files\n"
+        "*.bin filter=lfs -diff\n"
+        "\n"
+        "keep/*.bin -filter text\n");
+
+    EXPECT_EQ(attributes.get("a.bin", "filter"), "lfs");
+    EXPECT_EQ(attributes.get("a.bin", "diff"), "false");
+    EXPECT_EQ(attributes.get("keep/a.bin", "filter"), "false");
+    EXPECT_EQ(attributes.get("keep/a.bin", "text"), "true");
+    EXPECT_FALSE(attributes.get("a.txt", "filter").has_value());
+
+    auto all = attributes.getAll("keep/a.bin");
+    EXPECT_EQ(all.size(), 3u);
+    EXPECT_EQ(all["diff"], "false");
+
+    EXPECT_EQ(attributes.patternsWith("filter", "lfs"), std::vector<std::string>{"*.bin"});
+    EXPECT_TRUE(mimirion::Attributes::parse("# only a comment\n").empty());
+}
+
+// Test loading and appending to the attributes file
+TEST_F(AttributesTest, LoadAndAddRule) {
+    EXPECT_TRUE(mimirion::Attributes::load(testDir).empty());
+
+    mimirion::utils::writeFile(testDir / mimirion::Attributes::kFileName, "*.iso filter=lfs");
+    EXPECT_TRUE(mimirion::Attributes::addRule(testDir, "*.psd", "filter=lfs"));
+    EXPECT_TRUE(mimirion::Attributes::addRule(testDir, "*.psd", "filter=lfs"));
+
+    EXPECT_EQ(mimirion::utils::readFile(testDir / mimirion::Attributes::kFileName),
+              "*.iso filter=lfs\n*.psd filter=lfs\n");
+    auto attributes = mimirion::Attributes::load(testDir);
+    EXPECT_EQ(attributes.get("image.psd", "filter"), "lfs");
+    EXPECT_EQ(attributes.get("disk.iso", "filter"), "lfs");
+}
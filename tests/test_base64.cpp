@@ -0,0 +1,137 @@
+/**
+ * @file test_base64.cpp
+ * @brief Unit tests for the Base64Encoder and Base64Decoder classes
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include "base64.hpp"
+#include "utils.hpp"
+
+namespace {
+
+// Straightforward reference encoder
+std::string referenceEncode(const std::string& data) {
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    size_t i = 0;
+    for (; i + 2 < data.size(); i += 3) {
+        unsigned v = (static_cast<unsigned char>(data[i]) << 16) |
+                     (static_cast<unsigned char>(data[i + 1]) << 8) |
+                     static_cast<unsigned char>(data[i + 2]);
+        out += alphabet[(v >> 18) & 63];
+        out += alphabet[(v >> 12) & 63];
+        out += alphabet[(v >> 6) & 63];
+        out += alphabet[v & 63];
+    }
+    if (i < data.size()) {
+        unsigned v = static_cast<unsigned char>(data[i]) << 16;
+        if (i + 1 < data.size()) {
+            v |= static_cast<unsigned char>(data[i + 1]) << 8;
+        }
+        out += alphabet[(v >> 18) & 63];
+        out += alphabet[(v >> 12) & 63];
+        out += i + 1 < data.size() ? alphabet[(v >> 6) & 63] : '=';
+        out += '=';
+    }
+    return out;
+}
+
+std::string randomBytes(std::mt19937& rng, size_t size) {
+    std::string data(size, '\0');
+    for (auto& c : data) {
+        c = static_cast<char>(rng() & 0xff);
+    }
+    return data;
+}
+
+} // namespace
+
+class Base64Test : public ::testing::TestWithParam<const char*> {
+protected:
+    void SetUp() override {
+        detected = mimirion::base64Kernel();
+        if (!mimirion::setBase64Kernel(GetParam())) {
+            GTEST_SKIP() << GetParam() << " is not supported on this CPU";
+        }
+    }
+
+    void TearDown() override {
+        mimirion::setBase64Kernel(detected);
+    }
+
+    std::string detected;
+};
+
+// Test one-shot encoding and decoding against the reference at many sizes
+TEST_P(Base64Test, OneShotMatchesReference) {
+    std::mt19937 rng(42);
+    for (size_t size = 0; size < 300; ++size) {
+        std::string data = randomBytes(rng, size);
+        std::string encoded;
+        mimirion::Base64Encoder::encode(data, encoded);
+        ASSERT_EQ(encoded, referenceEncode(data)) << "size " << size;
+
+        std::string decoded;
+        ASSERT_TRUE(mimirion::Base64Decoder::decode(encoded, decoded)) << "size " << size;
+        ASSERT_EQ(decoded, data) << "size " << size;
+    }
+}
+
+// Test streaming in uneven chunks, with line-wrapped input for the decoder
+TEST_P(Base64Test, StreamingChunks) {
+    std::mt19937 rng(7);
+    std::string data = randomBytes(rng, 200 * 1024 + 5);
+
+    std::string encoded;
+    auto appendEncoded = [&encoded](const char* chunk, size_t size) {
+        encoded.append(chunk, size);
+        return true;
+    };
+    mimirion::Base64Encoder encoder;
+    for (size_t pos = 0, step = 1; pos < data.size(); pos += step, step = step * 3 % 9973 + 1) {
+        ASSERT_TRUE(encoder.write(data.data() + pos, std::min(step, data.size() - pos), appendEncoded));
+    }
+    ASSERT_TRUE(encoder.finish(appendEncoded));
+    ASSERT_EQ(encoded, referenceEncode(data));
+
+    // Wrap at 60 characters with CRLF, as some servers send it
+    std::string wrapped;
+    for (size_t i = 0; i < encoded.size(); i += 60) {
+        wrapped += encoded.substr(i, 60) + "\r\n";
+    }
+
+    std::string decoded;
+    auto appendDecoded = [&decoded](const char* chunk, size_t size) {
+        decoded.append(chunk, size);
+        return true;
+    };
+    mimirion::Base64Decoder decoder;
+    for (size_t pos = 0, step = 1; pos < wrapped.size(); pos += step, step = step * 5 % 7919 + 1) {
+        ASSERT_TRUE(decoder.write(wrapped.data() + pos, std::min(step, wrapped.size() - pos), appendDecoded));
+    }
+    ASSERT_TRUE(decoder.finish(appendDecoded));
+    EXPECT_EQ(decoded, data);
+}
+
+// Test that invalid input is rejected
+TEST_P(Base64Test, RejectsInvalidInput) {
+    std::string out;
+    EXPECT_FALSE(mimirion::Base64Decoder::decode("SGVsbG8*", out));
+    EXPECT_FALSE(mimirion::Base64Decoder::decode("S", out));
+    EXPECT_FALSE(mimirion::Base64Decoder::decode("SGVsbG8=QUJD", out));
+    EXPECT_FALSE(mimirion::Base64Decoder::decode("SG==VsbG8", out));
+    EXPECT_FALSE(mimirion::Base64Decoder::decode(std::string(40, 'A') + "\x80" + std::string(40, 'A'), out));
+    EXPECT_TRUE(out.empty());
+
+    // Padding may be omitted at the end
+    EXPECT_TRUE(mimirion::Base64Decoder::decode("SGk", out));
+    EXPECT_EQ(out, "Hi");
+    EXPECT_EQ(mimirion::utils::base64Decode("SGVsbG8sIE1pbWlyaW9uIQ=="), "Hello, Mimirion!");
+}
+
+INSTANTIATE_TEST_SUITE_P(Kernels, Base64Test, ::testing::Values("scalar", "ssse3", "avx2"));
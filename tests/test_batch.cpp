@@ -0,0 +1,100 @@
+/**
+ * @file test_batch.cpp
+ * @brief Unit tests for the BatchProcessor class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "batch.hpp"
+#include "object_store.hpp"
+
+namespace fs = std::filesystem;
+
+class BatchTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary directory for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_batch";
+        mimirionDir = testDir / ".mimirion";
+        fs::create_directories(mimirionDir / "objects");
+        fs::create_directories(mimirionDir / "refs" / "heads");
+        
+        std::ofstream headFile(mimirionDir / "HEAD");
+        headFile << "ref: refs/heads/master" << std::endl;
+        headFile.close();
+    }
+
+    void TearDown() override {
+        // Clean up the temporary directory
+        fs::remove_all(testDir);
+    }
+
+    // Create a sample file with content
+    void createSampleFile(const std::string& name, const std::string& content) {
+        std::ofstream file(testDir / name);
+        file << content;
+        file.close();
+    }
+
+    fs::path testDir;
+    fs::path mimirionDir;
+};
+
+// Test reading objects and resolving refs
+TEST_F(BatchTest, CatObjectAndResolve) {
+    mimirion::ObjectStore store(mimirionDir);
+    std::string hash = store.writeObject("batch content\n");
+    
+    std::ofstream branchFile(mimirionDir / "refs" / "heads" / "master");
+    branchFile << hash << std::endl;
+    branchFile.close();
+    
+    mimirion::BatchProcessor batch(testDir, mimirionDir);
+    EXPECT_EQ(batch.resolve("HEAD"), hash);
+    EXPECT_EQ(batch.resolve("master"), hash);
+    EXPECT_EQ(batch.resolve(hash.substr(0, 10)), hash);
+    
+    std::string payload;
+    EXPECT_TRUE(batch.handle("cat-object HEAD", payload));
+    EXPECT_EQ(payload, "batch content\n");
+    EXPECT_FALSE(batch.handle("cat-object 0000aaaa", payload));
+}
+
+// Test the length-prefixed stream protocol
+TEST_F(BatchTest, StreamProtocol) {
+    createSampleFile("notes.txt", "untracked notes");
+    mimirion::BatchProcessor batch(testDir, mimirionDir);
+    
+    std::istringstream in("status-path notes.txt\nstatus-path missing.txt\nbogus\n");
+    std::ostringstream out;
+    EXPECT_EQ(batch.run(in, out), 3u);
+    
+    std::string expected = "ok 9\nuntracked\n"
+                           "error 24\nno such path missing.txt\n"
+                           "error 21\nunknown command bogus\n";
+    EXPECT_EQ(out.str(), expected);
+}
+
+// Test NUL delimited requests and blob diffs
+TEST_F(BatchTest, DiffBlobsNulDelimited) {
+    mimirion::ObjectStore store(mimirionDir);
+    std::string oldHash = store.writeObject("one\ntwo\n");
+    std::string newHash = store.writeObject("one\nthree\n");
+    
+    mimirion::BatchProcessor batch(testDir, mimirionDir);
+    std::string request = "diff-blobs " + oldHash + " " + newHash;
+    std::istringstream in(request + std::string(1, '\0'));
+    std::ostringstream out;
+    EXPECT_EQ(batch.run(in, out, '\0'), 1u);
+    
+    std::string response = out.str();
+    EXPECT_EQ(response.compare(0, 3, "ok "), 0);
+    EXPECT_TRUE(response.find("-two") != std::string::npos);
+    EXPECT_TRUE(response.find("+three") != std::string::npos);
+    EXPECT_EQ(response.back(), '\0');
+}
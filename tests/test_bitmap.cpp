@@ -0,0 +1,177 @@
+/**
+ * @file test_bitmap.cpp
+ * @brief Unit tests for reachability bitmaps
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "bitmap.hpp"
+#include "fast_import.hpp"
+#include "refs.hpp"
+#include "repository.hpp"
+
+namespace fs = std::filesystem;
+
+class BitmapTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary repository with a long master and a short side branch
+        testDir = fs::temp_directory_path() / "mimirion_test_bitmap";
+        fs::create_directories(testDir);
+        mimirionDir = testDir / ".mimirion";
+        repo.init(testDir.string());
+
+        originalPath = fs::current_path();
+        fs::current_path(testDir);
+
+        std::ostringstream stream;
+        for (int i = 1; i <= 250; ++i) {
+            commit(stream, "refs/heads/master", i, i > 1 ? ":" + std::to_string(2 * (i - 1)) : "");
+            if (i == 120) {
+                stream << "reset refs/heads/side\nfrom :" << 2 * i << "\n\n";
+            }
+        }
+        for (int i = 251; i <= 255; ++i) {
+            commit(stream, "refs/heads/side", i, i > 251 ? ":" + std::to_string(2 * (i - 1)) : ":240");
+        }
+        ASSERT_TRUE(import(stream.str()));
+        mimirion::RefStore refs(mimirionDir);
+        master = refs.readRef("refs/heads/master");
+        side = refs.readRef("refs/heads/side");
+    }
+
+    void TearDown() override {
+        // Change back and clean up the temporary directory
+        fs::current_path(originalPath);
+        fs::remove_all(testDir);
+    }
+
+    // Commit i changes one of four files, so blob i is new and the rest carry over
+    static void commit(std::ostream& out, const std::string& ref, int i, const std::string& from) {
+        std::string content = "content " + std::to_string(i) + "\n";
+        out << "blob\nmark :" << 2 * i - 1 << "\ndata " << content.size() << "\n" << content << "\n"
+            << "commit " << ref << "\nmark :" << 2 * i << "\nauthor A <a@example.com> " << i
+            << " +0000\ncommitter A <a@example.com> " << i << " +0000\ndata 2\nc\n";
+        if (!from.empty()) {
+            out << "from " << from << "\n";
+        }
+        out << "M 100644 :" << 2 * i - 1 << " f" << i % 4 << ".txt\n\n";
+    }
+
+    bool import(const std::string& stream) {
+        std::istringstream in(stream);
+        return mimirion::FastImporter(testDir, mimirionDir).run(in);
+    }
+
+    mimirion::ReachableObjects query(const std::vector<std::string>& include,
+                                     const std::vector<std::string>& exclude = {}) {
+        mimirion::ReachableObjects result;
+        EXPECT_TRUE(mimirion::BitmapIndex(mimirionDir).reachable(include, exclude, result));
+        return result;
+    }
+
+    mimirion::Repository repo;
+    fs::path testDir;
+    fs::path mimirionDir;
+    fs::path originalPath;
+    std::string master;
+    std::string side;
+};
+
+// Test that compression keeps every word and counts without inflating
+TEST_F(BitmapTest, EwahRoundTrip) {
+    std::vector<uint64_t> plain(300, 0);
+    std::fill(plain.begin() + 10, plain.begin() + 200, ~0ull);
+    plain[5] = 0x1234;
+    plain[6] = 0x8000000000000001ull;
+    plain[250] = 42;
+    plain[299] = 1;
+
+    mimirion::EwahBitmap bitmap = mimirion::EwahBitmap::compress(plain);
+    EXPECT_EQ(bitmap.wordCount(), plain.size());
+    EXPECT_LT(bitmap.compressedWords(), 12u);
+    std::vector<uint64_t> restored;
+    bitmap.orInto(restored);
+    EXPECT_EQ(restored, plain);
+    EXPECT_EQ(bitmap.count(), 190u * 64 + 5 + 2 + 3 + 1);
+
+    std::string data;
+    bitmap.serialize(data);
+    size_t offset = 0;
+    mimirion::EwahBitmap parsed;
+    ASSERT_TRUE(parsed.parse(data, offset));
+    EXPECT_EQ(offset, data.size());
+    restored.clear();
+    parsed.orInto(restored);
+    EXPECT_EQ(restored, plain);
+
+    offset = 0;
+    EXPECT_FALSE(parsed.parse(std::string_view(data).substr(0, data.size() - 1), offset));
+}
+
+// Test that answers with bitmaps equal those of a full walk
+TEST_F(BitmapTest, MatchesWalk) {
+    auto walked = query({master}, {side});
+    EXPECT_EQ(walked.commits, 130u);
+    EXPECT_EQ(walked.blobs, 130u);
+    EXPECT_EQ(walked.commitHashes.front(), master);
+    EXPECT_EQ(query({master, side}).commits, 255u);
+
+    mimirion::BitmapIndex index(mimirionDir);
+    EXPECT_FALSE(index.loaded());
+    mimirion::BitmapWriteStats stats;
+    ASSERT_TRUE(index.write(&stats));
+    EXPECT_EQ(stats.commits, 255u);
+    EXPECT_EQ(stats.objects, 510u);
+    EXPECT_EQ(stats.bitmaps, 4u);
+    EXPECT_TRUE(mimirion::BitmapIndex::verify(mimirionDir / "objects" / "info" / "bitmaps"));
+
+    mimirion::BitmapIndex loaded(mimirionDir);
+    EXPECT_TRUE(loaded.loaded());
+    EXPECT_EQ(loaded.bitmapCount(), 4u);
+    auto indexed = query({master}, {side});
+    EXPECT_EQ(indexed.commitHashes, walked.commitHashes);
+    EXPECT_EQ(indexed.blobs, walked.blobs);
+    EXPECT_EQ(query({side}, {master}).commits, 5u);
+    EXPECT_EQ(query({master}, {master}).commits, 0u);
+}
+
+// Test that commits made after the index was written are still counted
+TEST_F(BitmapTest, NewerThanIndex) {
+    ASSERT_TRUE(mimirion::BitmapIndex(mimirionDir).write());
+    std::ostringstream stream;
+    commit(stream, "refs/heads/master", 256, master);
+    ASSERT_TRUE(import(stream.str()));
+    std::string tip = mimirion::RefStore(mimirionDir).readRef("refs/heads/master");
+
+    auto result = query({tip}, {master});
+    EXPECT_EQ(result.commits, 1u);
+    EXPECT_EQ(result.blobs, 1u);
+    ASSERT_EQ(result.commitHashes.size(), 1u);
+    EXPECT_EQ(result.commitHashes[0], tip);
+    EXPECT_EQ(query({tip}).commits, 251u);
+}
+
+// Test that a damaged index is ignored instead of trusted
+TEST_F(BitmapTest, CorruptIndex) {
+    ASSERT_TRUE(mimirion::BitmapIndex(mimirionDir).write());
+    fs::path path = mimirionDir / "objects" / "info" / "bitmaps";
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-40, std::ios::end);
+        file.put('\x7f');
+    }
+    EXPECT_FALSE(mimirion::BitmapIndex::verify(path));
+
+    fs::resize_file(path, fs::file_size(path) - 100);
+    testing::internal::CaptureStderr();
+    mimirion::BitmapIndex index(mimirionDir);
+    EXPECT_FALSE(index.loaded());
+    EXPECT_EQ(query({master}).commits, 250u);
+    EXPECT_NE(testing::internal::GetCapturedStderr().find("corrupt"), std::string::npos);
+}
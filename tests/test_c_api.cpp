@@ -0,0 +1,118 @@
+/**
+ * @file test_c_api.cpp
+ * @brief Unit tests for the C interface of libmimirion
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include "mimirion.h"
+#include "repository.hpp"
+#include "object_store.hpp"
+
+namespace fs = std::filesystem;
+
+class CApiTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary directory for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_c_api";
+        fs::create_directories(testDir);
+        
+        // Change to the test directory
+        originalPath = fs::current_path();
+        fs::current_path(testDir);
+        
+        mimirion::Repository repo;
+        repo.init(testDir.string());
+    }
+
+    void TearDown() override {
+        // Change back to the original directory
+        fs::current_path(originalPath);
+        
+        // Clean up the temporary directory
+        fs::remove_all(testDir);
+    }
+    
+    // Create a sample file with content
+    void createSampleFile(const std::string& name, const std::string& content) {
+        std::ofstream file(testDir / name);
+        file << content;
+        file.close();
+    }
+
+    fs::path testDir;
+    fs::path originalPath;
+};
+
+// Test opening repositories
+TEST_F(CApiTest, OpenAndClose) {
+    mimirion_repository* repo = nullptr;
+    EXPECT_EQ(mimirion_repository_open(testDir.c_str(), &repo), MIMIRION_OK);
+    EXPECT_NE(repo, nullptr);
+    mimirion_repository_close(repo);
+    
+    EXPECT_EQ(mimirion_repository_open(nullptr, &repo), MIMIRION_INVALID);
+    EXPECT_STRNE(mimirion_last_error(), "");
+}
+
+// Test zero-copy object reads
+TEST_F(CApiTest, ObjectRead) {
+    mimirion::ObjectStore store(testDir / ".mimirion");
+    std::string hash = store.writeObject("embedded content");
+    
+    mimirion_repository* repo = nullptr;
+    ASSERT_EQ(mimirion_repository_open(testDir.c_str(), &repo), MIMIRION_OK);
+    
+    const void* data = nullptr;
+    size_t size = 0;
+    ASSERT_EQ(mimirion_object_read(repo, hash.c_str(), &data, &size), MIMIRION_OK);
+    EXPECT_EQ(std::string(static_cast<const char*>(data), size), "embedded content");
+    
+    // A second read returns the same buffer
+    const void* again = nullptr;
+    ASSERT_EQ(mimirion_object_read(repo, hash.c_str(), &again, &size), MIMIRION_OK);
+    EXPECT_EQ(again, data);
+    
+    EXPECT_EQ(mimirion_object_read(repo, "0000ffff", &data, &size), MIMIRION_NOT_FOUND);
+    mimirion_repository_close(repo);
+}
+
+// Test commits, ref lookup and status iteration
+TEST_F(CApiTest, CommitLookupAndStatus) {
+    createSampleFile("api.txt", "api content");
+    
+    mimirion_repository* repo = nullptr;
+    ASSERT_EQ(mimirion_repository_open(testDir.c_str(), &repo), MIMIRION_OK);
+    
+    const char* paths[] = {"api.txt"};
+    char commitHash[128];
+    ASSERT_EQ(mimirion_commit_create(repo, "C API commit", paths, 1, commitHash, sizeof(commitHash)),
+              MIMIRION_OK);
+    
+    char resolved[128];
+    ASSERT_EQ(mimirion_ref_lookup(repo, "HEAD", resolved, sizeof(resolved)), MIMIRION_OK);
+    EXPECT_STREQ(resolved, commitHash);
+    
+    char tiny[4];
+    EXPECT_EQ(mimirion_ref_lookup(repo, "HEAD", tiny, sizeof(tiny)), MIMIRION_BUFFER_TOO_SMALL);
+    EXPECT_EQ(mimirion_ref_lookup(repo, "no-such-branch", resolved, sizeof(resolved)),
+              MIMIRION_NOT_FOUND);
+    
+    std::vector<std::string> seen;
+    auto collect = [](const char* path, mimirion_file_status, void* payload) -> int {
+        static_cast<std::vector<std::string>*>(payload)->push_back(path);
+        return 0;
+    };
+    EXPECT_EQ(mimirion_status_foreach(repo, collect, &seen), MIMIRION_OK);
+    EXPECT_NE(std::find(seen.begin(), seen.end(), "api.txt"), seen.end());
+    
+    mimirion_repository_close(repo);
+}
@@ -0,0 +1,169 @@
+/**
+ * @file test_codec.cpp
+ * @brief Unit tests for the object codecs
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "codec.hpp"
+#include "config.hpp"
+#include "object_store.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class CodecTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary directory for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_codec";
+        mimirionDir = testDir / ".mimirion";
+        fs::create_directories(mimirionDir / "objects");
+        fs::create_directories(mimirionDir / "config");
+
+        // Keep the user and system scopes out of the test
+        setenv("MIMIRION_CONFIG_GLOBAL", (testDir / "user.config").c_str(), 1);
+        setenv("MIMIRION_CONFIG_SYSTEM", (testDir / "system.config").c_str(), 1);
+        mimirion::Config::invalidate();
+    }
+
+    void TearDown() override {
+        unsetenv("MIMIRION_CONFIG_GLOBAL");
+        unsetenv("MIMIRION_CONFIG_SYSTEM");
+        mimirion::Config::invalidate();
+
+        // Clean up the temporary directory
+        fs::remove_all(testDir);
+    }
+
+    void useCodec(const std::string& name) {
+        ASSERT_TRUE(mimirion::Config::set(mimirionDir, mimirion::Config::Scope::REPOSITORY,
+                                          "core.compression", name));
+    }
+
+    // Small objects that share most of their structure, like source files
+    static std::vector<std::string> similarObjects(size_t count) {
+        std::vector<std::string> objects;
+        for (size_t i = 0; i < count; ++i) {
+            objects.push_back("/**\n * @file module" + std::to_string(i) + ".cpp\n"
+                              " * @brief Implementation of module " + std::to_string(i * 7) + "\n"
+                              " * @author Mimirion Team\n */\n\n#include <string>\n\n"
+                              "namespace mimirion {\n\nint value" + std::to_string(i) +
+                              "() {\n    return " + std::to_string(i * 31) + ";\n}\n\n}\n");
+        }
+        return objects;
+    }
+
+    fs::path testDir;
+    fs::path mimirionDir;
+};
+
+// Test that object headers round trip
+TEST_F(CodecTest, HeaderRoundTrip) {
+    mimirion::ObjectHeader header;
+    header.codec = mimirion::CodecId::ZSTD;
+    header.dictionaryId = 0x12345678;
+    header.size = 0x1122334455ULL;
+
+    std::string encoded;
+    header.encode(encoded);
+    ASSERT_EQ(encoded.size(), mimirion::ObjectHeader::kSize);
+
+    mimirion::ObjectHeader decoded;
+    ASSERT_TRUE(mimirion::ObjectHeader::decode(encoded, decoded));
+    EXPECT_EQ(decoded.codec, header.codec);
+    EXPECT_EQ(decoded.dictionaryId, header.dictionaryId);
+    EXPECT_EQ(decoded.size, header.size);
+
+    EXPECT_FALSE(mimirion::ObjectHeader::decode(encoded.substr(0, 10), decoded));
+    EXPECT_FALSE(mimirion::ObjectHeader::decode("plain object content", decoded));
+}
+
+// Test round trips through every codec in this build
+TEST_F(CodecTest, RoundTripAllCodecs) {
+    std::string data;
+    for (int i = 0; i < 2000; ++i) {
+        data += "entry " + std::to_string(i % 97) + "\n";
+    }
+
+    auto codecs = mimirion::Codec::available();
+    ASSERT_GE(codecs.size(), 2u);
+    for (const mimirion::Codec* codec : codecs) {
+        std::string compressed;
+        ASSERT_TRUE(codec->compress(data, compressed, mimirion::CompressionLevel::DEFAULT))
+            << codec->name();
+
+        std::string restored;
+        ASSERT_TRUE(codec->decompress(compressed, restored, data.size())) << codec->name();
+        EXPECT_EQ(restored, data) << codec->name();
+        EXPECT_EQ(mimirion::Codec::find(codec->name()), codec);
+    }
+
+    EXPECT_EQ(mimirion::Codec::find("unknown"), nullptr);
+}
+
+// Test reading a repository whose objects were written with different codecs
+TEST_F(CodecTest, MixedCodecRepository) {
+    if (!mimirion::Codec::find(mimirion::CodecId::ZSTD)) {
+        GTEST_SKIP() << "zstd is not available in this build";
+    }
+
+    std::string zlibContent(5000, 'z');
+    std::string zlibHash = mimirion::ObjectStore(mimirionDir).writeObject(zlibContent);
+
+    useCodec("zstd");
+    mimirion::ObjectStore store(mimirionDir);
+    EXPECT_EQ(store.writeCodec().id(), mimirion::CodecId::ZSTD);
+    std::string zstdContent(5000, 's');
+    std::string zstdHash = store.writeObject(zstdContent);
+
+    mimirion::ObjectHeader header;
+    ASSERT_TRUE(mimirion::ObjectHeader::decode(
+        mimirion::utils::readFile(store.objectPath(zstdHash)), header));
+    EXPECT_EQ(header.codec, mimirion::CodecId::ZSTD);
+
+    useCodec("none");
+    mimirion::ObjectStore reader(mimirionDir);
+    ASSERT_NE(reader.readObject(zlibHash), nullptr);
+    EXPECT_EQ(*reader.readObject(zlibHash), zlibContent);
+    ASSERT_NE(reader.readObject(zstdHash), nullptr);
+    EXPECT_EQ(*reader.readObject(zstdHash), zstdContent);
+}
+
+// Test training a dictionary and using it for new small objects
+TEST_F(CodecTest, TrainedDictionary) {
+    if (!mimirion::Codec::find(mimirion::CodecId::ZSTD)) {
+        GTEST_SKIP() << "zstd is not available in this build";
+    }
+
+    useCodec("zstd");
+    auto samples = similarObjects(400);
+    {
+        mimirion::ObjectStore store(mimirionDir);
+        for (size_t i = 0; i < 300; ++i) {
+            ASSERT_FALSE(store.writeObject(samples[i]).empty());
+        }
+        uint32_t id = store.trainDictionary(8 * 1024);
+        ASSERT_NE(id, 0u);
+        EXPECT_EQ(store.writeDictionary(), id);
+    }
+
+    // A fresh store picks the dictionary up from disk
+    mimirion::ObjectStore store(mimirionDir);
+    ASSERT_NE(store.writeDictionary(), 0u);
+    std::string hash = store.writeObject(samples[350]);
+
+    mimirion::ObjectHeader header;
+    ASSERT_TRUE(mimirion::ObjectHeader::decode(
+        mimirion::utils::readFile(store.objectPath(hash)), header));
+    EXPECT_EQ(header.dictionaryId, store.writeDictionary());
+
+    mimirion::ObjectStore reader(mimirionDir);
+    ASSERT_NE(reader.readObject(hash), nullptr);
+    EXPECT_EQ(*reader.readObject(hash), samples[350]);
+}
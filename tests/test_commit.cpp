@@ -10,7 +10,10 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <cstdlib>
 #include "commit.hpp"
+#include "object_store.hpp"
+#include "utils.hpp"
 
 namespace fs = std::filesystem;
 
@@ -162,3 +165,56 @@ TEST_F(CommitManagerTest, CommitParentRelationship) {
         }
     }
 }
+
+// Test that the identity cached in the repository config is used for commits
+TEST_F(CommitManagerTest, UsesCachedIdentity) {
+    // Environment values would take precedence over the cache
+    std::string savedName = getenv("GIT_AUTHOR_NAME") ? getenv("GIT_AUTHOR_NAME") : "";
+    std::string savedEmail = getenv("GIT_AUTHOR_EMAIL") ? getenv("GIT_AUTHOR_EMAIL") : "";
+    unsetenv("GIT_AUTHOR_NAME");
+    unsetenv("GIT_AUTHOR_EMAIL");
+    
+    fs::create_directories(mimirionDir / "config");
+    std::ofstream settingsFile(mimirionDir / "config" / "settings");
+    settingsFile << "[user]" << std::endl;
+    settingsFile << "\tname = Cached Author" << std::endl;
+    settingsFile << "\temail = cached@example.com" << std::endl;
+    settingsFile.close();
+    
+    createSampleFile("identity.txt", "Identity test content");
+    std::vector<std::string> stagedFiles = {"identity.txt"};
+    std::string commitHash = commitManager->createCommit("Identity test", stagedFiles);
+    mimirion::CommitInfo* commit = commitManager->getCommit(commitHash);
+    
+    ASSERT_NE(commit, nullptr);
+    EXPECT_EQ(commit->author, "Cached Author");
+    EXPECT_EQ(commit->email, "cached@example.com");
+    
+    if (!savedName.empty()) {
+        setenv("GIT_AUTHOR_NAME", savedName.c_str(), 1);
+    }
+    if (!savedEmail.empty()) {
+        setenv("GIT_AUTHOR_EMAIL", savedEmail.c_str(), 1);
+    }
+}
+
+// Test that committed files are stored as blobs in the object store
+TEST_F(CommitManagerTest, StoresFileBlobs) {
+    createSampleFile("blob.txt", "Blob content");
+    
+    std::vector<std::string> stagedFiles = {"blob.txt"};
+    std::string commitHash = commitManager->createCommit("Blob commit", stagedFiles);
+    mimirion::CommitInfo* commit = commitManager->getCommit(commitHash);
+    ASSERT_NE(commit, nullptr);
+    
+    std::string blobHash = commit->fileHashes["blob.txt"];
+    EXPECT_EQ(blobHash, mimirion::utils::sha256("Blob content"));
+    
+    mimirion::ObjectStore objects(mimirionDir);
+    auto content = objects.readObject(blobHash);
+    ASSERT_NE(content, nullptr);
+    EXPECT_EQ(*content, "Blob content");
+    
+    // Missing files cannot be committed
+    EXPECT_TRUE(commitManager->createCommit("Missing", {"missing.txt"}).empty());
+}
@@ -0,0 +1,127 @@
+/**
+ * @file test_compression.cpp
+ * @brief Unit tests for the Compressor and Decompressor classes
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include "compression.hpp"
+#include "utils.hpp"
+
+namespace {
+
+std::string sampleData(size_t size) {
+    std::string data;
+    data.reserve(size);
+    for (size_t i = 0; data.size() < size; ++i) {
+        data += "line " + std::to_string(i % 977) + " of some repetitive sample text\n";
+    }
+    data.resize(size);
+    return data;
+}
+
+} // namespace
+
+// Test one-shot round trips at every level
+TEST(CompressionTest, OneShotRoundTrip) {
+    std::string data = sampleData(200 * 1024);
+    
+    for (auto level : {mimirion::CompressionLevel::FAST, mimirion::CompressionLevel::DEFAULT,
+                       mimirion::CompressionLevel::BEST}) {
+        std::string compressed;
+        ASSERT_TRUE(mimirion::Compressor::compress(data, compressed, level));
+        EXPECT_LT(compressed.size(), data.size());
+        EXPECT_TRUE(mimirion::Decompressor::looksCompressed(compressed));
+        
+        std::string restored;
+        ASSERT_TRUE(mimirion::Decompressor::decompress(compressed, restored));
+        EXPECT_EQ(restored, data);
+        
+        // Exact and too-small size hints give the same result
+        ASSERT_TRUE(mimirion::Decompressor::decompress(compressed, restored, data.size()));
+        EXPECT_EQ(restored, data);
+        ASSERT_TRUE(mimirion::Decompressor::decompress(compressed, restored, 10));
+        EXPECT_EQ(restored, data);
+    }
+    
+    EXPECT_EQ(mimirion::utils::decompress(mimirion::utils::compress("")), "");
+    EXPECT_EQ(mimirion::utils::decompress(mimirion::utils::compress("abc")), "abc");
+}
+
+// Test streaming in small pieces through sinks
+TEST(CompressionTest, Streaming) {
+    std::string data = sampleData(300 * 1024);
+    
+    std::string compressed;
+    auto appendCompressed = [&compressed](const char* chunk, size_t size) {
+        compressed.append(chunk, size);
+        return true;
+    };
+    {
+        mimirion::Compressor compressor(mimirion::CompressionLevel::FAST);
+        for (size_t pos = 0; pos < data.size(); pos += 1000) {
+            ASSERT_TRUE(compressor.write(data.data() + pos, std::min<size_t>(1000, data.size() - pos),
+                                         appendCompressed));
+        }
+        ASSERT_TRUE(compressor.finish(appendCompressed));
+        EXPECT_EQ(compressor.totalIn(), data.size());
+        EXPECT_EQ(compressor.totalOut(), compressed.size());
+    }
+    
+    std::string restored;
+    mimirion::Decompressor decompressor;
+    for (size_t pos = 0; pos < compressed.size(); pos += 333) {
+        ASSERT_TRUE(decompressor.write(compressed.data() + pos,
+                                       std::min<size_t>(333, compressed.size() - pos),
+                                       [&restored](const char* chunk, size_t size) {
+                                           restored.append(chunk, size);
+                                           return true;
+                                       }));
+    }
+    EXPECT_TRUE(decompressor.finished());
+    EXPECT_EQ(restored, data);
+}
+
+// Test that thread contexts are reused safely, including nested use
+TEST(CompressionTest, ContextReuse) {
+    std::string data = sampleData(10000);
+    
+    mimirion::Compressor outer(mimirion::CompressionLevel::DEFAULT);
+    std::string outerOut;
+    ASSERT_TRUE(outer.write(data.data(), data.size(), [&outerOut](const char* chunk, size_t size) {
+        outerOut.append(chunk, size);
+        return true;
+    }));
+    
+    // The cached context is busy, so these get private ones
+    for (int i = 0; i < 3; ++i) {
+        std::string compressed, restored;
+        ASSERT_TRUE(mimirion::Compressor::compress(data, compressed));
+        ASSERT_TRUE(mimirion::Decompressor::decompress(compressed, restored));
+        EXPECT_EQ(restored, data);
+    }
+    
+    ASSERT_TRUE(outer.finish([&outerOut](const char* chunk, size_t size) {
+        outerOut.append(chunk, size);
+        return true;
+    }));
+    EXPECT_EQ(mimirion::utils::decompress(outerOut), data);
+}
+
+// Test rejection of data that is not a single complete zlib stream
+TEST(CompressionTest, RejectsInvalidInput) {
+    std::string compressed = mimirion::utils::compress(sampleData(5000));
+    std::string out;
+    
+    EXPECT_FALSE(mimirion::Decompressor::decompress("plain text", out));
+    EXPECT_FALSE(mimirion::Decompressor::decompress(compressed.substr(0, compressed.size() / 2), out));
+    EXPECT_FALSE(mimirion::Decompressor::decompress(compressed + "trailing", out));
+    EXPECT_FALSE(mimirion::Decompressor::looksCompressed("plain text"));
+    
+    // A sink can abort the stream
+    mimirion::Decompressor decompressor;
+    EXPECT_FALSE(decompressor.write(compressed.data(), compressed.size(),
+                                    [](const char*, size_t) { return false; }));
+}
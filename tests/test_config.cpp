@@ -0,0 +1,139 @@
+/**
+ * @file test_config.cpp
+ * @brief Unit tests for the Config class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "config.hpp"
+#include "remote.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class ConfigTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary directory for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_config";
+        mimirionDir = testDir / ".mimirion";
+        fs::create_directories(mimirionDir / "config");
+
+        // Keep the user and system scopes inside the test directory
+        setenv("MIMIRION_CONFIG_GLOBAL", (testDir / "user.config").c_str(), 1);
+        setenv("MIMIRION_CONFIG_SYSTEM", (testDir / "system.config").c_str(), 1);
+        mimirion::Config::invalidate();
+    }
+
+    void TearDown() override {
+        unsetenv("MIMIRION_CONFIG_GLOBAL");
+        unsetenv("MIMIRION_CONFIG_SYSTEM");
+        mimirion::Config::invalidate();
+
+        // Clean up the temporary directory
+        fs::remove_all(testDir);
+    }
+
+    fs::path testDir;
+    fs::path mimirionDir;
+};
+
+// Test parsing sections, subsections, quoting and typed getters
+TEST_F(ConfigTest, ParseAndTypedGetters) {
+    auto config = mimirion::Config::parse(
+        "# comment\n"
+        "[Core]\n"
+        "\tBare\n"
+        "\tenabled = off\n"
+        "\tlimit = 4k\n"
+        "\tbroken = 12x\n"
+        "[remote \"Origin\"]\n"
+        "\turl = https://example.com/repo.git\n"
+        "[user]\n"
+        "\tname = \" Spaced \\\"Name\\\" \"\n");
+
+    EXPECT_TRUE(config->getBool("core.bare"));
+    EXPECT_FALSE(config->getBool("core.enabled", true));
+    EXPECT_EQ(config->getInt("core.limit"), 4096);
+    EXPECT_EQ(config->getInt("core.broken", 7), 7);
+    EXPECT_EQ(config->getString("remote.Origin.url"), "https://example.com/repo.git");
+    EXPECT_FALSE(config->get("remote.origin.url").has_value());
+    EXPECT_EQ(config->getString("user.name"), " Spaced \"Name\" ");
+    EXPECT_EQ(config->getString("user.missing", "fallback"), "fallback");
+
+    auto remotes = config->getSubsections("remote");
+    ASSERT_EQ(remotes.size(), 1u);
+    EXPECT_EQ(remotes[0], "Origin");
+}
+
+// Test that scopes override each other and writes round-trip
+TEST_F(ConfigTest, ScopesAndSet) {
+    using Scope = mimirion::Config::Scope;
+    ASSERT_TRUE(mimirion::Config::set(mimirionDir, Scope::SYSTEM, "user.name", "System"));
+    ASSERT_TRUE(mimirion::Config::set(mimirionDir, Scope::USER, "user.name", "User"));
+    ASSERT_TRUE(mimirion::Config::set(mimirionDir, Scope::USER, "user.email", "user@example.com"));
+
+    auto config = mimirion::Config::load(mimirionDir);
+    EXPECT_EQ(config->getString("user.name"), "User");
+    EXPECT_EQ(config->getString("user.email"), "user@example.com");
+
+    ASSERT_TRUE(mimirion::Config::set(mimirionDir, Scope::REPOSITORY, "User.Name", "Repo"));
+    auto updated = mimirion::Config::load(mimirionDir);
+    EXPECT_EQ(updated->getString("user.name"), "Repo");
+
+    // Old snapshots are immutable
+    EXPECT_EQ(config->getString("user.name"), "User");
+
+    ASSERT_TRUE(mimirion::Config::unset(mimirionDir, Scope::REPOSITORY, "user.name"));
+    EXPECT_EQ(mimirion::Config::load(mimirionDir)->getString("user.name"), "User");
+}
+
+// Test that snapshots are shared and the binary cache is used
+TEST_F(ConfigTest, SnapshotAndBinaryCache) {
+    std::ofstream settings(mimirionDir / "config" / "settings");
+    settings << "[core]\n\tvalue = from-text\n";
+    settings.close();
+
+    auto first = mimirion::Config::load(mimirionDir);
+    auto second = mimirion::Config::load(mimirionDir);
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_EQ(first->getString("core.value"), "from-text");
+
+    fs::path cacheFile = mimirionDir / "config" / "settings.cache";
+    ASSERT_TRUE(fs::exists(cacheFile));
+
+    // A fresh process (simulated by invalidate) reads the cache, which is
+    // keyed by the source file state and therefore still valid
+    mimirion::Config::invalidate();
+    EXPECT_EQ(mimirion::Config::load(mimirionDir)->getString("core.value"), "from-text");
+
+    // A corrupt cache is ignored
+    mimirion::utils::writeFile(cacheFile, "garbage");
+    mimirion::Config::invalidate();
+    EXPECT_EQ(mimirion::Config::load(mimirionDir)->getString("core.value"), "from-text");
+}
+
+// Test that remotes are stored in the configuration and legacy files migrate
+TEST_F(ConfigTest, RemotesLiveInConfig) {
+    std::ofstream legacy(mimirionDir / "config" / "remotes");
+    legacy << "old https://example.com/old.git" << std::endl;
+    legacy.close();
+
+    auto remotes = mimirion::RemoteManager::loadRemotes(mimirionDir);
+    ASSERT_EQ(remotes.size(), 1u);
+    EXPECT_EQ(remotes["old"], "https://example.com/old.git");
+
+    remotes["origin"] = "https://example.com/origin.git";
+    ASSERT_TRUE(mimirion::RemoteManager::saveRemotes(mimirionDir, remotes));
+    EXPECT_FALSE(fs::exists(mimirionDir / "config" / "remotes"));
+
+    auto config = mimirion::Config::load(mimirionDir);
+    EXPECT_EQ(config->getString("remote.origin.url"), "https://example.com/origin.git");
+    EXPECT_EQ(config->getString("remote.old.url"), "https://example.com/old.git");
+    EXPECT_EQ(mimirion::RemoteManager::loadRemotes(mimirionDir).size(), 2u);
+}
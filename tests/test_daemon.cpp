@@ -0,0 +1,127 @@
+/**
+ * @file test_daemon.cpp
+ * @brief Unit tests for the repository daemon
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "daemon.hpp"
+#include "repository.hpp"
+
+namespace fs = std::filesystem;
+
+class DaemonTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary directory for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_daemon";
+        fs::create_directories(testDir);
+        
+        // Change to the test directory
+        originalPath = fs::current_path();
+        fs::current_path(testDir);
+        
+        mimirion::Repository repo;
+        repo.init(testDir.string());
+        mimirionDir = testDir / ".mimirion";
+    }
+
+    void TearDown() override {
+        // Change back to the original directory
+        fs::current_path(originalPath);
+        
+        // Clean up the temporary directory
+        fs::remove_all(testDir);
+    }
+
+    fs::path testDir;
+    fs::path mimirionDir;
+    fs::path originalPath;
+};
+
+// Test that forwarding fails cleanly when no daemon is running
+TEST_F(DaemonTest, ForwardWithoutDaemon) {
+    std::string output;
+    int exitCode = 0;
+    EXPECT_FALSE(mimirion::DaemonClient::forward(mimirionDir, {"status"}, output, exitCode));
+    EXPECT_FALSE(mimirion::DaemonClient::isRunning(mimirionDir));
+}
+
+// Test serving status and picking up branch changes
+TEST_F(DaemonTest, ServeStatus) {
+    mimirion::Daemon daemon(testDir, mimirionDir);
+    ASSERT_TRUE(daemon.start());
+    std::thread server([&daemon]() { daemon.serve(); });
+    
+    EXPECT_TRUE(mimirion::DaemonClient::isRunning(mimirionDir));
+    
+    std::string output;
+    int exitCode = -1;
+    ASSERT_TRUE(mimirion::DaemonClient::forward(mimirionDir, {"status"}, output, exitCode));
+    EXPECT_EQ(exitCode, 0);
+    EXPECT_TRUE(output.find("On branch master") != std::string::npos);
+    
+    // Changing HEAD on disk must invalidate the cached repository
+    std::ofstream headFile(mimirionDir / "HEAD");
+    headFile << "ref: refs/heads/feature" << std::endl;
+    headFile.close();
+    fs::last_write_time(mimirionDir / "HEAD", fs::file_time_type::clock::now() + std::chrono::seconds(5));
+    
+    ASSERT_TRUE(mimirion::DaemonClient::forward(mimirionDir, {"status"}, output, exitCode));
+    EXPECT_TRUE(output.find("On branch feature") != std::string::npos);
+    
+    // Shut down through the protocol
+    ASSERT_TRUE(mimirion::DaemonClient::forward(mimirionDir, {"shutdown"}, output, exitCode));
+    server.join();
+}
+
+// Test that unsupported commands are rejected
+TEST_F(DaemonTest, UnsupportedCommand) {
+    mimirion::Daemon daemon(testDir, mimirionDir);
+    ASSERT_TRUE(daemon.start());
+    std::thread server([&daemon]() { daemon.serve(); });
+    
+    std::string output;
+    int exitCode = 0;
+    ASSERT_TRUE(mimirion::DaemonClient::forward(mimirionDir, {"commit", "message"}, output, exitCode));
+    EXPECT_NE(exitCode, 0);
+    
+    daemon.stop();
+    server.join();
+}
+
+// Test that a client that connects and sends nothing does not block others
+TEST_F(DaemonTest, StalledClient) {
+    mimirion::Daemon daemon(testDir, mimirionDir);
+    ASSERT_TRUE(daemon.start());
+    std::thread server([&daemon]() { daemon.serve(); });
+
+    std::string socketFile = mimirion::Daemon::socketPath(mimirionDir).string();
+    sockaddr_un addr = {};
+    addr.sun_family = AF_UNIX;
+    ASSERT_LT(socketFile.size(), sizeof(addr.sun_path));
+    std::strcpy(addr.sun_path, socketFile.c_str());
+    int stalled = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(stalled, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+
+    auto started = std::chrono::steady_clock::now();
+    std::string output;
+    int exitCode = -1;
+    EXPECT_TRUE(mimirion::DaemonClient::forward(mimirionDir, {"status"}, output, exitCode));
+    EXPECT_EQ(exitCode, 0);
+    EXPECT_LT(std::chrono::steady_clock::now() - started,
+              std::chrono::seconds(2 * mimirion::Daemon::kConnectionTimeout));
+    close(stalled);
+
+    daemon.stop();
+    server.join();
+}
@@ -0,0 +1,145 @@
+/**
+ * @file test_fast_export.cpp
+ * @brief Unit tests for streaming history export
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include "fast_export.hpp"
+#include "fast_import.hpp"
+#include "commit.hpp"
+#include "object_store.hpp"
+#include "refs.hpp"
+#include "repository.hpp"
+
+namespace fs = std::filesystem;
+
+class FastExportTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a source and a destination repository for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_fast_export";
+        sourceDir = testDir / "source";
+        copyDir = testDir / "copy";
+        fs::create_directories(sourceDir);
+        fs::create_directories(copyDir);
+        repo.init(sourceDir.string());
+        repo.init(copyDir.string());
+
+        originalPath = fs::current_path();
+        fs::current_path(sourceDir);
+    }
+
+    void TearDown() override {
+        // Change back and clean up the temporary directory
+        fs::current_path(originalPath);
+        fs::remove_all(testDir);
+    }
+
+    static bool import(const fs::path& dir, const std::string& stream) {
+        std::istringstream in(stream);
+        mimirion::FastImporter importer(dir, dir / ".mimirion");
+        return importer.run(in);
+    }
+
+    static bool exportRange(const fs::path& dir, const std::vector<std::string>& revisions, std::string& stream,
+                            mimirion::FastExportStats* stats = nullptr) {
+        std::ostringstream out;
+        mimirion::FastExporter exporter(dir, dir / ".mimirion");
+        bool ok = exporter.run(revisions, out, stats);
+        stream = out.str();
+        return ok;
+    }
+
+    static std::string refAt(const fs::path& dir, const std::string& ref) {
+        return mimirion::RefStore(dir / ".mimirion").readRef(ref);
+    }
+
+    static std::string data(const std::string& content) {
+        return "data " + std::to_string(content.size()) + "\n" + content + "\n";
+    }
+
+    mimirion::Repository repo;
+    fs::path testDir;
+    fs::path sourceDir;
+    fs::path copyDir;
+    fs::path originalPath;
+};
+
+// Test that a full export rebuilds the same history elsewhere
+TEST_F(FastExportTest, RoundTrip) {
+    ASSERT_TRUE(import(sourceDir,
+        "commit master\nmark :1\nauthor Ada <ada@example.com> 1700000000 +0000\n" + data("First\n\nWith a body") +
+        "M 100644 inline a.txt\n" + data("same\n") +
+        "M 100644 inline dir/b.txt\n" + data("same\n") +
+        "M 100644 inline \"odd\\\\name\"\n" + data("odd\n") +
+        "commit side\nmark :2\ncommitter Bob <bob@example.com> 1700000100 +0000\n" + data("Side") +
+        "from :1\nD dir/b.txt\nM 100644 inline c.txt\n" + data("side\n") +
+        "commit master\nmark :3\ncommitter Bob <bob@example.com> 1700000200 +0000\n" + data("Merge") +
+        "merge :2\nM 100644 inline a.txt\n" + data("changed\n") +
+        "reset refs/tags/v1\nfrom :1\n"));
+
+    std::string stream;
+    mimirion::FastExportStats stats;
+    ASSERT_TRUE(exportRange(sourceDir, {}, stream, &stats));
+    EXPECT_EQ(stats.commits, 3u);
+    EXPECT_EQ(stats.refs, 3u);
+    // Identical content is written once
+    EXPECT_EQ(stats.blobs, 4u);
+    EXPECT_NE(stream.find("D dir/b.txt\n"), std::string::npos);
+    EXPECT_NE(stream.find(" \"odd\\\\name\"\n"), std::string::npos);
+
+    ASSERT_TRUE(import(copyDir, stream));
+    for (const char* ref : {"refs/heads/master", "refs/heads/side", "refs/tags/v1"}) {
+        EXPECT_FALSE(refAt(sourceDir, ref).empty());
+        EXPECT_EQ(refAt(copyDir, ref), refAt(sourceDir, ref)) << ref;
+    }
+
+    mimirion::CommitManager commits(copyDir, copyDir / ".mimirion");
+    mimirion::CommitInfo merge;
+    ASSERT_TRUE(commits.readCommit(refAt(copyDir, "refs/heads/master"), merge));
+    EXPECT_EQ(merge.parentHashes.size(), 2u);
+    EXPECT_EQ(merge.fileHashes.size(), 3u);
+    mimirion::ObjectStore objects(copyDir / ".mimirion");
+    auto content = objects.readObject(merge.fileHashes["a.txt"]);
+    ASSERT_TRUE(content);
+    EXPECT_EQ(*content, "changed\n");
+}
+
+// Test that a range extends a copy holding its start
+TEST_F(FastExportTest, IncrementalRange) {
+    std::string first = "commit master\ncommitter A <a@b> 1 +0000\n" + data("one") + "M 100644 inline f\n" + data("1");
+    ASSERT_TRUE(import(sourceDir, first));
+    std::string stream;
+    ASSERT_TRUE(exportRange(sourceDir, {"master"}, stream));
+    ASSERT_TRUE(import(copyDir, stream));
+    std::string base = refAt(sourceDir, "refs/heads/master");
+
+    ASSERT_TRUE(import(sourceDir, "commit master\ncommitter A <a@b> 2 +0000\n" + data("two") + "M 100644 inline g\n" + data("2") +
+                                  "commit master\ncommitter A <a@b> 3 +0000\n" + data("three") + "D f\n"));
+    mimirion::FastExportStats stats;
+    ASSERT_TRUE(exportRange(sourceDir, {base + "..master"}, stream, &stats));
+    EXPECT_EQ(stats.commits, 2u);
+    EXPECT_EQ(stats.blobs, 1u);
+    EXPECT_NE(stream.find("from " + base + "\n"), std::string::npos);
+
+    ASSERT_TRUE(import(copyDir, stream));
+    EXPECT_EQ(refAt(copyDir, "refs/heads/master"), refAt(sourceDir, "refs/heads/master"));
+
+    // Nothing is left once the range is empty
+    ASSERT_TRUE(exportRange(sourceDir, {"^master", "master"}, stream, &stats));
+    EXPECT_EQ(stats.commits, 0u);
+}
+
+// Test that unknown revisions are rejected
+TEST_F(FastExportTest, UnknownRevision) {
+    std::string stream;
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(exportRange(sourceDir, {"missing"}, stream));
+    EXPECT_FALSE(exportRange(sourceDir, {"^missing"}, stream));
+    EXPECT_NE(testing::internal::GetCapturedStderr().find("unknown revision 'missing'"), std::string::npos);
+}
@@ -0,0 +1,193 @@
+/**
+ * @file test_fast_import.cpp
+ * @brief Unit tests for streaming commit ingestion
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include "fast_import.hpp"
+#include "commit.hpp"
+#include "object_store.hpp"
+#include "refs.hpp"
+#include "repository.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class FastImportTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary repository for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_fast_import";
+        fs::create_directories(testDir);
+        mimirionDir = testDir / ".mimirion";
+        repo.init(testDir.string());
+
+        originalPath = fs::current_path();
+        fs::current_path(testDir);
+    }
+
+    void TearDown() override {
+        // Change back and clean up the temporary directory
+        fs::current_path(originalPath);
+        fs::remove_all(testDir);
+    }
+
+    bool import(const std::string& stream, mimirion::FastImportStats* stats = nullptr) {
+        std::istringstream in(stream);
+        mimirion::FastImporter importer(testDir, mimirionDir);
+        return importer.run(in, stats);
+    }
+
+    mimirion::CommitInfo commitAt(const std::string& name) {
+        mimirion::RefStore refs(mimirionDir);
+        mimirion::ObjectStore objects(mimirionDir);
+        mimirion::CommitManager commits(testDir, mimirionDir);
+        mimirion::CommitInfo* commit = commits.getCommit(refs.resolve(name, &objects));
+        return commit ? *commit : mimirion::CommitInfo();
+    }
+
+    std::string readBlob(const std::string& hash) {
+        mimirion::ObjectStore objects(mimirionDir);
+        auto content = objects.readObject(hash);
+        return content ? *content : "";
+    }
+
+    static std::string data(const std::string& content) {
+        return "data " + std::to_string(content.size()) + "\n" + content + "\n";
+    }
+
+    mimirion::Repository repo;
+    fs::path testDir;
+    fs::path mimirionDir;
+    fs::path originalPath;
+};
+
+// Test blobs, marks, branches, merges and file commands
+TEST_F(FastImportTest, Stream) {
+    std::string stream =
+        "# generated\n"
+        "blob\nmark :1\n" + data("hello\n") +
+        "blob\nmark :2\n" + data("world\n") +
+        "commit refs/heads/master\nmark :10\n"
+        "author Ada <ada@example.com> 1700000000 +0100\n"
+        "committer Bob <bob@example.com> 1700000100 +0000\n" + data("First\n") +
+        "M 100644 :1 a.txt\n"
+        "M 644 :2 dir/b.txt\n"
+        "M 100644 :2 dir/sub/c.txt\n"
+        "M 100644 inline \"quoted \\\"name\\\".txt\"\n" + data("inline\n") +
+        "\n"
+        "commit side\nmark :11\n"
+        "committer Bob <bob@example.com> 1700000200 +0000\n"
+        "data <<END\nOn a side\nbranch\nEND\n"
+        "from :10\n"
+        "D dir\n"
+        "M 100755 inline new.sh\n" + data("#!/bin/sh\n") +
+        "commit master\nmark :12\n"
+        "committer Bob <bob@example.com> 1700000300 +0000\n" + data("Merge") +
+        "merge :11\n"
+        "M 100644 :2 a.txt\n"
+        "reset refs/tags/v1\nfrom :10\n"
+        "done\n";
+
+    mimirion::FastImportStats stats;
+    ASSERT_TRUE(import(stream, &stats));
+    EXPECT_EQ(stats.blobs, 4u);
+    EXPECT_EQ(stats.commits, 3u);
+    EXPECT_EQ(stats.refs, 3u);
+
+    mimirion::CommitInfo first = commitAt("v1");
+    EXPECT_EQ(first.author, "Ada");
+    EXPECT_EQ(first.email, "ada@example.com");
+    EXPECT_EQ(std::chrono::system_clock::to_time_t(first.timestamp), 1700000000);
+    EXPECT_EQ(first.message, "First");
+    ASSERT_EQ(first.fileHashes.size(), 4u);
+    EXPECT_EQ(readBlob(first.fileHashes["a.txt"]), "hello\n");
+    EXPECT_EQ(readBlob(first.fileHashes["quoted \"name\".txt"]), "inline\n");
+
+    mimirion::CommitInfo side = commitAt("side");
+    EXPECT_EQ(side.message, "On a side\nbranch");
+    EXPECT_EQ(side.parentHashes, std::vector<std::string>{first.hash});
+    EXPECT_EQ(side.fileHashes.size(), 3u);
+    EXPECT_EQ(side.fileHashes.count("dir/b.txt"), 0u);
+    EXPECT_EQ(readBlob(side.fileHashes["new.sh"]), "#!/bin/sh\n");
+
+    // Without "from", master continues from its previous commit
+    mimirion::CommitInfo merge = commitAt("master");
+    EXPECT_EQ(merge.parentHashes, (std::vector<std::string>{first.hash, side.hash}));
+    EXPECT_EQ(readBlob(merge.fileHashes["a.txt"]), "world\n");
+    EXPECT_EQ(merge.fileHashes.size(), 4u);
+
+    // Nothing was checked out or staged
+    EXPECT_FALSE(fs::exists(testDir / "a.txt"));
+    EXPECT_FALSE(fs::exists(mimirionDir / "index"));
+}
+
+// Test that refs only move at checkpoints and errors name their line
+TEST_F(FastImportTest, CheckpointsAndErrors) {
+    std::string commit = "commit master\ncommitter A <a@b> 1 +0000\n" + data("one") + "M 100644 inline f\n" + data("1");
+    mimirion::RefStore refs(mimirionDir);
+
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(import(commit + "M 100644 :99 g\n"));
+    EXPECT_NE(testing::internal::GetCapturedStderr().find("line 8: unknown mark :99"), std::string::npos);
+    EXPECT_TRUE(refs.readRef("refs/heads/master").empty());
+
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(import(commit + "checkpoint\nbogus\n"));
+    EXPECT_NE(testing::internal::GetCapturedStderr().find("unknown command 'bogus'"), std::string::npos);
+    std::string head = refs.readRef("refs/heads/master");
+    ASSERT_FALSE(head.empty());
+
+    for (const char* bad : {"M 100644 inline ../escape\n", "M 100644 inline \"tab\\there\"\n", "M 040000 inline d\n", "M 100644 inline .mimirion/x\n",
+                            "M 100644 inline \"\\19x\"\n", "M 100644 inline \"\\4\"\n"}) {
+        testing::internal::CaptureStderr();
+        EXPECT_FALSE(import("commit master\ncommitter A <a@b> 2 +0000\n" + data("two") + bad + data("x")));
+        testing::internal::GetCapturedStderr();
+    }
+    EXPECT_FALSE(import("blob\ndata 10\nshort"));
+    EXPECT_EQ(refs.readRef("refs/heads/master"), head);
+
+    // Well-formed octal escapes name raw bytes
+    ASSERT_TRUE(import("commit master\ncommitter A <a@b> 3 +0000\n" + data("three") +
+                       "M 100644 inline \"caf\\303\\251\"\n" + data("x")));
+    mimirion::CommitInfo escaped;
+    ASSERT_TRUE(mimirion::CommitManager(testDir, mimirionDir).readCommit(refs.readRef("refs/heads/master"), escaped));
+    EXPECT_EQ(escaped.fileHashes.count("caf\xc3\xa9"), 1u);
+}
+
+// Test that marks carry over between runs and branches continue
+TEST_F(FastImportTest, IncrementalMarks) {
+    fs::path marksFile = testDir / "marks";
+    {
+        std::istringstream in("blob\nmark :1\n" + data("v1") +
+                              "commit master\nmark :2\ncommitter A <a@b> 1 +0000\n" + data("one") +
+                              "M 100644 :1 file\n");
+        mimirion::FastImporter importer(testDir, mimirionDir);
+        ASSERT_TRUE(importer.run(in));
+        ASSERT_TRUE(importer.exportMarks(marksFile));
+    }
+    std::string marks = mimirion::utils::readFile(marksFile);
+    EXPECT_EQ(marks.compare(0, 3, ":1 "), 0);
+    EXPECT_NE(marks.find("\n:2 "), std::string::npos);
+
+    std::istringstream in("commit master\ncommitter A <a@b> 2 +0000\n" + data("two") +
+                          "M 100644 :1 copy\n"
+                          "commit refs/heads/topic\ncommitter A <a@b> 3 +0000\n" + data("three") +
+                          "from :2\n");
+    mimirion::FastImporter importer(testDir, mimirionDir);
+    ASSERT_TRUE(importer.importMarks(marksFile));
+    mimirion::FastImportStats stats;
+    ASSERT_TRUE(importer.run(in, &stats));
+    EXPECT_EQ(stats.blobs, 0u);
+
+    mimirion::CommitInfo second = commitAt("master");
+    mimirion::CommitInfo first = commitAt(second.parentHashes.at(0));
+    EXPECT_EQ(first.message, "one");
+    EXPECT_EQ(second.fileHashes["copy"], first.fileHashes["file"]);
+    EXPECT_EQ(commitAt("topic").parentHashes, std::vector<std::string>{first.hash});
+}
@@ -6,10 +6,12 @@
  */
 
 #include <gtest/gtest.h>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <string>
 #include "file_tracker.hpp"
+#include "utils.hpp"
 
 namespace fs = std::filesystem;
 
@@ -187,3 +189,38 @@ TEST_F(FileTrackerTest, MultipleFiles) {
     }
     EXPECT_EQ(fileStatuses["file3.txt"], mimirion::FileStatus::STAGED);
 }
+
+// Test that scan results are kept in the index and reused while the file is unchanged
+TEST_F(FileTrackerTest, IndexCachesScanResults) {
+    createSampleFile("cached.txt", "one\r\ntwo\r\n");
+    
+    // Give the file an mtime safely older than the index about to be written
+    fs::last_write_time(testDir / "cached.txt",
+                        fs::file_time_type::clock::now() - std::chrono::hours(1));
+    EXPECT_TRUE(tracker->stageFile("cached.txt"));
+    
+    mimirion::FileTracker reloaded(testDir, mimirionDir);
+    ASSERT_TRUE(reloaded.loadState());
+    auto files = reloaded.getFiles();
+    ASSERT_EQ(files.size(), 1u);
+    EXPECT_EQ(files[0].lineCount, 2u);
+    EXPECT_EQ(files[0].newlines, mimirion::NewlineStyle::CRLF);
+    EXPECT_FALSE(files[0].binary);
+    EXPECT_EQ(files[0].size, 10u);
+    EXPECT_NE(files[0].mtime, 0);
+    
+    // Swap the recorded hash: an unchanged file is not read again, so the
+    // stale hash is trusted and the file still counts as staged
+    std::string index = mimirion::utils::readFile(mimirionDir / "index");
+    std::string hash = files[0].hash;
+    index.replace(index.find(hash), hash.size(), std::string(hash.size(), 'a'));
+    mimirion::utils::writeFile(mimirionDir / "index", index);
+    
+    mimirion::FileTracker trusting(testDir, mimirionDir);
+    ASSERT_TRUE(trusting.loadState());
+    EXPECT_EQ(trusting.getFileStatus("cached.txt"), mimirion::FileStatus::STAGED);
+    
+    // Once the file changes it is rehashed
+    createSampleFile("cached.txt", "one\r\ntwo\r\nthree\r\n");
+    EXPECT_EQ(trusting.getFileStatus("cached.txt"), mimirion::FileStatus::MODIFIED);
+}
@@ -0,0 +1,101 @@
+/**
+ * @file test_file_view.cpp
+ * @brief Unit tests for the FileView class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include "file_view.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class FileViewTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary directory for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_file_view";
+        fs::create_directories(testDir);
+    }
+
+    void TearDown() override {
+        // Clean up the temporary directory
+        fs::remove_all(testDir);
+    }
+
+    fs::path testDir;
+};
+
+// Test that small files are read and large files are mapped
+TEST_F(FileViewTest, SmallAndLargeFiles) {
+    mimirion::utils::writeFile(testDir / "small", "small content");
+    mimirion::FileView small(testDir / "small");
+    ASSERT_TRUE(small.isOpen());
+    EXPECT_FALSE(small.isMapped());
+    EXPECT_EQ(small.view(), "small content");
+
+    std::string content;
+    while (content.size() < 3 * mimirion::FileView::kMapThreshold) {
+        content += "line " + std::to_string(content.size()) + "\n";
+    }
+    mimirion::utils::writeFile(testDir / "large", content);
+
+    mimirion::FileView large(testDir / "large", mimirion::FileView::Advice::WILL_NEED);
+    ASSERT_TRUE(large.isOpen());
+    EXPECT_TRUE(large.isMapped());
+    EXPECT_EQ(large.size(), content.size());
+    EXPECT_EQ(large.view(), content);
+    EXPECT_EQ(large.view(5, 10), content.substr(5, 10));
+    EXPECT_EQ(large.view(content.size() - 3, 100), content.substr(content.size() - 3));
+    EXPECT_TRUE(large.view(content.size() + 10, 5).empty());
+    large.advise(mimirion::FileView::Advice::RANDOM, 4097, 10);
+
+    EXPECT_EQ(mimirion::utils::readFile(testDir / "large"), content);
+}
+
+// Test empty, missing and special files
+TEST_F(FileViewTest, EmptyMissingAndSpecialFiles) {
+    mimirion::utils::writeFile(testDir / "empty", "");
+    mimirion::FileView empty(testDir / "empty");
+    EXPECT_TRUE(empty.isOpen());
+    EXPECT_EQ(empty.size(), 0u);
+
+    mimirion::FileView missing(testDir / "missing");
+    EXPECT_FALSE(missing.isOpen());
+    EXPECT_TRUE(missing.view().empty());
+
+    mimirion::FileView directory(testDir);
+    EXPECT_FALSE(directory.isOpen());
+
+    // procfs files report size 0 but have content
+    if (fs::exists("/proc/self/status")) {
+        mimirion::FileView status("/proc/self/status");
+        ASSERT_TRUE(status.isOpen());
+        EXPECT_FALSE(status.isMapped());
+        EXPECT_NE(status.view().find("Name:"), std::string::npos);
+    }
+}
+
+// Test that moving a view keeps its contents valid
+TEST_F(FileViewTest, MoveKeepsContents) {
+    mimirion::utils::writeFile(testDir / "small", "tiny");
+    mimirion::utils::writeFile(testDir / "large", std::string(2 * mimirion::FileView::kMapThreshold, 'x'));
+
+    mimirion::FileView small(testDir / "small");
+    mimirion::FileView moved(std::move(small));
+    EXPECT_FALSE(small.isOpen());
+    EXPECT_EQ(moved.view(), "tiny");
+
+    mimirion::FileView large(testDir / "large");
+    moved = std::move(large);
+    EXPECT_FALSE(large.isOpen());
+    EXPECT_TRUE(moved.isMapped());
+    EXPECT_EQ(moved.view(), std::string(2 * mimirion::FileView::kMapThreshold, 'x'));
+
+    moved.close();
+    EXPECT_FALSE(moved.isOpen());
+}
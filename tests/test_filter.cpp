@@ -0,0 +1,197 @@
+/**
+ * @file test_filter.cpp
+ * @brief Unit tests for the filter pipeline
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include "filter.hpp"
+#include "commit.hpp"
+#include "config.hpp"
+#include "file_tracker.hpp"
+#include "object_store.hpp"
+#include "repository.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class FilterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary repository for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_filter";
+        fs::create_directories(testDir);
+        mimirionDir = testDir / ".mimirion";
+        repo.init(testDir.string());
+
+        originalPath = fs::current_path();
+        fs::current_path(testDir);
+
+        mimirion::utils::writeFile(testDir / mimirion::Attributes::kFileName,
+                                   "*.txt text\n"
+                                   "*.bat eol=crlf\n"
+                                   "*.dat text=auto\n"
+                                   "*.c ident\n"
+                                   "*.up filter=upper\n");
+    }
+
+    void TearDown() override {
+        // Change back and clean up the temporary directory
+        fs::current_path(originalPath);
+        fs::remove_all(testDir);
+    }
+
+    // Runs input through a path's chain, piece bytes at a time
+    std::string run(mimirion::FilterPipeline& filters, const std::string& path,
+                    mimirion::FilterDirection direction, const std::string& input,
+                    size_t piece = 1, const std::string& hash = "") {
+        std::string output;
+        auto chain = filters.open(path, direction, [&output](const char* data, size_t size) {
+            output.append(data, size);
+            return true;
+        }, hash);
+        EXPECT_NE(chain, nullptr);
+        for (size_t offset = 0; chain && offset < input.size(); offset += piece) {
+            EXPECT_TRUE(chain->write(input.data() + offset, std::min(piece, input.size() - offset)));
+        }
+        EXPECT_TRUE(chain && chain->finish());
+        return output;
+    }
+
+    mimirion::Repository repo;
+    fs::path testDir;
+    fs::path mimirionDir;
+    fs::path originalPath;
+};
+
+// Test line ending conversion across piece boundaries
+TEST_F(FilterTest, LineEndings) {
+    mimirion::FilterPipeline filters(testDir, mimirionDir);
+    using mimirion::FilterDirection;
+    EXPECT_FALSE(filters.hasFilters("notes.md"));
+    EXPECT_TRUE(filters.hasFilters("notes.txt"));
+
+    for (size_t piece : {1, 2, 3, 64}) {
+        EXPECT_EQ(run(filters, "a.txt", FilterDirection::CLEAN, "a\r\nb\r\r\nc\r", piece), "a\nb\r\nc\r");
+        EXPECT_EQ(run(filters, "a.bat", FilterDirection::SMUDGE, "a\nb\r\nc\n", piece), "a\r\nb\r\nc\r\n");
+    }
+
+    // text only normalizes when cleaning; text=auto leaves binary content alone
+    EXPECT_EQ(run(filters, "a.txt", FilterDirection::SMUDGE, "a\nb\n"), "a\nb\n");
+    EXPECT_EQ(run(filters, "a.dat", FilterDirection::CLEAN, "a\r\nb", 64), "a\nb");
+    std::string binary("\0\r\n", 3);
+    EXPECT_EQ(run(filters, "a.dat", FilterDirection::CLEAN, binary, 64), binary);
+}
+
+// Test keyword collapsing and expansion
+TEST_F(FilterTest, Keywords) {
+    mimirion::FilterPipeline filters(testDir, mimirionDir);
+    using mimirion::FilterDirection;
+    std::string input = "x $Id: 1234 $ y $Id$ $Idle$ $ $Id: broken\n$I";
+
+    for (size_t piece : {1, 5, 64}) {
+        EXPECT_EQ(run(filters, "a.c", FilterDirection::CLEAN, input, piece),
+                  "x $Id$ y $Id$ $Idle$ $ $Id: broken\n$I");
+    }
+    EXPECT_EQ(run(filters, "a.c", FilterDirection::SMUDGE, "$Id$\n", 2, "abcd"), "$Id: abcd $\n");
+}
+
+// Test that a filter process is started once and serves every file
+TEST_F(FilterTest, FilterProcess) {
+    if (std::system("python3 -c pass > /dev/null 2>&1") != 0) {
+        GTEST_SKIP() << "python3 is not available";
+    }
+
+    // Uppercases on clean, lowercases on smudge; logs each start
+    mimirion::utils::writeFile(testDir / "filter.py", R"(
+import sys
+def read():
+    n = int(sys.stdin.buffer.read(4), 16)
+    return None if n == 0 else sys.stdin.buffer.read(n - 4)
+def write(data):
+    sys.stdout.buffer.write(b'%04x' % (len(data) + 4) + data if data is not None else b'0000')
+def lst():
+    out = []
+    while (p := read()) is not None:
+        out.append(p)
+    return out
+open('starts.log', 'a').write('start\n')
+lst(); write(b'git-filter-server\n'); write(b'version=2\n'); write(None)
+lst(); write(b'capability=clean\n'); write(b'capability=smudge\n'); write(None)
+sys.stdout.flush()
+while True:
+    try:
+        command = lst()
+    except ValueError:
+        break
+    content = b''.join(lst())
+    content = content.upper() if b'command=clean\n' in command else content.lower()
+    write(b'status=success\n'); write(None)
+    for i in range(0, len(content), 65516):
+        write(content[i:i + 65516])
+    write(None); write(None)
+    sys.stdout.flush()
+)");
+    mimirion::Config::set(mimirionDir, mimirion::Config::Scope::REPOSITORY,
+                          "filter.upper.process", "python3 filter.py");
+
+    {
+        mimirion::FilterPipeline filters(testDir, mimirionDir);
+        using mimirion::FilterDirection;
+        EXPECT_EQ(run(filters, "a.up", FilterDirection::CLEAN, "hello", 2), "HELLO");
+        EXPECT_EQ(run(filters, "b.up", FilterDirection::SMUDGE, "WORLD"), "world");
+        EXPECT_EQ(run(filters, "c.up", FilterDirection::CLEAN, ""), "");
+
+        std::string large(200000, 'x');
+        EXPECT_EQ(run(filters, "d.up", FilterDirection::CLEAN, large, 70000), std::string(200000, 'X'));
+    }
+    EXPECT_EQ(mimirion::utils::readFile(testDir / "starts.log"), "start\n");
+
+    // A driver that is not configured passes content through unless required
+    mimirion::utils::writeFile(testDir / mimirion::Attributes::kFileName, "*.up filter=missing\n");
+    mimirion::FilterPipeline filters(testDir, mimirionDir);
+    EXPECT_EQ(run(filters, "a.up", mimirion::FilterDirection::CLEAN, "same"), "same");
+    mimirion::Config::set(mimirionDir, mimirion::Config::Scope::REPOSITORY,
+                          "filter.missing.required", "true");
+    mimirion::FilterPipeline required(testDir, mimirionDir);
+    EXPECT_EQ(required.open("a.up", mimirion::FilterDirection::CLEAN, nullptr), nullptr);
+}
+
+// Test that commits store cleaned content and checkout smudges it again
+TEST_F(FilterTest, CommitAndCheckout) {
+    mimirion::utils::writeFile(testDir / "run.bat", "echo one\r\necho two\r\n");
+    mimirion::utils::writeFile(testDir / "main.c", "/* $Id$ */\n");
+
+    mimirion::CommitManager commits(testDir, mimirionDir);
+    std::string hash = commits.createCommit("Filtered files", {"run.bat", "main.c"});
+    ASSERT_FALSE(hash.empty());
+    mimirion::CommitInfo* commit = commits.getCommit(hash);
+    ASSERT_NE(commit, nullptr);
+
+    mimirion::ObjectStore objects(mimirionDir);
+    std::string batHash = commit->fileHashes["run.bat"];
+    EXPECT_EQ(batHash, mimirion::utils::sha256("echo one\necho two\n"));
+    EXPECT_EQ(*objects.readObject(batHash), "echo one\necho two\n");
+
+    // The working file hashes like the stored object
+    mimirion::FileTracker tracker(testDir, mimirionDir);
+    tracker.loadState();
+    ASSERT_TRUE(tracker.stageFile("run.bat"));
+    EXPECT_EQ(tracker.getStagedFiles()[0].hash, batHash);
+
+    fs::remove(testDir / "run.bat");
+    ASSERT_TRUE(repo.checkout("master"));
+    EXPECT_EQ(mimirion::utils::readFile(testDir / "run.bat"), "echo one\r\necho two\r\n");
+    EXPECT_EQ(mimirion::utils::readFile(testDir / "main.c"),
+              "/* $Id: " + commit->fileHashes["main.c"] + " $ */\n");
+
+    // The expanded keyword still hashes like the committed file
+    ASSERT_TRUE(tracker.stageFile("main.c"));
+    for (const auto& file : tracker.getStagedFiles()) {
+        EXPECT_EQ(file.hash, commit->fileHashes[file.path]);
+    }
+}
@@ -0,0 +1,169 @@
+/**
+ * @file test_fsck.cpp
+ * @brief Unit tests for repository integrity checks
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include "fsck.hpp"
+#include "commit.hpp"
+#include "object_store.hpp"
+#include "refs.hpp"
+#include "repository.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class FsckTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary repository with two commits
+        testDir = fs::temp_directory_path() / "mimirion_test_fsck";
+        fs::create_directories(testDir);
+        mimirionDir = testDir / ".mimirion";
+        repo.init(testDir.string());
+
+        originalPath = fs::current_path();
+        fs::current_path(testDir);
+
+        mimirion::utils::writeFile(testDir / "a.txt", "first\n");
+        mimirion::CommitManager commits(testDir, mimirionDir);
+        first = commits.createCommit("First", {"a.txt"});
+        ASSERT_FALSE(first.empty());
+        mimirion::utils::writeFile(testDir / "b.txt", "second\n");
+        second = commits.createCommit("Second", {"a.txt", "b.txt"});
+        ASSERT_FALSE(second.empty());
+    }
+
+    void TearDown() override {
+        // Change back and clean up the temporary directory
+        fs::current_path(originalPath);
+        fs::remove_all(testDir);
+    }
+
+    // Runs a check, keeping the reported problems out of the test output
+    bool check(mimirion::FsckReport& report, const mimirion::FsckOptions& options = {}) {
+        testing::internal::CaptureStderr();
+        bool ok = mimirion::IntegrityChecker(testDir, mimirionDir).run(options, &report);
+        errors = testing::internal::GetCapturedStderr();
+        return ok;
+    }
+
+    mimirion::Repository repo;
+    fs::path testDir;
+    fs::path mimirionDir;
+    fs::path originalPath;
+    std::string first;
+    std::string second;
+    std::string errors;
+};
+
+// Test that a sound repository passes and every object is verified
+TEST_F(FsckTest, CleanRepository) {
+    mimirion::FsckReport report;
+    size_t calls = 0;
+    mimirion::FsckOptions options;
+    options.progress = [&](const mimirion::FsckProgress& progress) {
+        EXPECT_LE(progress.done, progress.total == 0 ? progress.done : progress.total);
+        ++calls;
+    };
+    EXPECT_TRUE(check(report, options)) << errors;
+    EXPECT_TRUE(report.complete);
+    EXPECT_EQ(report.errors(), 0u);
+    EXPECT_EQ(report.objects, report.totalObjects);
+    EXPECT_EQ(report.totalObjects, 4u);
+    EXPECT_EQ(report.commits, 2u);
+    EXPECT_EQ(report.dangling, 0u);
+    EXPECT_GT(calls, 0u);
+}
+
+// Test that objects whose content changed are reported
+TEST_F(FsckTest, CorruptObject) {
+    std::string blob = mimirion::utils::sha256("second\n");
+    mimirion::ObjectStore objects(mimirionDir);
+    ASSERT_TRUE(objects.hasObject(blob));
+    fs::path path = objects.objectPath(blob);
+    fs::permissions(path, fs::perms::owner_write, fs::perm_options::add);
+    std::ofstream(path, std::ios::binary) << "not an object";
+
+    mimirion::FsckReport report;
+    EXPECT_FALSE(check(report));
+    EXPECT_EQ(report.corrupt, 1u);
+    EXPECT_NE(errors.find(blob), std::string::npos);
+}
+
+// Test that commits are rehashed from their fields, not trusted by name
+TEST_F(FsckTest, CorruptCommit) {
+    mimirion::ObjectStore objects(mimirionDir);
+    std::string content = *objects.readObject(second);
+    size_t at = content.find("Second");
+    ASSERT_NE(at, std::string::npos);
+    content[at + 3] = 'u';
+    fs::path path = objects.objectPath(second);
+    fs::permissions(path, fs::perms::owner_write, fs::perm_options::add);
+    fs::remove(path);
+    ASSERT_TRUE(objects.storeObject(second, content));
+
+    // Named like the current style, before the snapshot had a digest
+    std::string blob = mimirion::utils::sha256("first\n");
+    std::string fields = "author A <a@example.com> 2020-01-01T00:00:00Z\n"
+                         "committer A <a@example.com> 2020-01-01T00:00:00Z\n\nLegacy\n";
+    std::string legacy = mimirion::utils::sha256("tree dummy-tree-hash\n" + fields);
+    ASSERT_TRUE(objects.storeObject(legacy, "commit " + legacy + "\n" + fields + "\nfiles:\na.txt\t" + blob + "\n"));
+    mimirion::RefStore(mimirionDir).writeRef("refs/heads/legacy", legacy);
+
+    mimirion::FsckReport report;
+    EXPECT_FALSE(check(report));
+    EXPECT_EQ(report.corrupt, 1u);
+    EXPECT_NE(errors.find("object " + second + " does not match its name"), std::string::npos);
+    EXPECT_EQ(errors.find(legacy), std::string::npos);
+}
+
+// Test that missing blobs, parents and bad refs break connectivity
+TEST_F(FsckTest, MissingObjects) {
+    mimirion::ObjectStore objects(mimirionDir);
+    fs::remove(objects.objectPath(mimirion::utils::sha256("second\n")));
+    fs::remove(objects.objectPath(first));
+    mimirion::RefStore(mimirionDir).writeRef("refs/heads/broken", "not-a-hash");
+
+    mimirion::FsckReport report;
+    EXPECT_FALSE(check(report));
+    EXPECT_EQ(report.corrupt, 0u);
+    EXPECT_EQ(report.missing, 2u);
+    EXPECT_EQ(report.badRefs, 1u);
+    EXPECT_EQ(report.commits, 1u);
+    EXPECT_NE(errors.find("cannot read commit " + first), std::string::npos);
+}
+
+// Test that malformed index entries are reported
+TEST_F(FsckTest, BadIndex) {
+    std::ofstream(mimirionDir / "index", std::ios::app) << "a.txt\t\t\t0\n"
+                                                        << "../outside\t\t\t0\n"
+                                                        << "a.txt\t\t\t0\n"
+                                                        << "c.txt\t\t\t9\n"
+                                                        << "truncated\n";
+    mimirion::FsckReport report;
+    EXPECT_FALSE(check(report));
+    EXPECT_EQ(report.badIndexEntries, 4u);
+    EXPECT_NE(errors.find("index: line"), std::string::npos);
+}
+
+// Test that a spent budget stops the check and marks it incomplete
+TEST_F(FsckTest, Budget) {
+    mimirion::FsckOptions options;
+    options.budget = std::chrono::milliseconds(1);
+    options.progress = [](const mimirion::FsckProgress&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    };
+
+    mimirion::FsckReport report;
+    EXPECT_FALSE(check(report, options));
+    EXPECT_FALSE(report.complete);
+    EXPECT_EQ(report.errors(), 0u);
+    EXPECT_LT(report.objects, report.totalObjects);
+}
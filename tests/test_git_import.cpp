@@ -0,0 +1,243 @@
+/**
+ * @file test_git_import.cpp
+ * @brief Unit tests for importing Git history
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include "git_import.hpp"
+#include "commit.hpp"
+#include "object_store.hpp"
+#include "refs.hpp"
+#include "repository.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class GitImportTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary repository for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_git_import";
+        fs::create_directories(testDir);
+        mimirionDir = testDir / ".mimirion";
+        repo.init(testDir.string());
+        gitDir = fs::temp_directory_path() / "mimirion_test_git_import_source";
+        fs::remove_all(gitDir);
+        fs::create_directories(gitDir);
+
+        originalPath = fs::current_path();
+        fs::current_path(testDir);
+    }
+
+    void TearDown() override {
+        // Change back and clean up the temporary directories
+        fs::current_path(originalPath);
+        fs::remove_all(testDir);
+        fs::remove_all(gitDir);
+    }
+
+    static bool hasGit() {
+        return std::system("git --version > /dev/null 2>&1") == 0;
+    }
+
+    // Runs git in the source repository with a fixed identity and time
+    void git(const std::string& args) {
+        ++clock;
+        std::string date = std::to_string(1600000000 + clock * 60) + " +0200";
+        std::string command = "GIT_AUTHOR_DATE='" + date + "' GIT_COMMITTER_DATE='" + date + "' git -C " +
+                              gitDir.string() + " -c user.name=Ada -c user.email=ada@example.com" +
+                              " -c commit.gpgsign=false " + args + " > /dev/null 2>&1";
+        ASSERT_EQ(std::system(command.c_str()), 0) << args;
+    }
+
+    void commitFile(const std::string& path, const std::string& content, const std::string& message) {
+        mimirion::utils::writeFile(gitDir / path, content);
+        git("add -A");
+        git("commit -q -m '" + message + "'");
+        lastCommitTime = 1600000000 + clock * 60;
+    }
+
+    // Points main at a commit whose tree git mktree builds from the output
+    // of a shell command, in which $blob names a one-line blob
+    void commitTree(const std::string& entries, const std::string& mktreeArgs = "") {
+        std::string command = "cd " + gitDir.string() + " && blob=$(printf 'x\\n' | git hash-object -w --stdin)" +
+                              " && tree=$(" + entries + " | git mktree " + mktreeArgs + ")" +
+                              " && commit=$(git -c user.name=Ada -c user.email=ada@example.com" +
+                              " commit-tree $tree -m Crafted) && git update-ref refs/heads/main $commit";
+        ASSERT_EQ(std::system((command + " > /dev/null 2>&1").c_str()), 0) << entries;
+    }
+
+    std::string readBlob(const std::string& hash) {
+        mimirion::ObjectStore objects(mimirionDir);
+        auto content = objects.readObject(hash);
+        return content ? *content : "";
+    }
+
+    // A file large enough for git to store its later versions as deltas
+    static std::string largeText(int version) {
+        std::string text;
+        for (int i = 0; i < 4000; ++i) {
+            text += "line " + std::to_string(i) + (i == version * 100 ? " changed" : "") + "\n";
+        }
+        return text;
+    }
+
+    // Builds main with a subdirectory and a large file, a feature branch
+    // merged back and an annotated tag
+    void buildHistory() {
+        git("init -q -b main");
+        commitFile("README", "hello\n", "Initial commit");
+        commitFile("src/big.txt", largeText(0), "Add big file");
+        git("tag -a v1.0 -m 'Release 1.0'");
+        git("checkout -q -b feature");
+        commitFile("src/feature.txt", "feature\n", "Add feature");
+        commitFile("src/big.txt", largeText(1), "Change big file on feature");
+        git("checkout -q main");
+        commitFile("src/big.txt", largeText(2) + "tail\n", "Change big file on main");
+        git("merge -q --no-edit feature");
+        commitFile("docs/guide.md", "guide\n", "Add guide\n\nWith a longer body.");
+    }
+
+    mimirion::Repository repo;
+    fs::path testDir;
+    fs::path mimirionDir;
+    fs::path gitDir;
+    fs::path originalPath;
+    int clock = 0;
+    long long lastCommitTime = 0;
+};
+
+// Test importing fully packed history with offset deltas
+TEST_F(GitImportTest, PackedHistory) {
+    if (!hasGit()) {
+        GTEST_SKIP() << "git is not available";
+    }
+    buildHistory();
+    git("repack -q -a -d -f --depth=50 --window=50");
+    ASSERT_TRUE(fs::exists(gitDir / ".git" / "packed-refs") || fs::exists(gitDir / ".git" / "refs" / "heads" / "main"));
+
+    mimirion::GitObjectReader reader(gitDir / ".git");
+    EXPECT_EQ(reader.packCount(), 1u);
+
+    mimirion::GitImporter importer(testDir, mimirionDir);
+    mimirion::GitImportStats stats;
+    ASSERT_TRUE(importer.run(gitDir, &stats));
+    EXPECT_EQ(stats.commits, 7u);
+    EXPECT_EQ(stats.refs, 3u);
+
+    // HEAD follows the source's current branch
+    mimirion::RefStore refs(mimirionDir);
+    EXPECT_EQ(refs.currentBranch(), "main");
+    mimirion::CommitManager commits(testDir, mimirionDir);
+    ASSERT_TRUE(commits.loadState());
+    mimirion::CommitInfo* head = commits.getHeadCommit();
+    ASSERT_NE(head, nullptr);
+    EXPECT_EQ(head->message, "Add guide\n\nWith a longer body.");
+    EXPECT_EQ(head->author, "Ada");
+    EXPECT_EQ(head->email, "ada@example.com");
+    EXPECT_EQ(std::chrono::system_clock::to_time_t(head->timestamp), lastCommitTime);
+
+    ASSERT_EQ(head->fileHashes.size(), 4u);
+    EXPECT_EQ(readBlob(head->fileHashes["README"]), "hello\n");
+    EXPECT_EQ(readBlob(head->fileHashes["src/feature.txt"]), "feature\n");
+    EXPECT_EQ(readBlob(head->fileHashes["docs/guide.md"]), "guide\n");
+
+    // The merge has both branches as parents and merged content
+    ASSERT_EQ(head->parentHashes.size(), 1u);
+    mimirion::CommitInfo* merge = commits.getCommit(head->parentHashes[0]);
+    ASSERT_NE(merge, nullptr);
+    EXPECT_EQ(merge->parentHashes.size(), 2u);
+    EXPECT_EQ(merge->parentHashes[1], refs.readRef("refs/heads/feature"));
+    EXPECT_EQ(readBlob(head->fileHashes["src/big.txt"]), readBlob(merge->fileHashes["src/big.txt"]));
+    std::string feature = readBlob(commits.getCommit(refs.readRef("refs/heads/feature"))->fileHashes["src/big.txt"]);
+    EXPECT_EQ(feature, largeText(1));
+
+    // The annotated tag is peeled to its commit and resolvable by name
+    std::string tagged = refs.resolve("v1.0");
+    ASSERT_FALSE(tagged.empty());
+    mimirion::CommitInfo* release = commits.getCommit(tagged);
+    ASSERT_NE(release, nullptr);
+    EXPECT_EQ(release->message, "Add big file");
+    EXPECT_EQ(readBlob(release->fileHashes["src/big.txt"]), largeText(0));
+}
+
+// Test reference deltas, loose objects and incremental imports
+TEST_F(GitImportTest, RefDeltasAndIncremental) {
+    if (!hasGit()) {
+        GTEST_SKIP() << "git is not available";
+    }
+    buildHistory();
+    git("-c repack.usedeltabaseoffset=false repack -q -a -d -f --depth=50 --window=50");
+    commitFile("src/big.txt", largeText(3), "Loose change");
+
+    mimirion::GitImporter importer(testDir, mimirionDir);
+    mimirion::GitImportStats stats;
+    ASSERT_TRUE(importer.run(gitDir / ".git", &stats));
+    EXPECT_EQ(stats.commits, 8u);
+
+    mimirion::CommitManager commits(testDir, mimirionDir);
+    ASSERT_TRUE(commits.loadState());
+    ASSERT_NE(commits.getHeadCommit(), nullptr);
+    EXPECT_EQ(readBlob(commits.getHeadCommit()->fileHashes["src/big.txt"]), largeText(3));
+    std::string previous = commits.getHeadCommit()->hash;
+
+    // A second run only imports what is new
+    commitFile("src/new.txt", "new\n", "Another commit");
+    ASSERT_TRUE(importer.run(gitDir, &stats));
+    EXPECT_EQ(stats.commits, 1u);
+    EXPECT_EQ(stats.blobs, 1u);
+
+    mimirion::CommitManager updated(testDir, mimirionDir);
+    ASSERT_TRUE(updated.loadState());
+    ASSERT_NE(updated.getHeadCommit(), nullptr);
+    EXPECT_EQ(updated.getHeadCommit()->parentHashes, std::vector<std::string>{previous});
+    // History follows first parents: five commits on main, then two more
+    EXPECT_EQ(updated.getHistory(100).size(), 7u);
+
+    EXPECT_FALSE(importer.run(testDir / "missing"));
+}
+
+// Test that paths a commit cannot record or check out safely fail the import
+TEST_F(GitImportTest, UnsafePaths) {
+    if (!hasGit()) {
+        GTEST_SKIP() << "git is not available";
+    }
+    git("init -q -b main");
+    mimirion::GitImporter importer(testDir, mimirionDir);
+    auto rejects = [&](const std::string& path) {
+        testing::internal::CaptureStderr();
+        bool imported = importer.run(gitDir);
+        std::string errors = testing::internal::GetCapturedStderr();
+        EXPECT_FALSE(imported) << path;
+        EXPECT_NE(errors.find("unsafe path \"" + path + "\""), std::string::npos) << errors;
+    };
+
+    commitTree("printf '100644 blob %s\\tbad\\tname\\n' $blob");
+    rejects("bad\\tname");
+    commitTree("printf '100644 blob %s\\tnew\\nline\\000' $blob", "-z");
+    rejects("new\\nline");
+    commitTree("sub=$(printf '100644 blob %s\\tpwned\\n' $blob | git mktree)"
+               " && printf '040000 tree %s\\t..\\n' $sub");
+    rejects("..");
+    commitTree("sub=$(printf '100644 blob %s\\t.mimirion\\n' $blob | git mktree)"
+               " && printf '040000 tree %s\\tdir\\n' $sub");
+    rejects("dir/.mimirion");
+
+    // Nothing was recorded for the rejected commits
+    mimirion::RefStore refs(mimirionDir);
+    EXPECT_TRUE(refs.readRef("refs/heads/main").empty());
+    EXPECT_FALSE(fs::exists(mimirionDir / "import" / "git-map"));
+
+    // The same names are fine as data
+    commitTree("printf '100644 blob %s\\tdots..\\n' $blob");
+    ASSERT_TRUE(importer.run(gitDir));
+    mimirion::CommitManager commits(testDir, mimirionDir);
+    mimirion::CommitInfo head;
+    ASSERT_TRUE(commits.readCommit(refs.readRef("refs/heads/main"), head));
+    EXPECT_EQ(head.fileHashes.count("dots.."), 1u);
+}
@@ -0,0 +1,202 @@
+/**
+ * @file test_grep.cpp
+ * @brief Unit tests for grep and ignore rules
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "grep.hpp"
+#include "commit.hpp"
+#include "file_tracker.hpp"
+#include "ignore.hpp"
+#include "repository.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class GrepTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary repository for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_grep";
+        fs::create_directories(testDir);
+        mimirionDir = testDir / ".mimirion";
+        repo.init(testDir.string());
+
+        originalPath = fs::current_path();
+        fs::current_path(testDir);
+    }
+
+    void TearDown() override {
+        // Change back and clean up the temporary directory
+        fs::current_path(originalPath);
+        fs::remove_all(testDir);
+    }
+
+    // Returns the text of every line the pattern matches
+    std::vector<std::string> lines(const std::string& pattern, const std::string& text,
+                                   bool fixed = false, bool ignoreCase = false) {
+        mimirion::GrepOptions options;
+        options.pattern = pattern;
+        options.fixedStrings = fixed;
+        options.ignoreCase = ignoreCase;
+        std::string error;
+        auto matcher = mimirion::LineMatcher::create(options, error);
+        EXPECT_NE(matcher, nullptr) << error;
+
+        std::vector<std::string> found;
+        size_t offset = 0;
+        size_t start = 0;
+        size_t end = 0;
+        while (matcher && matcher->next(text, offset, start, end)) {
+            found.push_back(text.substr(start, end - start));
+        }
+        return found;
+    }
+
+    std::string grep(const mimirion::GrepOptions& options, int expectedFiles) {
+        mimirion::Grep grep(testDir, mimirionDir);
+        std::ostringstream out;
+        EXPECT_EQ(grep.run(options, out), expectedFiles);
+        return out.str();
+    }
+
+    mimirion::Repository repo;
+    fs::path testDir;
+    fs::path mimirionDir;
+    fs::path originalPath;
+};
+
+// Test literal and regex matching of whole lines
+TEST_F(GrepTest, LineMatching) {
+    std::string text = "alpha beta\nGamma delta\nbeta\n\nepsilon beta gamma";
+    using Lines = std::vector<std::string>;
+    EXPECT_EQ(lines("beta", text, true), (Lines{"alpha beta", "beta", "epsilon beta gamma"}));
+    EXPECT_EQ(lines("gamma", text, true), (Lines{"epsilon beta gamma"}));
+    EXPECT_EQ(lines("gamma", text, true, true), (Lines{"Gamma delta", "epsilon beta gamma"}));
+    EXPECT_EQ(lines("^beta$", text), (Lines{"beta"}));
+    EXPECT_EQ(lines("^$", text), (Lines{""}));
+    EXPECT_EQ(lines("del+ta|alp", text), (Lines{"alpha beta", "Gamma delta"}));
+    EXPECT_EQ(lines("ep[a-z]+ beta", text), (Lines{"epsilon beta gamma"}));
+    EXPECT_EQ(lines("GAMMA$", text, false, true), (Lines{"epsilon beta gamma"}));
+    EXPECT_TRUE(lines("zeta", text, true).empty());
+
+    // Matches at the ends of the buffer
+    EXPECT_EQ(lines("a", "a", true), (Lines{"a"}));
+    EXPECT_EQ(lines("x", "x\n", true), (Lines{"x"}));
+
+    mimirion::GrepOptions invalid;
+    invalid.pattern = "a(b";
+    std::string error;
+    EXPECT_EQ(mimirion::LineMatcher::create(invalid, error), nullptr);
+    EXPECT_FALSE(error.empty());
+}
+
+// Test the literal used to skip to candidate lines
+TEST_F(GrepTest, ExtractLiteral) {
+    using mimirion::LineMatcher;
+    EXPECT_EQ(LineMatcher::extractLiteral("hello"), "hello");
+    EXPECT_EQ(LineMatcher::extractLiteral("^int main\\("), "int main(");
+    EXPECT_EQ(LineMatcher::extractLiteral("ab*cdef"), "cdef");
+    EXPECT_EQ(LineMatcher::extractLiteral("abc+de"), "abc");
+    EXPECT_EQ(LineMatcher::extractLiteral("x[0-9]+_suffix"), "_suffix");
+    EXPECT_EQ(LineMatcher::extractLiteral("(foo|bar)baz"), "baz");
+    EXPECT_EQ(LineMatcher::extractLiteral("foo|bar"), "");
+    EXPECT_EQ(LineMatcher::extractLiteral("a.b"), "a");
+    EXPECT_EQ(LineMatcher::extractLiteral("[]x]yz"), "yz");
+}
+
+// Test ignore patterns, negation and directories
+TEST_F(GrepTest, IgnoreRules) {
+    auto ignore = mimirion::IgnoreRules::parse("# comment\n*.log\n!keep.log\nbuild/\n/out\n");
+    EXPECT_TRUE(ignore.isIgnored("debug.log"));
+    EXPECT_TRUE(ignore.isIgnored("sub/debug.log"));
+    EXPECT_FALSE(ignore.isIgnored("keep.log"));
+    EXPECT_TRUE(ignore.isIgnored("build", true));
+    EXPECT_FALSE(ignore.isIgnored("build", false));
+    EXPECT_TRUE(ignore.isIgnored("build/main.o"));
+    EXPECT_TRUE(ignore.isIgnored("out/x.txt"));
+    EXPECT_FALSE(ignore.isIgnored("src/main.cpp"));
+    EXPECT_TRUE(mimirion::IgnoreRules::parse("").empty());
+
+    // Status leaves ignored files out
+    mimirion::utils::writeFile(testDir / mimirion::IgnoreRules::kFileName, "*.log\nbuild/\n");
+    mimirion::utils::writeFile(testDir / "a.txt", "a\n");
+    mimirion::utils::writeFile(testDir / "debug.log", "log\n");
+    mimirion::utils::writeFile(testDir / "build" / "out.txt", "out\n");
+    mimirion::FileTracker tracker(testDir, mimirionDir);
+    tracker.updateStatus();
+    for (const auto& file : tracker.getFiles()) {
+        EXPECT_NE(file.path, "debug.log");
+        EXPECT_NE(file.path, "build/out.txt");
+    }
+    EXPECT_EQ(tracker.getFileStatus("a.txt"), mimirion::FileStatus::UNTRACKED);
+}
+
+// Test searching the working tree, a commit and untracked files
+TEST_F(GrepTest, Sources) {
+    mimirion::utils::writeFile(testDir / "a.txt", "needle one\nhay\n");
+    mimirion::utils::writeFile(testDir / "src" / "b.txt", "hay\nhay needle\n");
+    mimirion::CommitManager commits(testDir, mimirionDir);
+    std::string hash = commits.createCommit("Files", {"a.txt", "src/b.txt"});
+    ASSERT_FALSE(hash.empty());
+
+    mimirion::utils::writeFile(testDir / "a.txt", "changed\nneedle two\n");
+    mimirion::utils::writeFile(testDir / "notes.txt", "needle untracked\n");
+    mimirion::utils::writeFile(testDir / "skip.log", "needle ignored\n");
+    mimirion::utils::writeFile(testDir / mimirion::IgnoreRules::kFileName, "*.log\n");
+
+    mimirion::GrepOptions options;
+    options.pattern = "needle";
+    options.lineNumbers = true;
+    EXPECT_EQ(grep(options, 2), "a.txt:2:needle two\nsrc/b.txt:2:hay needle\n");
+
+    options.source = mimirion::GrepSource::COMMIT;
+    options.revision = "HEAD";
+    EXPECT_EQ(grep(options, 2), "HEAD:a.txt:1:needle one\nHEAD:src/b.txt:2:hay needle\n");
+
+    options.source = mimirion::GrepSource::WORKING_TREE;
+    options.lineNumbers = false;
+    options.untracked = true;
+    options.filesWithMatches = true;
+    EXPECT_EQ(grep(options, 3), "a.txt\nnotes.txt\nsrc/b.txt\n");
+
+    options.untracked = false;
+    options.filesWithMatches = false;
+    options.count = true;
+    options.paths = {"src/"};
+    EXPECT_EQ(grep(options, 1), "src/b.txt:1\n");
+
+    options.paths.clear();
+    options.count = false;
+    options.pattern = "nomatch";
+    EXPECT_EQ(grep(options, 0), "");
+
+    options.source = mimirion::GrepSource::COMMIT;
+    options.revision = "unknown";
+    EXPECT_EQ(grep(options, -1), "");
+}
+
+// Test searching staged content
+TEST_F(GrepTest, Cached) {
+    mimirion::utils::writeFile(testDir / "a.txt", "staged needle\n");
+    mimirion::FileTracker tracker(testDir, mimirionDir);
+    tracker.loadState();
+    ASSERT_TRUE(tracker.stageFile("a.txt"));
+
+    mimirion::GrepOptions options;
+    options.pattern = "NEEDLE";
+    options.ignoreCase = true;
+    options.source = mimirion::GrepSource::INDEX;
+    EXPECT_EQ(grep(options, 1), "a.txt:staged needle\n");
+
+    mimirion::utils::writeFile(testDir / "bin.dat", std::string("needle\0data", 11));
+    ASSERT_TRUE(tracker.stageFile("bin.dat"));
+    options.source = mimirion::GrepSource::WORKING_TREE;
+    EXPECT_EQ(grep(options, 2), "a.txt:staged needle\nBinary file bin.dat matches\n");
+}
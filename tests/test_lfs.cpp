@@ -0,0 +1,156 @@
+/**
+ * @file test_lfs.cpp
+ * @brief Unit tests for the LargeFileStore class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include "lfs.hpp"
+#include "commit.hpp"
+#include "config.hpp"
+#include "file_tracker.hpp"
+#include "object_store.hpp"
+#include "repository.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class LargeFileStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary repository for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_lfs";
+        fs::create_directories(testDir);
+        mimirionDir = testDir / ".mimirion";
+        repo.init(testDir.string());
+
+        originalPath = fs::current_path();
+        fs::current_path(testDir);
+
+        mimirion::utils::writeFile(testDir / mimirion::Attributes::kFileName, "*.bin filter=lfs\n");
+        while (content.size() < 3 * mimirion::LargeFileStore::kChunkSize / 2) {
+            content += "large chunk " + std::to_string(content.size()) + "\n";
+        }
+    }
+
+    void TearDown() override {
+        // Change back and clean up the temporary directory
+        fs::current_path(originalPath);
+        fs::remove_all(testDir);
+    }
+
+    mimirion::Repository repo;
+    fs::path testDir;
+    fs::path mimirionDir;
+    fs::path originalPath;
+    std::string content;
+};
+
+// Test formatting and parsing pointer text
+TEST_F(LargeFileStoreTest, PointerRoundTrip) {
+    mimirion::LfsPointer pointer{mimirion::utils::sha256("data"), 4};
+    std::string text = mimirion::LargeFileStore::formatPointer(pointer);
+    EXPECT_LE(text.size(), mimirion::LargeFileStore::kMaxPointerSize);
+
+    mimirion::LfsPointer parsed;
+    ASSERT_TRUE(mimirion::LargeFileStore::parsePointer(text, parsed));
+    EXPECT_EQ(parsed.oid, pointer.oid);
+    EXPECT_EQ(parsed.size, 4u);
+
+    EXPECT_FALSE(mimirion::LargeFileStore::parsePointer("data", parsed));
+    EXPECT_FALSE(mimirion::LargeFileStore::parsePointer(text + "extra\n", parsed));
+    EXPECT_FALSE(mimirion::LargeFileStore::parsePointer(text.substr(0, text.size() - 2) + "x\n", parsed));
+}
+
+// Test storing a file and materializing it elsewhere
+TEST_F(LargeFileStoreTest, StoreAndMaterialize) {
+    mimirion::utils::writeFile(testDir / "big.bin", content);
+    mimirion::LargeFileStore store(testDir, mimirionDir);
+    EXPECT_TRUE(store.isTracked("big.bin"));
+    EXPECT_TRUE(store.isTracked("sub/big.bin"));
+    EXPECT_FALSE(store.isTracked("notes.txt"));
+
+    mimirion::LfsPointer pointer;
+    ASSERT_TRUE(store.store(testDir / "big.bin", pointer));
+    EXPECT_EQ(pointer.oid, mimirion::utils::sha256(content));
+    EXPECT_EQ(pointer.size, content.size());
+    EXPECT_TRUE(store.hasObject(pointer.oid));
+    EXPECT_TRUE(fs::is_empty(mimirionDir / "lfs" / "tmp"));
+
+    // Storing the pointer file itself yields the same pointer
+    mimirion::utils::writeFile(testDir / "pointer.bin", mimirion::LargeFileStore::formatPointer(pointer));
+    mimirion::LfsPointer again;
+    ASSERT_TRUE(store.store(testDir / "pointer.bin", again));
+    EXPECT_EQ(again.oid, pointer.oid);
+
+    ASSERT_TRUE(store.materialize(pointer, testDir / "out" / "copy.bin"));
+    EXPECT_EQ(mimirion::utils::readFile(testDir / "out" / "copy.bin"), content);
+
+    mimirion::LfsPointer missing{mimirion::utils::sha256("missing"), 7};
+    EXPECT_FALSE(store.materialize(missing, testDir / "missing.bin"));
+}
+
+// Test that commits record pointers and checkout restores the content
+TEST_F(LargeFileStoreTest, CommitAndCheckout) {
+    mimirion::utils::writeFile(testDir / "big.bin", content);
+    mimirion::utils::writeFile(testDir / "small.txt", "small");
+
+    mimirion::CommitManager commits(testDir, mimirionDir);
+    std::string hash = commits.createCommit("Add large file", {"big.bin", "small.txt"});
+    ASSERT_FALSE(hash.empty());
+
+    mimirion::CommitInfo* commit = commits.getCommit(hash);
+    ASSERT_NE(commit, nullptr);
+    mimirion::ObjectStore objects(mimirionDir);
+    auto blob = objects.readObject(commit->fileHashes["big.bin"]);
+    ASSERT_NE(blob, nullptr);
+    mimirion::LfsPointer pointer;
+    ASSERT_TRUE(mimirion::LargeFileStore::parsePointer(*blob, pointer));
+    EXPECT_EQ(pointer.oid, mimirion::utils::sha256(content));
+    EXPECT_EQ(commit->fileHashes["small.txt"], mimirion::utils::sha256("small"));
+
+    fs::remove(testDir / "big.bin");
+    ASSERT_TRUE(repo.checkout("master"));
+    EXPECT_EQ(mimirion::utils::readFile(testDir / "big.bin"), content);
+
+    // Lazy checkout leaves the pointer in place
+    mimirion::Config::set(mimirionDir, mimirion::Config::Scope::REPOSITORY, "lfs.lazyCheckout", "true");
+    fs::remove(testDir / "big.bin");
+    ASSERT_TRUE(repo.checkout("master"));
+    EXPECT_EQ(mimirion::utils::readFile(testDir / "big.bin"), *blob);
+}
+
+// Test that checkout leaves pointer text alone outside large file paths
+TEST_F(LargeFileStoreTest, CheckoutUntrackedPointer) {
+    mimirion::utils::writeFile(testDir / "big.bin", content);
+    mimirion::LargeFileStore store(testDir, mimirionDir);
+    mimirion::LfsPointer pointer;
+    ASSERT_TRUE(store.store(testDir / "big.bin", pointer));
+    std::string text = mimirion::LargeFileStore::formatPointer(pointer);
+    mimirion::utils::writeFile(testDir / "fixture.txt", text);
+
+    mimirion::CommitManager commits(testDir, mimirionDir);
+    ASSERT_FALSE(commits.createCommit("Add fixture", {"fixture.txt"}).empty());
+    fs::remove(testDir / "fixture.txt");
+    ASSERT_TRUE(repo.checkout("master"));
+    EXPECT_EQ(mimirion::utils::readFile(testDir / "fixture.txt"), text);
+}
+
+// Test that the content and its pointer file hash like the committed pointer
+TEST_F(LargeFileStoreTest, TrackerHashesPointer) {
+    mimirion::utils::writeFile(testDir / "big.bin", content);
+    mimirion::LfsPointer pointer{mimirion::utils::sha256(content), content.size()};
+    std::string pointerHash = mimirion::utils::sha256(mimirion::LargeFileStore::formatPointer(pointer));
+
+    mimirion::FileTracker tracker(testDir, mimirionDir);
+    tracker.loadState();
+    ASSERT_TRUE(tracker.stageFile("big.bin"));
+    EXPECT_EQ(tracker.getStagedFiles()[0].hash, pointerHash);
+
+    mimirion::utils::writeFile(testDir / "big.bin", mimirion::LargeFileStore::formatPointer(pointer));
+    ASSERT_TRUE(tracker.stageFile("big.bin"));
+    EXPECT_EQ(tracker.getStagedFiles()[0].hash, pointerHash);
+}
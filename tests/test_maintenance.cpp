@@ -0,0 +1,379 @@
+/**
+ * @file test_maintenance.cpp
+ * @brief Unit tests for packs and repository maintenance
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include "config.hpp"
+#include "fast_import.hpp"
+#include "fsck.hpp"
+#include "maintenance.hpp"
+#include "object_store.hpp"
+#include "pack.hpp"
+#include "refs.hpp"
+#include "repository.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class MaintenanceTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary repository with a short history
+        testDir = fs::temp_directory_path() / "mimirion_test_maintenance";
+        fs::create_directories(testDir);
+        mimirionDir = testDir / ".mimirion";
+        repo.init(testDir.string());
+
+        originalPath = fs::current_path();
+        fs::current_path(testDir);
+
+        std::ostringstream stream;
+        for (int i = 1; i <= 30; ++i) {
+            std::string content = "content " + std::to_string(i) + "\n";
+            stream << "blob\nmark :" << 2 * i - 1 << "\ndata " << content.size() << "\n" << content << "\n"
+                   << "commit refs/heads/master\nmark :" << 2 * i << "\nauthor A <a@example.com> " << i
+                   << " +0000\ncommitter A <a@example.com> " << i << " +0000\ndata 2\nc\n";
+            if (i > 1) {
+                stream << "from :" << 2 * (i - 1) << "\n";
+            }
+            stream << "M 100644 :" << 2 * i - 1 << " f" << i % 4 << ".txt\n\n";
+        }
+        std::istringstream in(stream.str());
+        ASSERT_TRUE(mimirion::FastImporter(testDir, mimirionDir).run(in));
+    }
+
+    void TearDown() override {
+        // Change back and clean up the temporary directory
+        fs::current_path(originalPath);
+        fs::remove_all(testDir);
+    }
+
+    std::vector<fs::path> looseObjects() {
+        std::vector<fs::path> files;
+        for (const auto& dir : fs::directory_iterator(mimirionDir / "objects")) {
+            std::string name = dir.path().filename().string();
+            if (name.size() == 2 && dir.is_directory()) {
+                for (const auto& file : fs::directory_iterator(dir.path())) {
+                    files.push_back(file.path());
+                }
+            }
+        }
+        return files;
+    }
+
+    bool runTasks(const std::vector<std::string>& tasks, mimirion::MaintenanceReport* report = nullptr) {
+        mimirion::MaintenanceOptions options;
+        options.tasks = tasks;
+        return mimirion::MaintenanceManager(testDir, mimirionDir).run(options, report);
+    }
+
+    static void age(const fs::path& path) {
+        fs::last_write_time(path, fs::file_time_type::clock::now() - std::chrono::hours(24 * 30));
+    }
+
+    // Content that is not referenced anywhere, with a hash in the wanted half
+    std::string garbage(mimirion::ObjectStore& objects, bool lowHalf) {
+        for (int i = 0;; ++i) {
+            std::string hash = objects.writeObject((lowHalf ? "low " : "high ") + std::to_string(i) + "\n");
+            if ((hash[0] < '8') == lowHalf) {
+                return hash;
+            }
+            fs::remove(objects.objectPath(hash));
+        }
+    }
+
+    mimirion::Repository repo;
+    fs::path testDir;
+    fs::path mimirionDir;
+    fs::path originalPath;
+};
+
+// Test that packs find, list and verify their objects
+TEST_F(MaintenanceTest, PackFormat) {
+    fs::path packDir = testDir / "packs";
+    fs::path index;
+    {
+        mimirion::PackWriter writer(packDir);
+        ASSERT_TRUE(writer.add(std::string(64, 'b'), "second"));
+        ASSERT_TRUE(writer.add(std::string(64, 'a'), "first"));
+        ASSERT_TRUE(writer.add("ab" + std::string(62, '0'), "third"));
+        EXPECT_EQ(writer.objectCount(), 3u);
+        ASSERT_TRUE(writer.finish(&index));
+    }
+
+    mimirion::PackFile pack;
+    ASSERT_TRUE(pack.open(index));
+    EXPECT_EQ(pack.objectCount(), 3u);
+    EXPECT_TRUE(pack.verify());
+    EXPECT_EQ(pack.hashAt(0), std::string(64, 'a'));
+    std::string_view stored;
+    ASSERT_TRUE(pack.find(std::string(64, 'b'), stored));
+    EXPECT_EQ(stored, "second");
+    EXPECT_FALSE(pack.find(std::string(64, 'c'), stored));
+    std::vector<std::string> matches;
+    pack.findPrefix("aa", matches);
+    EXPECT_EQ(matches.size(), 1u);
+    matches.clear();
+    pack.findPrefix("a", matches);
+    EXPECT_EQ(matches.size(), 2u);
+
+    // Only the finished pack and its index are left behind
+    size_t files = 0;
+    for (const auto& entry : fs::directory_iterator(packDir)) {
+        EXPECT_EQ(entry.path().filename().string().compare(0, 5, "pack-"), 0);
+        ++files;
+    }
+    EXPECT_EQ(files, 2u);
+
+    {
+        std::fstream file(pack.packPath(), std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(20);
+        file.put('X');
+    }
+    mimirion::PackFile damaged;
+    ASSERT_TRUE(damaged.open(index));
+    EXPECT_FALSE(damaged.verify());
+}
+
+// Test that packed objects read like loose ones and pass fsck
+TEST_F(MaintenanceTest, PackLooseObjects) {
+    std::vector<fs::path> before = looseObjects();
+    ASSERT_EQ(before.size(), 60u);
+    std::string hash = before[0].parent_path().filename().string() + before[0].filename().string();
+    mimirion::ObjectStore loose(mimirionDir);
+    auto content = loose.readObject(hash);
+    ASSERT_TRUE(content);
+
+    mimirion::MaintenanceReport report;
+    ASSERT_TRUE(runTasks({"loose-objects"}, &report));
+    EXPECT_EQ(report.packedObjects, 60u);
+    EXPECT_EQ(report.packsWritten, 1u);
+    EXPECT_TRUE(report.complete);
+    EXPECT_TRUE(looseObjects().empty());
+
+    // A store opened before packing finds the objects once it rescans
+    loose.clearCache();
+    ASSERT_TRUE(loose.readObject(hash));
+    mimirion::ObjectStore packed(mimirionDir);
+    EXPECT_TRUE(packed.hasObject(hash));
+    EXPECT_EQ(*packed.readObject(hash), *content);
+    EXPECT_EQ(packed.resolvePrefix(hash.substr(0, 10)), hash);
+    uint64_t size = 0;
+    EXPECT_TRUE(packed.objectSize(hash, size));
+    EXPECT_EQ(size, content->size());
+
+    // Storing it again does not bring back a loose copy
+    EXPECT_TRUE(packed.storeObject(hash, *content));
+    EXPECT_TRUE(looseObjects().empty());
+
+    mimirion::FsckReport fsck;
+    EXPECT_TRUE(mimirion::IntegrityChecker(testDir, mimirionDir).run({}, &fsck));
+    EXPECT_EQ(fsck.objects, 60u);
+    EXPECT_EQ(fsck.commits, 30u);
+}
+
+// Test that fsck notices a damaged pack
+TEST_F(MaintenanceTest, CorruptPack) {
+    ASSERT_TRUE(runTasks({"loose-objects"}));
+    fs::path pack;
+    for (const auto& entry : fs::directory_iterator(mimirionDir / "objects" / "pack")) {
+        if (entry.path().extension() == ".pack") {
+            pack = entry.path();
+        }
+    }
+    {
+        std::fstream file(pack, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-40, std::ios::end);
+        file.put('\x7f');
+    }
+
+    testing::internal::CaptureStderr();
+    mimirion::FsckReport report;
+    EXPECT_FALSE(mimirion::IntegrityChecker(testDir, mimirionDir).run({}, &report));
+    EXPECT_GE(report.corrupt, 1u);
+    EXPECT_NE(testing::internal::GetCapturedStderr().find("does not match its checksum"), std::string::npos);
+}
+
+// Test that many small packs are merged and still pass fsck
+TEST_F(MaintenanceTest, MergePacks) {
+    std::vector<fs::path> files = looseObjects();
+    for (size_t i = 0; i < mimirion::MaintenanceManager::kMaxPacks + 1; ++i) {
+        mimirion::PackWriter writer(mimirionDir / "objects" / "pack");
+        std::string hash = files[i].parent_path().filename().string() + files[i].filename().string();
+        std::ifstream in(files[i], std::ios::binary);
+        std::string stored((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        ASSERT_TRUE(writer.add(hash, stored));
+        ASSERT_TRUE(writer.finish());
+        fs::remove(files[i]);
+    }
+    mimirion::MaintenanceManager maintenance(testDir, mimirionDir);
+    EXPECT_EQ(maintenance.packCount(), mimirion::MaintenanceManager::kMaxPacks + 1);
+    EXPECT_EQ(maintenance.dueTasks().front(), "loose-objects");
+
+    mimirion::MaintenanceReport report;
+    ASSERT_TRUE(runTasks({"loose-objects"}, &report));
+    EXPECT_EQ(report.packedObjects, 60u - mimirion::MaintenanceManager::kMaxPacks - 1);
+    EXPECT_EQ(maintenance.packCount(), mimirion::MaintenanceManager::kMaxPacks / 2);
+    EXPECT_TRUE(mimirion::IntegrityChecker(testDir, mimirionDir).run({}));
+}
+
+// Test that packed objects of a deleted branch are unpacked and pruned
+TEST_F(MaintenanceTest, PruneDeletedBranch) {
+    std::istringstream side("blob\nmark :1\ndata 5\nside\n\n"
+                            "commit refs/heads/side\nmark :2\n"
+                            "author A <a@example.com> 100 +0000\ncommitter A <a@example.com> 100 +0000\n"
+                            "data 2\ns\nfrom refs/heads/master\nM 100644 :1 side.txt\n\n");
+    ASSERT_TRUE(mimirion::FastImporter(testDir, mimirionDir).run(side));
+    std::string tip = mimirion::RefStore(mimirionDir).readRef("refs/heads/side");
+    std::string blob = mimirion::utils::sha256("side\n");
+    ASSERT_TRUE(runTasks({"loose-objects"}));
+    ASSERT_TRUE(looseObjects().empty());
+
+    fs::remove(mimirionDir / "refs" / "heads" / "side");
+    mimirion::MaintenanceReport report;
+    ASSERT_TRUE(runTasks({"prune"}, &report));
+    EXPECT_EQ(report.unpackedObjects, 2u);
+    EXPECT_EQ(report.prunedObjects, 0u);
+    EXPECT_EQ(looseObjects().size(), 2u);
+
+    // Kept for the grace period, then gone like any loose garbage
+    for (const auto& file : looseObjects()) {
+        age(file);
+    }
+    ASSERT_TRUE(runTasks({"prune"}, &report));
+    EXPECT_EQ(report.unpackedObjects, 0u);
+    EXPECT_EQ(report.prunedObjects, 2u);
+    mimirion::ObjectStore objects(mimirionDir);
+    EXPECT_FALSE(objects.hasObject(tip));
+    EXPECT_FALSE(objects.hasObject(blob));
+    EXPECT_EQ(mimirion::MaintenanceManager(testDir, mimirionDir).packCount(), 1u);
+    EXPECT_TRUE(mimirion::IntegrityChecker(testDir, mimirionDir).run({}));
+}
+
+// Test that prune only removes old objects nothing refers to
+TEST_F(MaintenanceTest, Prune) {
+    mimirion::ObjectStore objects(mimirionDir);
+    std::string old = garbage(objects, true);
+    for (const auto& file : looseObjects()) {
+        age(file);
+    }
+    std::string recent = objects.writeObject("recent garbage\n");
+    fs::path temporary = mimirionDir / "objects" / "tmp" / "12345-0";
+    ASSERT_TRUE(mimirion::utils::writeFile(temporary, "partial"));
+    age(temporary);
+
+    mimirion::MaintenanceReport report;
+    ASSERT_TRUE(runTasks({"prune"}, &report));
+    EXPECT_EQ(report.prunedObjects, 1u);
+    EXPECT_EQ(report.removedTemporaries, 1u);
+    EXPECT_FALSE(objects.hasObject(old));
+    EXPECT_TRUE(objects.hasObject(recent));
+    EXPECT_FALSE(fs::exists(temporary));
+    EXPECT_TRUE(mimirion::IntegrityChecker(testDir, mimirionDir).run({}));
+}
+
+// Test that storing an old object again protects it from prune
+TEST_F(MaintenanceTest, PruneSparesReusedObjects) {
+    mimirion::ObjectStore objects(mimirionDir);
+    std::string hash = objects.writeObject("reused\n");
+    age(objects.objectPath(hash));
+    EXPECT_EQ(objects.writeObject("reused\n"), hash);
+
+    mimirion::MaintenanceReport report;
+    ASSERT_TRUE(runTasks({"prune"}, &report));
+    EXPECT_EQ(report.prunedObjects, 0u);
+    EXPECT_TRUE(objects.hasObject(hash));
+}
+
+// Test that an interrupted prune carries on from where it stopped
+TEST_F(MaintenanceTest, PruneResumes) {
+    mimirion::ObjectStore objects(mimirionDir);
+    std::string low = garbage(objects, true);
+    std::string high = garbage(objects, false);
+    age(objects.objectPath(low));
+    age(objects.objectPath(high));
+
+    // As left by a run whose budget ran out halfway
+    {
+        std::ofstream state(mimirionDir / "maintenance");
+        state << "prune.cursor=128\n";
+    }
+    mimirion::MaintenanceReport report;
+    ASSERT_TRUE(runTasks({"prune"}, &report));
+    EXPECT_EQ(report.prunedObjects, 1u);
+    EXPECT_TRUE(objects.hasObject(low));
+    EXPECT_FALSE(objects.hasObject(high));
+
+    ASSERT_TRUE(runTasks({"prune"}, &report));
+    EXPECT_EQ(report.prunedObjects, 1u);
+    EXPECT_FALSE(objects.hasObject(low));
+}
+
+// Test that runs with a tight budget make progress and finish eventually
+TEST_F(MaintenanceTest, Budget) {
+    mimirion::MaintenanceOptions options;
+    options.budget = std::chrono::milliseconds(5);
+    mimirion::MaintenanceReport report;
+    size_t packed = 0;
+    int runs = 0;
+    do {
+        ASSERT_TRUE(mimirion::MaintenanceManager(testDir, mimirionDir).run(options, &report));
+        packed += report.packedObjects;
+        ASSERT_LT(++runs, 1000);
+    } while (!report.complete);
+    EXPECT_EQ(packed, 60u);
+    EXPECT_TRUE(looseObjects().empty());
+    EXPECT_TRUE(mimirion::IntegrityChecker(testDir, mimirionDir).run({}));
+}
+
+// Test that thresholds decide which tasks are due
+TEST_F(MaintenanceTest, DueTasks) {
+    mimirion::MaintenanceManager maintenance(testDir, mimirionDir);
+    EXPECT_TRUE(maintenance.dueTasks().empty());
+
+    ASSERT_TRUE(mimirion::Config::set(mimirionDir, mimirion::Config::Scope::REPOSITORY,
+                                      "maintenance.autoUnindexedCommits", "10"));
+    EXPECT_EQ(maintenance.dueTasks(), (std::vector<std::string>{"bitmaps", "prune"}));
+
+    mimirion::MaintenanceOptions options;
+    options.autoOnly = true;
+    mimirion::MaintenanceReport report;
+    ASSERT_TRUE(maintenance.run(options, &report));
+    EXPECT_EQ(report.tasks, (std::vector<std::string>{"bitmaps", "prune"}));
+    EXPECT_EQ(report.bitmapObjects, 60u);
+    EXPECT_TRUE(maintenance.dueTasks().empty());
+}
+
+// Test that runs exclude each other but not a dead runner
+TEST_F(MaintenanceTest, Lock) {
+    fs::path lock = mimirionDir / "maintenance.lock";
+    mimirion::MaintenanceManager maintenance(testDir, mimirionDir);
+    {
+        std::ofstream file(lock);
+        file << getpid() << "\n";
+    }
+    int fd = ::open(lock.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(::flock(fd, LOCK_EX | LOCK_NB), 0);
+    EXPECT_EQ(maintenance.runningProcess(), getpid());
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(runTasks({"prune"}));
+    EXPECT_NE(testing::internal::GetCapturedStderr().find("already running"), std::string::npos);
+
+    // The lock goes with its holder, whatever the file says
+    ::close(fd);
+    EXPECT_TRUE(runTasks({"prune"}));
+    EXPECT_FALSE(fs::exists(lock));
+    EXPECT_EQ(maintenance.runningProcess(), 0);
+    EXPECT_FALSE(runTasks({"repack"}));
+}
@@ -0,0 +1,154 @@
+/**
+ * @file test_object_store.cpp
+ * @brief Unit tests for the ObjectStore class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include "object_store.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class ObjectStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary directory for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_object_store";
+        mimirionDir = testDir / ".mimirion";
+        fs::create_directories(mimirionDir / "objects");
+    }
+
+    void TearDown() override {
+        // Clean up the temporary directory
+        fs::remove_all(testDir);
+    }
+
+    fs::path testDir;
+    fs::path mimirionDir;
+};
+
+// Test writing and reading back an object
+TEST_F(ObjectStoreTest, WriteAndRead) {
+    mimirion::ObjectStore store(mimirionDir);
+    std::string hash = store.writeObject("object content");
+    
+    EXPECT_EQ(hash, mimirion::utils::sha256("object content"));
+    EXPECT_TRUE(store.hasObject(hash));
+    
+    // Written to the side and renamed into place
+    EXPECT_TRUE(fs::exists(store.objectPath(hash)));
+    EXPECT_TRUE(fs::is_empty(mimirionDir / "objects" / "tmp"));
+    
+    auto content = store.readObject(hash);
+    ASSERT_NE(content, nullptr);
+    EXPECT_EQ(*content, "object content");
+    
+    // Cached reads hand out the same buffer
+    EXPECT_EQ(store.readObject(hash).get(), content.get());
+}
+
+// Test reading objects that do not exist
+TEST_F(ObjectStoreTest, MissingObject) {
+    mimirion::ObjectStore store(mimirionDir);
+    EXPECT_FALSE(store.hasObject("deadbeef"));
+    EXPECT_EQ(store.readObject("deadbeef"), nullptr);
+    EXPECT_EQ(store.readObject("../../etc/passwd"), nullptr);
+}
+
+// Test resolving abbreviated hashes
+TEST_F(ObjectStoreTest, ResolvePrefix) {
+    mimirion::ObjectStore store(mimirionDir);
+    std::string hash = store.writeObject("prefix test");
+    
+    EXPECT_EQ(store.resolvePrefix(hash.substr(0, 8)), hash);
+    EXPECT_EQ(store.resolvePrefix("zz"), "");
+}
+
+// Test that objects are stored compressed and raw objects stay readable
+TEST_F(ObjectStoreTest, CompressedAndRawObjects) {
+    mimirion::ObjectStore store(mimirionDir);
+    std::string content(10000, 'a');
+    std::string hash = store.writeObject(content);
+    
+    std::string onDisk = mimirion::utils::readFile(store.objectPath(hash));
+    EXPECT_LT(onDisk.size(), content.size());
+    mimirion::ObjectHeader header;
+    ASSERT_TRUE(mimirion::ObjectHeader::decode(onDisk, header));
+    EXPECT_EQ(header.codec, mimirion::CodecId::ZLIB);
+    EXPECT_EQ(header.size, content.size());
+    EXPECT_EQ(*store.readObject(hash), content);
+    
+    // An object written uncompressed by an older version
+    std::string legacy = "x^ legacy raw object";
+    std::string legacyHash = mimirion::utils::sha256(legacy);
+    mimirion::utils::writeFile(store.objectPath(legacyHash), legacy);
+    auto read = store.readObject(legacyHash);
+    ASSERT_NE(read, nullptr);
+    EXPECT_EQ(*read, legacy);
+}
+
+// Test storing a large file, which is compressed straight to disk
+TEST_F(ObjectStoreTest, WriteLargeFile) {
+    std::string content;
+    while (content.size() < 5 * 1024 * 1024) {
+        content += "block " + std::to_string(content.size() % 4093) + "\n";
+    }
+    mimirion::utils::writeFile(testDir / "large.bin", content);
+    
+    mimirion::ObjectStore store(mimirionDir);
+    std::string hash = store.writeFile(testDir / "large.bin");
+    EXPECT_EQ(hash, mimirion::utils::sha256(content));
+    EXPECT_LT(fs::file_size(store.objectPath(hash)), content.size());
+    EXPECT_FALSE(fs::exists(mimirionDir / "objects" / "tmp") &&
+                 !fs::is_empty(mimirionDir / "objects" / "tmp"));
+    
+    mimirion::ObjectStore reader(mimirionDir);
+    auto read = reader.readObject(hash);
+    ASSERT_NE(read, nullptr);
+    EXPECT_EQ(*read, content);
+}
+
+// Test reading through alternates while writing locally
+TEST_F(ObjectStoreTest, Alternates) {
+    fs::path sharedDir = testDir / "shared" / ".mimirion";
+    fs::path cacheDir = testDir / "cache" / ".mimirion";
+    fs::create_directories(sharedDir / "objects");
+    fs::create_directories(cacheDir / "objects");
+    std::string deep = mimirion::ObjectStore(cacheDir).writeObject("from the cache");
+    std::string shared = mimirion::ObjectStore(sharedDir).writeObject("from the shared store");
+
+    // shared borrows from cache, and cache names shared back
+    ASSERT_TRUE(mimirion::ObjectStore(sharedDir).addAlternate(cacheDir));
+    mimirion::utils::writeFile(cacheDir / "objects" / "info" / "alternates", "../../shared/.mimirion/objects\n");
+
+    mimirion::ObjectStore store(mimirionDir);
+    ASSERT_TRUE(store.addAlternate(sharedDir.parent_path() / ".mimirion" / "objects"));
+    EXPECT_TRUE(store.addAlternate(sharedDir));
+    EXPECT_FALSE(store.addAlternate(mimirionDir));
+    EXPECT_FALSE(store.addAlternate(testDir / "missing"));
+    ASSERT_EQ(store.alternateDirs().size(), 2u);
+    EXPECT_EQ(store.alternateDirs()[0], fs::canonical(sharedDir / "objects"));
+
+    mimirion::ObjectStore reader(mimirionDir);
+    EXPECT_TRUE(reader.hasObject(deep));
+    ASSERT_NE(reader.readObject(shared), nullptr);
+    EXPECT_EQ(*reader.readObject(deep), "from the cache");
+    EXPECT_EQ(reader.resolvePrefix(deep.substr(0, 8)), deep);
+    std::string streamed;
+    EXPECT_TRUE(reader.readStream(deep, [&](const char* data, size_t size) {
+        streamed.append(data, size);
+        return true;
+    }));
+    EXPECT_EQ(streamed, "from the cache");
+
+    // Borrowed objects are not copied, new ones are written here
+    EXPECT_EQ(reader.writeObject("from the cache"), deep);
+    EXPECT_FALSE(fs::exists(reader.objectPath(deep)));
+    std::string local = reader.writeObject("local");
+    EXPECT_TRUE(fs::exists(reader.objectPath(local)));
+    EXPECT_FALSE(mimirion::ObjectStore(sharedDir).hasObject(local));
+}
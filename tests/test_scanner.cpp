@@ -0,0 +1,154 @@
+/**
+ * @file test_scanner.cpp
+ * @brief Unit tests for the FileScanner class
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include "scanner.hpp"
+#include "object_store.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class ScannerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary directory for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_scanner";
+        fs::create_directories(testDir / ".mimirion" / "objects");
+    }
+
+    void TearDown() override {
+        // Clean up the temporary directory
+        fs::remove_all(testDir);
+    }
+
+    mimirion::ScanResult scanContent(const std::string& content) {
+        fs::path path = testDir / "sample";
+        mimirion::utils::writeFile(path, content);
+
+        mimirion::ScanResult result;
+        EXPECT_TRUE(scanner.scan(path, result));
+        return result;
+    }
+
+    fs::path testDir;
+    mimirion::FileScanner scanner;
+};
+
+// Test line counting and newline detection
+TEST_F(ScannerTest, LinesAndNewlines) {
+    auto lf = scanContent("one\ntwo\nthree\n");
+    EXPECT_EQ(lf.lines, 3u);
+    EXPECT_EQ(lf.newlines, mimirion::NewlineStyle::LF);
+    EXPECT_FALSE(lf.binary);
+    EXPECT_EQ(lf.hash, mimirion::utils::sha256("one\ntwo\nthree\n"));
+    EXPECT_EQ(lf.size, 14u);
+
+    auto crlf = scanContent("one\r\ntwo\r\nno newline");
+    EXPECT_EQ(crlf.lines, 3u);
+    EXPECT_EQ(crlf.newlines, mimirion::NewlineStyle::CRLF);
+
+    auto mixed = scanContent("one\r\ntwo\n");
+    EXPECT_EQ(mixed.newlines, mimirion::NewlineStyle::MIXED);
+
+    auto empty = scanContent("");
+    EXPECT_EQ(empty.lines, 0u);
+    EXPECT_EQ(empty.newlines, mimirion::NewlineStyle::NONE);
+    EXPECT_EQ(empty.hash, mimirion::utils::sha256(""));
+}
+
+// Test a CRLF split across two read chunks and a file of several chunks
+TEST_F(ScannerTest, ChunkBoundaries) {
+    std::string content(mimirion::FileScanner::kBinaryCheckSize - 1, 'x');
+    content += "\r\n";
+    while (content.size() < 200 * 1024) {
+        content += "another line of text\r\n";
+    }
+
+    mimirion::FileScanner small(mimirion::FileScanner::kBinaryCheckSize);
+    fs::path path = testDir / "large";
+    mimirion::utils::writeFile(path, content);
+    mimirion::ScanResult result;
+    ASSERT_TRUE(small.scan(path, result));
+
+    auto expected = mimirion::FileScanner::scanBuffer(content);
+    EXPECT_EQ(result.newlines, mimirion::NewlineStyle::CRLF);
+    EXPECT_EQ(result.lines, expected.lines);
+    EXPECT_EQ(result.hash, expected.hash);
+    EXPECT_EQ(result.hash, mimirion::utils::sha256(content));
+}
+
+// Test binary detection only looks at the start of the file
+TEST_F(ScannerTest, BinaryDetection) {
+    EXPECT_TRUE(scanContent(std::string("ab\0cd", 5)).binary);
+    EXPECT_TRUE(scanContent("text\x01").binary);
+    EXPECT_FALSE(scanContent("tabs\tand\r\nlines\n").binary);
+
+    std::string lateNul(mimirion::FileScanner::kBinaryCheckSize, 'a');
+    lateNul += '\0';
+    EXPECT_FALSE(scanContent(lateNul).binary);
+    EXPECT_EQ(mimirion::utils::isBinaryFile(testDir / "sample"), false);
+}
+
+// Test that content sinks and compression see the whole file
+TEST_F(ScannerTest, ContentAndCompressedSinks) {
+    std::string content;
+    for (int i = 0; i < 20000; ++i) {
+        content += "line " + std::to_string(i) + "\n";
+    }
+    fs::path path = testDir / "sample";
+    mimirion::utils::writeFile(path, content);
+
+    std::string copy;
+    mimirion::ScanResult result;
+    ASSERT_TRUE(scanner.scan(path, result, [&copy](const char* data, size_t size) {
+        copy.append(data, size);
+        return true;
+    }));
+    EXPECT_EQ(copy, content);
+
+    std::string compressed;
+    mimirion::Compressor compressor;
+    ASSERT_TRUE(scanner.scan(path, result, compressor, [&compressed](const char* data, size_t size) {
+        compressed.append(data, size);
+        return true;
+    }));
+    EXPECT_EQ(result.lines, 20000u);
+
+    std::string restored;
+    ASSERT_TRUE(mimirion::Decompressor::decompress(compressed, restored));
+    EXPECT_EQ(restored, content);
+
+    EXPECT_FALSE(scanner.scan(testDir / "missing", result));
+}
+
+// Test storing a file as an object in one pass
+TEST_F(ScannerTest, ObjectStoreWriteFile) {
+    std::string content;
+    for (int i = 0; i < 5000; ++i) {
+        content += "row " + std::to_string(i % 13) + "\n";
+    }
+    fs::path path = testDir / "sample";
+    mimirion::utils::writeFile(path, content);
+
+    mimirion::ObjectStore store(testDir / ".mimirion");
+    mimirion::ScanResult result;
+    std::string hash = store.writeFile(path, &result);
+    EXPECT_EQ(hash, mimirion::utils::sha256(content));
+    EXPECT_EQ(result.lines, 5000u);
+    EXPECT_LT(fs::file_size(store.objectPath(hash)), content.size());
+
+    mimirion::ObjectStore reader(testDir / ".mimirion");
+    auto read = reader.readObject(hash);
+    ASSERT_NE(read, nullptr);
+    EXPECT_EQ(*read, content);
+
+    // Storing the same file again keeps the existing object
+    EXPECT_EQ(store.writeFile(path), hash);
+    EXPECT_EQ(store.writeFile(testDir / "missing"), "");
+}
@@ -0,0 +1,87 @@
+/**
+ * @file test_scheduler.cpp
+ * @brief Unit tests for the TaskScheduler and TaskGroup classes
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include "scheduler.hpp"
+
+// Test that every task in a group runs before wait() returns
+TEST(SchedulerTest, RunsAllTasks) {
+    mimirion::TaskScheduler scheduler(4);
+    std::atomic<int> counter(0);
+    
+    mimirion::TaskGroup group(scheduler);
+    for (int i = 0; i < 1000; ++i) {
+        group.run([&counter]() { ++counter; });
+    }
+    group.wait();
+    
+    EXPECT_EQ(counter.load(), 1000);
+    
+    mimirion::TaskScheduler::Metrics metrics = scheduler.getMetrics();
+    EXPECT_EQ(metrics.threadCount, 4u);
+    EXPECT_GE(metrics.tasksExecuted, 1000u);
+    EXPECT_GE(metrics.maxQueueDepth, 1u);
+    EXPECT_EQ(metrics.queuedTasks, 0u);
+}
+
+// Test nested groups do not deadlock a small pool
+TEST(SchedulerTest, NestedGroups) {
+    mimirion::TaskScheduler scheduler(1);
+    std::atomic<int> counter(0);
+    
+    mimirion::TaskGroup outer(scheduler);
+    for (int i = 0; i < 8; ++i) {
+        outer.run([&scheduler, &counter]() {
+            mimirion::TaskGroup inner(scheduler);
+            for (int j = 0; j < 8; ++j) {
+                inner.run([&counter]() { ++counter; });
+            }
+            inner.wait();
+        });
+    }
+    outer.wait();
+    
+    EXPECT_EQ(counter.load(), 64);
+}
+
+// Test that cancelled groups skip pending tasks
+TEST(SchedulerTest, Cancellation) {
+    mimirion::TaskScheduler scheduler(0);
+    std::atomic<int> counter(0);
+    
+    mimirion::TaskGroup group(scheduler);
+    group.run([&counter]() { ++counter; });
+    group.cancel();
+    group.run([&counter]() { ++counter; });
+    group.wait();
+    
+    EXPECT_TRUE(group.isCancelled());
+    EXPECT_EQ(counter.load(), 1);
+}
+
+// Test that task exceptions surface from wait()
+TEST(SchedulerTest, ExceptionPropagation) {
+    mimirion::TaskScheduler scheduler(2);
+    mimirion::TaskGroup group(scheduler);
+    group.run([]() { throw std::runtime_error("task failed"); });
+    EXPECT_THROW(group.wait(), std::runtime_error);
+}
+
+// Test the parallel loop helper on the shared scheduler
+TEST(SchedulerTest, ParallelFor) {
+    std::vector<int> values(10000, 0);
+    mimirion::parallelFor(values.size(), [&values](size_t i) {
+        values[i] = static_cast<int>(i) * 2;
+    });
+    
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQ(values[i], static_cast<int>(i) * 2);
+    }
+}
@@ -0,0 +1,189 @@
+/**
+ * @file test_trigram.cpp
+ * @brief Unit tests for the trigram index
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "trigram.hpp"
+#include "commit.hpp"
+#include "grep.hpp"
+#include "object_store.hpp"
+#include "repository.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class TrigramTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary repository for each test
+        testDir = fs::temp_directory_path() / "mimirion_test_trigram";
+        fs::create_directories(testDir);
+        mimirionDir = testDir / ".mimirion";
+        repo.init(testDir.string());
+
+        originalPath = fs::current_path();
+        fs::current_path(testDir);
+    }
+
+    void TearDown() override {
+        // Change back and clean up the temporary directory
+        fs::current_path(originalPath);
+        fs::remove_all(testDir);
+    }
+
+    std::string store(const std::string& content) {
+        mimirion::ObjectStore objects(mimirionDir);
+        return objects.writeObject(content);
+    }
+
+    std::unordered_set<std::string> find(const std::vector<std::string>& literals) {
+        mimirion::TrigramIndex index(mimirionDir);
+        std::unordered_set<std::string> hashes;
+        EXPECT_TRUE(index.candidates(literals, hashes));
+        return hashes;
+    }
+
+    mimirion::Repository repo;
+    fs::path testDir;
+    fs::path mimirionDir;
+    fs::path originalPath;
+};
+
+// Test trigram extraction and case folding
+TEST_F(TrigramTest, Trigrams) {
+    using Grams = std::vector<uint32_t>;
+    EXPECT_TRUE(mimirion::TrigramIndex::trigrams("ab").empty());
+    EXPECT_EQ(mimirion::TrigramIndex::trigrams("abc"), (Grams{0x616263}));
+    EXPECT_EQ(mimirion::TrigramIndex::trigrams("ABCAbc"),
+              (Grams{0x616263, 0x626361, 0x636162}));
+}
+
+// Test indexing, incremental updates and candidate lookup
+TEST_F(TrigramTest, UpdateAndQuery) {
+    std::string a = store("int main() { return parse(argv); }\n");
+    std::string b = store("void Parse(const char* text);\n");
+    std::string c = store("nothing relevant here\n");
+    std::string binary = store(std::string("parse\0\1\2", 8));
+
+    size_t added = 0;
+    {
+        mimirion::TrigramIndex index(mimirionDir);
+        ASSERT_TRUE(index.update({a, b, c, binary, a}, &added));
+        EXPECT_EQ(added, 4u);
+        EXPECT_TRUE(index.contains(binary));
+        EXPECT_FALSE(index.contains("missing"));
+    }
+
+    // Binary blobs have no postings and are always candidates
+    using Hashes = std::unordered_set<std::string>;
+    EXPECT_EQ(find({"parse"}), (Hashes{a, b, binary}));
+    EXPECT_EQ(find({"parse(", "argv"}), (Hashes{a, binary}));
+    EXPECT_EQ(find({"nothing"}), (Hashes{c, binary}));
+    EXPECT_EQ(find({"absent"}), (Hashes{binary}));
+
+    // Too short to narrow anything
+    mimirion::TrigramIndex index(mimirionDir);
+    Hashes hashes;
+    EXPECT_FALSE(index.candidates({"ab"}, hashes));
+
+    // Only new blobs are read again
+    std::string d = store("parser tables\n");
+    ASSERT_TRUE(index.update({a, b, c, d}, &added));
+    EXPECT_EQ(added, 1u);
+    EXPECT_EQ(index.blobCount(), 5u);
+    EXPECT_EQ(index.segmentCount(), 2u);
+    EXPECT_EQ(find({"parse"}), (Hashes{a, b, d, binary}));
+}
+
+// Test that segments are merged and interrupted updates are rolled back
+TEST_F(TrigramTest, MergeAndRecover) {
+    std::vector<std::string> hashes;
+    {
+        mimirion::TrigramIndex index(mimirionDir);
+        for (size_t i = 0; i <= mimirion::TrigramIndex::kMaxSegments; ++i) {
+            hashes.push_back(store("file " + std::to_string(i) + " shared_token\n"));
+            ASSERT_TRUE(index.update({hashes.back()}));
+        }
+        EXPECT_EQ(index.segmentCount(), 1u);
+    }
+    EXPECT_EQ(find({"shared_token"}).size(), hashes.size());
+    EXPECT_EQ(find({"file 3 "}), (std::unordered_set<std::string>{hashes[3]}));
+
+    // A segment whose blobs are missing from the table is dropped
+    std::string extra = store("late shared_token\n");
+    {
+        mimirion::TrigramIndex index(mimirionDir);
+        ASSERT_TRUE(index.update({extra}));
+    }
+    fs::path table = mimirionDir / "index.d" / "blobs";
+    std::string content = mimirion::utils::readFile(table);
+    mimirion::utils::writeFile(table, content.substr(0, content.size() - 10));
+
+    mimirion::TrigramIndex index(mimirionDir);
+    EXPECT_EQ(index.blobCount(), hashes.size());
+    EXPECT_EQ(index.segmentCount(), 1u);
+    EXPECT_FALSE(index.contains(extra));
+    size_t added = 0;
+    ASSERT_TRUE(index.update({extra}, &added));
+    EXPECT_EQ(added, 1u);
+    EXPECT_EQ(find({"shared_token"}).size(), hashes.size() + 1);
+}
+
+// Test that indexed searches of a commit match plain ones
+TEST_F(TrigramTest, IndexedGrep) {
+    mimirion::utils::writeFile(testDir / "a.txt", "alpha Needle\n");
+    mimirion::utils::writeFile(testDir / "b.txt", "beta\n");
+    mimirion::utils::writeFile(testDir / "c.txt", "needles and pins\n");
+    mimirion::CommitManager commits(testDir, mimirionDir);
+    ASSERT_FALSE(commits.createCommit("Files", {"a.txt", "b.txt", "c.txt"}).empty());
+
+    for (const char* pattern : {"needle", "ne+dle", "pins|beta", "x"}) {
+        mimirion::GrepOptions options;
+        options.pattern = pattern;
+        options.ignoreCase = true;
+        options.source = mimirion::GrepSource::COMMIT;
+        options.revision = "HEAD";
+
+        std::ostringstream plain;
+        std::ostringstream indexed;
+        mimirion::Grep grep(testDir, mimirionDir);
+        int plainFiles = grep.run(options, plain);
+        options.useIndex = true;
+        EXPECT_EQ(grep.run(options, indexed), plainFiles) << pattern;
+        EXPECT_EQ(indexed.str(), plain.str()) << pattern;
+    }
+    EXPECT_EQ(mimirion::TrigramIndex(mimirionDir).blobCount(), 3u);
+}
+
+// Test that indexed searches still find matches in unindexed blobs
+TEST_F(TrigramTest, IndexedGrepUnindexedBlobs) {
+    mimirion::utils::writeFile(testDir / "a.txt", "alpha\n");
+    mimirion::utils::writeFile(testDir / "bin.dat", std::string("needle\0\1\2", 9));
+    std::string large(mimirion::TrigramIndex::kMaxIndexedSize + 1, 'x');
+    large += "\nneedle\n";
+    mimirion::utils::writeFile(testDir / "large.txt", large);
+    mimirion::CommitManager commits(testDir, mimirionDir);
+    ASSERT_FALSE(commits.createCommit("Files", {"a.txt", "bin.dat", "large.txt"}).empty());
+
+    mimirion::GrepOptions options;
+    options.pattern = "needle";
+    options.source = mimirion::GrepSource::COMMIT;
+    options.revision = "HEAD";
+    options.filesWithMatches = true;
+
+    std::ostringstream plain;
+    std::ostringstream indexed;
+    mimirion::Grep grep(testDir, mimirionDir);
+    EXPECT_EQ(grep.run(options, plain), 2);
+    options.useIndex = true;
+    EXPECT_EQ(grep.run(options, indexed), 2);
+    EXPECT_EQ(indexed.str(), plain.str());
+    EXPECT_EQ(mimirion::TrigramIndex(mimirionDir).blobCount(), 3u);
+}
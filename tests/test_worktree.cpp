@@ -0,0 +1,171 @@
+/**
+ * @file test_worktree.cpp
+ * @brief Unit tests for linked worktrees
+ * @author Mimirion Team
+ * @date June 2025
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include "worktree.hpp"
+#include "commit.hpp"
+#include "refs.hpp"
+#include "repository.hpp"
+#include "utils.hpp"
+
+namespace fs = std::filesystem;
+
+class WorktreeTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // Create a temporary repository with a master and a feature branch
+        testDir = fs::temp_directory_path() / "mimirion_test_worktree";
+        mainPath = testDir / "main";
+        fs::create_directories(mainPath);
+        mimirionDir = mainPath / ".mimirion";
+        repo.init(mainPath.string());
+
+        originalPath = fs::current_path();
+        fs::current_path(mainPath);
+
+        mimirion::utils::writeFile(mainPath / "a.txt", "master\n");
+        mimirion::CommitManager commits(mainPath, mimirionDir);
+        ASSERT_FALSE(commits.createCommit("Master", {"a.txt"}).empty());
+        mimirion::RefStore refs(mimirionDir);
+        ASSERT_TRUE(refs.writeRef("refs/heads/feature", refs.readRef("refs/heads/master")));
+    }
+
+    void TearDown() override {
+        // Change back and clean up the temporary directory
+        fs::current_path(originalPath);
+        fs::remove_all(testDir);
+    }
+
+    mimirion::Repository repo;
+    fs::path testDir;
+    fs::path mainPath;
+    fs::path mimirionDir;
+    fs::path originalPath;
+};
+
+// Test that a worktree shares objects and refs but has its own HEAD
+TEST_F(WorktreeTest, AddSharesStore) {
+    fs::path path = testDir / "feature-tree";
+    mimirion::WorktreeManager worktrees(mainPath, mimirionDir);
+    ASSERT_TRUE(worktrees.add(path, "feature"));
+
+    EXPECT_TRUE(fs::is_regular_file(path / ".mimirion"));
+    EXPECT_EQ(mimirion::utils::readFile(path / "a.txt"), "master\n");
+    fs::path admin = mimirion::Repository::findMimirionDir(path);
+    EXPECT_EQ(admin, mimirionDir / "worktrees" / "feature-tree");
+    EXPECT_TRUE(fs::is_symlink(admin / "objects"));
+    EXPECT_TRUE(fs::is_symlink(admin / "refs"));
+    EXPECT_EQ(mimirion::WorktreeManager::commonDir(admin), mimirionDir);
+    EXPECT_EQ(mimirion::Repository::findRepositoryRoot(path / "a.txt"), path);
+
+    // A commit in the worktree moves the shared branch, not the main HEAD
+    mimirion::utils::writeFile(path / "b.txt", "feature\n");
+    mimirion::CommitManager commits(path, admin);
+    commits.loadState();
+    std::string hash = commits.createCommit("Feature", {"a.txt", "b.txt"});
+    ASSERT_FALSE(hash.empty());
+    mimirion::RefStore mainRefs(mimirionDir);
+    EXPECT_EQ(mainRefs.readRef("refs/heads/feature"), hash);
+    EXPECT_EQ(mainRefs.currentBranch(), "master");
+    EXPECT_NE(mainRefs.resolve("HEAD"), hash);
+
+    auto list = worktrees.list();
+    ASSERT_EQ(list.size(), 2u);
+    EXPECT_TRUE(list[0].name.empty());
+    EXPECT_EQ(list[0].branch, "master");
+    EXPECT_EQ(list[1].name, "feature-tree");
+    EXPECT_EQ(list[1].path, path);
+    EXPECT_EQ(list[1].head, hash);
+
+    // A branch is checked out in one worktree at a time
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(worktrees.add(testDir / "again", "feature"));
+    EXPECT_FALSE(worktrees.add(testDir / "main-again", "master"));
+    EXPECT_FALSE(worktrees.add(testDir / "missing", "missing"));
+    testing::internal::GetCapturedStderr();
+    EXPECT_FALSE(fs::exists(testDir / "again"));
+}
+
+// Test that checkout refuses a branch another worktree has checked out
+TEST_F(WorktreeTest, CheckoutHeldBranch) {
+    mimirion::WorktreeManager worktrees(mainPath, mimirionDir);
+    fs::path path = testDir / "feature-tree";
+    ASSERT_TRUE(worktrees.add(path, "feature"));
+
+    mimirion::Repository main;
+    ASSERT_TRUE(main.load(mainPath.string()));
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(main.checkout("feature"));
+    std::string errors = testing::internal::GetCapturedStderr();
+    EXPECT_NE(errors.find("already checked out at " + path.string()), std::string::npos) << errors;
+    mimirion::RefStore refs(mimirionDir);
+    EXPECT_EQ(refs.currentBranch(), "master");
+
+    // Nor can the worktree take the main worktree's branch, but each can
+    // check out its own again
+    mimirion::Repository linked;
+    ASSERT_TRUE(linked.load(path.string()));
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(linked.checkout("master"));
+    testing::internal::GetCapturedStderr();
+    EXPECT_TRUE(main.checkout("master"));
+    EXPECT_TRUE(linked.checkout("feature"));
+
+    // Once the worktree is gone the branch is free
+    ASSERT_TRUE(worktrees.remove(path.string()));
+    EXPECT_TRUE(main.checkout("feature"));
+    EXPECT_EQ(refs.currentBranch(), "feature");
+}
+
+// Test that removal keeps worktrees with changes unless forced
+TEST_F(WorktreeTest, RemoveAndPrune) {
+    mimirion::WorktreeManager worktrees(mainPath, mimirionDir);
+    fs::path path = testDir / "tree";
+    ASSERT_TRUE(worktrees.add(path, "feature"));
+
+    mimirion::utils::writeFile(path / "new.txt", "untracked\n");
+    testing::internal::CaptureStderr();
+    EXPECT_FALSE(worktrees.remove("tree"));
+    EXPECT_FALSE(worktrees.remove(mainPath.string()));
+    testing::internal::GetCapturedStderr();
+    EXPECT_TRUE(fs::exists(path));
+
+    fs::remove(path / "new.txt");
+    EXPECT_TRUE(worktrees.remove(path.string()));
+    EXPECT_FALSE(fs::exists(path));
+    EXPECT_FALSE(fs::exists(mimirionDir / "worktrees" / "tree"));
+    EXPECT_TRUE(fs::exists(mimirionDir / "objects"));
+
+    // Worktrees whose directory was deleted by hand are pruned
+    ASSERT_TRUE(worktrees.add(path, "feature"));
+    fs::remove_all(path);
+    EXPECT_EQ(worktrees.prune(), 1u);
+    EXPECT_EQ(worktrees.list().size(), 1u);
+}
+
+// Test that ref updates take a lock and can check the old value
+TEST_F(WorktreeTest, RefLocking) {
+    mimirion::RefStore refs(mimirionDir);
+    std::string head = refs.readRef("refs/heads/master");
+    std::string other = std::string(64, 'a');
+
+    testing::internal::CaptureStderr();
+    mimirion::utils::writeFile(mimirionDir / "refs" / "heads" / "master.lock", "");
+    EXPECT_FALSE(refs.writeRef("refs/heads/master", other));
+    fs::remove(mimirionDir / "refs" / "heads" / "master.lock");
+
+    std::string stale = "stale";
+    EXPECT_FALSE(refs.writeRef("refs/heads/master", other, &stale));
+    testing::internal::GetCapturedStderr();
+    EXPECT_EQ(refs.readRef("refs/heads/master"), head);
+    EXPECT_FALSE(fs::exists(mimirionDir / "refs" / "heads" / "master.lock"));
+
+    EXPECT_TRUE(refs.writeRef("refs/heads/master", other, &head));
+    EXPECT_EQ(refs.readRef("refs/heads/master"), other);
+}